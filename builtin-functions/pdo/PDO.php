@@ -8,6 +8,12 @@ class PDO {
      * @link https://php.net/manual/en/pdo.constants.php#pdo.constants.attr-timeout
      */
     const ATTR_TIMEOUT = 2;
+    /**
+     * If false, rows are read from the connection one by one on fetch(), instead of reading the whole result set on execute().
+     * It can be set in the constructor options, or for a statement in the prepare() options.
+     * @link https://php.net/manual/en/ref.pdo-mysql.php#pdo.constants.mysql-attr-use-buffered-query
+     */
+    const MYSQL_ATTR_USE_BUFFERED_QUERY = 1000;
 
     public function __construct(
         string $dsn,
@@ -22,12 +28,13 @@ class PDO {
     /** @kphp-extern-func-info resumable */
     public function exec(string $statement): int|false;
 
+    public function prepare(string $query, array $options = []): ?PDOStatement;
+
     public function errorCode(): ?string;
     public function errorInfo(): (int|string)[];
 
 //     These methods are not supported yet:
 //
-//     public function prepare(string $query, array $options = []): ?PDOStatement;
 //     public function beginTransaction(): bool;
 //     public function commit(): bool;
 
@@ -11,9 +11,12 @@ class PDOStatement {
     public function fetch(): mixed;      // TODO: only default behaviour supported
     public function fetchAll(): mixed[]; // TODO: only default behaviour supported
 
+    /** @kphp-extern-func-info resumable */
+    public function execute(?array $params = null): bool;
+    public function closeCursor(): bool;
+
 //     These methods are not supported yet:
 //
-//     public function execute(?array $params = null): bool;
 //     public bindColumn(
 //         string|int $column,
 //         mixed &$var,
@@ -29,7 +32,6 @@ class PDOStatement {
 //         mixed $driverOptions = null
 //     ): bool
 //     public bindValue(string|int $param, mixed $value, int $type = PDO::PARAM_STR): bool
-//     public closeCursor(): bool
 //     public columnCount(): int
 //     public debugDumpParams(): ?bool
 //     public errorCode(): ?string
@@ -20,6 +20,7 @@
 #include "common/options.h"
 #include "common/precise-time.h"
 #include "common/kfs/kfs-binlog.h"
+#include "common/kfs/kfs.h"
 
 #include "common/binlog/kdb-binlog-common.h"
 
@@ -142,6 +143,7 @@ int bb_buffer_replay_log (bb_buffer_t *B, int set_now) {
     r = bb_buffer_work (B);
     vkprintf (3, "%s: bb_buffer_work returns 0x%x.\n", __func__, r);
   } while (r > 0);
+  kfs_bz_stop_read_ahead ();
   B->log_readto_pos = bb_buffer_log_cur_pos (B);
   if (B->log_readto_pos != B->log_last_wpos) {
     vkprintf (2, "replay binlog '%s' till %lld position, read binlog till %lld position.\n", B->replica->replica_prefix, B->log_last_rpos, B->log_last_wpos);
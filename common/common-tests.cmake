@@ -9,6 +9,7 @@ prepend(COMMON_TESTS_SOURCES ${COMMON_DIR}/
         allocators/lockfree-slab-test.cpp
         crc32c-test.cpp
         crypto/aes256-test.cpp
+        kfs/kfs-test.cpp
         parallel/counter-test.cpp
         parallel/limit-counter-test.cpp
         parallel/maximum-test.cpp
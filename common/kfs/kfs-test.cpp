@@ -0,0 +1,177 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2020 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "common/kfs/kfs.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+#include <gtest/gtest.h>
+
+#include "common/kfs/kfs-layout.h"
+
+namespace {
+
+// a zipped binlog without kfs headers, which is decoded by kfs_bz_decode() as the binlog replay does
+class ZippedBinlog {
+public:
+  explicit ZippedBinlog(long long orig_size) :
+    orig_(orig_size, '\0') {
+    std::mt19937 rng{42};
+    for (auto &c : orig_) {
+      c = static_cast<char>('a' + rng() % 4);
+    }
+
+    const int chunks = kfs_bz_get_chunks_no(orig_size);
+    header_.resize(kfs_bz_compute_header_size(orig_size));
+    auto *H = reinterpret_cast<kfs_binlog_zip_header_t *>(header_.data());
+    H->magic = KFS_BINLOG_ZIP_MAGIC;
+    H->format = kfs_bzf_zlib;
+    H->orig_file_size = orig_size;
+
+    std::vector<unsigned char> zipped;
+    std::vector<unsigned char> encoded(compressBound(KFS_BINLOG_ZIP_CHUNK_SIZE));
+    for (int chunk_no = 0; chunk_no < chunks; ++chunk_no) {
+      const long long chunk_offset = static_cast<long long>(chunk_no) << KFS_BINLOG_ZIP_CHUNK_SIZE_EXP;
+      const long long chunk_size = std::min<long long>(KFS_BINLOG_ZIP_CHUNK_SIZE, orig_size - chunk_offset);
+      uLongf encoded_size = encoded.size();
+      const int res = compress2(encoded.data(), &encoded_size, reinterpret_cast<const Bytef *>(orig_.data() + chunk_offset), chunk_size, 1);
+      assert(res == Z_OK);
+      H->chunk_offset[chunk_no] = header_.size() + zipped.size();
+      zipped.insert(zipped.end(), encoded.begin(), encoded.begin() + encoded_size);
+    }
+
+    char path[] = "/tmp/kfs-test-XXXXXX";
+    file_.fd = mkstemp(path);
+    assert(file_.fd >= 0);
+    unlink(path);
+    ssize_t written = write(file_.fd, header_.data(), header_.size());
+    assert(written == static_cast<ssize_t>(header_.size()));
+    written = write(file_.fd, zipped.data(), zipped.size());
+    assert(written == static_cast<ssize_t>(zipped.size()));
+
+    memset(&info_, 0, sizeof(info_));
+    info_.filename = filename_;
+    info_.start = header_.data();
+    info_.file_size = header_.size() + zipped.size();
+    file_.info = &info_;
+    file_.offset = 0;
+  }
+
+  ~ZippedBinlog() {
+    kfs_bz_stop_read_ahead();
+    close(file_.fd);
+  }
+
+  // reads the binlog from the offset like the replay does, returns the decoded bytes
+  std::string read(long long off, int len) const {
+    std::string buffer(len, '\0');
+    int dest_len = len;
+    EXPECT_GE(kfs_bz_decode(&file_, off, &buffer[0], &dest_len, nullptr), 0);
+    buffer.resize(dest_len);
+    return buffer;
+  }
+
+  void expect_read(long long off, int len) const {
+    const std::string decoded = read(off, len);
+    ASSERT_GT(decoded.size(), 0);
+    ASSERT_TRUE(decoded == orig_.substr(off, decoded.size())) << "offset " << off;
+  }
+
+  void expect_replay() const {
+    long long off = 0;
+    while (off < static_cast<long long>(orig_.size())) {
+      const std::string decoded = read(off, KFS_BINLOG_ZIP_CHUNK_SIZE);
+      ASSERT_GT(decoded.size(), 0);
+      ASSERT_TRUE(decoded == orig_.substr(off, decoded.size())) << "offset " << off;
+      off += decoded.size();
+    }
+    ASSERT_EQ(off, orig_.size());
+    kfs_bz_stop_read_ahead();
+  }
+
+private:
+  char filename_[16] = "test.bin.bz";
+  std::string orig_;
+  std::vector<char> header_;
+  kfs_file_info info_;
+  mutable kfs_file file_;
+};
+
+constexpr long long chunk = KFS_BINLOG_ZIP_CHUNK_SIZE;
+
+class KfsBzReadAheadTest : public ::testing::Test {
+protected:
+  static void SetUpTestSuite() {
+    binlog_ = new ZippedBinlog{5 * chunk + 12345};
+  }
+
+  static void TearDownTestSuite() {
+    delete binlog_;
+    binlog_ = nullptr;
+  }
+
+  void TearDown() override {
+    kfs_bz_set_read_ahead(3);
+  }
+
+  static ZippedBinlog *binlog_;
+};
+
+ZippedBinlog *KfsBzReadAheadTest::binlog_ = nullptr;
+
+} // namespace
+
+TEST_F(KfsBzReadAheadTest, replay_without_read_ahead) {
+  kfs_bz_set_read_ahead(0);
+  binlog_->expect_replay();
+}
+
+TEST_F(KfsBzReadAheadTest, replay_with_read_ahead) {
+  for (int depth : {1, 3, 8}) {
+    kfs_bz_set_read_ahead(depth);
+    ASSERT_NO_FATAL_FAILURE(binlog_->expect_replay()) << "depth " << depth;
+  }
+}
+
+TEST_F(KfsBzReadAheadTest, several_chunks_at_once) {
+  kfs_bz_set_read_ahead(3);
+  binlog_->expect_read(0, 3 * chunk);
+  binlog_->expect_read(3 * chunk, 3 * chunk);
+  kfs_bz_stop_read_ahead();
+}
+
+TEST_F(KfsBzReadAheadTest, seeks_fall_back_to_sync_decoding) {
+  kfs_bz_set_read_ahead(3);
+  binlog_->expect_read(0, chunk);
+  // forward over the scheduled chunks, then back and into the middle of a chunk
+  binlog_->expect_read(4 * chunk, chunk);
+  binlog_->expect_read(chunk, chunk);
+  binlog_->expect_read(2 * chunk + 100, chunk);
+  binlog_->expect_read(3 * chunk, chunk);
+  binlog_->expect_read(5 * chunk, chunk);
+  kfs_bz_stop_read_ahead();
+}
+
+TEST_F(KfsBzReadAheadTest, stop_in_the_middle_of_replay) {
+  kfs_bz_set_read_ahead(3);
+  binlog_->expect_read(0, chunk);
+  binlog_->expect_read(chunk, chunk);
+  // the scheduled chunks are dropped, the replay goes on with the sync decoding and schedules the next ones again
+  kfs_bz_stop_read_ahead();
+  binlog_->expect_read(2 * chunk, chunk);
+  kfs_bz_stop_read_ahead();
+  kfs_bz_stop_read_ahead();
+  binlog_->expect_read(3 * chunk, chunk);
+  binlog_->expect_read(4 * chunk, chunk);
+  binlog_->expect_read(5 * chunk, chunk);
+  kfs_bz_stop_read_ahead();
+}
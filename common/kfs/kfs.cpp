@@ -19,6 +19,13 @@
 #include <unistd.h>
 #include <zlib.h>
 #include <zstd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "common/binlog/kdb-binlog-common.h"
 #include "common/binlog/snapshot-shifts.h"
@@ -466,10 +473,13 @@ bool preload_file_info(struct kfs_file_info *FI) {
   return fd == -1;
 }
 
+static void kfs_bz_stop_read_ahead_of(const struct kfs_file *F);
+
 int kfs_close_file(kfs_file_handle_t F, bool close_handle) {
   if (!F) {
     return 0;
   }
+  kfs_bz_stop_read_ahead_of(F);
   if (F->fd >= 0) {
     if (close_handle) {
       int r = close(F->fd);
@@ -505,6 +515,257 @@ static void free_decode_buffers() {
   }
 }
 
+// reads and decodes a chunk into dst, which has room for expected_output_bytes;
+// the file offset is not changed, so chunks of the same file may be decoded by several threads at once
+static int kfs_bz_decode_chunk(const struct kfs_file *F, int chunk_no, int expected_output_bytes, unsigned char *src, void *dst, int *disk_bytes_read) {
+  const struct kfs_file_info *FI = F->info;
+  const kfs_binlog_zip_header_t *H = kfs_get_binlog_zip_header(FI);
+  const int chunks = kfs_bz_get_chunks_no(H->orig_file_size);
+  const long long chunk_size = (chunk_no < chunks - 1
+                                ? H->chunk_offset[chunk_no + 1]
+                                : FI->file_size - sizeof(struct kfs_file_header) * FI->kfs_headers) - H->chunk_offset[chunk_no];
+  const long long chunk_offset = H->chunk_offset[chunk_no] + F->offset;
+  if (chunk_size <= 0) {
+    kprintf("not positive chunk size (%lld), broken header(?), file: %s\n, chunk: %d, chunk_offset: %lld\n",
+            chunk_size, FI->filename, chunk_no, chunk_offset);
+    return -1;
+  }
+  if (chunk_size > KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE) {
+    kprintf("chunk size (%lld) > KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE (%d), file: %s, chunk: %d, chunk_offset: %lld\n",
+            chunk_size, KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE, FI->filename, chunk_no, chunk_offset);
+    return -1;
+  }
+
+  vkprintf(3, "chunk_no: %d, chunks: %d, chunk_size: %lld, chunk_off: %lld\n", chunk_no, chunks, chunk_size, chunk_offset);
+  ssize_t r = pread(F->fd, src, chunk_size, chunk_offset);
+  if (r < 0) {
+    kprintf("read chunk (%d), offset %lld of file '%s' failed. %m\n", chunk_no, chunk_offset, FI->filename);
+    return -1;
+  }
+  if (disk_bytes_read) {
+    *disk_bytes_read += r;
+  }
+  if (r != chunk_size) {
+    kprintf("read only %lld of expected %lld bytes, chunk (%d), offset %lld, file '%s'.\n",
+            (long long)r, chunk_size, chunk_no, chunk_offset, FI->filename);
+    return -1;
+  }
+  if (FI->iv) {
+    kfs_replica_handle_t R = FI->replica;
+    assert (R && R->ctx_crypto);
+    R->ctx_crypto->ctr_crypt(R->ctx_crypto, src, src, chunk_size, FI->iv, chunk_offset);
+  }
+  vkprintf(2, "read %lld bytes from the file '%s', chunk: %d.\n", (long long)r, FI->filename, chunk_no);
+
+  int m = expected_output_bytes;
+  switch (H->format & 15) {
+    case kfs_bzf_zlib: {
+      uLongf destLen = m;
+      int res = uncompress(static_cast<unsigned char*>(dst), &destLen, src, chunk_size);
+      if (res != Z_OK) {
+        kprintf("uncompress returns error code %d, chunk %d, offset %lld, file '%s'.\n", res, chunk_no, chunk_offset, FI->filename);
+        return -1;
+      }
+      m = (int)destLen;
+      break;
+    }
+    default:
+      kprintf("Unimplemented format '%d' in the file '%s'.\n", H->format & 15, FI->filename);
+      return -1;
+  }
+  if (expected_output_bytes != m) {
+    kprintf("expected chunks size is %d, but decoded bytes number is %d, file: '%s', chunk_no: %d, chunk_offset: %lld\n",
+            expected_output_bytes, m, FI->filename, chunk_no, chunk_offset);
+    return -1;
+  }
+  return m;
+}
+
+static int kfs_bz_expected_chunk_size(const kfs_binlog_zip_header_t *H, int chunk_no) {
+  const int chunks = kfs_bz_get_chunks_no(H->orig_file_size);
+  return chunk_no == chunks - 1 ? (H->orig_file_size & (KFS_BINLOG_ZIP_CHUNK_SIZE - 1)) : KFS_BINLOG_ZIP_CHUNK_SIZE;
+}
+
+namespace {
+
+// Chunks following the one being read are decoded in the background, so replaying a zipped binlog
+// is not bound by a single core decompression: zlib checks the adler32 of each chunk on the same threads.
+// Chunks are decoded by a small pool of threads, which live only while the binlog is being replayed,
+// see kfs_bz_stop_read_ahead(); each scheduled chunk takes a buffer of about 33MB.
+class BzReadAhead {
+public:
+  // returns the decoded size or -1 if the chunk is decoded, and -2 if it's not scheduled
+  int take(const struct kfs_file *F, int chunk_no, void *dst, int *disk_bytes_read) {
+    if (file_ != F || chunks_.empty() || chunks_.front()->chunk_no != chunk_no) {
+      cancel();
+      return -2;
+    }
+    std::unique_ptr<Chunk> chunk = std::move(chunks_.front());
+    chunks_.pop_front();
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      decoded_.wait(lock, [&chunk] { return chunk->decoded; });
+    }
+    if (disk_bytes_read) {
+      *disk_bytes_read += chunk->result.disk_bytes_read;
+    }
+    if (chunk->result.size > 0) {
+      memcpy(dst, chunk->buffer.get() + KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE, chunk->result.size);
+    }
+    free_buffers_.emplace_back(std::move(chunk->buffer));
+    return chunk->result.size;
+  }
+
+  // schedules decoding of chunks after the current one
+  void schedule(const struct kfs_file *F, int current_chunk_no) {
+    if (!depth_) {
+      return;
+    }
+    if (workers_.empty()) {
+      const int workers = std::max(1, std::min<int>(depth_, std::thread::hardware_concurrency()));
+      for (int i = 0; i < workers; ++i) {
+        workers_.emplace_back([this] { work(); });
+      }
+    }
+    const kfs_binlog_zip_header_t *H = kfs_get_binlog_zip_header(F->info);
+    const int chunks = kfs_bz_get_chunks_no(H->orig_file_size);
+    file_ = F;
+    int chunk_no = chunks_.empty() ? current_chunk_no + 1 : chunks_.back()->chunk_no + 1;
+    for (; chunk_no < chunks && chunk_no <= current_chunk_no + depth_; ++chunk_no) {
+      auto chunk = std::make_unique<Chunk>();
+      chunk->file = F;
+      chunk->chunk_no = chunk_no;
+      chunk->expected_output_bytes = kfs_bz_expected_chunk_size(H, chunk_no);
+      if (free_buffers_.empty()) {
+        chunk->buffer.reset(new unsigned char[KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE + KFS_BINLOG_ZIP_CHUNK_SIZE]);
+      } else {
+        chunk->buffer = std::move(free_buffers_.back());
+        free_buffers_.pop_back();
+      }
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        pending_.push_back(chunk.get());
+      }
+      has_pending_.notify_one();
+      chunks_.emplace_back(std::move(chunk));
+    }
+  }
+
+  // drops the scheduled chunks, waits for the ones being decoded and keeps the buffers for the next chunks
+  void cancel() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    pending_.clear();
+    decoded_.wait(lock, [this] { return decoding_ == 0; });
+    lock.unlock();
+    for (auto &chunk : chunks_) {
+      free_buffers_.emplace_back(std::move(chunk->buffer));
+    }
+    chunks_.clear();
+    file_ = nullptr;
+  }
+
+  // joins the decoding threads and frees the memory
+  void stop() {
+    cancel();
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+    }
+    has_pending_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+    stopping_ = false;
+    free_buffers_.clear();
+  }
+
+  void stop(const struct kfs_file *F) {
+    if (file_ == F) {
+      stop();
+    }
+  }
+
+  void set_depth(int depth) {
+    stop();
+    depth_ = depth;
+  }
+
+private:
+  struct DecodeResult {
+    int size{-1};
+    int disk_bytes_read{0};
+  };
+
+  struct Chunk {
+    const struct kfs_file *file{nullptr};
+    int chunk_no{0};
+    int expected_output_bytes{0};
+    // the encoded chunk followed by the decoded one
+    std::unique_ptr<unsigned char[]> buffer;
+    DecodeResult result;
+    // guarded by mutex_
+    bool decoded{false};
+  };
+
+  void work() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    while (true) {
+      has_pending_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        return;
+      }
+      Chunk *chunk = pending_.front();
+      pending_.pop_front();
+      ++decoding_;
+      lock.unlock();
+
+      unsigned char *src = chunk->buffer.get();
+      DecodeResult result;
+      result.size = kfs_bz_decode_chunk(chunk->file, chunk->chunk_no, chunk->expected_output_bytes,
+                                        src, src + KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE, &result.disk_bytes_read);
+
+      lock.lock();
+      chunk->result = result;
+      chunk->decoded = true;
+      --decoding_;
+      decoded_.notify_all();
+    }
+  }
+
+  const struct kfs_file *file_{nullptr};
+  // owned by the replaying thread, in the order of chunks
+  std::deque<std::unique_ptr<Chunk>> chunks_;
+  std::vector<std::unique_ptr<unsigned char[]>> free_buffers_;
+  std::vector<std::thread> workers_;
+  int depth_{3};
+
+  std::mutex mutex_;
+  std::condition_variable has_pending_;
+  std::condition_variable decoded_;
+  // chunks which are not taken by the decoding threads yet
+  std::deque<Chunk *> pending_;
+  int decoding_{0};
+  bool stopping_{false};
+};
+
+BzReadAhead bz_read_ahead;
+
+} // namespace
+
+void kfs_bz_set_read_ahead(int chunks) {
+  assert (chunks >= 0);
+  bz_read_ahead.set_depth(chunks);
+}
+
+void kfs_bz_stop_read_ahead() {
+  bz_read_ahead.stop();
+}
+
+static void kfs_bz_stop_read_ahead_of(const struct kfs_file *F) {
+  bz_read_ahead.stop(F);
+}
+
 int kfs_bz_decode(const struct kfs_file *F, long long off, void *dst, int *dest_len, int *disk_bytes_read) {
   assert (F->offset == 0 || F->offset == 4096 || F->offset == 8192);
   vkprintf(3, "F.offset = %lld, off = %lld, dst = %p, *dest_len = %d\n", F->offset, off, dst, *dest_len);
@@ -514,7 +775,7 @@ int kfs_bz_decode(const struct kfs_file *F, long long off, void *dst, int *dest_
   const struct kfs_file_info *FI = F->info;
   const kfs_binlog_zip_header_t *H = kfs_get_binlog_zip_header(FI);
   assert (H);
-  const int chunks = kfs_bz_get_chunks_no(H->orig_file_size), fd = F->fd;
+  const int chunks = kfs_bz_get_chunks_no(H->orig_file_size);
 
   if (off < 0) {
     kprintf("negative file offset '%lld', file '%s'.\n", off, FI->filename);
@@ -542,77 +803,25 @@ int kfs_bz_decode(const struct kfs_file *F, long long off, void *dst, int *dest_
   int o = off & (KFS_BINLOG_ZIP_CHUNK_SIZE - 1);
 
   while (chunk_no < chunks) {
-    const long long chunk_size = (chunk_no < chunks - 1
-                                  ? H->chunk_offset[chunk_no + 1]
-                                  : FI->file_size - sizeof(struct kfs_file_header) * FI->kfs_headers) - H->chunk_offset[chunk_no];
-    const long long chunk_offset = H->chunk_offset[chunk_no] + F->offset;
-    if (chunk_size <= 0) {
-      kprintf("not positive chunk size (%lld), broken header(?), file: %s\n, chunk: %d, chunk_offset: %lld\n",
-              chunk_size, FI->filename, chunk_no, chunk_offset);
-      return -1;
-    }
-    if (chunk_size > KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE) {
-      kprintf("chunk size (%lld) > KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE (%d), file: %s, chunk: %d, chunk_offset: %lld\n",
-              chunk_size, KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE, FI->filename, chunk_no, chunk_offset);
-      return -1;
-    }
-
-    int expected_output_bytes = chunk_no == chunks - 1 ? (H->orig_file_size & (KFS_BINLOG_ZIP_CHUNK_SIZE - 1)) : KFS_BINLOG_ZIP_CHUNK_SIZE;
+    int expected_output_bytes = kfs_bz_expected_chunk_size(H, chunk_no);
 
     if (avail_out < expected_output_bytes) {
       break;
     }
 
-    vkprintf(3, "chunk_no: %d, chunks: %d, chunk_size: %lld, chunk_off: %lld\n", chunk_no, chunks, chunk_size, chunk_offset);
-    if (lseek(fd, chunk_offset, SEEK_SET) != chunk_offset) {
-      kprintf("lseek to chunk (%d), offset %lld of file '%s' failed. %m\n", chunk_no, chunk_offset, FI->filename);
-      return -1;
-    }
-    static __thread unsigned char *src;
-    if (src == NULL) {
-      src = alloc_buffer(KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE);
-    }
-    ssize_t r = read(fd, src, chunk_size);
-    if (r < 0) {
-      kprintf("read chunk (%d), offset %lld of file '%s' failed. %m\n", chunk_no, chunk_offset, FI->filename);
-      return -1;
-    }
-    if (disk_bytes_read) {
-      *disk_bytes_read += r;
-    }
-    if (r != chunk_size) {
-      kprintf("read only %lld of expected %lld bytes, chunk (%d), offset %lld, file '%s'.\n",
-              (long long)r, chunk_size, chunk_no, chunk_offset, FI->filename);
-      return -1;
-    }
-    if (FI->iv) {
-      kfs_replica_handle_t R = FI->replica;
-      assert (R && R->ctx_crypto);
-      R->ctx_crypto->ctr_crypt(R->ctx_crypto, src, src, chunk_size, FI->iv, chunk_offset);
-    }
-    vkprintf(2, "read %lld bytes from the file '%s', chunk: %d.\n", (long long)r, FI->filename, chunk_no);
-
-    int m = expected_output_bytes;
-    switch (H->format & 15) {
-      case kfs_bzf_zlib: {
-        uLongf destLen = m;
-        int res = uncompress(static_cast<unsigned char*>(dst), &destLen, src, chunk_size);
-        if (res != Z_OK) {
-          kprintf("uncompress returns error code %d, chunk %d, offset %lld, file '%s'.\n", res, chunk_no, chunk_offset, FI->filename);
-          return -1;
-        }
-        m = (int)destLen;
-        break;
+    int m = bz_read_ahead.take(F, chunk_no, dst, disk_bytes_read);
+    if (m == -2) {
+      static __thread unsigned char *src;
+      if (src == NULL) {
+        src = alloc_buffer(KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE);
       }
-      default:
-        kprintf("Unimplemented format '%d' in the file '%s'.\n", H->format & 15, FI->filename);
-        return -1;
+      m = kfs_bz_decode_chunk(F, chunk_no, expected_output_bytes, src, dst, disk_bytes_read);
     }
-    if (expected_output_bytes != m) {
-      kprintf("expected chunks size is %d, but decoded bytes number is %d, file: '%s', chunk_no: %d, chunk_offset: %lld\n",
-              expected_output_bytes, m, FI->filename, chunk_no, chunk_offset);
+    if (m < 0) {
+      bz_read_ahead.stop();
       return -1;
     }
+    bz_read_ahead.schedule(F, chunk_no);
 
     int w = -1;
     if (o > 0) {
@@ -29,6 +29,11 @@ int kfs_count_headers(const struct kfs_file_header *kfs_Hdr, int r, int strict_c
 int kfs_bz_get_chunks_no(long long orig_file_size);
 int kfs_bz_compute_header_size(long long orig_file_size);
 int kfs_bz_decode(const struct kfs_file *F, long long off, void *dst, int *dest_len, int *disk_bytes_read);
+/* chunks following the decoded one are decoded ahead in background threads, 0 disables it;
+   each of them takes a buffer of about 33MB until kfs_bz_stop_read_ahead() */
+void kfs_bz_set_read_ahead(int chunks);
+/* waits for background decoding and frees its buffers, must be called before fork */
+void kfs_bz_stop_read_ahead();
 
 int kfs_file_compute_initialization_vector(struct kfs_file_info *FI);
 
@@ -8,6 +8,7 @@
 
 #include "compiler/code-gen/common.h"
 #include "compiler/code-gen/files/json-encoder-tags.h"
+#include "compiler/code-gen/files/vars-reset.h"
 #include "compiler/code-gen/files/tl2cpp/tl2cpp-utils.h"
 #include "compiler/code-gen/includes.h"
 #include "compiler/code-gen/namespace.h"
@@ -49,6 +50,9 @@ void VarDeclaration::compile(CodeGenerator &W) const {
   kphp_assert(type->ptype() != tp_void);
 
   W << (extern_flag ? "extern " : "") << TypeName(type) << " " << VarName(var);
+  if (!extern_flag && GlobalVarsReset::is_plain_data_var(var)) {
+    W << " PLAIN_DATA_GLOBAL";
+  }
 
   if (defval_flag) {
     if (vk::any_of_equal(type->ptype(), tp_float, tp_int, tp_future, tp_future_queue)) {
@@ -591,6 +595,7 @@ void ClassDeclaration::compile_inner_methods(CodeGenerator &W, ClassPtr klass) {
   compile_msgpack_serialize(W, klass);
   compile_msgpack_deserialize(W, klass);
   compile_virtual_builtin_functions(W, klass);
+  compile_virt_dispatch_slots(W, klass);
   compile_wakeup(W, klass);
 }
 
@@ -863,6 +868,30 @@ void ClassDeclaration::compile_virtual_builtin_functions(CodeGenerator &W, Class
                        klass->src_name + "* virtual_builtin_clone()", "new " + klass->src_name + "{*this}");
 }
 
+// every class of a hierarchy dispatched over dense slots (see generate-virtual-methods.cpp) returns its slot
+// from the overload tagged by the root class: each class declares the overloads of all its hierarchies, so none of them are hidden
+void ClassDeclaration::compile_virt_dispatch_slots(CodeGenerator &W, ClassPtr klass) {
+  for (const auto &root_and_slot : klass->virt_dispatch_slots) {
+    const ClassPtr root = root_and_slot.first;
+    const int slot = root_and_slot.second;
+    const bool is_root = root == klass;
+    const bool has_derived = !klass->derived_classes.empty();
+
+    FunctionSignatureGenerator &&signature = FunctionSignatureGenerator(W).set_const_this()
+      .set_is_virtual(is_root)
+      .set_final(!is_root && !has_derived && slot)
+      .set_overridden(!is_root && (has_derived || !slot))
+      .set_pure_virtual(!slot)
+      << fmt_format("int get_virt_dispatch_slot(const {} *)", root->src_name);
+
+    if (!slot) {
+      std::move(signature) << SemicolonAndNL{} << NL;
+    } else {
+      std::move(signature) << BEGIN << "return " << slot << SemicolonAndNL{} << END << NL << NL;
+    }
+  }
+}
+
 void ClassDeclaration::compile_wakeup(CodeGenerator &W, ClassPtr klass) {
   const auto *m_wakeup = klass->members.get_instance_method("__wakeup");
   if (!m_wakeup || klass->is_interface()) {
@@ -129,6 +129,7 @@ private:
   static void compile_msgpack_serialize(CodeGenerator &W, ClassPtr klass);
   static void compile_msgpack_deserialize(CodeGenerator &W, ClassPtr klass);
   static void compile_virtual_builtin_functions(CodeGenerator &W, ClassPtr klass);
+  static void compile_virt_dispatch_slots(CodeGenerator &W, ClassPtr klass);
   static void compile_wakeup(CodeGenerator &W, ClassPtr klass);
 
   template<class ReturnValueT>
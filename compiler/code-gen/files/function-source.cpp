@@ -9,7 +9,9 @@
 #include "compiler/code-gen/includes.h"
 #include "compiler/code-gen/namespace.h"
 #include "compiler/code-gen/naming.h"
+#include "compiler/code-gen/raw-data.h"
 #include "compiler/code-gen/vertex-compiler.h"
+#include "compiler/data/src-file.h"
 #include "compiler/stage.h"
 
 FunctionCpp::FunctionCpp(FunctionPtr function) :
@@ -34,6 +36,20 @@ void declare_static_vars(FunctionPtr function, CodeGenerator &W) {
   }
 }
 
+// lets the sampling profiler map native frames to php functions, see runtime/sampling-profiler.h
+static void compile_function_symbol(FunctionPtr function, CodeGenerator &W) {
+  if (function->is_resumable) {
+    return;
+  }
+  const auto &location = function->root->get_location();
+  W << "static const PhpFunctionSymbol " << FunctionName(function) << "$symbol PHP_FUNCTION_SYMBOL = " << BEGIN
+    << "reinterpret_cast<const void *>(" << FunctionName(function) << ")," << NL
+    << RawString(function->as_human_readable(false)) << "," << NL
+    << RawString(location.file ? location.file->relative_file_name : "unknown file") << "," << NL
+    << std::max(location.line, 0) << NL
+    << END << ";" << NL;
+}
+
 void FunctionCpp::compile(CodeGenerator &W) const {
   if (function->is_inline) {
     return;
@@ -57,6 +73,7 @@ void FunctionCpp::compile(CodeGenerator &W) const {
   W << UnlockComments();
   W << function->root << NL;
   W << LockComments();
+  compile_function_symbol(function, W);
 
   W << CloseNamespace();
   W << CloseFile();
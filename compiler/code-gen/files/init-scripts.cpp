@@ -13,6 +13,7 @@
 #include "compiler/code-gen/raw-data.h"
 #include "compiler/data/lib-data.h"
 #include "compiler/data/src-file.h"
+#include "compiler/gentree.h"
 
 struct StaticInit {
   void compile(CodeGenerator &W) const;
@@ -215,6 +216,24 @@ void InitScriptsCpp::compile(CodeGenerator &W) const {
 
   W << FunctionName(main_file_id->main_function) << "$global_reset();" << NL;
 
+  // kphp libs are compiled separately, they may use any superglobals
+  const auto libs = G->get_libs();
+  const bool has_kphp_libs = std::any_of(libs.begin(), libs.end(), [](LibPtr lib) { return lib && !lib->is_raw_php(); });
+  if (!has_kphp_libs) {
+    std::vector<std::string> used_superglobals;
+    for (VarPtr var : G->get_global_vars()) {
+      if (GenTree::is_superglobal(var->name)) {
+        used_superglobals.emplace_back(var->name);
+      }
+    }
+    std::sort(used_superglobals.begin(), used_superglobals.end());
+    W << "set_used_superglobals({";
+    for (size_t i = 0; i != used_superglobals.size(); ++i) {
+      W << (i ? ", " : "") << RawString{used_superglobals[i]};
+    }
+    W << "});" << NL;
+  }
+
   W << "set_script ("
     << FunctionName(main_file_id->main_function) << "$run, "
     << FunctionName(main_file_id->main_function) << "$global_reset);" << NL;
@@ -11,13 +11,23 @@
 #include "compiler/code-gen/vertex-compiler.h"
 #include "compiler/data/class-data.h"
 #include "compiler/data/src-file.h"
+#include "compiler/data/var-data.h"
 #include "compiler/data/vars-collector.h"
+#include "compiler/inferring/public.h"
 #include "compiler/vertex.h"
 
 GlobalVarsReset::GlobalVarsReset(SrcFilePtr main_file) :
   main_file_(main_file) {
 }
 
+bool GlobalVarsReset::is_plain_data_var(VarPtr var) {
+  if (!var->is_in_global_scope() || var->is_builtin_global() || G->settings().is_static_lib_mode()) {
+    return false;
+  }
+  const TypeData *type = tinf::get_type(var);
+  return vk::any_of_equal(type->ptype(), tp_int, tp_float, tp_bool) && !type->use_optional() && !var->needs_const_iterator_flag;
+}
+
 void GlobalVarsReset::declare_extern_for_init_val(VertexPtr v, std::set<VarPtr> &externed_vars, CodeGenerator &W) {
   if (auto var_vertex = v.try_as<op_var>()) {
     VarPtr var = var_vertex->var_id;
@@ -47,22 +57,31 @@ void GlobalVarsReset::compile_part(FunctionPtr func, const std::set<VarPtr> &use
     }
   }
 
-  FunctionSignatureGenerator(W) << "void " << GlobalVarsResetFuncName(func, part_i) << " " << BEGIN;
-  for (auto var : used_vars) {
-    if (G->settings().is_static_lib_mode() && var->is_builtin_global()) {
-      continue;
+  auto compile_reset_vars = [&](bool plain_data) {
+    FunctionSignatureGenerator(W) << "void " << GlobalVarsResetFuncName(func, part_i, plain_data) << " " << BEGIN;
+    for (auto var : used_vars) {
+      if (G->settings().is_static_lib_mode() && var->is_builtin_global()) {
+        continue;
+      }
+      if (is_plain_data_var(var) != plain_data) {
+        continue;
+      }
+
+      W << "hard_reset_var(" << VarName(var);
+      //FIXME: brk and comments
+      if (var->init_val) {
+        W << ", " << var->init_val;
+      }
+      W << ");" << NL;
     }
+    W << END;
+    W << NL;
+  };
 
-    W << "hard_reset_var(" << VarName(var);
-    //FIXME: brk and comments
-    if (var->init_val) {
-      W << ", " << var->init_val;
-    }
-    W << ");" << NL;
+  compile_reset_vars(false);
+  if (!G->settings().is_static_lib_mode()) {
+    compile_reset_vars(true);
   }
-
-  W << END;
-  W << NL;
   W << CloseNamespace();
 }
 
@@ -75,6 +94,15 @@ void GlobalVarsReset::compile_func(FunctionPtr func, int parts_n, CodeGenerator
     W << GlobalVarsResetFuncName(func, i) << ";" << NL;
   }
 
+  if (!G->settings().is_static_lib_mode()) {
+    W << "reset_plain_data_globals([] " << BEGIN;
+    for (int i = 0; i < parts_n; i++) {
+      W << "void " << GlobalVarsResetFuncName(func, i, true) << ";" << NL;
+      W << GlobalVarsResetFuncName(func, i, true) << ";" << NL;
+    }
+    W << END << ");" << NL;
+  }
+
   W << END;
   W << NL;
   W << CloseNamespace();
@@ -20,6 +20,9 @@ struct GlobalVarsReset : CodeGenRootCmd {
 
   static void declare_extern_for_init_val(VertexPtr v, std::set<VarPtr> &externed_vars, CodeGenerator &W);
 
+  // such globals are defined in a separate section and reset all at once, see reset_plain_data_globals()
+  static bool is_plain_data_var(VarPtr var);
+
 private:
   SrcFilePtr main_file_;
 };
@@ -213,12 +213,16 @@ struct VarName {
 };
 
 struct GlobalVarsResetFuncName {
-  explicit GlobalVarsResetFuncName(FunctionPtr main_func, int part = -1) :
+  explicit GlobalVarsResetFuncName(FunctionPtr main_func, int part = -1, bool plain_data = false) :
     main_func_(main_func),
-    part_(part) {}
+    part_(part),
+    plain_data_(plain_data) {}
 
   void compile(CodeGenerator &W) const {
     W << FunctionName(main_func_) << "$global_vars_reset";
+    if (plain_data_) {
+      W << "_plain_data";
+    }
     if (part_ >= 0) {
       W << std::to_string(part_);
     }
@@ -228,4 +232,5 @@ struct GlobalVarsResetFuncName {
 private:
   const FunctionPtr main_func_;
   const int part_{-1};
+  const bool plain_data_{false};
 };
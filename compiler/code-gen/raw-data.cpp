@@ -122,7 +122,7 @@ std::vector<int> compile_arrays_raw_representation(const std::vector<VarPtr> &co
     W << "{ .is = { .a = 0, .b = " << ExtraRefCnt::for_global_const << "}},";
     // max_key
     W << "{ .i64 = " << array_size - 1 << "},";
-    // end_.next, end_.prev
+    // used_entries, first_entry
     W << "{ .is = { .a = 0, .b = 0}},";
 
     // int_size, int_buf_size
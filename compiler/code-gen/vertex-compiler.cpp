@@ -1385,6 +1385,11 @@ void compile_function(VertexAdaptor<op_function> func_root, CodeGenerator &W) {
 
   compile_tracing_profiler(func, W);
 
+  // declared before local vars to be destroyed after them
+  for (int i = 0; i < func->stack_instances.size(); ++i) {
+    W << "stack_instance_storage<" << func->stack_instances[i]->src_name << "> stack_instance$" << i << ";" << NL;
+  }
+
   for (auto var : func->local_var_ids) {
     if (var->type() != VarData::var_local_inplace_t && !var->is_foreach_reference) {
       W << VarDeclaration(var);
@@ -2150,6 +2155,10 @@ void compile_common_op(VertexPtr root, CodeGenerator &W) {
     case op_alloc: {
       const TypeData *tp = tinf::get_type(root);
       kphp_assert(tp->ptype() == tp_Class);
+      if (root.as<op_alloc>()->stack_instance_id >= 0) {
+        W << "stack_instance$" << root.as<op_alloc>()->stack_instance_id << ".alloc()";
+        break;
+      }
       const auto *alloc_function = tp->class_type()->is_empty_class() ? "().empty_alloc()" : "().alloc()";
       W << TypeName(tp) << alloc_function;
       break;
@@ -103,6 +103,7 @@ prepend(KPHP_COMPILER_PIPES_SOURCES pipes/
         calc-empty-functions.cpp
         calc-func-dep.cpp
         calc-locations.cpp
+        calc-non-escaping-instances.cpp
         calc-real-defines-values.cpp
         calc-rl.cpp
         calc-val-ref.cpp
@@ -142,12 +143,14 @@ prepend(KPHP_COMPILER_PIPES_SOURCES pipes/
         instantiate-generics-and-lambdas.cpp
         instantiate-ffi-operations.cpp
         load-files.cpp
+        move-last-usages.cpp
         optimization.cpp
         parse.cpp
         parse-and-apply-phpdoc.cpp
         preprocess-break.cpp
         preprocess-eq3.cpp
         preprocess-exceptions.cpp
+        propagate-const-args.cpp
         propagate-throw-flag.cpp
         register-defines.cpp
         register-kphp-configuration.cpp
@@ -32,6 +32,7 @@
 #include "compiler/pipes/calc-const-types.h"
 #include "compiler/pipes/calc-empty-functions.h"
 #include "compiler/pipes/calc-locations.h"
+#include "compiler/pipes/calc-non-escaping-instances.h"
 #include "compiler/pipes/calc-real-defines-values.h"
 #include "compiler/pipes/calc-rl.h"
 #include "compiler/pipes/calc-val-ref.h"
@@ -73,12 +74,14 @@
 #include "compiler/pipes/inline-defines-usages.h"
 #include "compiler/pipes/inline-simple-functions.h"
 #include "compiler/pipes/load-files.h"
+#include "compiler/pipes/move-last-usages.h"
 #include "compiler/pipes/optimization.h"
 #include "compiler/pipes/parse-and-apply-phpdoc.h"
 #include "compiler/pipes/parse.h"
 #include "compiler/pipes/preprocess-break.h"
 #include "compiler/pipes/preprocess-eq3.h"
 #include "compiler/pipes/preprocess-exceptions.h"
+#include "compiler/pipes/propagate-const-args.h"
 #include "compiler/pipes/propagate-throw-flag.h"
 #include "compiler/pipes/register-defines.h"
 #include "compiler/pipes/register-ffi-scopes.h"
@@ -263,6 +266,8 @@ bool compiler_execute(CompilerSettings *settings) {
     >> PassC<RemoveEmptyFunctionCallsPass>{}
     >> PassC<PreprocessBreakPass>{}
     >> PassC<ConvertSprintfCallsPass>{}
+    >> PassC<CollectConstArgsPass>{}
+    >> SyncC<PropagateConstArgsF>{}
     >> PassC<CalcConstTypePass>{}
     >> PassC<CollectConstVarsPass>{}
     >> PassC<ConvertListAssignmentsPass>{}
@@ -284,6 +289,8 @@ bool compiler_execute(CompilerSettings *settings) {
     >> PassC<CalcValRefPass>{}
     >> PassC<CalcFuncDepPass>{}
     >> SyncC<CalcBadVarsF>{}
+    >> PassC<CollectNonEscapingInstancesPass>{}
+    >> SyncC<CalcNonEscapingInstancesF>{}
     >> PipeC<CheckUBF>{}
     >> PassC<ExtractResumableCallsPass>{}
     >> PassC<ExtractAsyncPass>{}
@@ -294,6 +301,7 @@ bool compiler_execute(CompilerSettings *settings) {
     >> PassC<CheckAccessModifiersPass>{}
     >> PassC<AnalyzePerformance>{}
     >> PassC<FinalCheckPass>{}
+    >> PassC<MoveLastUsagesPass>{}
     >> PassC<CollectForkableTypesPass>{}
     >> SyncC<CodeGenF>{}              // create all codegen commands and launch them in "just calc hashes" mode
     >> PipeC<CodeGenForDiffF>{}       // re-launch codegen commands that diff from the previous kphp launch
@@ -53,6 +53,8 @@ public:
   std::vector<InterfacePtr> implements;
   std::vector<ClassPtr> derived_classes;
   FunctionPtr construct_function;
+  // (root, slot) for every hierarchy with dense virtual dispatching this class belongs to; 0 is a slot of abstract classes
+  std::vector<std::pair<ClassPtr, int>> virt_dispatch_slots;
 
   const PhpDocComment *phpdoc{nullptr};
   const kphp_json::KphpJsonTagList *kphp_json_tags{nullptr};
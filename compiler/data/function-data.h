@@ -57,6 +57,7 @@ public:
   std::vector<FunctionPtr> dep;
   std::set<ClassPtr> class_dep;
   std::set<ClassPtr> exceptions_thrown; // exceptions that can be thrown by this function
+  std::vector<ClassPtr> stack_instances; // classes of `new` that don't escape this function, indexed by op_alloc::stack_instance_id
   bool tl_common_h_dep = false;
 
   // for lambdas: a function that contains this lambda ($this is captured from outer_function, it can also be a lambda on nesting)
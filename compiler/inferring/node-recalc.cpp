@@ -160,7 +160,7 @@ void NodeRecalc::on_changed() {
   new_type_ = nullptr;
 
   // here we need a lock: in case another thread updates edges_to_this_ just now via auto edge
-  AutoLocker<Lockable *> locker(node_);
+  AutoLocker<tinf::Node *> locker(node_);
   for (const tinf::Edge *e : node_->get_edges_to_this()) {
     inferer_->recalc_node(e->from);
   }
@@ -4,7 +4,9 @@
 
 #include "compiler/inferring/node.h"
 
+#include "compiler/inferring/public.h"
 #include "compiler/inferring/type-data.h"
+#include "compiler/inferring/type-inferer.h"
 #include "compiler/stage.h"
 
 namespace tinf {
@@ -13,6 +15,13 @@ std::string Node::as_human_readable() const {
   return type_->as_human_readable(false);
 }
 
+void Node::lock() {
+  if (!Lockable::try_lock()) {
+    get_inferer()->on_lock_contention();
+    Lockable::lock();
+  }
+}
+
 void Node::register_edge_from_this(const tinf::Edge *edge) {
   AutoLocker<Node *> locker(this);
   edges_from_this_.emplace_front(edge);
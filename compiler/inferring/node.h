@@ -61,6 +61,9 @@ public:
     return recalc_state_ >= recalc_bit_at_least_once;
   }
 
+  // hides Lockable::lock() to count contention on tinf nodes (see TypeInferer stats)
+  void lock();
+
   void register_edge_from_this(const tinf::Edge *edge);
   void register_edge_to_this(const tinf::Edge *edge);
 
@@ -14,6 +14,15 @@
 
 namespace tinf {
 
+namespace {
+
+// a worker with a long queue gives a half of it to idle threads;
+// the queue length is checked not on every recalc, it's not for free
+constexpr uint64_t SHARE_WORK_CHECK_PERIOD = 256;
+constexpr size_t MIN_NODES_TO_SHARE = 512;
+
+} // namespace
+
 TypeInferer::TypeInferer()
   : finish_flag(false) {}
 
@@ -42,6 +51,8 @@ void TypeInferer::add_restriction(RestrictionBase *restriction) {
 }
 
 void TypeInferer::check_restrictions() {
+  static CachedProfiler check_restrictions_profiler{"Type Inferring: check restrictions"};
+  AutoProfiler profiler{*check_restrictions_profiler};
   int limit = G->settings().show_all_type_errors.get() ? 200 : 1;
   int shown = 0;
 
@@ -76,27 +87,64 @@ public:
     AutoProfiler profiler{*type_inferer_profiler};
     stage::set_name("Infer types");
     stage::set_function(FunctionPtr());
+    inferer_->on_task_started();
     inferer_->run_queue(&queue_);
+    inferer_->on_task_finished();
   }
 };
 
 CachedProfiler TypeInfererTask::type_inferer_profiler{"Type Inferring"};
 
+// initial nodes were added by threads that happened to process functions in previous pipes, so queues are unbalanced;
+// they are split into equal contiguous parts (neighbour nodes mostly belong to the same function), one per thread
 std::vector<Task *> TypeInferer::get_tasks() {
+  static CachedProfiler partition_profiler{"Type Inferring: partition"};
+  AutoProfiler profiler{*partition_profiler};
+
+  size_t total_nodes = 0;
+  for (int i = 0; i < Q.size(); i++) {
+    total_nodes += Q.get(i).size();
+  }
+  const size_t tasks_count = std::max<size_t>(G->settings().threads_count.get(), 1);
+  const size_t nodes_per_task = (total_nodes + tasks_count - 1) / tasks_count;
+
   std::vector<Task *> res;
+  NodeQueue cur;
   for (int i = 0; i < Q.size(); i++) {
-    NodeQueue q = std::move(Q.get(i));
-    if (q.empty()) {
-      continue;
+    NodeQueue &q = Q.get(i);
+    for (; !q.empty(); q.pop()) {
+      cur.push(q.front());
+      if (cur.size() == nodes_per_task) {
+        res.push_back(new TypeInfererTask(this, std::move(cur)));
+        cur = NodeQueue{};
+      }
     }
-
-    res.push_back(new TypeInfererTask(this, std::move(q)));
+  }
+  if (!cur.empty()) {
+    res.push_back(new TypeInfererTask(this, std::move(cur)));
   }
   return res;
 }
 
-void TypeInferer::do_run_queue() {
+// while solving, new nodes are pushed to the current thread's queue, so one task can grow much bigger than others;
+// when some threads are idle, a half of a long queue is moved to a new task that will be taken by them
+void TypeInferer::try_share_work(NodeQueue &q) {
+  if (q.size() < MIN_NODES_TO_SHARE || running_tasks_count >= static_cast<int>(G->settings().threads_count.get())) {
+    return;
+  }
+
+  NodeQueue shared;
+  for (size_t half = q.size() / 2; half > 0; --half) {
+    shared.push(q.front());
+    q.pop();
+  }
+  ++shared_queues_count;
+  register_async_task(new TypeInfererTask(this, std::move(shared)));
+}
+
+void TypeInferer::do_run_queue(bool can_share_work) {
   NodeQueue &q = Q.get();
+  uint64_t &recalcs = *recalcs_count;
 
   while (!q.empty()) {
     Node *node = q.front();
@@ -106,18 +154,24 @@ void TypeInferer::do_run_queue() {
     if (node->try_finish_recalc()) {
       q.pop();
     }
+
+    if (can_share_work && ++recalcs % SHARE_WORK_CHECK_PERIOD == 0) {
+      try_share_work(q);
+    }
   }
 }
 
 void TypeInferer::run_queue(NodeQueue *new_q) {
   *Q = std::move(*new_q);
-  do_run_queue();
+  do_run_queue(true);
 }
 
 void TypeInferer::run_node(Node *node) {
+  // it's called on demand after tinf has finished (a type of a new vertex is needed), work is never shared here:
+  // the caller waits for a node, not for a task
   if (!node->was_recalc_started_at_least_once()) {
     add_node(node);
-    do_run_queue();
+    do_run_queue(false);
   }
   while (!node->was_recalc_finished_at_least_once()) {
     usleep(250);
@@ -127,6 +181,14 @@ void TypeInferer::run_node(Node *node) {
 void TypeInferer::finish() {
   finish_flag = true;
   kphp_assert(Q->empty());
+
+  uint64_t recalcs = 0;
+  for (int i = 0; i < recalcs_count.size(); i++) {
+    recalcs += recalcs_count.get(i);
+  }
+  G->stats.tinf_node_recalcs = recalcs;
+  G->stats.tinf_lock_contentions = lock_contentions_count.load();
+  G->stats.tinf_shared_queues = shared_queues_count.load();
 }
 
 
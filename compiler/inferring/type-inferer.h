@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <queue>
 
 #include "compiler/inferring/node.h"
@@ -20,6 +21,13 @@ private:
   TLS<std::vector<RestrictionBase *>> restrictions;
   bool finish_flag;
 
+  // instrumentation, reported to G->stats on finish
+  TLS<uint64_t> recalcs_count;
+  std::atomic<uint64_t> lock_contentions_count{0};
+  std::atomic<uint64_t> shared_queues_count{0};
+
+  std::atomic<int> running_tasks_count{0};
+
 public:
   TLS<NodeQueue> Q;
 
@@ -39,11 +47,16 @@ public:
 
   void run_node(Node *node);
 
+  void on_task_started() { ++running_tasks_count; }
+  void on_task_finished() { --running_tasks_count; }
+  void on_lock_contention() { ++lock_contentions_count; }
+
   void finish();
   bool is_finished() const { return finish_flag; }
 
 private:
-  void do_run_queue();
+  void do_run_queue(bool can_share_work);
+  void try_share_work(NodeQueue &q);
 };
 
 } // namespace tinf
@@ -0,0 +1,204 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "compiler/pipes/calc-non-escaping-instances.h"
+
+#include <queue>
+
+#include "compiler/data/class-data.h"
+#include "compiler/data/function-data.h"
+#include "compiler/data/var-data.h"
+#include "compiler/inferring/public.h"
+#include "compiler/vertex.h"
+
+// here we find instances that never outlive the function where they are created:
+//   $a = new A(...);     // not inside a loop
+//   $a->x = 1;           // accessing fields is ok
+//   $a->method();        // ok if A::method() doesn't leak $this — calculated inter-procedurally
+//   echo $a->x;
+//   // $a is not returned, not passed anywhere except as $this, not assigned to other vars/fields/arrays
+// such instances are allocated inside a stack storage at codegen, with refcounting turned off (see stack_instance_storage)
+//
+// the analysis is intentionally conservative: any usage of a var that is not listed above makes it escaping
+
+namespace {
+
+// big objects on a stack are a risk for deep recursion, they are left in the heap
+constexpr int MAX_FIELDS_OF_STACK_INSTANCE = 16;
+
+int count_instance_fields(ClassPtr klass) {
+  int count = 0;
+  for (ClassPtr cur = klass; cur; cur = cur->parent_class) {
+    cur->members.for_each([&count](const ClassMemberInstanceField &) { count++; });
+  }
+  return count;
+}
+
+bool is_loop(Operation op) {
+  return vk::any_of_equal(op, op_for, op_while, op_do, op_foreach);
+}
+
+} // namespace
+
+bool CollectNonEscapingInstancesPass::check_function(FunctionPtr function) const {
+  return !function->is_extern() && !function->is_resumable;
+}
+
+void CollectNonEscapingInstancesPass::on_start() {
+  data.this_escapes = false;
+  if (current_function->has_implicit_this_arg() && !current_function->param_ids.empty()) {
+    this_var = current_function->param_ids.front();
+  }
+}
+
+bool CollectNonEscapingInstancesPass::is_tracked_var(VarPtr var) const {
+  return var && (var == this_var || (var->type() == VarData::var_local_t && !var->is_reference));
+}
+
+void CollectNonEscapingInstancesPass::allow_var_usage(VertexPtr v) {
+  if (auto as_var = v.try_as<op_var>()) {
+    allowed_var_usages.insert(&*as_var);
+  }
+}
+
+void CollectNonEscapingInstancesPass::on_constructor_assignment(VertexAdaptor<op_set> set, VertexAdaptor<op_func_call> constructor_call) {
+  auto alloc = constructor_call->args()[0].as<op_alloc>();
+  VarPtr var = set->lhs().as<op_var>()->var_id;
+  ClassPtr klass = alloc->allocated_class;
+  if (!is_tracked_var(var) || var == this_var || loop_depth || !klass || !constructor_call->func_id) {
+    return;
+  }
+  if (klass->is_empty_class() || klass->is_builtin() || klass->is_ffi_cdata() || count_instance_fields(klass) > MAX_FIELDS_OF_STACK_INSTANCE) {
+    return;
+  }
+  const TypeData *var_type = tinf::get_type(var);
+  if (var_type->ptype() != tp_Class || var_type->class_type() != klass || var_type->or_false_flag()) {
+    return;
+  }
+
+  allow_var_usage(set->lhs());
+  data.candidates.emplace_back(StackInstanceCandidate{alloc, var, {constructor_call->func_id}});
+}
+
+VertexPtr CollectNonEscapingInstancesPass::on_enter_vertex(VertexPtr vertex) {
+  if (is_loop(vertex->type())) {
+    loop_depth++;
+  }
+
+  if (auto set = vertex.try_as<op_set>()) {
+    if (auto lhs_var = set->lhs().try_as<op_var>()) {
+      assignments_count[lhs_var->var_id]++;
+      auto call = set->rhs().try_as<op_func_call>();
+      if (call && call->extra_type == op_ex_constructor_call && !call->args().empty() && call->args()[0]->type() == op_alloc) {
+        on_constructor_assignment(set, call);
+      }
+    }
+  } else if (auto prop = vertex.try_as<op_instance_prop>()) {
+    allow_var_usage(prop->instance());
+  } else if (auto call = vertex.try_as<op_func_call>()) {
+    FunctionPtr callee = call->func_id;
+    if (callee && callee->has_implicit_this_arg() && !call->args().empty()) {
+      if (auto this_arg = call->args()[0].try_as<op_var>()) {
+        allow_var_usage(this_arg);
+        passed_as_this_to[this_arg->var_id].emplace_back(callee);
+      }
+    }
+  } else if (auto ret = vertex.try_as<op_return>()) {
+    // constructors end with `return $this`, the result is tracked at the caller side
+    if (current_function->is_constructor() && ret->has_expr()) {
+      allow_var_usage(ret->expr());
+    }
+  } else if (auto var = vertex.try_as<op_var>()) {
+    if (is_tracked_var(var->var_id) && !allowed_var_usages.count(&*var)) {
+      escaped_vars.insert(var->var_id);
+    }
+  }
+
+  return vertex;
+}
+
+VertexPtr CollectNonEscapingInstancesPass::on_exit_vertex(VertexPtr vertex) {
+  if (is_loop(vertex->type())) {
+    loop_depth--;
+  }
+  return vertex;
+}
+
+EscapeData CollectNonEscapingInstancesPass::get_data() {
+  if (this_var) {
+    data.this_escapes = escaped_vars.count(this_var);
+    data.this_passed_as_this_to = std::move(passed_as_this_to[this_var]);
+  }
+
+  auto candidate_escapes = [this](const StackInstanceCandidate &candidate) {
+    return escaped_vars.count(candidate.var) || assignments_count[candidate.var] != 1;
+  };
+  data.candidates.erase(std::remove_if(data.candidates.begin(), data.candidates.end(), candidate_escapes), data.candidates.end());
+  for (auto &candidate : data.candidates) {
+    const auto &methods = passed_as_this_to[candidate.var];
+    candidate.passed_as_this_to.insert(candidate.passed_as_this_to.end(), methods.begin(), methods.end());
+  }
+
+  return std::move(data);
+}
+
+
+void CalcNonEscapingInstancesF::on_finish(DataStream<FunctionPtr> &os) {
+  stage::die_if_global_errors();
+
+  stage::set_name("Calc non escaping instances");
+  auto all = tmp_stream.flush_as_vector();
+
+  // calc methods that leak $this: directly or passing it to other leaking methods;
+  // functions that were not analyzed (extern, resumable) are considered leaking
+  std::unordered_map<FunctionPtr, const EscapeData *> escape_data;
+  for (const auto &f_and_data : all) {
+    escape_data.emplace(f_and_data.first, &f_and_data.second);
+  }
+  std::unordered_set<FunctionPtr> this_escapes;
+  std::unordered_map<FunctionPtr, std::vector<FunctionPtr>> callers_passing_this;
+  std::queue<FunctionPtr> q;
+  auto mark_this_escapes = [&this_escapes, &q](FunctionPtr f) {
+    if (this_escapes.insert(f).second) {
+      q.push(f);
+    }
+  };
+  auto is_analyzed = [&escape_data](FunctionPtr f) {
+    return !f->is_extern() && !f->is_resumable && escape_data.count(f);
+  };
+
+  for (const auto &f_and_data : all) {
+    FunctionPtr f = f_and_data.first;
+    if (!is_analyzed(f) || f_and_data.second.this_escapes) {
+      mark_this_escapes(f);
+    }
+    for (FunctionPtr callee : f_and_data.second.this_passed_as_this_to) {
+      if (!is_analyzed(callee)) {
+        mark_this_escapes(callee);
+      }
+      callers_passing_this[callee].emplace_back(f);
+    }
+  }
+  while (!q.empty()) {
+    FunctionPtr f = q.front();
+    q.pop();
+    for (FunctionPtr caller : callers_passing_this[f]) {
+      mark_this_escapes(caller);
+    }
+  }
+
+  for (auto &f_and_data : all) {
+    FunctionPtr f = f_and_data.first;
+    for (auto &candidate : f_and_data.second.candidates) {
+      bool escapes = vk::any_of(candidate.passed_as_this_to, [&](FunctionPtr callee) {
+        return !is_analyzed(callee) || this_escapes.count(callee);
+      });
+      if (!escapes && !f->is_resumable) {
+        candidate.alloc->stack_instance_id = static_cast<int>(f->stack_instances.size());
+        f->stack_instances.emplace_back(candidate.alloc->allocated_class);
+      }
+    }
+    os << f;
+  }
+}
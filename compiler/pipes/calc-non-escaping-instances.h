@@ -0,0 +1,60 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/mixin/movable_only.h"
+
+#include "compiler/function-pass.h"
+#include "compiler/pipes/sync.h"
+
+// `$v = new A(...)` inside a function, that is not inside a loop, and $v is a local var not escaping locally
+struct StackInstanceCandidate {
+  VertexAdaptor<op_alloc> alloc;
+  VarPtr var;
+  std::vector<FunctionPtr> passed_as_this_to;   // constructor and all methods called on $v: they must not leak $this
+};
+
+struct EscapeData : private vk::movable_only {
+  bool this_escapes{false};                     // for instance methods: whether $this escapes the method itself
+  std::vector<FunctionPtr> this_passed_as_this_to;
+  std::vector<StackInstanceCandidate> candidates;
+};
+
+class CollectNonEscapingInstancesPass final : public FunctionPassBase {
+  EscapeData data;
+  VarPtr this_var;
+  int loop_depth{0};
+
+  std::unordered_set<VarPtr> escaped_vars;
+  std::unordered_map<VarPtr, std::vector<FunctionPtr>> passed_as_this_to;
+  std::unordered_map<VarPtr, int> assignments_count;
+  std::unordered_set<const void *> allowed_var_usages;
+
+  bool is_tracked_var(VarPtr var) const;
+  void allow_var_usage(VertexPtr v);
+  void on_constructor_assignment(VertexAdaptor<op_set> set, VertexAdaptor<op_func_call> constructor_call);
+
+public:
+  std::string get_description() override {
+    return "Collect non escaping instances";
+  }
+
+  bool check_function(FunctionPtr function) const override;
+
+  void on_start() override;
+  VertexPtr on_enter_vertex(VertexPtr vertex) override;
+  VertexPtr on_exit_vertex(VertexPtr vertex) override;
+
+  EscapeData get_data();
+};
+
+class CalcNonEscapingInstancesF final : public SyncPipeF<std::pair<FunctionPtr, EscapeData>, FunctionPtr> {
+public:
+  void on_finish(DataStream<FunctionPtr> &os) final;
+};
@@ -108,6 +108,8 @@ class CFG {
   IdMap<int> node_dfs;
   IdMap<int> node_dfs_smartcast_mask;
   IdMap<UsagePtr> node_dfs_usages;
+  IdMap<int> node_dfs_live_in;
+  IdMap<int> node_dfs_live_out;
   void reserve_size_for_dfs_idmaps();
 
   IdMap<VarSplitData> var_split_data;
@@ -144,6 +146,7 @@ class CFG {
   void dfs_uni_rw_usages(Node v, UsagePtr usage);
   void dfs_apply_type_hint(Node v, UsagePtr type_hint_usage);
   bool dfs_is_uninited_usage(Node v, UsagePtr read_usage);
+  void calc_last_usages(VarPtr var);
   void process_var(FunctionPtr function, VarPtr v);
   void on_uninited_var(VertexAdaptor<op_var> v);
   void split_var(FunctionPtr function, VarPtr var, std::vector<std::vector<VertexAdaptor<op_var>>> &parts);
@@ -176,6 +179,8 @@ void CFG::reserve_size_for_dfs_idmaps() {
   node_dfs.update_size(n_nodes);
   node_dfs_smartcast_mask.update_size(n_nodes);
   node_dfs_usages.update_size(n_nodes);
+  node_dfs_live_in.update_size(n_nodes);
+  node_dfs_live_out.update_size(n_nodes);
 }
 
 UsagePtr CFG::new_usage(UsageType type, VertexAdaptor<op_var> v) {
@@ -1155,6 +1160,54 @@ void CFG::dfs_apply_smartcasts(Node v, VarPtr var, int current_mask) {
   }
 }
 
+// find read usages after which a var is dead: no path from them leads to another read without passing a write
+// for example, function f() { $a = [1]; $b = $a; $a = [2]; echo $a[0]; } — usage 2 is the last one for the first value of $a
+// it's a backward liveness analysis: starting from all reading nodes, we traverse up all available paths stopping at write usages;
+// having a var live after a node (node_dfs_live_out) means that some reading follows it
+// such last usages are marked with is_last_usage, a value can be moved from there instead of copying (see MoveLastUsagesPass)
+void CFG::calc_last_usages(VarPtr var) {
+  cur_dfs_step++;
+  std::stack<Node> node_stack;
+  auto is_reading = [](UsagePtr usage) {
+    return usage->type == usage_read_t || usage->type == usage_weak_write_t;
+  };
+
+  for (UsagePtr u : var_split_data[var].usages) {
+    if (is_reading(u) && node_dfs_live_in[u->node] != cur_dfs_step) {
+      node_dfs_live_in[u->node] = cur_dfs_step;
+      node_stack.push(u->node);
+    }
+  }
+
+  while (!node_stack.empty()) {
+    Node v = node_stack.top();
+    node_stack.pop();
+
+    for (Node i : node_prev[v]) {
+      node_dfs_live_out[i] = cur_dfs_step;
+      if (node_dfs_live_in[i] == cur_dfs_step) {
+        continue;
+      }
+      bool is_killed = false;
+      for (UsagePtr another_usage : node_usages[i]) {
+        if (another_usage->v->var_id == var && another_usage->type == usage_write_t) {
+          is_killed = true;
+        }
+      }
+      if (!is_killed) {
+        node_dfs_live_in[i] = cur_dfs_step;
+        node_stack.push(i);
+      }
+    }
+  }
+
+  for (UsagePtr u : var_split_data[var].usages) {
+    if (u->type == usage_read_t && node_dfs[u->node] && node_dfs_live_out[u->node] != cur_dfs_step) {
+      u->v->is_last_usage = true;
+    }
+  }
+}
+
 void CFG::on_uninited_var(VertexAdaptor<op_var> v) {
   // when we met an uninited usage — don't emit a warning here: instead, save it and analyze after tinf
   data.uninited_vars.emplace_front(v);
@@ -1246,6 +1299,8 @@ void CFG::process_var(FunctionPtr function, VarPtr var) {
     }
   }
 
+  calc_last_usages(var);
+
   cur_dfs_step++;
   std::fill(node_dfs_usages.begin(), node_dfs_usages.end(), UsagePtr());
   for (UsagePtr u : var_split.usages) {
@@ -586,6 +586,17 @@ void DeduceImplicitTypesAndCastsPass::on_func_call(VertexAdaptor<op_func_call> c
 
       call->func_id = method->function;
 
+      // lhs is a class without inheritors, so a virtual method inherited by it can be called directly, bypassing dispatching
+      // (all classes are already loaded at this point, and a class's own method isn't virtual unless it has inheritors)
+      FunctionPtr called_method = method->function;
+      if (called_method->is_virtual_method && !called_method->modifiers.is_abstract() &&
+          klass->is_class() && !klass->modifiers.is_abstract() && klass->derived_classes.empty()) {
+        if (const auto *self_method = called_method->class_id->members.get_instance_method(called_method->get_name_of_self_method())) {
+          call->str_val = std::string{self_method->local_name()};
+          call->func_id = self_method->function;
+        }
+      }
+
     } else {
       // just a regular function call in a global namespace
       call->func_id = G->get_function(call->str_val);
@@ -4,6 +4,7 @@
 
 #include "compiler/pipes/generate-virtual-methods.h"
 
+#include "common/algorithms/compare.h"
 #include "common/algorithms/contains.h"
 
 #include "compiler/compiler-core.h"
@@ -266,12 +267,19 @@ void check_constructor_signature_compatibility(FunctionPtr interface_constructor
   }
 }
 
-VertexAdaptor<op_case> gen_case_on_hash(ClassPtr derived, VertexAdaptor<op_seq> cmd) {
-  auto hash_of_derived = GenTree::create_int_const(derived->get_hash());
-  return VertexAdaptor<op_case>::create(hash_of_derived, cmd);
-}
+// virtual dispatching through a hash switch is compiled by gcc into a binary search over sparse hashes;
+// when there are many inheritors, they are numbered 1..N inside the hierarchy, and we switch over these numbers instead —
+// then the switch is always a dense jump table
+constexpr int MIN_CASES_FOR_DENSE_DISPATCH = 4;
+
+// all derived classes which share the same concrete method (e.g. Derived2 extends Derived1 without overriding)
+// are dispatched to a single call, casting $this to the class that declares that method
+struct VirtualMethodImplementation {
+  FunctionPtr concrete_method;
+  std::vector<ClassPtr> derived_classes;
+};
 
-VertexAdaptor<op_case> gen_case_calling_methods_on_derived_class(ClassPtr derived, FunctionPtr virtual_function) {
+FunctionPtr find_concrete_method_of_derived(ClassPtr derived, FunctionPtr virtual_function) {
   FunctionPtr concrete_method_of_derived;
   if (const auto *method_of_derived = derived->members.get_instance_method(virtual_function->local_name())) {
     concrete_method_of_derived = method_of_derived->function;
@@ -301,12 +309,63 @@ VertexAdaptor<op_case> gen_case_calling_methods_on_derived_class(ClassPtr derive
     return {};
   }
 
-  VertexPtr this_var = generate_instance_cast_to_call(ClassData::gen_vertex_this({}), derived);
+  return concrete_method_of_derived;
+}
+
+VertexAdaptor<op_return> gen_return_call_of_implementation(const VirtualMethodImplementation &impl, FunctionPtr virtual_function) {
+  VertexPtr this_var = generate_instance_cast_to_call(ClassData::gen_vertex_this({}), impl.concrete_method->class_id);
   // generate concrete_method call, with arguments from virtual_functions, because of Derived can have extra default params:
-  auto call_self_method_of_derived = generate_call_of_self_method(this_var, virtual_function, concrete_method_of_derived);
-  auto call_derived_method = VertexAdaptor<op_seq>::create(VertexAdaptor<op_return>::create(call_self_method_of_derived));
+  auto call_self_method_of_derived = generate_call_of_self_method(this_var, virtual_function, impl.concrete_method);
+  return VertexAdaptor<op_return>::create(call_self_method_of_derived);
+}
+
+// a slot of derived in the hierarchy of root, or -1 if slots of this hierarchy aren't assigned
+int get_virt_dispatch_slot(ClassPtr derived, ClassPtr root) {
+  for (const auto &root_and_slot : derived->virt_dispatch_slots) {
+    if (root_and_slot.first == root) {
+      return root_and_slot.second;
+    }
+  }
+  return -1;
+}
 
-  return gen_case_on_hash(derived, call_derived_method);
+// number all instantiable classes of the hierarchy 1..N (0 is left for null and abstract classes) once for all virtual methods of root;
+// every class returns its slot via a generated C++ virtual method, so the classes of the runtime can't take part in it
+bool assign_virt_dispatch_slots(ClassPtr root, const std::vector<ClassPtr> &all_derived_classes) {
+  if (get_virt_dispatch_slot(root, root) >= 0) {
+    return true;
+  }
+
+  auto is_instantiable = [](ClassPtr derived) { return derived->is_class() && !derived->modifiers.is_abstract(); };
+  const auto instantiable_count = std::count_if(all_derived_classes.begin(), all_derived_classes.end(), is_instantiable);
+  if (instantiable_count < MIN_CASES_FOR_DENSE_DISPATCH || vk::any_of(all_derived_classes, [](ClassPtr derived) { return derived->is_builtin(); })) {
+    return false;
+  }
+
+  int slot = 0;
+  for (ClassPtr derived : all_derived_classes) {
+    derived->virt_dispatch_slots.emplace_back(root, is_instantiable(derived) ? ++slot : 0);
+  }
+  return true;
+}
+
+// cases for all classes of an implementation are placed one after another: the empty ones fall through to the last one;
+// abstract classes have no instances, with dense dispatching they share slot 0 and don't get cases
+void gen_cases_for_implementation(const VirtualMethodImplementation &impl, FunctionPtr virtual_function, bool dense_dispatch, std::vector<VertexPtr> &cases) {
+  std::vector<int> case_values;
+  for (ClassPtr derived : impl.derived_classes) {
+    int case_value = dense_dispatch ? get_virt_dispatch_slot(derived, virtual_function->class_id) : derived->get_hash();
+    if (!dense_dispatch || case_value) {
+      case_values.emplace_back(case_value);
+    }
+  }
+
+  for (int case_value : case_values) {
+    auto case_cmd = case_value == case_values.back()
+                    ? VertexAdaptor<op_seq>::create(gen_return_call_of_implementation(impl, virtual_function))
+                    : VertexAdaptor<op_seq>::create();
+    cases.emplace_back(VertexAdaptor<op_case>::create(GenTree::create_int_const(case_value), case_cmd));
+  }
 }
 
 // we can't express "return default of ReturnT", something like 'return {}' in C++ code
@@ -398,6 +457,13 @@ VertexAdaptor<op_seq> generate_body_of_empty_virtual_method(ClassPtr klass, Func
  *   default: {
  *     critical_error("call method(Interface::virtual_function) on null object
  *   }
+ *
+ * if there are many inheritors, the switch is done over _get_virt_dispatch_slot($this) instead of a hash,
+ * case values are sequential numbers of classes in the hierarchy, and gcc emits a jump table
+ *
+ * if all inheritors share the same implementation, there is no switch at all (devirtualization):
+ *   if (!get_hash_of_class($this)) critical_error(...);
+ *   return instance_cast<Derived1>($this)->virtual_function($param1, ...);
  */
 void generate_body_of_virtual_method(FunctionPtr virtual_function) {
   auto klass = virtual_function->class_id;
@@ -409,7 +475,7 @@ void generate_body_of_virtual_method(FunctionPtr virtual_function) {
     kphp_assert(virtual_function->root->cmd()->empty());
   }
 
-  std::vector<VertexPtr> cases;
+  std::vector<VirtualMethodImplementation> impls;
   std::vector<ClassPtr> all_derived_classes = klass->get_all_derived_classes();
   std::sort(all_derived_classes.begin(), all_derived_classes.end());
   ClassPtr prev_derived;
@@ -418,25 +484,44 @@ void generate_body_of_virtual_method(FunctionPtr virtual_function) {
     kphp_error (prev_derived != derived, fmt_format("Duplicated class {} in hierarchy from class {}.\nDiamond inheritance is not supported", derived->name, klass->name));
     prev_derived = derived;
 
-    if (auto v_case = gen_case_calling_methods_on_derived_class(derived, virtual_function)) {
-      cases.emplace_back(v_case);
+    if (FunctionPtr concrete_method = find_concrete_method_of_derived(derived, virtual_function)) {
+      auto impl_it = std::find_if(impls.begin(), impls.end(), [concrete_method](const auto &impl) { return impl.concrete_method == concrete_method; });
+      if (impl_it == impls.end()) {
+        impls.emplace_back(VirtualMethodImplementation{concrete_method, {}});
+        impl_it = std::prev(impls.end());
+      }
+      impl_it->derived_classes.emplace_back(derived);
     }
   }
-  if (!cases.empty()) {
-    auto case_default_warn = generate_critical_error_call(fmt_format("call method({}) on null object", virtual_function->as_human_readable()));
-    cases.emplace_back(VertexAdaptor<op_default>::create(VertexAdaptor<op_seq>::create(case_default_warn)));
-  }
 
-  if (cases.empty() && !stage::has_error()) {
+  auto call_critical_error = [virtual_function] {
+    return generate_critical_error_call(fmt_format("call method({}) on null object", virtual_function->as_human_readable()));
+  };
+
+  if (impls.empty() && !stage::has_error()) {
     // when there are no inheritors of an interface, generate an empty body if possible —
     // it won't be executed at runtime, but it would be compiled by gcc
     virtual_function->root->cmd_ref() = generate_body_of_empty_virtual_method(klass, virtual_function);
-  } else {
-    // create a dispatching switch through all inheritors
+  } else if (impls.size() == 1) {
+    // the only implementation for the whole hierarchy: call it directly, checking only for null
     auto call_get_hash = VertexAdaptor<op_func_call>::create(ClassData::gen_vertex_this({}));
     call_get_hash->str_val = "get_hash_of_class";
     call_get_hash->func_id = G->get_function(call_get_hash->str_val);
-    virtual_function->root->cmd_ref() = VertexAdaptor<op_seq>::create(GenTree::create_switch_vertex(virtual_function, call_get_hash, std::move(cases)));
+    auto check_null = VertexAdaptor<op_if>::create(VertexAdaptor<op_log_not>::create(call_get_hash), VertexAdaptor<op_seq>::create(call_critical_error()));
+    virtual_function->root->cmd_ref() = VertexAdaptor<op_seq>::create(check_null, gen_return_call_of_implementation(impls.front(), virtual_function));
+  } else {
+    // create a dispatching switch through all inheritors
+    bool dense_dispatch = assign_virt_dispatch_slots(klass, all_derived_classes);
+    std::vector<VertexPtr> cases;
+    for (const auto &impl : impls) {
+      gen_cases_for_implementation(impl, virtual_function, dense_dispatch, cases);
+    }
+    cases.emplace_back(VertexAdaptor<op_default>::create(VertexAdaptor<op_seq>::create(call_critical_error())));
+
+    auto switch_condition = VertexAdaptor<op_func_call>::create(ClassData::gen_vertex_this({}));
+    switch_condition->str_val = dense_dispatch ? "_get_virt_dispatch_slot" : "get_hash_of_class";
+    switch_condition->func_id = G->get_function(switch_condition->str_val);
+    virtual_function->root->cmd_ref() = VertexAdaptor<op_seq>::create(GenTree::create_switch_vertex(virtual_function, switch_condition, std::move(cases)));
   }
 
   virtual_function->type = FunctionData::func_local;    // could be func_extern before, but now it has a body
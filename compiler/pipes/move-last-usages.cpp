@@ -0,0 +1,114 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "compiler/pipes/move-last-usages.h"
+
+#include "compiler/data/var-data.h"
+#include "compiler/inferring/public.h"
+#include "compiler/vertex.h"
+
+namespace {
+
+int count_var_usages(VertexPtr root, VarPtr var) {
+  if (auto as_var = root.try_as<op_var>()) {
+    return as_var->var_id == var;
+  }
+  int count = 0;
+  for (VertexPtr child : *root) {
+    count += count_var_usages(child, var);
+  }
+  return count;
+}
+
+bool is_movable_type(const TypeData *type) {
+  return vk::any_of_equal(type->ptype(), tp_array, tp_string, tp_mixed);
+}
+
+bool is_passed_by_value(VertexPtr param_vertex) {
+  auto param = param_vertex.as<op_func_param>();
+  VarPtr param_var = param->var()->var_id;
+  // keep in sync with FunctionParams::declare_cpp_param()
+  return !param->var()->ref_flag && !param_var->marked_as_const && !param_var->is_read_only;
+}
+
+} // namespace
+
+bool MoveLastUsagesPass::check_function(FunctionPtr function) const {
+  return !function->is_extern() && vk::any_of_equal(function->type, FunctionData::func_local, FunctionData::func_lambda);
+}
+
+// expr is an argument/rhs/returned value inside a statement; it's moved if it's the only occurrence of a var in a statement,
+// otherwise evaluation order in C++ could make another occurrence see an already moved-from value;
+// the only exception is `$a = ...$a...`, as an assignment is sequenced after evaluating its rhs
+bool MoveLastUsagesPass::try_move(VertexPtr statement, VertexPtr &expr, VertexPtr set_lhs) {
+  auto var = expr.try_as<op_var>();
+  if (!var || !var->is_last_usage || var->val_ref_flag || var->rl_type != val_r) {
+    return false;
+  }
+  VarPtr var_id = var->var_id;
+  if (!vk::any_of_equal(var_id->type(), VarData::var_local_t, VarData::var_param_t) || var_id->is_reference || var_id->is_foreach_reference) {
+    return false;
+  }
+  if (!is_movable_type(tinf::get_type(var_id))) {
+    return false;
+  }
+
+  int allowed_usages = 1;
+  if (auto lhs_var = set_lhs.try_as<op_var>()) {
+    allowed_usages += lhs_var->var_id == var_id;
+  }
+  if (count_var_usages(statement, var_id) != allowed_usages) {
+    return false;
+  }
+
+  expr = VertexAdaptor<op_move>::create(expr).set_rl_type(val_r).set_location(expr);
+  return true;
+}
+
+void MoveLastUsagesPass::process_call_args(VertexPtr statement, VertexAdaptor<op_func_call> call, VertexPtr set_lhs) {
+  FunctionPtr callee = call->func_id;
+  if (!callee || call->extra_type == op_ex_internal_func || callee->is_extern() || callee->is_resumable || callee->has_variadic_param) {
+    return;
+  }
+  auto args = call->args();
+  auto params = callee->get_params();
+  for (int i = 0; i < args.size() && i < params.size(); ++i) {
+    if (is_passed_by_value(params[i])) {
+      try_move(statement, args[i], set_lhs);
+    }
+  }
+}
+
+void MoveLastUsagesPass::process_statement(VertexPtr statement) {
+  if (auto set = statement.try_as<op_set>()) {
+    if (auto call = set->rhs().try_as<op_func_call>()) {
+      process_call_args(statement, call, set->lhs());
+    } else {
+      try_move(statement, set->rhs(), {});
+    }
+  } else if (auto call = statement.try_as<op_func_call>()) {
+    process_call_args(statement, call, {});
+  } else if (auto ret = statement.try_as<op_return>()) {
+    if (!ret->has_expr()) {
+      return;
+    }
+    if (auto call = ret->expr().try_as<op_func_call>()) {
+      process_call_args(statement, call, {});
+    } else if (auto var = ret->expr().try_as<op_var>()) {
+      // `return $local` of the same type is moved (or elided) by a C++ compiler itself, std::move would only prevent NRVO
+      if (current_function->is_resumable || !are_equal_types(tinf::get_type(var->var_id), tinf::get_type(current_function, -1))) {
+        try_move(statement, ret->expr(), {});
+      }
+    }
+  }
+}
+
+VertexPtr MoveLastUsagesPass::on_enter_vertex(VertexPtr vertex) {
+  if (auto seq = vertex.try_as<op_seq>()) {
+    for (VertexPtr statement : *seq) {
+      process_statement(statement);
+    }
+  }
+  return vertex;
+}
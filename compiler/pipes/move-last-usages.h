@@ -0,0 +1,27 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include "compiler/function-pass.h"
+
+// wraps last usages of local vars (see CFG::calc_last_usages) into op_move where a copy would be made otherwise:
+//   $b = $a;          ->  v$b = std::move(v$a);
+//   $a = f($a);       ->  v$a = f$f(std::move(v$a));   if f() modifies its param, so it's passed by value
+//   return $a;        ->  return std::move(v$a);       if a conversion to a return type is needed
+// so that a following mutation doesn't clone an array/string because of a refcount held by a dead var
+class MoveLastUsagesPass final : public FunctionPassBase {
+  void process_statement(VertexPtr statement);
+  void process_call_args(VertexPtr statement, VertexAdaptor<op_func_call> call, VertexPtr set_lhs);
+  bool try_move(VertexPtr statement, VertexPtr &expr, VertexPtr set_lhs);
+
+public:
+  std::string get_description() final {
+    return "Move last usages of local vars";
+  }
+
+  bool check_function(FunctionPtr function) const final;
+
+  VertexPtr on_enter_vertex(VertexPtr vertex) final;
+};
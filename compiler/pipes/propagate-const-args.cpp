@@ -0,0 +1,257 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "compiler/pipes/propagate-const-args.h"
+
+#include <unordered_set>
+
+#include "compiler/type-hint.h"
+#include "compiler/vertex.h"
+
+namespace {
+
+// a param used only this way is never modified and can be replaced with a literal
+bool is_read_only_usage(VertexPtr parent, const VertexPtr *usage) {
+  switch (parent->type()) {
+    case op_set:
+    case op_set_add:
+    case op_set_sub:
+    case op_set_mul:
+    case op_set_div:
+    case op_set_mod:
+    case op_set_pow:
+    case op_set_and:
+    case op_set_or:
+    case op_set_xor:
+    case op_set_dot:
+    case op_set_shr:
+    case op_set_shl:
+    case op_set_null_coalesce:
+      return usage == &parent.as<meta_op_binary>()->rhs();
+    case op_index: {
+      auto index = parent.as<op_index>();
+      return index->has_key() && usage == &index->key();
+    }
+    case op_func_call: {
+      auto call = parent.as<op_func_call>();
+      if (!call->func_id) {
+        return false;
+      }
+      auto params = call->func_id->get_params();
+      int i = 0;
+      for (const auto &arg : call->args()) {
+        if (&arg == usage) {
+          break;
+        }
+        ++i;
+      }
+      return i < params.size() && !params[i].as<op_func_param>()->var()->ref_flag;
+    }
+    case op_add:
+    case op_sub:
+    case op_mul:
+    case op_div:
+    case op_mod:
+    case op_pow:
+    case op_concat:
+    case op_string_build:
+    case op_eq2:
+    case op_eq3:
+    case op_lt:
+    case op_le:
+    case op_spaceship:
+    case op_and:
+    case op_or:
+    case op_xor:
+    case op_shl:
+    case op_shr:
+    case op_log_and:
+    case op_log_or:
+    case op_log_not:
+    case op_not:
+    case op_minus:
+    case op_plus:
+    case op_conv_int:
+    case op_conv_float:
+    case op_conv_string:
+    case op_conv_bool:
+    case op_ternary:
+    case op_array:
+    case op_double_arrow:
+    case op_return:
+      return true;
+    default:
+      return false;
+  }
+}
+
+PrimitiveType get_literal_ptype(VertexPtr v) {
+  switch (v->type()) {
+    case op_int_const:
+      return tp_int;
+    case op_float_const:
+      return tp_float;
+    case op_string:
+      return tp_string;
+    case op_true:
+    case op_false:
+      return tp_bool;
+    default:
+      return tp_any;
+  }
+}
+
+bool is_same_literal(VertexPtr a, VertexPtr b) {
+  if (a->type() != b->type()) {
+    return false;
+  }
+  return vk::any_of_equal(a->type(), op_true, op_false) || a->get_string() == b->get_string();
+}
+
+bool can_propagate_into(FunctionPtr f) {
+  return f->type == FunctionData::func_local && !f->is_extern() && !f->kphp_lib_export && !f->has_implicit_this_arg() &&
+         !f->has_variadic_param && !f->is_generic();
+}
+
+} // namespace
+
+void CollectConstArgsPass::on_start() {
+  auto params = current_function->get_params();
+  data.params_usages.resize(params.size());
+  param_modified.resize(params.size());
+  for (int i = 0; i < params.size(); ++i) {
+    param_names.emplace(params[i].as<op_func_param>()->var()->str_val, i);
+  }
+}
+
+void CollectConstArgsPass::on_param_usage(VertexPtr parent, VertexPtr *usage) {
+  int param_i = param_names.at((*usage).as<op_var>()->str_val);
+  if ((*usage)->ref_flag || !is_read_only_usage(parent, usage)) {
+    param_modified[param_i] = true;
+  } else {
+    data.params_usages[param_i].emplace_back(usage);
+  }
+}
+
+void CollectConstArgsPass::mark_params_modified(VertexPtr root) {
+  if (auto var = root.try_as<op_var>()) {
+    auto it = param_names.find(var->str_val);
+    if (it != param_names.end()) {
+      param_modified[it->second] = true;
+    }
+  }
+  for (VertexPtr child : *root) {
+    mark_params_modified(child);
+  }
+}
+
+VertexPtr CollectConstArgsPass::on_enter_vertex(VertexPtr vertex) {
+  if (auto call = vertex.try_as<op_func_call>()) {
+    if (call->func_id) {
+      data.calls.emplace_back(call);
+    }
+  } else if (auto callback = vertex.try_as<op_callback_of_builtin>()) {
+    data.referenced_not_by_calls.emplace_back(callback->func_id);
+  } else if (auto invoke = vertex.try_as<op_invoke_call>()) {
+    data.referenced_not_by_calls.emplace_back(invoke->func_id);
+  }
+
+  if (!param_names.empty()) {
+    // [$a, $b] = ... is not converted to op_list yet, vars inside op_array are written then
+    if (auto set = vertex.try_as<op_set>()) {
+      if (set->lhs()->type() == op_array) {
+        mark_params_modified(set->lhs());
+      }
+    }
+    for (auto &child : *vertex) {
+      if (child->type() == op_var && param_names.count(child.as<op_var>()->str_val)) {
+        on_param_usage(vertex, &child);
+      }
+    }
+  }
+  return vertex;
+}
+
+bool CollectConstArgsPass::user_recursion(VertexPtr vertex) {
+  return vertex->type() == op_func_param_list;
+}
+
+void CollectConstArgsPass::on_finish() {
+  for (int i = 0; i < param_modified.size(); ++i) {
+    if (param_modified[i]) {
+      data.params_usages[i].clear();
+    }
+  }
+}
+
+ConstArgsData CollectConstArgsPass::get_data() {
+  return std::move(data);
+}
+
+
+void PropagateConstArgsF::on_finish(DataStream<FunctionPtr> &os) {
+  stage::die_if_global_errors();
+
+  stage::set_name("Propagate constant arguments");
+  auto all = tmp_stream.flush_as_vector();
+
+  // for every param of every function: a literal passed at all call sites, or an empty vertex if they differ
+  std::unordered_map<FunctionPtr, std::vector<VertexPtr>> const_args;
+  std::unordered_set<FunctionPtr> unknown_args;
+  for (const auto &f_and_data : all) {
+    for (FunctionPtr f : f_and_data.second.referenced_not_by_calls) {
+      unknown_args.insert(f);
+    }
+  }
+  for (const auto &f_and_data : all) {
+    for (auto call : f_and_data.second.calls) {
+      FunctionPtr callee = call->func_id;
+      if (!can_propagate_into(callee) || unknown_args.count(callee)) {
+        continue;
+      }
+      auto params = callee->get_params();
+      auto args = call->args();
+      auto inserted = const_args.emplace(callee, std::vector<VertexPtr>{});
+      std::vector<VertexPtr> &values = inserted.first->second;
+      if (inserted.second) {
+        values.resize(params.size());
+      }
+
+      for (int i = 0; i < params.size(); ++i) {
+        auto param = params[i].as<op_func_param>();
+        VertexPtr arg = i < args.size() ? args[i] : param->has_default_value() ? param->default_value() : VertexPtr{};
+        bool is_literal = arg && get_literal_ptype(arg) != tp_any;
+        if (!is_literal || (!inserted.second && (!values[i] || !is_same_literal(values[i], arg)))) {
+          values[i] = {};
+        } else if (inserted.second) {
+          values[i] = arg;
+        }
+      }
+    }
+  }
+
+  for (auto &f_and_data : all) {
+    FunctionPtr f = f_and_data.first;
+    auto it = const_args.find(f);
+    if (it != const_args.end() && !unknown_args.count(f)) {
+      stage::set_function(f);
+      auto params = f->get_params();
+      for (int i = 0; i < params.size(); ++i) {
+        VertexPtr value = it->second[i];
+        const TypeHint *type_hint = params[i].as<op_func_param>()->type_hint;
+        if (!value || f_and_data.second.params_usages[i].empty()) {
+          continue;
+        }
+        const auto *as_primitive = type_hint ? type_hint->try_as<TypeHintPrimitive>() : nullptr;
+        if (type_hint && (!as_primitive || as_primitive->ptype != get_literal_ptype(value))) {
+          continue;
+        }
+        for (VertexPtr *usage : f_and_data.second.params_usages[i]) {
+          *usage = value.clone().set_location(*usage);
+        }
+      }
+    }
+    os << f;
+  }
+}
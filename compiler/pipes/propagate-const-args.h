@@ -0,0 +1,51 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "common/mixin/movable_only.h"
+
+#include "compiler/function-pass.h"
+#include "compiler/pipes/sync.h"
+
+struct ConstArgsData : private vk::movable_only {
+  std::vector<VertexAdaptor<op_func_call>> calls;     // calls of functions from this one, their args are analyzed
+  std::vector<FunctionPtr> referenced_not_by_calls;   // callbacks and others: args passed to them are unknown
+  std::vector<std::vector<VertexPtr *>> params_usages; // for each param: its usages, if it's never modified; empty otherwise
+};
+
+// collects call sites and usages of own params for PropagateConstArgsF
+class CollectConstArgsPass final : public FunctionPassBase {
+  ConstArgsData data;
+  std::unordered_map<std::string, int> param_names;
+  std::vector<bool> param_modified;
+
+  void on_param_usage(VertexPtr parent, VertexPtr *usage);
+  void mark_params_modified(VertexPtr root);
+
+public:
+  std::string get_description() final {
+    return "Collect constant arguments";
+  }
+
+  void on_start() final;
+  VertexPtr on_enter_vertex(VertexPtr vertex) final;
+  bool user_recursion(VertexPtr vertex) final;
+  void on_finish() final;
+
+  ConstArgsData get_data();
+};
+
+// inter-procedural propagation of constant arguments:
+//   function f($mode) { return str_repeat('-', $mode); }
+//   f(5); f(5);                                          // all call sites pass the same literal
+// such a param is replaced with that literal inside a function body (if the function is never called indirectly),
+// then str_repeat('-', 5) becomes a const expression, it's computed once, see CalcConstTypePass and CollectConstVarsPass
+class PropagateConstArgsF final : public SyncPipeF<std::pair<FunctionPtr, ConstArgsData>, FunctionPtr> {
+public:
+  void on_finish(DataStream<FunctionPtr> &os) final;
+};
@@ -74,6 +74,10 @@ void Stats::write_to(std::ostream &out, bool with_indent) const {
   out << indent << "types.params_mixed: " << cnt_mixed_params << std::endl;
   out << indent << "types.const_params_mixed: " << cnt_const_mixed_params << std::endl;
   out << block_sep;
+  out << indent << "tinf.node_recalcs: " << tinf_node_recalcs << std::endl;
+  out << indent << "tinf.lock_contentions: " << tinf_lock_contentions << std::endl;
+  out << indent << "tinf.shared_queues: " << tinf_shared_queues << std::endl;
+  out << block_sep;
   out << indent << "functions.total: " << total_functions_ << std::endl;
   out << indent << "functions.total_inline: " << total_inline_functions_ << std::endl;
   out << indent << "functions.total_throwing: " << total_throwing_functions_ << std::endl;
@@ -26,6 +26,10 @@ public:
   std::atomic<std::uint64_t> cnt_const_mixed_params{0u};
   std::atomic<std::uint64_t> cnt_make_clone{0u};
 
+  std::atomic<std::uint64_t> tinf_node_recalcs{0u};
+  std::atomic<std::uint64_t> tinf_lock_contentions{0u};
+  std::atomic<std::uint64_t> tinf_shared_queues{0u};
+
   std::atomic<std::uint64_t> object_out_size{0u};
   std::atomic<double> transpilation_time{0.0};
   std::atomic<double> total_time{0.0};
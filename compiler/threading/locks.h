@@ -44,6 +44,10 @@ public:
 
   virtual ~Lockable() = default;
 
+  bool try_lock() {
+    return ::try_lock(&x);
+  }
+
   void lock() {
     ::lock(&x);
   }
@@ -0,0 +1,40 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/array-keys-pool.h"
+
+#include <cstring>
+
+namespace {
+
+ArrayKeysPool::Key make_key(string str, int64_t hash) noexcept {
+  int64_t int_key = 0;
+  if (str.try_to_int(&int_key)) {
+    return {std::move(str), int_key, true};
+  }
+  return {std::move(str), hash, false};
+}
+
+} // namespace
+
+ArrayKeysPool::Key ArrayKeysPool::intern(const char *s, string::size_type len) noexcept {
+  const int64_t hash = string_hash(s, len);
+  if (len > MAX_KEY_LENGTH) {
+    return make_key(string{s, len}, hash);
+  }
+
+  // the low bits of string_hash() depend on the last bytes only
+  Key &slot = slots_[(static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> (64 - SLOTS_COUNT_LOG)];
+  const bool is_hit = slot.str.size() == len && (slot.is_int || slot.int_key == hash) && !memcmp(slot.str.c_str(), s, len);
+  if (!is_hit) {
+    slot = make_key(string{s, len}, hash);
+  }
+  return slot;
+}
+
+void ArrayKeysPool::reset() noexcept {
+  for (Key &slot : slots_) {
+    hard_reset_var(slot);
+  }
+}
@@ -0,0 +1,51 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <array>
+
+#include "common/mixin/not_copyable.h"
+#include "common/smart_ptrs/singleton.h"
+
+#include "runtime/kphp_core.h"
+
+// Decoders (json_decode(), mysql rows, tl dictionaries) produce the same short array keys over and over.
+// Such keys are interned for the duration of a script: equal keys share one string, and its hash is computed once.
+// The pool is a direct mapped cache of a fixed size, a colliding key just replaces the previous one.
+class ArrayKeysPool : vk::not_copyable {
+public:
+  static constexpr string::size_type MAX_KEY_LENGTH = 32;
+
+  struct Key {
+    string str;
+    // the key itself for int like strings ("123"), the string hash otherwise (as map entries of arrays store it)
+    int64_t int_key{0};
+    bool is_int{false};
+
+    template<class T, class V>
+    void set_value_to(array<T> &arr, V &&value) const noexcept {
+      if (is_int) {
+        arr.set_value(int_key, std::forward<V>(value));
+      } else {
+        arr.set_value(str, std::forward<V>(value), int_key);
+      }
+    }
+  };
+
+  // long keys are not interned, a new string is returned for them
+  Key intern(const char *s, string::size_type len) noexcept;
+
+  // is called at the end of a script, the strings are allocated in the script memory
+  void reset() noexcept;
+
+private:
+  ArrayKeysPool() = default;
+
+  friend class vk::singleton<ArrayKeysPool>;
+
+  static constexpr uint32_t SLOTS_COUNT_LOG = 10;
+
+  std::array<Key, 1u << SLOTS_COUNT_LOG> slots_;
+};
@@ -6,8 +6,6 @@
 
 #include <type_traits>
 
-#include "common/algorithms/fastmod.h"
-
 #ifndef INCLUDED_FROM_KPHP_CORE
   #error "this file must be included only from kphp_core.h"
 #endif
@@ -102,13 +100,32 @@ void sort(T *begin_init, T *end_init, const T1 &compare) {
 } // namespace dl
 
 template<class T>
-typename array<T>::key_type array<T>::int_hash_entry::get_key() const {
-  return key_type(int_key);
+uintptr_t array<T>::map_entry::get_tag() const {
+  static_assert(sizeof(string) == sizeof(uintptr_t), "string is a pointer");
+  uintptr_t tag = 0;
+  memcpy(&tag, static_cast<const void *>(&string_key), sizeof(tag));
+  return tag;
+}
+
+template<class T>
+void array<T>::map_entry::set_tag(uintptr_t tag) {
+  memcpy(static_cast<void *>(&string_key), &tag, sizeof(tag));
+}
+
+template<class T>
+bool array<T>::map_entry::is_string_key() const {
+  // string pointers are never null and aligned
+  return get_tag() > DELETED_TAG;
+}
+
+template<class T>
+bool array<T>::map_entry::is_deleted() const {
+  return get_tag() == DELETED_TAG;
 }
 
 template<class T>
-typename array<T>::key_type array<T>::string_hash_entry::get_key() const {
-  return key_type(string_key);
+typename array<T>::key_type array<T>::map_entry::get_key() const {
+  return is_string_key() ? key_type(string_key) : key_type(int_key);
 }
 
 template<class T>
@@ -120,7 +137,7 @@ template<>
 inline typename array<Unknown>::array_inner *array<Unknown>::array_inner::empty_array() {
   static array_inner_control empty_array{
     0, ExtraRefCnt::for_global_const, -1,
-    {0, 0},
+    0, 0,
     0, 2,
     0, std::numeric_limits<uint32_t>::max()
   };
@@ -133,102 +150,145 @@ typename array<T>::array_inner *array<T>::array_inner::empty_array() {
 }
 
 template<class T>
-uint32_t array<T>::array_inner::choose_bucket_int(int64_t key) const {
-  return choose_bucket(key, int_buf_size, fields_for_map().modulo_helper_int_buf_size);
+uint32_t array<T>::array_inner::choose_slot(int64_t key) const {
+  // int keys and string hashes differ mostly in the low bits, fibonacci hashing mixes them into the high ones
+  return static_cast<uint32_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> (64 - __builtin_ctz(string_buf_size)));
 }
 
 template<class T>
-uint32_t array<T>::array_inner::choose_bucket_string(int64_t key) const {
-  return choose_bucket(key, string_buf_size, fields_for_map().modulo_helper_string_buf_size);
+uint32_t array<T>::array_inner::get_key_tag(int64_t key) {
+  // bits 32..36 of the same product as in choose_slot(): the largest index takes the upper 27 bits for the slot, so they never overlap
+  static_assert(MAX_HASHTABLE_SIZE * 2 <= (1ULL << (64 - 32 - (32 - ENTRY_NUM_BITS))), "the tag overlaps the slot bits");
+  return static_cast<uint32_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> (32 - ENTRY_NUM_BITS)) & ~ENTRY_NUM_MASK;
 }
 
 template<class T>
-uint32_t array<T>::array_inner::choose_bucket(int64_t key, uint32_t buf_size, uint64_t modulo_helper) {
-  return fastmod::fastmod_u32(static_cast<uint32_t>(key << 2), modulo_helper, buf_size);
+uint32_t array<T>::array_inner::make_index_slot(uint32_t entry_num, int64_t key) {
+  return get_key_tag(key) | (entry_num + 1);
 }
 
 template<class T>
-bool array<T>::array_inner::is_vector() const {
-  return string_buf_size == std::numeric_limits<uint32_t>::max();
+uint32_t array<T>::array_inner::get_entry_num(uint32_t index_slot) {
+  return (index_slot & ENTRY_NUM_MASK) - 1;
 }
 
-
 template<class T>
-typename array<T>::list_hash_entry *array<T>::array_inner::get_entry(entry_pointer_type pointer) const {
-  return (list_hash_entry * )((char *)this + pointer);
-//  return pointer;
+bool array<T>::array_inner::is_vector() const {
+  return string_buf_size == std::numeric_limits<uint32_t>::max();
 }
 
 template<class T>
-typename array<T>::entry_pointer_type array<T>::array_inner::get_pointer(list_hash_entry *entry) const {
-  return (entry_pointer_type)((char *)entry - (char *)this);
-//  return entry;
+const typename array<T>::map_entry *array<T>::array_inner::begin() const {
+  return entries + first_entry;
 }
 
-
 template<class T>
-const typename array<T>::string_hash_entry *array<T>::array_inner::begin() const {
-  return (const string_hash_entry *)get_entry(last.next);
+const typename array<T>::map_entry *array<T>::array_inner::next(const map_entry *p) const {
+  // p may be already deleted and even trimmed by unset during foreach by reference
+  const map_entry *last = end();
+  do {
+    ++p;
+  } while (p < last && p->is_deleted());
+  return p < last ? p : last;
 }
 
 template<class T>
-const typename array<T>::string_hash_entry *array<T>::array_inner::next(const string_hash_entry *p) const {
-  return (const string_hash_entry *)get_entry(p->next);
+const typename array<T>::map_entry *array<T>::array_inner::prev(const map_entry *p) const {
+  // there may be deleted entries before the first alive one, they are never visited
+  const map_entry *first = begin();
+  while (p > first) {
+    --p;
+    if (!p->is_deleted()) {
+      return p;
+    }
+  }
+  return first;
 }
 
 template<class T>
-const typename array<T>::string_hash_entry *array<T>::array_inner::prev(const string_hash_entry *p) const {
-  return (const string_hash_entry *)get_entry(p->prev);
+const typename array<T>::map_entry *array<T>::array_inner::end() const {
+  return entries + used_entries;
 }
 
 template<class T>
-const typename array<T>::string_hash_entry *array<T>::array_inner::end() const {
-  return const_cast<array<T>::array_inner *>(this)->end();
+typename array<T>::map_entry *array<T>::array_inner::begin() {
+  return const_cast<map_entry *>(static_cast<const array_inner *>(this)->begin());
 }
 
 template<class T>
-typename array<T>::string_hash_entry *array<T>::array_inner::begin() {
-  return (string_hash_entry *)get_entry(end()->next);
+typename array<T>::map_entry *array<T>::array_inner::next(map_entry *p) {
+  return const_cast<map_entry *>(static_cast<const array_inner *>(this)->next(p));
 }
 
 template<class T>
-typename array<T>::string_hash_entry *array<T>::array_inner::next(string_hash_entry *p) {
-  return (string_hash_entry *)get_entry(p->next);
+typename array<T>::map_entry *array<T>::array_inner::prev(map_entry *p) {
+  return const_cast<map_entry *>(static_cast<const array_inner *>(this)->prev(p));
 }
 
 template<class T>
-typename array<T>::string_hash_entry *array<T>::array_inner::prev(string_hash_entry *p) {
-  return (string_hash_entry *)get_entry(p->prev);
+typename array<T>::map_entry *array<T>::array_inner::end() {
+  return entries + used_entries;
 }
 
 template<class T>
-typename array<T>::string_hash_entry *array<T>::array_inner::end() {
-  return (string_hash_entry * ) &last;
+bool array<T>::array_inner::has_deleted_entries() const {
+  return used_entries - first_entry != int_size + string_size;
 }
 
 template<class T>
-bool array<T>::array_inner::is_string_hash_entry(const string_hash_entry *p) const {
-  return p >= get_string_entries();
+const uint32_t *array<T>::array_inner::get_index() const {
+  return reinterpret_cast<const uint32_t *>(entries + int_buf_size);
 }
 
 template<class T>
-const typename array<T>::string_hash_entry *array<T>::array_inner::get_string_entries() const {
-  return (const string_hash_entry *)(int_entries + int_buf_size);
+uint32_t *array<T>::array_inner::get_index() {
+  return reinterpret_cast<uint32_t *>(entries + int_buf_size);
 }
 
 template<class T>
-typename array<T>::string_hash_entry *array<T>::array_inner::get_string_entries() {
-  return (string_hash_entry * )(int_entries + int_buf_size);
+void array<T>::array_inner::remove_index_slot(uint32_t slot) {
+  // the following slots of the probe sequence are shifted back, if they don't precede their chosen slots then
+  uint32_t *index = get_index();
+  const uint32_t mask = string_buf_size - 1;
+  for (uint32_t i = (slot + 1) & mask; index[i] != EMPTY_SLOT; i = (i + 1) & mask) {
+    const uint32_t chosen = choose_slot(entries[get_entry_num(index[i])].int_key);
+    if (((i - chosen) & mask) >= ((i - slot) & mask)) {
+      index[slot] = index[i];
+      slot = i;
+    }
+  }
+  index[slot] = EMPTY_SLOT;
 }
 
 template<class T>
-typename array<T>::array_inner_fields_for_map &array<T>::array_inner::fields_for_map() {
-  return *reinterpret_cast<array_inner_fields_for_map *>(reinterpret_cast<char *>(this) - sizeof(array_inner_fields_for_map));
+void array<T>::array_inner::rebuild_index() {
+  uint32_t *index = get_index();
+  memset(index, 0, string_buf_size * sizeof(uint32_t));
+  const uint32_t mask = string_buf_size - 1;
+  for (uint32_t i = first_entry; i != used_entries; ++i) {
+    if (!entries[i].is_deleted()) {
+      uint32_t slot = choose_slot(entries[i].int_key);
+      while (index[slot] != EMPTY_SLOT) {
+        slot = (slot + 1) & mask;
+      }
+      index[slot] = make_index_slot(i, entries[i].int_key);
+    }
+  }
 }
 
 template<class T>
-const typename array<T>::array_inner_fields_for_map &array<T>::array_inner::fields_for_map() const {
-  return const_cast<array_inner *>(this)->fields_for_map();
+void array<T>::array_inner::compact() {
+  uint32_t alive = 0;
+  for (uint32_t i = first_entry; i != used_entries; ++i) {
+    if (!entries[i].is_deleted()) {
+      if (alive != i) {
+        memcpy(static_cast<void *>(&entries[alive]), static_cast<const void *>(&entries[i]), sizeof(map_entry));
+      }
+      ++alive;
+    }
+  }
+  used_entries = alive;
+  first_entry = 0;
 }
 
 template<class T>
@@ -237,8 +297,8 @@ size_t array<T>::array_inner::sizeof_vector(uint32_t int_size) {
 }
 
 template<class T>
-size_t array<T>::array_inner::sizeof_map(uint32_t int_size, uint32_t string_size) {
-  return sizeof(array_inner_fields_for_map) + sizeof(array_inner) + int_size * sizeof(int_hash_entry) + string_size * sizeof(string_hash_entry);
+size_t array<T>::array_inner::sizeof_map(uint32_t entries_size, uint32_t index_size) {
+  return sizeof(array_inner) + entries_size * sizeof(map_entry) + index_size * sizeof(uint32_t);
 }
 
 template<class T>
@@ -256,14 +316,11 @@ size_t array<T>::array_inner::estimate_size(int64_t &new_int_size, int64_t &new_
     return sizeof_vector(static_cast<uint32_t>(new_int_size));
   }
 
-  new_int_size = 2 * new_int_size + 3;
-  if (new_int_size % 5 == 0) {
-    new_int_size += 2;
-  }
-
-  new_string_size = 2 * new_string_size + 3;
-  if (new_string_size % 5 == 0) {
-    new_string_size += 2;
+  // the index is at most half full, so that probe sequences are short
+  new_int_size = std::max(new_int_size + new_string_size, int64_t{4});
+  new_string_size = 8;
+  while (new_string_size < 2 * new_int_size) {
+    new_string_size *= 2;
   }
 
   return sizeof_map(static_cast<uint32_t>(new_int_size), static_cast<uint32_t>(new_string_size));
@@ -272,35 +329,21 @@ size_t array<T>::array_inner::estimate_size(int64_t &new_int_size, int64_t &new_
 template<class T>
 typename array<T>::array_inner *array<T>::array_inner::create(int64_t new_int_size, int64_t new_string_size, bool is_vector) {
   const size_t mem_size = estimate_size(new_int_size, new_string_size, is_vector);
+  auto p = reinterpret_cast<array_inner *>(dl::allocate(mem_size));
+  p->ref_cnt = 0;
+  p->max_key = -1;
+  p->int_size = 0;
+  p->int_buf_size = static_cast<uint32_t>(new_int_size);
+  p->string_size = 0;
   if (is_vector) {
-    auto p = reinterpret_cast<array_inner *>(dl::allocate(mem_size));
-    p->ref_cnt = 0;
-    p->max_key = -1;
-    p->int_size = 0;
-    p->int_buf_size = static_cast<uint32_t>(new_int_size);
-    p->string_size = 0;
     p->string_buf_size = std::numeric_limits<uint32_t>::max();
     return p;
   }
 
-  auto shift_pointer_to_array_inner = [](void *mem) {
-    return reinterpret_cast<array_inner *>(static_cast<char *>(mem) + sizeof(array_inner_fields_for_map));
-  };
-
-  array_inner *p = shift_pointer_to_array_inner(dl::allocate0(mem_size));
-  p->ref_cnt = 0;
-  p->max_key = -1;
-  p->end()->next = p->get_pointer(p->end());
-  p->end()->prev = p->get_pointer(p->end());
-
-  p->int_buf_size = static_cast<uint32_t>(new_int_size);
-  p->fields_for_map().modulo_helper_int_buf_size = fastmod::computeM_u32(p->int_buf_size);
-
+  p->used_entries = 0;
+  p->first_entry = 0;
   p->string_buf_size = static_cast<uint32_t>(new_string_size);
-  p->fields_for_map().modulo_helper_string_buf_size = fastmod::computeM_u32(p->string_buf_size);
-
-  p->int_size = 0;
-  p->string_size = 0;
+  memset(p->get_index(), 0, p->string_buf_size * sizeof(uint32_t));
   return p;
 }
 
@@ -311,23 +354,22 @@ void array<T>::array_inner::dispose() {
     if (ref_cnt <= -1) {
       if (is_vector()) {
         for (uint32_t i = 0; i < int_size; i++) {
-          ((T *)int_entries)[i].~T();
+          ((T *)entries)[i].~T();
         }
 
         dl::deallocate((void *)this, sizeof_vector(int_buf_size));
         return;
       }
 
-      for (const string_hash_entry *it = begin(); it != end(); it = next(it)) {
+      for (map_entry *it = begin(); it != end(); it = next(it)) {
         it->value.~T();
-        if (is_string_hash_entry(it)) {
+        if (it->is_string_key()) {
           it->string_key.~string();
         }
       }
 
       php_assert(this != empty_array());
-      auto shifted_this = reinterpret_cast<char *>(this) - sizeof(array_inner_fields_for_map);
-      dl::deallocate(shifted_this, sizeof_map(int_buf_size, string_buf_size));
+      dl::deallocate((void *)this, sizeof_map(int_buf_size, string_buf_size));
     }
   }
 }
@@ -346,10 +388,10 @@ template<class ...Args>
 inline T &array<T>::array_inner::emplace_back_vector_value(Args &&... args) noexcept {
   static_assert(std::is_constructible<T, Args...>{}, "should be constructible");
   php_assert (int_size < int_buf_size);
-  new(&((T *)int_entries)[int_size]) T(std::forward<Args>(args)...);
+  new(&((T *)entries)[int_size]) T(std::forward<Args>(args)...);
   max_key++;
   int_size++;
-  return reinterpret_cast<T *>(int_entries)[max_key];
+  return reinterpret_cast<T *>(entries)[max_key];
 }
 
 template<class T>
@@ -359,19 +401,19 @@ T &array<T>::array_inner::push_back_vector_value(const T &v) {
 
 template<class T>
 T &array<T>::array_inner::get_vector_value(int64_t int_key) {
-  return reinterpret_cast<T *>(int_entries)[int_key];
+  return reinterpret_cast<T *>(entries)[int_key];
 }
 
 template<class T>
 const T &array<T>::array_inner::get_vector_value(int64_t int_key) const {
-  return reinterpret_cast<const T *>(int_entries)[int_key];
+  return reinterpret_cast<const T *>(entries)[int_key];
 }
 
 template<class T>
 template<class ...Args>
 T &array<T>::array_inner::emplace_vector_value(int64_t int_key, Args &&... args) noexcept {
   static_assert(std::is_constructible<T, Args...>{}, "should be constructible");
-  reinterpret_cast<T *>(int_entries)[int_key] = T(std::forward<Args>(args)...);
+  reinterpret_cast<T *>(entries)[int_key] = T(std::forward<Args>(args)...);
   return get_vector_value(int_key);
 }
 
@@ -384,34 +426,36 @@ template<class T>
 template<class ...Args>
 T &array<T>::array_inner::emplace_int_key_map_value(overwrite_element policy, int64_t int_key, Args &&... args) noexcept {
   static_assert(std::is_constructible<T, Args...>{}, "should be constructible");
-  uint32_t bucket = choose_bucket_int(int_key);
-  while (int_entries[bucket].next != EMPTY_POINTER && int_entries[bucket].int_key != int_key) {
-    if (unlikely (++bucket == int_buf_size)) {
-      bucket = 0;
+  uint32_t *index = get_index();
+  const uint32_t mask = string_buf_size - 1;
+  const uint32_t tag = get_key_tag(int_key);
+  uint32_t slot = choose_slot(int_key);
+  for (; index[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+    if ((index[slot] & ~ENTRY_NUM_MASK) != tag) {
+      continue;
+    }
+    map_entry &entry = entries[get_entry_num(index[slot])];
+    if (entry.int_key == int_key && entry.get_tag() == map_entry::INT_KEY_TAG) {
+      if (policy == overwrite_element::YES) {
+        entry.value = T(std::forward<Args>(args)...);
+      }
+      return entry.value;
     }
   }
 
-  if (int_entries[bucket].next == EMPTY_POINTER) {
-    int_entries[bucket].int_key = int_key;
-
-    int_entries[bucket].prev = end()->prev;
-    get_entry(end()->prev)->next = get_pointer(&int_entries[bucket]);
-
-    int_entries[bucket].next = get_pointer(end());
-    end()->prev = get_pointer(&int_entries[bucket]);
-
-    new(&int_entries[bucket].value) T(std::forward<Args>(args)...);
+  php_assert (used_entries < int_buf_size);
+  index[slot] = make_index_slot(used_entries, int_key);
+  map_entry &entry = entries[used_entries++];
+  entry.int_key = int_key;
+  entry.set_tag(map_entry::INT_KEY_TAG);
+  new(&entry.value) T(std::forward<Args>(args)...);
 
-    int_size++;
+  int_size++;
 
-    if (int_key > max_key) {
-      max_key = int_key;
-    }
-  } else if (policy == overwrite_element::YES) {
-    int_entries[bucket].value = T(std::forward<Args>(args)...);
+  if (int_key > max_key) {
+    max_key = int_key;
   }
-
-  return int_entries[bucket].value;
+  return entry.value;
 }
 
 template<class T>
@@ -422,96 +466,99 @@ T &array<T>::array_inner::set_map_value(overwrite_element policy, int64_t int_ke
 template<class T>
 T array<T>::array_inner::unset_vector_value() {
   --int_size;
-  T res = std::move(reinterpret_cast<T *>(int_entries)[max_key--]);
+  T res = std::move(reinterpret_cast<T *>(entries)[max_key--]);
   return res;
 }
 
 template<class T>
-T array<T>::array_inner::unset_map_value(int64_t int_key) {
-  uint32_t bucket = choose_bucket_int(int_key);
-  while (int_entries[bucket].next != EMPTY_POINTER && int_entries[bucket].int_key != int_key) {
-    if (unlikely (++bucket == int_buf_size)) {
-      bucket = 0;
-    }
-  }
-
-  if (int_entries[bucket].next != EMPTY_POINTER) {
-    int_entries[bucket].int_key = 0;
-
-    get_entry(int_entries[bucket].prev)->next = int_entries[bucket].next;
-    get_entry(int_entries[bucket].next)->prev = int_entries[bucket].prev;
-
-    int_entries[bucket].next = EMPTY_POINTER;
-    int_entries[bucket].prev = EMPTY_POINTER;
-
-    T res = std::move(int_entries[bucket].value);
+T array<T>::array_inner::unset_map_entry(uint32_t slot) {
+  const uint32_t entry_num = get_entry_num(get_index()[slot]);
+  remove_index_slot(slot);
 
+  // the entry stays in place until the compaction, so that iterators don't move
+  map_entry &entry = entries[entry_num];
+  T res = std::move(entry.value);
+  entry.value.~T();
+  if (entry.is_string_key()) {
+    entry.string_key.~string();
+    string_size--;
+  } else {
     int_size--;
+  }
+  entry.set_tag(map_entry::DELETED_TAG);
 
-#define FIXD(a) ((a) >= int_buf_size ? (a) - int_buf_size : (a))
-#define FIXU(a, m) ((a) <= (m) ? (a) + int_buf_size : (a))
-    uint32_t j, rj, ri = bucket;
-    for (j = bucket + 1; 1; j++) {
-      rj = FIXD(j);
-      if (int_entries[rj].next == EMPTY_POINTER) {
-        break;
-      }
-
-      uint32_t bucket_j = choose_bucket_int(int_entries[rj].int_key);
-      uint32_t wnt = FIXU(bucket_j, bucket);
-
-      if (wnt > j || wnt <= bucket) {
-        list_hash_entry *ei = int_entries + ri, *ej = int_entries + rj;
-        memcpy(ei, ej, sizeof(int_hash_entry));
-        ej->next = EMPTY_POINTER;
-
-        get_entry(ei->prev)->next = get_pointer(ei);
-        get_entry(ei->next)->prev = get_pointer(ei);
+  if (entry_num == first_entry) {
+    while (first_entry != used_entries && entries[first_entry].is_deleted()) {
+      first_entry++;
+    }
+  }
+  while (used_entries != first_entry && entries[used_entries - 1].is_deleted()) {
+    used_entries--;
+  }
+  if (first_entry == used_entries) {
+    first_entry = used_entries = 0;
+  }
+  return res;
+}
 
-        ri = rj;
-        bucket = j;
-      }
+template<class T>
+T array<T>::array_inner::unset_map_value(int64_t int_key) {
+  const uint32_t *index = get_index();
+  const uint32_t mask = string_buf_size - 1;
+  const uint32_t tag = get_key_tag(int_key);
+  for (uint32_t slot = choose_slot(int_key); index[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+    if ((index[slot] & ~ENTRY_NUM_MASK) != tag) {
+      continue;
+    }
+    const map_entry &entry = entries[get_entry_num(index[slot])];
+    if (entry.int_key == int_key && entry.get_tag() == map_entry::INT_KEY_TAG) {
+      return unset_map_entry(slot);
     }
-#undef FIXU
-#undef FIXD
-    return res;
   }
   return {};
 }
 
 template<class T>
 template<class S>
-auto &array<T>::array_inner::find_map_entry(S &self, int64_t int_key) noexcept {
-  uint32_t bucket = self.choose_bucket_int(int_key);
-  while (self.int_entries[bucket].next != EMPTY_POINTER && self.int_entries[bucket].int_key != int_key) {
-    if (unlikely (++bucket == self.int_buf_size)) {
-      bucket = 0;
+auto *array<T>::array_inner::find_map_entry(S &self, int64_t int_key) noexcept {
+  const uint32_t *index = self.get_index();
+  const uint32_t mask = self.string_buf_size - 1;
+  const uint32_t tag = get_key_tag(int_key);
+  for (uint32_t slot = self.choose_slot(int_key); index[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+    if ((index[slot] & ~ENTRY_NUM_MASK) != tag) {
+      continue;
+    }
+    auto *entry = &self.entries[get_entry_num(index[slot])];
+    if (entry->int_key == int_key && entry->get_tag() == map_entry::INT_KEY_TAG) {
+      return entry;
     }
   }
-
-  return self.int_entries[bucket];
+  return static_cast<decltype(&self.entries[0])>(nullptr);
 }
 
 template<class T>
 template<class S>
-auto &array<T>::array_inner::find_map_entry(S &self, const string &string_key, int64_t precomuted_hash) noexcept {
-  auto *string_entries = self.get_string_entries();
-  uint32_t bucket = self.choose_bucket_string(precomuted_hash);
-  while (string_entries[bucket].next != EMPTY_POINTER &&
-         (string_entries[bucket].int_key != precomuted_hash || string_entries[bucket].string_key != string_key)) {
-    if (unlikely (++bucket == self.string_buf_size)) {
-      bucket = 0;
+auto *array<T>::array_inner::find_map_entry(S &self, const string &string_key, int64_t precomuted_hash) noexcept {
+  const uint32_t *index = self.get_index();
+  const uint32_t mask = self.string_buf_size - 1;
+  const uint32_t tag = get_key_tag(precomuted_hash);
+  for (uint32_t slot = self.choose_slot(precomuted_hash); index[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+    if ((index[slot] & ~ENTRY_NUM_MASK) != tag) {
+      continue;
+    }
+    auto *entry = &self.entries[get_entry_num(index[slot])];
+    if (entry->int_key == precomuted_hash && entry->is_string_key() && entry->string_key == string_key) {
+      return entry;
     }
   }
-
-  return string_entries[bucket];
+  return static_cast<decltype(&self.entries[0])>(nullptr);
 }
 
 template<class T>
 template<class ...Key>
 const T *array<T>::array_inner::find_map_value(Key &&... key) const noexcept {
-  const auto &entry = find_map_entry(*this, std::forward<Key>(key)...);
-  return entry.next != EMPTY_POINTER ? &entry.value : nullptr;
+  const auto *entry = find_map_entry(*this, std::forward<Key>(key)...);
+  return entry ? &entry->value : nullptr;
 }
 
 template<class T>
@@ -529,35 +576,33 @@ template<class STRING, class ...Args>
 std::pair<T &, bool> array<T>::array_inner::emplace_string_key_map_value(overwrite_element policy, int64_t int_key, STRING &&string_key, Args &&... args) noexcept {
   static_assert(std::is_same<std::decay_t<STRING>, string>::value, "string_key should be string");
 
-  string_hash_entry *string_entries = get_string_entries();
-  uint32_t bucket = choose_bucket_string(int_key);
-  while (string_entries[bucket].next != EMPTY_POINTER && (string_entries[bucket].int_key != int_key || string_entries[bucket].string_key != string_key)) {
-    if (unlikely (++bucket == string_buf_size)) {
-      bucket = 0;
+  uint32_t *index = get_index();
+  const uint32_t mask = string_buf_size - 1;
+  const uint32_t tag = get_key_tag(int_key);
+  uint32_t slot = choose_slot(int_key);
+  for (; index[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+    if ((index[slot] & ~ENTRY_NUM_MASK) != tag) {
+      continue;
+    }
+    map_entry &entry = entries[get_entry_num(index[slot])];
+    if (entry.int_key == int_key && entry.is_string_key() && entry.string_key == string_key) {
+      if (policy == overwrite_element::YES) {
+        entry.value = T(std::forward<Args>(args)...);
+        return {entry.value, true};
+      }
+      return {entry.value, false};
     }
   }
 
-  bool inserted = false;
-  if (string_entries[bucket].next == EMPTY_POINTER) {
-    string_entries[bucket].int_key = int_key;
-    new(&string_entries[bucket].string_key) string{std::forward<STRING>(string_key)};
-
-    string_entries[bucket].prev = end()->prev;
-    get_entry(end()->prev)->next = get_pointer(&string_entries[bucket]);
+  php_assert (used_entries < int_buf_size);
+  index[slot] = make_index_slot(used_entries, int_key);
+  map_entry &entry = entries[used_entries++];
+  entry.int_key = int_key;
+  new(&entry.string_key) string{std::forward<STRING>(string_key)};
+  new(&entry.value) T(std::forward<Args>(args)...);
 
-    string_entries[bucket].next = get_pointer(end());
-    end()->prev = get_pointer(&string_entries[bucket]);
-
-    new(&string_entries[bucket].value) T(std::forward<Args>(args)...);
-
-    string_size++;
-    inserted = true;
-  } else if (policy == overwrite_element::YES) {
-    string_entries[bucket].value = T(std::forward<Args>(args)...);
-    inserted = true;
-  }
-
-  return {string_entries[bucket].value, inserted};
+  string_size++;
+  return {entry.value, true};
 }
 
 template<class T>
@@ -567,55 +612,17 @@ T &array<T>::array_inner::set_map_value(overwrite_element policy, int64_t int_ke
 
 template<class T>
 T array<T>::array_inner::unset_map_value(const string &string_key, int64_t precomuted_hash) {
-  string_hash_entry *string_entries = get_string_entries();
-  uint32_t bucket = choose_bucket_string(precomuted_hash);
-  while (string_entries[bucket].next != EMPTY_POINTER && (string_entries[bucket].int_key != precomuted_hash || string_entries[bucket].string_key != string_key)) {
-    if (unlikely (++bucket == string_buf_size)) {
-      bucket = 0;
+  const uint32_t *index = get_index();
+  const uint32_t mask = string_buf_size - 1;
+  const uint32_t tag = get_key_tag(precomuted_hash);
+  for (uint32_t slot = choose_slot(precomuted_hash); index[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+    if ((index[slot] & ~ENTRY_NUM_MASK) != tag) {
+      continue;
     }
-  }
-
-  if (string_entries[bucket].next != EMPTY_POINTER) {
-    string_entries[bucket].int_key = 0;
-    string_entries[bucket].string_key.~string();
-
-    get_entry(string_entries[bucket].prev)->next = string_entries[bucket].next;
-    get_entry(string_entries[bucket].next)->prev = string_entries[bucket].prev;
-
-    string_entries[bucket].next = EMPTY_POINTER;
-    string_entries[bucket].prev = EMPTY_POINTER;
-
-    T res = std::move(string_entries[bucket].value);
-
-    string_size--;
-
-#define FIXD(a) ((a) >= string_buf_size ? (a) - string_buf_size : (a))
-#define FIXU(a, m) ((a) <= (m) ? (a) + string_buf_size : (a))
-    uint32_t j, rj, ri = bucket;
-    for (j = bucket + 1; 1; j++) {
-      rj = FIXD(j);
-      if (string_entries[rj].next == EMPTY_POINTER) {
-        break;
-      }
-
-      uint32_t bucket_j = choose_bucket_string(string_entries[rj].int_key);
-      uint32_t wnt = FIXU(bucket_j, bucket);
-
-      if (wnt > j || wnt <= bucket) {
-        list_hash_entry *ei = string_entries + ri, *ej = string_entries + rj;
-        memcpy(ei, ej, sizeof(string_hash_entry));
-        ej->next = EMPTY_POINTER;
-
-        get_entry(ei->prev)->next = get_pointer(ei);
-        get_entry(ei->next)->prev = get_pointer(ei);
-
-        ri = rj;
-        bucket = j;
-      }
+    const map_entry &entry = entries[get_entry_num(index[slot])];
+    if (entry.int_key == precomuted_hash && entry.is_string_key() && entry.string_key == string_key) {
+      return unset_map_entry(slot);
     }
-#undef FIXU
-#undef FIXD
-    return res;
   }
   return {};
 }
@@ -634,7 +641,7 @@ size_t array<T>::array_inner::estimate_memory_usage() const {
     return estimate_size(int_elements, string_elements, vector_structure);
   }
   string_elements = string_size;
-  return estimate_size(++int_elements, ++string_elements, vector_structure);
+  return estimate_size(int_elements, string_elements, vector_structure);
 }
 
 template<class T>
@@ -667,7 +674,7 @@ bool array<T>::mutate_to_size_if_vector_shared(int64_t int_size) {
     array_inner *new_array = array_inner::create(int_size, 0, true);
 
     const auto size = static_cast<uint32_t>(p->int_size);
-    T *it = (T *)p->int_entries;
+    T *it = (T *)p->entries;
 
     for (uint32_t i = 0; i < size; i++) {
       new_array->push_back_vector_value(it[i]);
@@ -685,13 +692,15 @@ bool array<T>::mutate_if_map_shared(uint32_t mul) {
   if (p->ref_cnt > 0) {
     array_inner *new_array = array_inner::create(p->int_size * mul + 1, p->string_size * mul + 1, false);
 
-    for (const string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
-      if (p->is_string_hash_entry(it)) {
+    for (const map_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
+      if (it->is_string_key()) {
         new_array->set_map_value(overwrite_element::YES, it->int_key, it->string_key, it->value);
       } else {
         new_array->set_map_value(overwrite_element::YES, it->int_key, it->value);
       }
     }
+    // the next free key doesn't depend on whether the map was shared, growth in place keeps it as well
+    new_array->max_key = p->max_key;
 
     p->dispose();
     p = new_array;
@@ -725,57 +734,54 @@ void array<T>::mutate_to_size(int64_t int_size) {
 }
 
 template<class T>
-void array<T>::mutate_if_map_needed_int() {
+void array<T>::mutate_if_map_needed() {
   if (mutate_if_map_shared(2)) {
     return;
   }
 
   // not shared (ref_cnt == 0)
-  if (p->int_size * 5 > 3 * p->int_buf_size) {
-    int64_t new_int_size = max(int64_t{p->int_size * 2 + 1}, int64_t{p->string_size});
-    int64_t new_string_size = max(int64_t{p->string_size}, int64_t{p->string_buf_size >> 1} - 1);
-    array_inner *new_array = array_inner::create(new_int_size, new_string_size, false);
-
-    for (string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
-      if (p->is_string_hash_entry(it)) {
-        new_array->emplace_string_key_map_value(overwrite_element::YES,
-                                                it->int_key, std::move(it->string_key), std::move(it->value));
-      } else {
-        new_array->emplace_int_key_map_value(overwrite_element::YES,
-                                             it->int_key, std::move(it->value));
-      }
+  if (p->used_entries == p->int_buf_size) {
+    // if a quarter of entries is deleted, they are dropped in place, otherwise the map is doubled
+    if (4 * count() <= 3 * int64_t{p->int_buf_size}) {
+      p->compact();
+      p->rebuild_index();
+    } else {
+      resize_map(2 * int64_t{p->int_buf_size});
     }
-
-    p->dispose();
-    p = new_array;
   }
 }
 
 template<class T>
-void array<T>::mutate_if_map_needed_string() {
-  if (mutate_if_map_shared(2)) {
-    return;
+void array<T>::resize_map(int64_t entries_size) {
+  // not shared (ref_cnt == 0), entries are relocated like vector values in mutate_to_size()
+  if (p->has_deleted_entries()) {
+    p->compact();
   }
+  int64_t new_entries_size = entries_size;
+  int64_t new_index_size = 0;
+  const size_t mem_size = array_inner::estimate_size(new_entries_size, new_index_size, false);
+  p = static_cast<array_inner *>(dl::reallocate(p, mem_size, array_inner::sizeof_map(p->int_buf_size, p->string_buf_size)));
+  p->int_buf_size = static_cast<uint32_t>(new_entries_size);
+  p->string_buf_size = static_cast<uint32_t>(new_index_size);
+  p->rebuild_index();
+}
 
-  // not shared (ref_cnt == 0)
-  if (p->string_size * 5 > 3 * p->string_buf_size) {
-    int64_t new_int_size = max(int64_t{p->int_size}, int64_t{p->int_buf_size >> 1} - 1);
-    int64_t new_string_size = max(int64_t{p->string_size * 2 + 1}, int64_t{p->int_size});
-    array_inner *new_array = array_inner::create(new_int_size, new_string_size, false);
-
-    for (string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
-      if (p->is_string_hash_entry(it)) {
-        new_array->emplace_string_key_map_value(overwrite_element::YES,
-                                                it->int_key, std::move(it->string_key), std::move(it->value));
-      } else {
-        new_array->emplace_int_key_map_value(overwrite_element::YES,
-                                             it->int_key, std::move(it->value));
-      }
-    }
-
-    p->dispose();
-    p = new_array;
+template<class T>
+void array<T>::reorder_map(const uint32_t *order) {
+  // not shared (ref_cnt == 0), order contains the numbers of all alive entries
+  const uint32_t size = static_cast<uint32_t>(count());
+  array_inner *new_array = array_inner::create(p->int_buf_size, 0, false);
+  for (uint32_t i = 0; i != size; ++i) {
+    memcpy(static_cast<void *>(&new_array->entries[i]), static_cast<const void *>(&p->entries[order[i]]), sizeof(map_entry));
   }
+  new_array->max_key = p->max_key;
+  new_array->used_entries = size;
+  new_array->int_size = p->int_size;
+  new_array->string_size = p->string_size;
+  new_array->rebuild_index();
+
+  dl::deallocate((void *)p, array_inner::sizeof_map(p->int_buf_size, p->string_buf_size));
+  p = new_array;
 }
 
 template<class T>
@@ -783,34 +789,32 @@ void array<T>::mutate_to_map_if_vector_or_map_need_string() {
   if (is_vector()) {
     convert_to_map();
   } else {
-    mutate_if_map_needed_string();
+    mutate_if_map_needed();
   }
 }
 
 template<class T>
 void array<T>::reserve(int64_t int_size, int64_t string_size, bool make_vector_if_possible) {
-  if (int_size > int64_t{p->int_buf_size} || (string_size > 0 && string_size > int64_t{p->string_buf_size})) {
-    if (is_vector() && string_size == 0 && make_vector_if_possible) {
+  if (!is_vector()) {
+    const int64_t entries_size = int_size + string_size;
+    if (entries_size > int64_t{p->int_buf_size}) {
+      mutate_if_map_shared();
+      if (entries_size > int64_t{p->int_buf_size}) {
+        resize_map(entries_size);
+      }
+    }
+    return;
+  }
+
+  if (int_size > int64_t{p->int_buf_size}) {
+    if (string_size == 0 && make_vector_if_possible) {
       mutate_to_size(int_size);
     } else {
-      const int64_t new_int_size = std::max(int_size, int64_t{p->int_buf_size});
-      const int64_t new_string_size = std::max(string_size, is_vector() ? 0L : int64_t{p->string_buf_size});
-      array_inner *new_array = array_inner::create(new_int_size, new_string_size, false);
-
-      if (is_vector()) {
-        for (uint32_t it = 0; it != p->int_size; it++) {
-          new_array->set_map_value(overwrite_element::YES, it, ((T *)p->int_entries)[it]);
-        }
-        php_assert (new_array->max_key == p->max_key);
-      } else {
-        for (const string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
-          if (p->is_string_hash_entry(it)) {
-            new_array->set_map_value(overwrite_element::YES, it->int_key, it->string_key, it->value);
-          } else {
-            new_array->set_map_value(overwrite_element::YES, it->int_key, it->value);
-          }
-        }
+      array_inner *new_array = array_inner::create(int_size, string_size, false);
+      for (uint32_t it = 0; it != p->int_size; it++) {
+        new_array->set_map_value(overwrite_element::YES, it, ((T *)p->entries)[it]);
       }
+      php_assert (new_array->max_key == p->max_key);
 
       p->dispose();
       p = new_array;
@@ -866,9 +870,9 @@ typename array<T>::iterator array<T>::end() {
 
 template<class T>
 void array<T>::convert_to_map() {
-  array_inner *new_array = array_inner::create(p->int_size + 4, p->int_size + 4, false);
+  array_inner *new_array = array_inner::create(p->int_size + 4, 0, false);
 
-  T *elements = reinterpret_cast<T *>(p->int_entries);
+  T *elements = reinterpret_cast<T *>(p->entries);
   const bool move_values = p->ref_cnt == 0;
   if (move_values) {
     for (uint32_t it = 0; it != p->int_size; it++) {
@@ -898,13 +902,13 @@ void array<T>::copy_from(const array<T1> &other) {
 
   if (new_array->is_vector()) {
     uint32_t size = other.p->int_size;
-    T1 *it = reinterpret_cast<T1 *>(other.p->int_entries);
+    T1 *it = reinterpret_cast<T1 *>(other.p->entries);
     for (uint32_t i = 0; i < size; i++) {
       new_array->push_back_vector_value(convert_to<T>::convert(it[i]));
     }
   } else {
-    for (const typename array<T1>::string_hash_entry *it = other.p->begin(); it != other.p->end(); it = other.p->next(it)) {
-      if (other.p->is_string_hash_entry(it)) {
+    for (const typename array<T1>::map_entry *it = other.p->begin(); it != other.p->end(); it = other.p->next(it)) {
+      if (it->is_string_key()) {
         new_array->set_map_value(overwrite_element::YES, it->int_key, it->string_key, convert_to<T>::convert(it->value));
       } else {
         new_array->set_map_value(overwrite_element::YES, it->int_key, convert_to<T>::convert(it->value));
@@ -936,13 +940,13 @@ void array<T>::move_from(array<T1> &&other) noexcept {
 
   if (new_array->is_vector()) {
     uint32_t size = other.p->int_size;
-    T1 *it = reinterpret_cast<T1 *>(other.p->int_entries);
+    T1 *it = reinterpret_cast<T1 *>(other.p->entries);
     for (uint32_t i = 0; i < size; i++) {
       new_array->emplace_back_vector_value(convert_to<T>::convert(std::move(it[i])));
     }
   } else {
     for (auto it = other.p->begin(); it != other.p->end(); it = other.p->next(it)) {
-      if (other.p->is_string_hash_entry(it)) {
+      if (it->is_string_key()) {
         new_array->emplace_string_key_map_value(overwrite_element::YES, it->int_key,
                                                 std::move(it->string_key), convert_to<T>::convert(std::move(it->value)));
       } else {
@@ -1089,7 +1093,7 @@ T &array<T>::operator[](int64_t int_key) {
 
     convert_to_map();
   } else {
-    mutate_if_map_needed_int();
+    mutate_if_map_needed();
   }
 
   return p->emplace_int_key_map_value(overwrite_element::NO, int_key);
@@ -1135,11 +1139,11 @@ T &array<T>::operator[](double double_key) {
 template<class T>
 T &array<T>::operator[](const const_iterator &it) noexcept {
   if (it.self_->is_vector()) {
-    const auto key = static_cast<int64_t>(reinterpret_cast<const T *>(it.entry_) - reinterpret_cast<const T *>(it.self_->int_entries));
+    const auto key = static_cast<int64_t>(reinterpret_cast<const T *>(it.entry_) - reinterpret_cast<const T *>(it.self_->entries));
     return operator[](key);
   }
-  auto *entry = reinterpret_cast<const string_hash_entry *>(it.entry_);
-  if (it.self_->is_string_hash_entry(entry)) {
+  auto *entry = reinterpret_cast<const map_entry *>(it.entry_);
+  if (entry->is_string_key()) {
     mutate_to_map_if_vector_or_map_need_string();
     return p->emplace_string_key_map_value(overwrite_element::NO, entry->int_key, entry->string_key).first;
   }
@@ -1168,7 +1172,7 @@ void array<T>::emplace_value(int64_t int_key, Args &&... args) noexcept {
 
     convert_to_map();
   } else {
-    mutate_if_map_needed_int();
+    mutate_if_map_needed();
   }
 
   p->emplace_int_key_map_value(overwrite_element::YES, int_key, std::forward<Args>(args)...);
@@ -1285,12 +1289,12 @@ void array<T>::set_value(const Optional<OptionalT> &key, const T &value) noexcep
 template<class T>
 void array<T>::set_value(const const_iterator &it) noexcept {
   if (it.self_->is_vector()) {
-    const auto key = static_cast<int64_t>(reinterpret_cast<const T *>(it.entry_) - reinterpret_cast<const T *>(it.self_->int_entries));
+    const auto key = static_cast<int64_t>(reinterpret_cast<const T *>(it.entry_) - reinterpret_cast<const T *>(it.self_->entries));
     emplace_value(key, *reinterpret_cast<const T *>(it.entry_));
     return;
   }
-  auto *entry = reinterpret_cast<const string_hash_entry *>(it.entry_);
-  if (it.self_->is_string_hash_entry(entry)) {
+  auto *entry = reinterpret_cast<const map_entry *>(it.entry_);
+  if (entry->is_string_key()) {
     mutate_to_map_if_vector_or_map_need_string();
     p->emplace_string_key_map_value(overwrite_element::YES, entry->int_key, entry->string_key, entry->value);
   } else {
@@ -1359,11 +1363,11 @@ const T *array<T>::find_value(double double_key) const noexcept {
 template<class T>
 const T *array<T>::find_value(const const_iterator &it) const noexcept {
   if (it.self_->is_vector()) {
-    const auto key = static_cast<int64_t>(reinterpret_cast<const T *>(it.entry_) - reinterpret_cast<const T *>(it.self_->int_entries));
+    const auto key = static_cast<int64_t>(reinterpret_cast<const T *>(it.entry_) - reinterpret_cast<const T *>(it.self_->entries));
     return find_value(key);
   } else {
-    auto *entry = reinterpret_cast<const string_hash_entry *>(it.entry_);
-    return it.self_->is_string_hash_entry(entry)
+    auto *entry = reinterpret_cast<const map_entry *>(it.entry_);
+    return entry->is_string_key()
            ? find_value(entry->string_key, entry->int_key)
            : find_value(entry->int_key);
   }
@@ -1378,7 +1382,7 @@ template<class T>
 typename array<T>::iterator array<T>::find_no_mutate(int64_t int_key) noexcept {
   if (p->is_vector()) {
     if (auto *vector_entry = p->find_vector_value(int_key)) {
-      return iterator{p, reinterpret_cast<list_hash_entry *>(vector_entry)};
+      return iterator{p, reinterpret_cast<map_entry *>(vector_entry)};
     }
     return end_no_mutate();
   }
@@ -1400,9 +1404,8 @@ typename array<T>::iterator array<T>::find_no_mutate(const string &string_key) n
 template<class T>
 template<class ...Key>
 typename array<T>::iterator array<T>::find_iterator_in_map_no_mutate(const Key &... key) noexcept {
-  list_hash_entry &map_entry = array_inner::find_map_entry(*p, key...);
-  if (map_entry.next != array_inner::EMPTY_POINTER) {
-    return iterator{p, &map_entry};
+  if (auto *entry = array_inner::find_map_entry(*p, key...)) {
+    return iterator{p, entry};
   }
   return end_no_mutate();
 }
@@ -1579,7 +1582,7 @@ const array<T> array<T>::operator+(const array<T> &other) const {
 
   if (is_vector()) {
     uint32_t size = p->int_size;
-    T *it = (T *)p->int_entries;
+    T *it = (T *)p->entries;
 
     if (result.is_vector()) {
       for (uint32_t i = 0; i < size; i++) {
@@ -1591,8 +1594,8 @@ const array<T> array<T>::operator+(const array<T> &other) const {
       }
     }
   } else {
-    for (const string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
-      if (p->is_string_hash_entry(it)) {
+    for (const map_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
+      if (it->is_string_key()) {
         result.p->set_map_value(overwrite_element::YES, it->int_key, it->string_key, it->value);
       } else {
         result.p->set_map_value(overwrite_element::YES, it->int_key, it->value);
@@ -1602,7 +1605,7 @@ const array<T> array<T>::operator+(const array<T> &other) const {
 
   if (other.is_vector()) {
     uint32_t size = other.p->int_size;
-    T *it = (T *)other.p->int_entries;
+    T *it = (T *)other.p->entries;
 
     if (result.is_vector()) {
       for (uint32_t i = p->int_size; i < size; i++) {
@@ -1614,8 +1617,8 @@ const array<T> array<T>::operator+(const array<T> &other) const {
       }
     }
   } else {
-    for (const string_hash_entry *it = other.p->begin(); it != other.p->end(); it = other.p->next(it)) {
-      if (other.p->is_string_hash_entry(it)) {
+    for (const map_entry *it = other.p->begin(); it != other.p->end(); it = other.p->next(it)) {
+      if (it->is_string_key()) {
         result.p->set_map_value(overwrite_element::NO, it->int_key, it->string_key, it->value);
       } else {
         result.p->set_map_value(overwrite_element::NO, it->int_key, it->value);
@@ -1634,11 +1637,11 @@ array<T> &array<T>::operator+=(const array<T> &other) {
   if (is_vector()) {
     if (other.is_vector()) {
       uint32_t size = other.p->int_size;
-      T *it = (T *)other.p->int_entries;
+      T *it = (T *)other.p->entries;
 
       if (p->ref_cnt > 0) {
         uint32_t my_size = p->int_size;
-        T *my_it = (T *)p->int_entries;
+        T *my_it = (T *)p->entries;
 
         array_inner *new_array = array_inner::create(max(size, my_size), 0, true);
 
@@ -1664,8 +1667,8 @@ array<T> &array<T>::operator+=(const array<T> &other) {
 
       return *this;
     } else {
-      array_inner *new_array = array_inner::create(p->int_size + other.p->int_size + 4, other.p->string_size + 4, false);
-      T *it = (T *)p->int_entries;
+      array_inner *new_array = array_inner::create(p->int_size + other.count() + 4, 0, false);
+      T *it = (T *)p->entries;
 
       for (uint32_t i = 0; i != p->int_size; i++) {
         new_array->set_map_value(overwrite_element::YES, i, it[i]);
@@ -1679,35 +1682,37 @@ array<T> &array<T>::operator+=(const array<T> &other) {
       return *this;
     }
 
-    uint32_t new_int_size = p->int_size + other.p->int_size;
-    uint32_t new_string_size = p->string_size + other.p->string_size;
+    const int64_t new_size = count() + other.count();
 
-    if (new_int_size * 5 > 3 * p->int_buf_size || new_string_size * 5 > 3 * p->string_buf_size || p->ref_cnt > 0) {
-      array_inner *new_array = array_inner::create(max(new_int_size, 2 * p->int_size) + 1, max(new_string_size, 2 * p->string_size) + 1, false);
+    if (p->ref_cnt > 0) {
+      array_inner *new_array = array_inner::create(max(new_size, 2 * count()) + 1, 0, false);
 
-      for (const string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
-        if (p->is_string_hash_entry(it)) {
+      for (const map_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
+        if (it->is_string_key()) {
           new_array->set_map_value(overwrite_element::YES, it->int_key, it->string_key, it->value);
         } else {
           new_array->set_map_value(overwrite_element::YES, it->int_key, it->value);
         }
       }
+      new_array->max_key = p->max_key;
 
       p->dispose();
       p = new_array;
+    } else if (p->used_entries + other.count() > p->int_buf_size) {
+      resize_map(max(new_size, 2 * int64_t{p->int_buf_size}));
     }
   }
 
   if (other.is_vector()) {
     uint32_t size = other.p->int_size;
-    T *it = (T *)other.p->int_entries;
+    T *it = (T *)other.p->entries;
 
     for (uint32_t i = 0; i < size; i++) {
       p->set_map_value(overwrite_element::NO, i, it[i]);
     }
   } else {
-    for (string_hash_entry *it = other.p->begin(); it != other.p->end(); it = other.p->next(it)) {
-      if (other.p->is_string_hash_entry(it)) {
+    for (map_entry *it = other.p->begin(); it != other.p->end(); it = other.p->next(it)) {
+      if (it->is_string_key()) {
         p->set_map_value(overwrite_element::NO, it->int_key, it->string_key, it->value);
       } else {
         p->set_map_value(overwrite_element::NO, it->int_key, it->value);
@@ -1725,7 +1730,7 @@ T &array<T>::emplace_back(Args &&... args) noexcept {
     mutate_if_vector_needed_int();
     return p->emplace_back_vector_value(std::forward<Args>(args)...);
   } else {
-    mutate_if_map_needed_int();
+    mutate_if_map_needed();
     return p->emplace_int_key_map_value(overwrite_element::YES, get_next_key(), std::forward<Args>(args)...);
   }
 }
@@ -1758,8 +1763,8 @@ void array<T>::push_back_iterator(const array_iterator<T1> &it) noexcept {
   if (it.self_->is_vector()) {
     emplace_back(*reinterpret_cast<const T1 *>(it.entry_));
   } else {
-    auto *entry = reinterpret_cast<typename array_iterator<T1>::string_hash_type *>(it.entry_);
-    if (it.self_->is_string_hash_entry(entry)) {
+    const auto *entry = it.entry_;
+    if (entry->is_string_key()) {
       mutate_to_map_if_vector_or_map_need_string();
 
       // don't overwrite existing element if we are in merge_recursive::YES mode,
@@ -1776,7 +1781,7 @@ void array<T>::push_back_iterator(const array_iterator<T1> &it) noexcept {
         mutate_if_vector_needed_int();
         p->push_back_vector_value(entry->value);
       } else {
-        mutate_if_map_needed_int();
+        mutate_if_map_needed();
         p->set_map_value(overwrite_element::YES, get_next_key(), entry->value);
       }
     }
@@ -1812,7 +1817,7 @@ void array<T>::swap_int_keys(int64_t idx1, int64_t idx2) noexcept {
   // this function is supposed to be used for vector optimization, else branch is just to be on the safe side
   if (is_vector() && idx1 >= 0 && idx2 >= 0 && idx1 < p->int_size && idx2 < p->int_size) {
     mutate_if_vector_shared();
-    std::swap(reinterpret_cast<T *>(p->int_entries)[idx1], reinterpret_cast<T *>(p->int_entries)[idx2]);
+    std::swap(reinterpret_cast<T *>(p->entries)[idx1], reinterpret_cast<T *>(p->entries)[idx2]);
   } else {
     if (auto *v1 = find_value(idx1)) {
       if (auto *v2 = find_value(idx2)) {
@@ -1828,7 +1833,7 @@ template<class T>
 void array<T>::fill_vector(int64_t num, const T &value) {
   php_assert(is_vector() && p->int_size == 0 && num <= p->int_buf_size);
 
-  std::uninitialized_fill((T *)p->int_entries, (T *)p->int_entries + num, value);
+  std::uninitialized_fill((T *)p->entries, (T *)p->entries + num, value);
   p->max_key = num - 1;
   p->int_size = static_cast<uint32_t>(num);
 }
@@ -1839,7 +1844,7 @@ void array<T>::memcpy_vector(int64_t num __attribute__((unused)), const void *sr
     php_assert(is_vector() && p->int_size == 0 && num <= p->int_buf_size);
     mutate_if_vector_shared();
 
-    memcpy(p->int_entries, src_buf, num * sizeof(T));
+    memcpy(reinterpret_cast<T *>(p->entries), src_buf, num * sizeof(T));
     p->max_key = num - 1;
     p->int_size = static_cast<uint32_t>(num);
   } else {
@@ -1847,6 +1852,18 @@ void array<T>::memcpy_vector(int64_t num __attribute__((unused)), const void *sr
   }
 }
 
+template<class T>
+template<class S>
+void array<T>::convert_vector(int64_t num, const S *src_buf) {
+  static_assert(std::is_arithmetic_v<T> && std::is_arithmetic_v<S>, "only arithmetic items can be converted");
+  php_assert(is_vector() && p->int_size == 0 && num <= p->int_buf_size);
+  mutate_if_vector_shared();
+
+  std::copy(src_buf, src_buf + num, reinterpret_cast<T *>(p->entries));
+  p->max_key = num - 1;
+  p->int_size = static_cast<uint32_t>(num);
+}
+
 
 template<class T>
 int64_t array<T>::get_next_key() const {
@@ -1866,7 +1883,7 @@ void array<T>::sort(const T1 &compare, bool renumber) {
 
     if (!is_vector()) {
       array_inner *res = array_inner::create(n, 0, true);
-      for (string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
+      for (map_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
         res->push_back_vector_value(it->value);
       }
 
@@ -1880,7 +1897,7 @@ void array<T>::sort(const T1 &compare, bool renumber) {
       [&compare](const T &lhs, const T &rhs) {
         return compare(lhs, rhs) > 0;
       };
-    T *begin = reinterpret_cast<T *>(p->int_entries);
+    T *begin = reinterpret_cast<T *>(p->entries);
     dl::sort<T, decltype(elements_cmp)>(begin, begin + n, elements_cmp);
     return;
   }
@@ -1895,29 +1912,23 @@ void array<T>::sort(const T1 &compare, bool renumber) {
     mutate_if_map_shared();
   }
 
-  int_hash_entry **arTmp = (int_hash_entry **)dl::allocate(n * sizeof(int_hash_entry * ));
-  uint32_t i = 0;
-  for (string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
-    arTmp[i++] = (int_hash_entry *)it;
+  // the index is rebuilt by reorder_map()
+  p->compact();
+
+  auto *order = static_cast<uint32_t *>(dl::allocate(n * sizeof(uint32_t)));
+  for (uint32_t i = 0; i != n; i++) {
+    order[i] = i;
   }
-  php_assert (i == n);
 
-  const auto hash_entry_cmp =
-    [&compare](const int_hash_entry *lhs, const int_hash_entry *rhs) {
-      return compare(lhs->value, rhs->value) > 0;
+  const map_entry *entries = p->entries;
+  const auto entry_cmp =
+    [&compare, entries](uint32_t lhs, uint32_t rhs) {
+      return compare(entries[lhs].value, entries[rhs].value) > 0;
     };
-  dl::sort<int_hash_entry *, decltype(hash_entry_cmp)>(arTmp, arTmp + n, hash_entry_cmp);
-
-  arTmp[0]->prev = p->get_pointer(p->end());
-  p->end()->next = p->get_pointer(arTmp[0]);
-  for (uint32_t j = 1; j < n; j++) {
-    arTmp[j]->prev = p->get_pointer(arTmp[j - 1]);
-    arTmp[j - 1]->next = p->get_pointer(arTmp[j]);
-  }
-  arTmp[n - 1]->next = p->get_pointer(p->end());
-  p->end()->prev = p->get_pointer(arTmp[n - 1]);
+  dl::sort<uint32_t, decltype(entry_cmp)>(order, order + n, entry_cmp);
 
-  dl::deallocate(arTmp, n * sizeof(int_hash_entry * ));
+  reorder_map(order);
+  dl::deallocate(order, n * sizeof(uint32_t));
 }
 
 
@@ -1935,50 +1946,25 @@ void array<T>::ksort(const T1 &compare) {
     mutate_if_map_shared();
   }
 
+  // the index is rebuilt by reorder_map()
+  p->compact();
+
   array<key_type> keys(array_size(n, 0, true));
-  for (string_hash_entry *it = p->begin(); it != p->end(); it = p->next(it)) {
-    if (p->is_string_hash_entry(it)) {
-      keys.p->push_back_vector_value(it->get_key());
-    } else {
-      keys.p->push_back_vector_value(((int_hash_entry *)it)->get_key());
-    }
+  auto *order = static_cast<uint32_t *>(dl::allocate(n * sizeof(uint32_t)));
+  for (uint32_t i = 0; i != n; i++) {
+    keys.p->push_back_vector_value(p->entries[i].get_key());
+    order[i] = i;
   }
 
-  key_type *keysp = (key_type *)keys.p->int_entries;
-  dl::sort<key_type, T1>(keysp, keysp + n, compare);
-
-  list_hash_entry *prev = (list_hash_entry *)p->end();
-  for (uint32_t j = 0; j < n; j++) {
-    list_hash_entry *cur;
-    if (is_int_key(keysp[j])) {
-      int64_t int_key = keysp[j].to_int();
-      uint32_t bucket = p->choose_bucket_int(int_key);
-      while (p->int_entries[bucket].int_key != int_key) {
-        if (unlikely (++bucket == p->int_buf_size)) {
-          bucket = 0;
-        }
-      }
-      cur = (list_hash_entry * ) & p->int_entries[bucket];
-    } else {
-      string string_key = keysp[j].to_string();
-      int64_t int_key = string_key.hash();
-      string_hash_entry *string_entries = p->get_string_entries();
-      uint32_t bucket = p->choose_bucket_string(int_key);
-      while ((string_entries[bucket].int_key != int_key || string_entries[bucket].string_key != string_key)) {
-        if (unlikely (++bucket == p->string_buf_size)) {
-          bucket = 0;
-        }
-      }
-      cur = (list_hash_entry * ) & string_entries[bucket];
-    }
-
-    cur->prev = p->get_pointer(prev);
-    prev->next = p->get_pointer(cur);
+  const key_type *keysp = (const key_type *)keys.p->entries;
+  const auto key_cmp =
+    [&compare, keysp](uint32_t lhs, uint32_t rhs) {
+      return compare(keysp[lhs], keysp[rhs]);
+    };
+  dl::sort<uint32_t, decltype(key_cmp)>(order, order + n, key_cmp);
 
-    prev = cur;
-  }
-  prev->next = p->get_pointer(p->end());
-  p->end()->prev = p->get_pointer(prev);
+  reorder_map(order);
+  dl::deallocate(order, n * sizeof(uint32_t));
 }
 
 
@@ -2001,9 +1987,9 @@ T array<T>::pop() {
   }
 
   mutate_if_map_shared();
-  string_hash_entry *it = p->prev(p->end());
+  map_entry *it = p->prev(p->end());
 
-  return p->is_string_hash_entry(it) ?
+  return it->is_string_key() ?
     p->unset_map_value(it->string_key, it->int_key) :
     p->unset_map_value(it->int_key);
 }
@@ -2018,7 +2004,7 @@ T array<T>::shift() {
   if (is_vector()) {
     mutate_if_vector_shared();
 
-    T *it = (T *)p->int_entries;
+    T *it = (T *)p->entries;
     T res = *it;
 
     it->~T();
@@ -2031,12 +2017,12 @@ T array<T>::shift() {
     bool is_v = (new_size.string_size == 0);
 
     array_inner *new_array = array_inner::create(new_size.int_size, new_size.string_size, is_v);
-    string_hash_entry *it = p->begin();
+    map_entry *it = p->begin();
     T res = it->value;
 
     it = p->next(it);
     while (it != p->end()) {
-      if (p->is_string_hash_entry(it)) {
+      if (it->is_string_key()) {
         new_array->set_map_value(overwrite_element::YES, it->int_key, it->string_key, it->value);
       } else {
         if (is_v) {
@@ -2061,7 +2047,7 @@ int64_t array<T>::unshift(const T &val) {
   if (is_vector()) {
     mutate_if_vector_needed_int();
 
-    T *it = (T *)p->int_entries;
+    T *it = (T *)p->entries;
     memmove((void *)(it + 1), it, p->int_size++ * sizeof(T));
     p->max_key++;
     new(it) T(val);
@@ -2070,7 +2056,7 @@ int64_t array<T>::unshift(const T &val) {
     bool is_v = (new_size.string_size == 0);
 
     array_inner *new_array = array_inner::create(new_size.int_size + 1, new_size.string_size, is_v);
-    string_hash_entry *it = p->begin();
+    map_entry *it = p->begin();
 
     if (is_v) {
       new_array->push_back_vector_value(val);
@@ -2079,7 +2065,7 @@ int64_t array<T>::unshift(const T &val) {
     }
 
     while (it != p->end()) {
-      if (p->is_string_hash_entry(it)) {
+      if (it->is_string_key()) {
         new_array->set_map_value(overwrite_element::YES, it->int_key, it->string_key, it->value);
       } else {
         if (is_v) {
@@ -2147,7 +2133,7 @@ void array<T>::force_destroy(ExtraRefCnt expected_ref_cnt) noexcept {
 template<class T>
 typename array<T>::iterator array<T>::begin_no_mutate() {
   if (is_vector()) {
-    return typename array<T>::iterator(p, p->int_entries);
+    return typename array<T>::iterator(p, p->entries);
   }
   return typename array<T>::iterator(p, p->begin());
 }
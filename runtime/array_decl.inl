@@ -37,20 +37,16 @@ enum class overwrite_element { YES, NO };
 
 enum class merge_recursive { YES, NO };
 
-using list_entry_pointer_type = uint32_t;
-
-struct array_list_hash_entry {
-  list_entry_pointer_type next;
-  list_entry_pointer_type prev;
-};
-
 struct array_inner_control {
   // This stub field is needed to ensure the alignment during the const arrays generation
   // TODO: figure out something smarter
   int stub;
   int ref_cnt;
   int64_t max_key;
-  array_list_hash_entry last;
+  // for maps: entries [0, used_entries) are in use, some of them may be deleted;
+  // there are no alive entries before first_entry
+  uint32_t used_entries;
+  uint32_t first_entry;
   uint32_t int_size;
   uint32_t int_buf_size;
   uint32_t string_size;
@@ -68,74 +64,72 @@ public:
   inline static bool is_int_key(const key_type &key);
 
 private:
-  using entry_pointer_type = list_entry_pointer_type;
-  using list_hash_entry = array_list_hash_entry;
-
-  struct int_hash_entry : list_hash_entry {
+  // Map entries are kept densely in the insertion order and are found by the index of 32-bit slots after them;
+  // a slot keeps a few bits of the key hash along with the entry number, so probes rarely touch other entries.
+  // All the entries have the same size: for int keys and deleted entries,
+  // the string key holds a tag instead of a string pointer, see map_entry::get_tag().
+  struct map_entry {
     T value;
 
+    // if key is number, int_key contains this number, there is no string_key.
+    // if key is string, int_key contains hash of this string, string_key contains this string.
     int64_t int_key;
+    string string_key;
 
-    inline key_type get_key() const;
-  };
+    static constexpr uintptr_t INT_KEY_TAG = 0;
+    static constexpr uintptr_t DELETED_TAG = 1;
 
-  struct string_hash_entry : list_hash_entry {
-    T value;
+    inline uintptr_t get_tag() const __attribute__ ((always_inline));
+    inline void set_tag(uintptr_t tag) __attribute__ ((always_inline));
 
-    int64_t int_key;
-    string string_key;
+    inline bool is_string_key() const __attribute__ ((always_inline));
+    inline bool is_deleted() const __attribute__ ((always_inline));
 
     inline key_type get_key() const;
   };
 
-  // `max_key` and `string_size` could be also be there
-  // but sometimes, for simplicity, we use them in vector too
-  // to not add extra checks they are left in `array_inner`
-  struct array_inner_fields_for_map {
-    uint64_t modulo_helper_int_buf_size{0};
-    uint64_t modulo_helper_string_buf_size{0};
-  };
-
   struct array_inner : array_inner_control {
-    //if key is number, int_key contains this number, there is no string_key.
-    //if key is string, int_key contains hash of this string, string_key contains this string.
-    //empty hash_entry identified by (next == EMPTY_POINTER)
-    //vector is_identified by string_buf_size == -1
+    // vector is identified by string_buf_size == -1, its values are placed instead of entries;
+    // for maps, int_buf_size is the capacity of entries and string_buf_size is the count of index slots (a power of 2)
 
     static constexpr uint32_t MAX_HASHTABLE_SIZE = (1 << 26);
 
-    static constexpr entry_pointer_type EMPTY_POINTER = 0;
+    // index slots contain the entry number + 1 in the low bits and the tag of the key hash in the high ones
+    static constexpr uint32_t EMPTY_SLOT = 0;
+    static constexpr uint32_t ENTRY_NUM_BITS = 27;
+    static constexpr uint32_t ENTRY_NUM_MASK = (1U << ENTRY_NUM_BITS) - 1;
+    static_assert(MAX_HASHTABLE_SIZE < ENTRY_NUM_MASK, "entry numbers should fit into index slots");
 
-    int_hash_entry int_entries[0];
+    map_entry entries[0];
 
     inline bool is_vector() const __attribute__ ((always_inline));
 
-    inline list_hash_entry *get_entry(entry_pointer_type pointer) const __attribute__ ((always_inline));
-    inline entry_pointer_type get_pointer(list_hash_entry *entry) const __attribute__ ((always_inline));
-
-    inline const string_hash_entry *begin() const __attribute__ ((always_inline)) ubsan_supp("alignment");
-    inline const string_hash_entry *next(const string_hash_entry *p) const __attribute__ ((always_inline)) ubsan_supp("alignment");
-    inline const string_hash_entry *prev(const string_hash_entry *p) const __attribute__ ((always_inline)) ubsan_supp("alignment");
-    inline const string_hash_entry *end() const __attribute__ ((always_inline)) ubsan_supp("alignment");
+    inline const map_entry *begin() const __attribute__ ((always_inline));
+    inline const map_entry *next(const map_entry *p) const __attribute__ ((always_inline));
+    inline const map_entry *prev(const map_entry *p) const __attribute__ ((always_inline));
+    inline const map_entry *end() const __attribute__ ((always_inline));
 
-    inline string_hash_entry *begin() __attribute__ ((always_inline)) ubsan_supp("alignment");
-    inline string_hash_entry *next(string_hash_entry *p) __attribute__ ((always_inline)) ubsan_supp("alignment");
-    inline string_hash_entry *prev(string_hash_entry *p) __attribute__ ((always_inline)) ubsan_supp("alignment");
-    inline string_hash_entry *end() __attribute__ ((always_inline)) ubsan_supp("alignment");
+    inline map_entry *begin() __attribute__ ((always_inline));
+    inline map_entry *next(map_entry *p) __attribute__ ((always_inline));
+    inline map_entry *prev(map_entry *p) __attribute__ ((always_inline));
+    inline map_entry *end() __attribute__ ((always_inline));
 
-    inline bool is_string_hash_entry(const string_hash_entry *p) const __attribute__ ((always_inline));
-    inline const string_hash_entry *get_string_entries() const __attribute__ ((always_inline));
-    inline string_hash_entry *get_string_entries() __attribute__ ((always_inline));
+    inline bool has_deleted_entries() const __attribute__ ((always_inline));
 
-    inline array_inner_fields_for_map &fields_for_map() __attribute__((always_inline));
-    inline const array_inner_fields_for_map &fields_for_map() const __attribute__((always_inline));
+    inline const uint32_t *get_index() const __attribute__ ((always_inline));
+    inline uint32_t *get_index() __attribute__ ((always_inline));
+    inline uint32_t choose_slot(int64_t key) const __attribute__ ((always_inline));
+    inline static uint32_t get_key_tag(int64_t key) __attribute__ ((always_inline));
+    inline static uint32_t make_index_slot(uint32_t entry_num, int64_t key) __attribute__ ((always_inline));
+    inline static uint32_t get_entry_num(uint32_t index_slot) __attribute__ ((always_inline));
 
-    inline uint32_t choose_bucket_int(int64_t key) const __attribute__ ((always_inline));
-    inline uint32_t choose_bucket_string(int64_t key) const __attribute__ ((always_inline));
-    inline static uint32_t choose_bucket(int64_t key, uint32_t buf_size, uint64_t modulo_helper) __attribute__ ((always_inline));
+    inline void remove_index_slot(uint32_t slot);
+    inline void rebuild_index();
+    // removes deleted entries, alive ones are relocated
+    inline void compact();
 
     inline static size_t sizeof_vector(uint32_t int_size) __attribute__((always_inline));
-    inline static size_t sizeof_map(uint32_t int_size, uint32_t string_size) __attribute__((always_inline));
+    inline static size_t sizeof_map(uint32_t entries_size, uint32_t index_size) __attribute__((always_inline));
     inline static size_t estimate_size(int64_t &new_int_size, int64_t &new_string_size, bool is_vector);
     inline static array_inner *create(int64_t new_int_size, int64_t new_string_size, bool is_vector);
 
@@ -164,12 +158,13 @@ private:
 
     inline T unset_vector_value();
     inline T unset_map_value(int64_t int_key);
+    inline T unset_map_entry(uint32_t slot);
 
     // to avoid the const_cast, declare these functions as static with a template self parameter (this)
     template<class S>
-    static inline auto &find_map_entry(S &self, int64_t int_key) noexcept;
+    static inline auto *find_map_entry(S &self, int64_t int_key) noexcept;
     template<class S>
-    static inline auto &find_map_entry(S &self, const string &string_key, int64_t precomuted_hash) noexcept;
+    static inline auto *find_map_entry(S &self, const string &string_key, int64_t precomuted_hash) noexcept;
 
     template<class ...Key>
     inline const T *find_map_value(Key &&... key) const noexcept;
@@ -184,8 +179,8 @@ private:
 
     size_t estimate_memory_usage() const;
 
-    constexpr array_inner(int ref_cnt, int64_t max_key, list_hash_entry end, uint32_t int_size, uint32_t int_buf_size, uint32_t string_size, uint32_t string_buf_size) noexcept :
-      array_inner_control{0, ref_cnt, max_key, end, int_size, int_buf_size, string_size, string_buf_size} {
+    constexpr array_inner(int ref_cnt, int64_t max_key, uint32_t int_size, uint32_t int_buf_size, uint32_t string_size, uint32_t string_buf_size) noexcept :
+      array_inner_control{0, ref_cnt, max_key, 0, 0, int_size, int_buf_size, string_size, string_buf_size} {
     }
 
     inline array_inner(const array_inner &other) = delete;
@@ -197,9 +192,10 @@ private:
   inline void mutate_to_size(int64_t int_size);
   inline bool mutate_if_map_shared(uint32_t mul = 1);
   inline void mutate_if_vector_needed_int();
-  inline void mutate_if_map_needed_int();
-  inline void mutate_if_map_needed_string();
+  inline void mutate_if_map_needed();
   inline void mutate_to_map_if_vector_or_map_need_string();
+  inline void resize_map(int64_t entries_size);
+  inline void reorder_map(const uint32_t *order);
 
   inline void convert_to_map();
 
@@ -336,6 +332,9 @@ public:
 
   inline void fill_vector(int64_t num, const T &value);
   inline void memcpy_vector(int64_t num, const void *src_buf);
+  // like memcpy_vector, but converts elements of another arithmetic type
+  template<class S>
+  inline void convert_vector(int64_t num, const S *src_buf);
 
   inline int64_t get_next_key() const __attribute__ ((always_inline));
 
@@ -49,6 +49,30 @@ inline class_instance<T> class_instance<T>::empty_alloc() {
   return *this;
 }
 
+template<class T>
+class_instance<T> class_instance<T>::alloc_at(void *storage) {
+  static_assert(!std::is_empty<T>{}, "class T may not be empty");
+  php_assert(!o);
+  new (&o) vk::intrusive_ptr<T>(new (storage) T{});
+  o->set_refcnt(ExtraRefCnt::for_global_const);
+  return *this;
+}
+
+template<class T>
+class_instance<T> stack_instance_storage<T>::alloc() noexcept {
+  php_assert(!instance_);
+  auto res = class_instance<T>{}.alloc_at(storage_);
+  instance_ = res.get();
+  return res;
+}
+
+template<class T>
+stack_instance_storage<T>::~stack_instance_storage() noexcept {
+  if (instance_) {
+    instance_->~T();
+  }
+}
+
 template<class T>
 T *class_instance<T>::operator->() {
   if (unlikely(!o)) {
@@ -76,6 +76,7 @@ public:
   template<class... Args>
   inline class_instance<T> alloc(Args &&... args) __attribute__((always_inline));
   inline class_instance<T> empty_alloc() __attribute__((always_inline));
+  inline class_instance<T> alloc_at(void *storage) __attribute__((always_inline));
   inline void destroy() { o.reset(); }
   int64_t get_reference_counter() const { return o ? o->get_refcnt() : 0; }
 
@@ -184,6 +185,24 @@ private:
   class_instance<T> clone_impl(std::false_type /*is empty*/) const;
 };
 
+// a storage for the instance created by `new` that is proven by the compiler not to outlive the function
+// (see calc-non-escaping-instances.cpp); the instance is never deleted by refcounting,
+// it is destroyed together with the storage when the function exits
+template<class T>
+class stack_instance_storage {
+public:
+  stack_instance_storage() = default;
+  stack_instance_storage(const stack_instance_storage &) = delete;
+  stack_instance_storage &operator=(const stack_instance_storage &) = delete;
+
+  inline class_instance<T> alloc() noexcept __attribute__((always_inline));
+  inline ~stack_instance_storage() noexcept __attribute__((always_inline));
+
+private:
+  alignas(T) char storage_[sizeof(T)];
+  T *instance_{nullptr};
+};
+
 template<class T, class ...Args>
 class_instance<T> make_instance(Args &&...args) noexcept {
   class_instance<T> instance;
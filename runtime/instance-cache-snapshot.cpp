@@ -0,0 +1,303 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/instance-cache-snapshot.h"
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/kprintf.h"
+#include "common/wrappers/memory-utils.h"
+
+#include "runtime/php_assert.h"
+
+namespace impl_ {
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'K', 'P', 'H', 'P', 'I', 'C', 'S', '1'};
+constexpr size_t RECORD_ALIGNMENT = 8;
+
+// the file starts with the header, then a hash table of record offsets follows (0 for empty slots), then records
+struct SnapshotHeader {
+  char magic[8];
+  int64_t created_at;
+  uint64_t table_size;
+  uint64_t records_count;
+};
+
+// a record as it's written, followed by the key, the class name and the value;
+// 'taken' is accessed atomically by workers, see InstanceCacheSnapshot::Record
+struct RecordHeader {
+  uint32_t taken;
+  uint32_t key_size;
+  uint32_t class_name_size;
+  uint32_t value_size;
+  int64_t expiring_at;
+};
+
+// the hash must be the same in different binaries, therefore std::hash is not used
+uint64_t hash_key(vk::string_view key) noexcept {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : key) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+size_t align_record(size_t size) noexcept {
+  return (size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+bool write_all(int fd, const void *data, size_t size) noexcept {
+  const char *pos = static_cast<const char *>(data);
+  while (size) {
+    const ssize_t written = write(fd, pos, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    pos += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+} // namespace
+
+struct InstanceCacheSnapshot::Record {
+  std::atomic<uint32_t> taken;
+  uint32_t key_size;
+  uint32_t class_name_size;
+  uint32_t value_size;
+  int64_t expiring_at;
+
+  const char *key() const noexcept {
+    return reinterpret_cast<const char *>(this + 1);
+  }
+};
+
+void InstanceCacheSnapshotWriter::add(vk::string_view key, vk::string_view class_name, int64_t expiring_at, vk::string_view value) noexcept {
+  if (key.size() > UINT32_MAX || class_name.size() > UINT32_MAX || value.size() > UINT32_MAX) {
+    return;
+  }
+  const RecordHeader header{0, static_cast<uint32_t>(key.size()), static_cast<uint32_t>(class_name.size()),
+                            static_cast<uint32_t>(value.size()), expiring_at};
+  std::string record;
+  record.reserve(align_record(sizeof(header) + key.size() + class_name.size() + value.size()));
+  record.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  record.append(key.data(), key.size());
+  record.append(class_name.data(), class_name.size());
+  record.append(value.data(), value.size());
+  record.resize(align_record(record.size()), '\0');
+  records_.emplace_back(std::move(record));
+  key_hashes_.emplace_back(hash_key(key));
+}
+
+bool InstanceCacheSnapshotWriter::write(const char *file_name, int64_t now) const noexcept {
+  // the load factor is at most 0.5, so that probe sequences are short
+  uint64_t table_size = 16;
+  while (table_size < 2 * records_.size()) {
+    table_size *= 2;
+  }
+  std::vector<uint64_t> table(table_size, 0);
+  uint64_t offset = sizeof(SnapshotHeader) + table_size * sizeof(uint64_t);
+  for (size_t i = 0; i != records_.size(); ++i) {
+    uint64_t slot = key_hashes_[i] & (table_size - 1);
+    while (table[slot]) {
+      slot = (slot + 1) & (table_size - 1);
+    }
+    table[slot] = offset;
+    offset += records_[i].size();
+  }
+
+  char tmp_file_name[PATH_MAX];
+  if (snprintf(tmp_file_name, sizeof(tmp_file_name), "%s.tmp.%d", file_name, static_cast<int>(getpid())) >= static_cast<int>(sizeof(tmp_file_name))) {
+    kprintf("instance cache snapshot file name '%s' is too long\n", file_name);
+    return false;
+  }
+  const int fd = open(tmp_file_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+  if (fd < 0) {
+    kprintf("can't create instance cache snapshot '%s': %s\n", tmp_file_name, strerror(errno));
+    return false;
+  }
+
+  SnapshotHeader header{};
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.created_at = now;
+  header.table_size = table_size;
+  header.records_count = records_.size();
+  bool ok = write_all(fd, &header, sizeof(header)) && write_all(fd, table.data(), table.size() * sizeof(uint64_t));
+  for (size_t i = 0; ok && i != records_.size(); ++i) {
+    ok = write_all(fd, records_[i].data(), records_[i].size());
+  }
+  ok = close(fd) == 0 && ok;
+  if (!ok || rename(tmp_file_name, file_name) != 0) {
+    kprintf("can't write instance cache snapshot '%s': %s\n", file_name, strerror(errno));
+    unlink(tmp_file_name);
+    return false;
+  }
+  return true;
+}
+
+// an open addressing set of key hashes in the shared memory, 0 is for empty slots;
+// if it's full, nothing is taken from the snapshot at all
+struct InstanceCacheSnapshot::Tombstones {
+  static constexpr uint64_t SIZE = 1 << 16;
+  static constexpr uint64_t MAX_PROBES = 64;
+
+  std::atomic<bool> overflowed;
+  std::atomic<uint64_t> key_hashes[SIZE];
+
+  static uint64_t tombstone_hash(vk::string_view key) noexcept {
+    const uint64_t hash = hash_key(key);
+    return hash ? hash : 1;
+  }
+
+  void add(vk::string_view key) noexcept {
+    if (overflowed.load(std::memory_order_relaxed)) {
+      return;
+    }
+    const uint64_t hash = tombstone_hash(key);
+    uint64_t slot = hash & (SIZE - 1);
+    for (uint64_t probes = 0; probes != MAX_PROBES; ++probes, slot = (slot + 1) & (SIZE - 1)) {
+      uint64_t expected = 0;
+      if (key_hashes[slot].compare_exchange_strong(expected, hash) || expected == hash) {
+        return;
+      }
+    }
+    overflowed.store(true);
+  }
+
+  bool contains(vk::string_view key) const noexcept {
+    if (overflowed.load()) {
+      return true;
+    }
+    const uint64_t hash = tombstone_hash(key);
+    uint64_t slot = hash & (SIZE - 1);
+    for (uint64_t probes = 0; probes != MAX_PROBES; ++probes, slot = (slot + 1) & (SIZE - 1)) {
+      const uint64_t stored = key_hashes[slot].load();
+      if (stored == hash) {
+        return true;
+      }
+      if (!stored) {
+        return false;
+      }
+    }
+    return false;
+  }
+};
+
+void InstanceCacheSnapshot::init_tombstones() noexcept {
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "tombstones are shared between processes");
+  php_assert(!tombstones_);
+  // mmaped memory is zeroed
+  tombstones_ = static_cast<Tombstones *>(mmap_shared(sizeof(Tombstones)));
+}
+
+InstanceCacheSnapshot::~InstanceCacheSnapshot() noexcept {
+  if (data_) {
+    munmap(data_, size_);
+  }
+}
+
+bool InstanceCacheSnapshot::open(const char *file_name, int64_t min_created_at) noexcept {
+  static_assert(sizeof(Record) == sizeof(RecordHeader), "records are written as RecordHeader");
+  static_assert(std::atomic<uint32_t>::is_always_lock_free, "records are shared between processes");
+
+  const int fd = ::open(file_name, O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st{};
+  void *data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(SnapshotHeader)) {
+    data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  const size_t size = static_cast<size_t>(st.st_size);
+  const auto *header = static_cast<const SnapshotHeader *>(data);
+  const uint64_t table_size = header->table_size;
+  const bool is_valid = !memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic))
+                        && table_size && !(table_size & (table_size - 1))
+                        && table_size <= (size - sizeof(SnapshotHeader)) / sizeof(uint64_t)
+                        && header->created_at >= min_created_at;
+  if (!is_valid) {
+    munmap(data, size);
+    return false;
+  }
+
+  data_ = static_cast<char *>(data);
+  size_ = size;
+  table_size_ = table_size;
+  return true;
+}
+
+InstanceCacheSnapshot::Record *InstanceCacheSnapshot::find(vk::string_view key) noexcept {
+  if (!data_) {
+    return nullptr;
+  }
+  const auto *table = reinterpret_cast<const uint64_t *>(data_ + sizeof(SnapshotHeader));
+  uint64_t slot = hash_key(key) & (table_size_ - 1);
+  for (uint64_t probes = 0; probes != table_size_; ++probes, slot = (slot + 1) & (table_size_ - 1)) {
+    const uint64_t offset = table[slot];
+    if (!offset) {
+      return nullptr;
+    }
+    // the file is not trusted, a broken record stops the search
+    if (offset % RECORD_ALIGNMENT || offset > size_ || size_ - offset < sizeof(Record)) {
+      return nullptr;
+    }
+    auto *record = reinterpret_cast<Record *>(data_ + offset);
+    const uint64_t payload_size = uint64_t{record->key_size} + record->class_name_size + record->value_size;
+    if (size_ - offset - sizeof(Record) < payload_size) {
+      return nullptr;
+    }
+    if (vk::string_view{record->key(), record->key_size} == key) {
+      return record;
+    }
+  }
+  return nullptr;
+}
+
+bool InstanceCacheSnapshot::take(vk::string_view key, Element &element) noexcept {
+  if (tombstones_ && tombstones_->contains(key)) {
+    return false;
+  }
+  Record *record = find(key);
+  if (!record || record->taken.load(std::memory_order_relaxed) || record->taken.exchange(1, std::memory_order_relaxed)) {
+    return false;
+  }
+  element.class_name = vk::string_view{record->key() + record->key_size, record->class_name_size};
+  element.value = vk::string_view{record->key() + record->key_size + record->class_name_size, record->value_size};
+  element.expiring_at = record->expiring_at;
+  return true;
+}
+
+void InstanceCacheSnapshot::invalidate(vk::string_view key) noexcept {
+  if (!data_) {
+    if (tombstones_) {
+      tombstones_->add(key);
+    }
+    return;
+  }
+  if (Record *record = find(key)) {
+    record->taken.store(1, std::memory_order_relaxed);
+  }
+}
+
+} // namespace impl_
@@ -0,0 +1,81 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+#include "common/wrappers/string_view.h"
+
+// The instance cache lives in the master's shared memory, so it's lost on graceful restart.
+// To avoid a cold start, the old master saves elements of @kphp-serializable classes into a snapshot file,
+// and workers of the new master restore them one by one on misses (see f$instance_cache_fetch()).
+// Instances are kept in the msgpack format: they can't be shared as is, because they refer to vtables and constants
+// of the old binary, while tagged msgpack fields survive changes of classes between deploys.
+// The file is mapped by all the workers; each element can be taken only once, then it's stored into the cache as usual.
+namespace impl_ {
+
+class InstanceCacheSnapshotWriter : vk::not_copyable {
+public:
+  // expiring_at is a unix time in seconds, 0 for immortal elements
+  void add(vk::string_view key, vk::string_view class_name, int64_t expiring_at, vk::string_view value) noexcept;
+
+  // the snapshot is written into a temporary file and renamed, so readers never see a partially written one
+  bool write(const char *file_name, int64_t now) const noexcept;
+
+  size_t size() const noexcept {
+    return records_.size();
+  }
+
+private:
+  std::vector<std::string> records_;
+  std::vector<uint64_t> key_hashes_;
+};
+
+class InstanceCacheSnapshot : vk::not_copyable {
+public:
+  struct Element {
+    vk::string_view class_name;
+    vk::string_view value;
+    int64_t expiring_at{0};
+  };
+
+  InstanceCacheSnapshot() = default;
+  ~InstanceCacheSnapshot() noexcept;
+
+  // is called by the master before workers are started: allocates the tombstones shared by all its workers
+  void init_tombstones() noexcept;
+
+  // snapshots created before min_created_at (a unix time in seconds) are ignored
+  bool open(const char *file_name, int64_t min_created_at) noexcept;
+
+  bool is_open() const noexcept {
+    return data_ != nullptr;
+  }
+
+  // returns false if there is no such element, or it has been already taken (by any process) or invalidated
+  bool take(vk::string_view key, Element &element) noexcept;
+  // is called on store and delete, so that an outdated element is not restored afterwards;
+  // before the snapshot is opened (e.g. it's not written by the previous master yet) the key is kept as a tombstone,
+  // elements with such keys are never taken by any worker
+  void invalidate(vk::string_view key) noexcept;
+
+private:
+  struct Record;
+  struct Tombstones;
+
+  Record *find(vk::string_view key) noexcept;
+
+  Tombstones *tombstones_{nullptr};
+
+  char *data_{nullptr};
+  size_t size_{0};
+  uint64_t table_size_{0};
+};
+
+} // namespace impl_
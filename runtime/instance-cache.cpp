@@ -15,6 +15,7 @@
 
 #include "runtime/allocator.h"
 #include "runtime/critical_section.h"
+#include "runtime/instance-cache-snapshot.h"
 #include "runtime/inter-process-mutex.h"
 #include "runtime/inter-process-resource.h"
 #include "runtime/memory_resource/resource_allocator.h"
@@ -48,18 +49,45 @@ static constexpr std::chrono::minutes PHYSICAL_REMOVING_DELAY{1};
 static constexpr size_t DATA_SHARDS_COUNT{997u};
 // The buckets check step during the cache cleanup
 static constexpr size_t SHARDS_PURGE_PERIOD{5u};
+// For this time after start, workers wait for a snapshot of the previous master; older snapshots are ignored
+static constexpr std::chrono::seconds SNAPSHOT_WAITING_TIME{60};
+// The sizes of the memory chunks that a magazine takes from the common buffer: every next chunk is twice bigger
+static constexpr size_t MAGAZINE_MIN_CHUNK_SIZE{64u * 1024u};
+static constexpr size_t MAGAZINE_MAX_CHUNK_SIZE{4u * 1024u * 1024u};
 
 class ElementHolder;
 
+// The memory of a worker process inside the buffer: the elements stored by the process are copied into its magazine.
+// The magazine mutex is taken by the owner on storing and by any process on destroying an element of the magazine,
+// so the stores of different processes don't wait for each other.
+// A magazine takes memory chunks from the common memory resource under the allocator_mutex and never gives them back until the buffer is swapped;
+// when the buffer is almost full, a magazine takes only as much as it needs, so that the memory isn't left in the chunks of other processes.
+struct MemoryMagazine : private vk::not_copyable {
+  explicit MemoryMagazine(void *buffer_begin) noexcept {
+    // the magazine has no own memory, it uses only the extra memory pools;
+    // the buffer begin is needed for the defragmentation
+    memory_resource.init(buffer_begin, 0);
+  }
+
+  inter_process_mutex mutex;
+  memory_resource::unsynchronized_pool_resource memory_resource;
+  size_t next_chunk_size{MAGAZINE_MIN_CHUNK_SIZE};
+  // the total size of the chunks taken from the common memory resource
+  size_t chunks_size{0};
+};
+
 struct CacheContext : private vk::not_copyable {
   inter_process_mutex allocator_mutex;
   memory_resource::unsynchronized_pool_resource memory_resource;
   InstanceCacheStats stats;
   std::atomic<bool> memory_swap_required{false};
+  // indexed by logname_id, magazines are created on the first store of a process
+  std::array<std::atomic<MemoryMagazine *>, WorkersControl::max_workers_count> magazines{};
 
   void move_to_garbage(ElementHolder *element) noexcept;
   bool has_garbage() const noexcept { return cache_garbage_ != nullptr; }
-  void clear_garbage() noexcept;
+  // the elements of the magazines locked by other processes are left in the garbage
+  void clear_garbage(bool force_enable_disable_allocator = false) noexcept;
 
 private:
   std::atomic<ElementHolder *> cache_garbage_{nullptr};
@@ -76,19 +104,21 @@ public:
     }
   }
 
+  // should be called under the magazine mutex, with the magazine memory resource as the script allocator
   void destroy() noexcept {
     php_assert(refcnt == 0);
     cache_context.stats.elements_destroyed.fetch_add(1, std::memory_order_relaxed);
-    auto &mem_resource = cache_context.memory_resource;
+    auto &mem_resource = magazine.memory_resource;
     this->~ElementHolder();
     mem_resource.deallocate(this, sizeof(ElementHolder));
   }
 
   ElementHolder(std::chrono::nanoseconds now, int64_t ttl,
                 std::unique_ptr<InstanceCopyistBase> &&instance,
-                CacheContext &context) noexcept:
+                MemoryMagazine &magazine, CacheContext &context) noexcept:
     inserted_by_process(getpid()),
     instance_wrapper(std::move(instance)),
+    magazine(magazine),
     cache_context(context) {
     update_time_points(now, ttl);
     cache_context.stats.elements_created.fetch_add(1, std::memory_order_relaxed);
@@ -120,6 +150,8 @@ public:
   const pid_t inserted_by_process{0};
 
   std::unique_ptr<InstanceCopyistBase> instance_wrapper;
+  // the element and its instance are allocated in the magazine
+  MemoryMagazine &magazine;
   CacheContext &cache_context;
 
   // Removed elements list
@@ -147,12 +179,20 @@ void CacheContext::move_to_garbage(ElementHolder *element) noexcept {
   } while (!cache_garbage_.compare_exchange_strong(next, element));
 }
 
-void CacheContext::clear_garbage() noexcept {
+void CacheContext::clear_garbage(bool force_enable_disable_allocator) noexcept {
   auto *element = cache_garbage_.exchange(nullptr);
 
   while (element) {
-    auto *next = element->next_in_garbage_list.load();
-    element->destroy();
+    auto *next = element->next_in_garbage_list.exchange(nullptr);
+    MemoryMagazine &magazine = element->magazine;
+    std::unique_lock<inter_process_mutex> magazine_lock{magazine.mutex, std::try_to_lock};
+    if (magazine_lock) {
+      dl::MemoryReplacementGuard magazine_memory_guard{magazine.memory_resource, force_enable_disable_allocator};
+      element->destroy();
+    } else {
+      // the owner of the magazine is storing an element right now, try next time
+      move_to_garbage(element);
+    }
     element = next;
   }
 }
@@ -237,6 +277,7 @@ private:
 
 struct {
   size_t total_memory_limit{DEFAULT_MEMORY_LIMIT};
+  const char *snapshot_file_name{nullptr};
 } static instance_cache_settings;
 
 class InstanceCache {
@@ -254,6 +295,9 @@ public:
   void global_init() {
     php_assert(!current_ && !context_);
     data_manager_.init(instance_cache_settings.total_memory_limit);
+    if (instance_cache_settings.snapshot_file_name) {
+      snapshot_.init_tombstones();
+    }
   }
 
   void refresh() {
@@ -261,6 +305,7 @@ public:
     update_now();
     current_ = data_manager_.acquire_current_resource();
     context_ = &current_->get_context();
+    open_snapshot_if_needed();
   }
 
   void update_now() {
@@ -278,15 +323,12 @@ public:
     used_elements_.clear();
 
     if (context_->has_garbage()) {
-      std::unique_lock<inter_process_mutex> allocator_lock{context_->allocator_mutex, std::try_to_lock};
-      if (allocator_lock) {
-        dl::MemoryReplacementGuard shared_memory_guard{context_->memory_resource};
-        context_->clear_garbage();
-      }
+      context_->clear_garbage();
     }
     data_manager_.release_resource(current_);
     current_ = nullptr;
     context_ = nullptr;
+    magazine_ = nullptr;
   }
 
   bool store(const string &key, const InstanceCopyistBase &instance_wrapper, int64_t ttl) noexcept {
@@ -297,6 +339,7 @@ public:
     }
 
     sync_delayed();
+    snapshot_.invalidate(vk::string_view{key.c_str(), key.size()});
     // various service things that we can do without synchronization
     auto &data = current_->get_data(key);
     update_now();
@@ -304,9 +347,13 @@ public:
       return false;
     }
 
-    InstanceDeepCopyVisitor detach_processor{context_->memory_resource, ExtraRefCnt::for_instance_cache};
+    MemoryMagazine *magazine = acquire_magazine();
+    if (unlikely(!magazine)) {
+      return false;
+    }
+    InstanceDeepCopyVisitor detach_processor{magazine->memory_resource, ExtraRefCnt::for_instance_cache, refill_magazine};
     const ElementHolder *inserted_element = try_insert_element_into_cache(
-      data, key, ttl, instance_wrapper, detach_processor);
+      data, key, ttl, instance_wrapper, *magazine, detach_processor);
 
     if (!inserted_element) {
       // failed to insert the element due to some problems (e.g. memory, depth limit)
@@ -314,6 +361,9 @@ public:
         fire_warning(detach_processor, instance_wrapper.get_class());
         return false;
       }
+      if (context_->memory_swap_required) {
+        return false;
+      }
       // failed to acquire a lock, save the instance into the script memory container, we'll try again later
       class_instance<DelayedInstance> delayed_instance;
       delayed_instance.alloc().get()->ttl = ttl;
@@ -426,6 +476,7 @@ public:
     // request_cache_ and storing_delayed_ use a script memory
     storing_delayed_.unset(key);
     request_cache_.unset(key);
+    snapshot_.invalidate(vk::string_view{key.c_str(), key.size()});
     auto &data = current_->get_data(key);
     update_now();
     std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
@@ -443,6 +494,25 @@ public:
     return true;
   }
 
+  bool take_from_snapshot(const string &key, string &class_name, string &value, int64_t &ttl) noexcept {
+    php_assert(current_ && context_);
+    InstanceCacheSnapshot::Element element;
+    if (!snapshot_.take(vk::string_view{key.c_str(), key.size()}, element)) {
+      return false;
+    }
+    update_now();
+    const int64_t now_sec = std::chrono::duration_cast<std::chrono::seconds>(now_).count();
+    if (element.expiring_at && element.expiring_at <= now_sec) {
+      return false;
+    }
+    ic_debug("restore '%s' from snapshot\n", key.c_str());
+    context_->stats.elements_restored_from_snapshot.fetch_add(1, std::memory_order_relaxed);
+    class_name.assign(element.class_name.data(), static_cast<string::size_type>(element.class_name.size()));
+    value.assign(element.value.data(), static_cast<string::size_type>(element.value.size()));
+    ttl = element.expiring_at ? element.expiring_at - now_sec : 0;
+    return true;
+  }
+
   void force_release_all_resources() {
     data_manager_.force_release_all_resources();
   }
@@ -453,6 +523,32 @@ public:
     const auto now_with_delay = now_ - PHYSICAL_REMOVING_DELAY;
 
     auto &current_data = data_manager_.get_current_resource();
+    auto &context = current_data.get_context();
+    purge_expired_keys(current_data, now_with_delay);
+
+    // the elements of the purged keys are destroyed in their magazines;
+    // as this call happens from the master process we need to explicitly activate and deactivate the script allocator
+    context.clear_garbage(true);
+    update_last_memory_stats(context);
+  }
+
+  // the memory given to the magazines is accounted as used only if it's used by the elements
+  void update_last_memory_stats(CacheContext &context) noexcept {
+    size_t magazines_memory_used = 0;
+    size_t magazines_memory_taken = 0;
+    for (const auto &magazine_slot : context.magazines) {
+      if (MemoryMagazine *magazine = magazine_slot.load(std::memory_order_acquire)) {
+        std::lock_guard<inter_process_mutex> magazine_lock{magazine->mutex};
+        magazines_memory_used += magazine->memory_resource.get_memory_stats().memory_used;
+        magazines_memory_taken += sizeof(MemoryMagazine) + magazine->chunks_size;
+      }
+    }
+    std::lock_guard<inter_process_mutex> allocator_lock{context.allocator_mutex};
+    last_memory_stats_ = context.memory_resource.get_memory_stats();
+    last_memory_stats_.memory_used = last_memory_stats_.memory_used + magazines_memory_used - magazines_memory_taken;
+  }
+
+  void purge_expired_keys(SharedMemoryData &current_data, std::chrono::nanoseconds now_with_delay) noexcept {
     auto &context = current_data.get_context();
     // replace the default script allocator
     // as this call happens from the master process
@@ -495,10 +591,57 @@ public:
     }
 
     purge_shard_offset_ = (purge_shard_offset_ + 1) % SHARDS_PURGE_PERIOD;
+  }
 
-    std::lock_guard<inter_process_mutex> allocator_lock{context.allocator_mutex};
-    context.clear_garbage();
-    last_memory_stats_ = context.memory_resource.get_memory_stats();
+  // this function should be called only from master
+  void save_snapshot() noexcept {
+    if (!instance_cache_settings.snapshot_file_name) {
+      return;
+    }
+    update_now();
+    auto &current_data = data_manager_.get_current_resource();
+    auto *data_shards = current_data.get_data_shards();
+    InstanceCacheSnapshotWriter writer;
+    // elements are packed one by one in the heap of the master
+    string_buffer buffer;
+    vk::msgpack::packer<string_buffer> packer{buffer};
+    size_t skipped = 0;
+    for (size_t shard_id = 0; shard_id != current_data.get_data_shards_count(); ++shard_id) {
+      auto &data_shard = data_shards[shard_id];
+      if (data_shard.is_storage_empty.load(std::memory_order_relaxed)) {
+        continue;
+      }
+      std::lock_guard<inter_process_mutex> shared_data_lock{data_shard.storage_mutex};
+      for (const auto &stored_element : data_shard.storage) {
+        const ElementHolder &element = *stored_element.second;
+        if (element.expiring_at <= now_) {
+          continue;
+        }
+        buffer.clean();
+        vk::msgpack::packer_float32_decorator::clear();
+        vk::msgpack::CheckInstanceDepth::depth = 0;
+        string_buffer::string_buffer_error_flag = STRING_BUFFER_ERROR_FLAG_ON;
+        const bool packed = element.instance_wrapper->msgpack_pack(packer);
+        const bool failed = string_buffer::string_buffer_error_flag == STRING_BUFFER_ERROR_FLAG_FAILED || vk::msgpack::CheckInstanceDepth::is_exceeded();
+        string_buffer::string_buffer_error_flag = STRING_BUFFER_ERROR_FLAG_OFF;
+        if (!packed || failed) {
+          ++skipped;
+          continue;
+        }
+        const int64_t expiring_at = element.expiring_at == std::chrono::nanoseconds::max()
+                                    ? 0
+                                    : std::chrono::duration_cast<std::chrono::seconds>(element.expiring_at).count() + 1;
+        const string &key = stored_element.first;
+        writer.add(vk::string_view{key.c_str(), key.size()}, element.instance_wrapper->get_class(), expiring_at,
+                   vk::string_view{buffer.buffer(), buffer.size()});
+      }
+    }
+
+    const int64_t now_sec = std::chrono::duration_cast<std::chrono::seconds>(now_).count();
+    if (writer.write(instance_cache_settings.snapshot_file_name, now_sec)) {
+      kprintf("instance cache snapshot is saved to '%s': %zu elements, %zu skipped as not serializable\n",
+              instance_cache_settings.snapshot_file_name, writer.size(), skipped);
+    }
   }
 
   // this function should be called only from master
@@ -545,7 +688,14 @@ private:
       return;
     }
 
-    InstanceDeepCopyVisitor detach_processor{context_->memory_resource, ExtraRefCnt::for_instance_cache};
+    if (storing_delayed_.empty()) {
+      return;
+    }
+    MemoryMagazine *magazine = acquire_magazine();
+    if (unlikely(!magazine)) {
+      return;
+    }
+    InstanceDeepCopyVisitor detach_processor{magazine->memory_resource, ExtraRefCnt::for_instance_cache, refill_magazine};
     for (auto it = storing_delayed_.cbegin(); it != storing_delayed_.cend(); it = storing_delayed_.cbegin()) {
       string key = it.get_key().to_string();
       const auto &delayed_instance = *it.get_value().get();
@@ -557,10 +707,10 @@ private:
       }
       const ElementHolder *inserted_element = try_insert_element_into_cache(
         data, key, delayed_instance.ttl,
-        *delayed_instance.instance_wrapper, detach_processor);
+        *delayed_instance.instance_wrapper, *magazine, detach_processor);
       if (!inserted_element) {
         if (likely(detach_processor.is_ok())) {
-          // failed to acquire an allocator lock; try later
+          // failed to acquire a lock; try later
           return;
         }
         fire_warning(detach_processor, delayed_instance.instance_wrapper->get_class());
@@ -580,52 +730,136 @@ private:
   ElementHolder *try_insert_element_into_cache(SharedDataStorages &data,
                                                const string &key_in_script_memory, int64_t ttl,
                                                const InstanceCopyistBase &instance_wrapper,
+                                               MemoryMagazine &magazine,
                                                InstanceDeepCopyVisitor &detach_processor) noexcept {
-    // swap the allocator
-    dl::MemoryReplacementGuard shared_memory_guard{context_->memory_resource};
+    vk::intrusive_ptr<ElementHolder> element;
+    {
+      // moving an instance into the magazine of this process
+      dl::MemoryReplacementGuard magazine_memory_guard{magazine.memory_resource};
+      std::unique_lock<inter_process_mutex> magazine_lock{magazine.mutex, std::try_to_lock};
+      // can be taken by another process that destroys an element of this magazine
+      if (!magazine_lock) {
+        return nullptr;
+      }
+      if (auto cached_instance_wrapper = instance_wrapper.deep_copy_and_set_ref_cnt(detach_processor)) {
+        if (void *mem = detach_processor.prepare_raw_memory(sizeof(ElementHolder))) {
+          element = vk::intrusive_ptr<ElementHolder>{new(mem) ElementHolder{now_, ttl, std::move(cached_instance_wrapper), magazine, *context_}};
+        }
+      }
+    }
+    if (!element) {
+      return nullptr;
+    }
+
+    {
+      std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
+      auto it = data.storage.find(key_in_script_memory);
+      if (it != data.storage.end()) {
+        return replace_element(it->second, std::move(element));
+      }
+    }
 
-    std::unique_lock<inter_process_mutex> allocator_lock{context_->allocator_mutex, std::try_to_lock};
+    // the key is new: the key and the storage node are allocated in the common memory resource;
+    // the allocator_mutex is held for a short time by anyone, so it's waited for, otherwise the copy of the element would be wasted
+    dl::MemoryReplacementGuard shared_memory_guard{context_->memory_resource};
     // locking strictly before the storage_mutex to avoid a deadlock
-    if (!allocator_lock) {
-      return nullptr;
+    std::lock_guard<inter_process_mutex> allocator_lock{context_->allocator_mutex};
+
+    std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
+    auto it = data.storage.find(key_in_script_memory);
+    if (it == data.storage.end()) {
+      InstanceDeepCopyVisitor key_detach_processor{context_->memory_resource, ExtraRefCnt::for_instance_cache};
+      string key_in_shared_memory = key_in_script_memory;
+      constexpr auto node_max_size = ElementStorage_::allocator_type::max_value_type_size();
+      if (unlikely(!key_detach_processor.process(key_in_shared_memory) || !key_detach_processor.is_enough_memory_for(node_max_size))) {
+        InstanceDeepDestroyVisitor{ExtraRefCnt::for_instance_cache}.process(key_in_shared_memory);
+        fire_warning(key_detach_processor, element->instance_wrapper->get_class());
+        return nullptr;
+      }
+
+      it = data.storage.emplace(std::move(key_in_shared_memory), vk::intrusive_ptr<ElementHolder>{}).first;
+      data.is_storage_empty.store(false, std::memory_order_relaxed);
+      context_->stats.elements_cached.fetch_add(1, std::memory_order_relaxed);
     }
+    return replace_element(it->second, std::move(element));
+  }
 
-    // acquired an allocator lock, now we can safely collect the garbage
-    auto clear_garbage = vk::finally([this] { context_->clear_garbage(); });
-
-    // moving an instance into a shared memory
-    if (auto cached_instance_wrapper = instance_wrapper.deep_copy_and_set_ref_cnt(detach_processor)) {
-      if (void *mem = detach_processor.prepare_raw_memory(sizeof(ElementHolder))) {
-        vk::intrusive_ptr<ElementHolder> element{new(mem) ElementHolder{now_, ttl, std::move(cached_instance_wrapper), *context_}};
-        std::lock_guard<inter_process_mutex> shared_data_lock{data.storage_mutex};
-        auto it = data.storage.find(key_in_script_memory);
-        if (it == data.storage.end()) {
-          string key_in_shared_memory = key_in_script_memory;
-          if (unlikely(!detach_processor.process(key_in_shared_memory))) {
-            return nullptr;
-          }
-          constexpr auto node_max_size = ElementStorage_::allocator_type::max_value_type_size();
-          if (unlikely(!detach_processor.is_enough_memory_for(node_max_size))) {
-            InstanceDeepDestroyVisitor{ExtraRefCnt::for_instance_cache}.process(key_in_shared_memory);
-            return nullptr;
-          }
-
-          it = data.storage.emplace(std::move(key_in_shared_memory), vk::intrusive_ptr<ElementHolder>{}).first;
-          data.is_storage_empty.store(false, std::memory_order_relaxed);
-          context_->stats.elements_cached.fetch_add(1, std::memory_order_relaxed);
-        }
-        // replace element and save previous element into used_elements_;
-        // it'll make it possible to free it without taking a storage_mutex lock
-        it->second.swap(element);
-        if (element) {
-          // used_elements_ uses heap memory for its internal allocations
-          used_elements_.emplace(std::move(element));
-        }
-        used_elements_.emplace(it->second);
-        return it->second.get();
+  // should be called under the storage_mutex
+  ElementHolder *replace_element(vk::intrusive_ptr<ElementHolder> &stored_element, vk::intrusive_ptr<ElementHolder> &&element) noexcept {
+    // replace element and save previous element into used_elements_;
+    // it'll make it possible to free it without taking a storage_mutex lock
+    stored_element.swap(element);
+    if (element) {
+      // used_elements_ uses heap memory for its internal allocations
+      used_elements_.emplace(std::move(element));
+    }
+    used_elements_.emplace(stored_element);
+    return stored_element.get();
+  }
+
+  MemoryMagazine *acquire_magazine() noexcept {
+    if (magazine_) {
+      return magazine_;
+    }
+    php_assert(logname_id >= 0 && logname_id < WorkersControl::max_workers_count);
+    auto &magazine_slot = context_->magazines[logname_id];
+    magazine_ = magazine_slot.load(std::memory_order_acquire);
+    if (!magazine_) {
+      std::lock_guard<inter_process_mutex> allocator_lock{context_->allocator_mutex};
+      auto &common_resource = context_->memory_resource;
+      if (!common_resource.is_enough_memory_for(sizeof(MemoryMagazine))) {
+        php_warning("Memory limit exceeded on creating a memory magazine of instance cache");
+        context_->memory_swap_required = true;
+        return nullptr;
       }
+      magazine_ = new(common_resource.allocate(sizeof(MemoryMagazine))) MemoryMagazine{common_resource.memory_begin()};
+      magazine_slot.store(magazine_, std::memory_order_release);
+      context_->stats.memory_magazines_created.fetch_add(1, std::memory_order_relaxed);
+      context_->stats.memory_magazines_taken.fetch_add(sizeof(MemoryMagazine), std::memory_order_relaxed);
+    }
+    return magazine_;
+  }
+
+  // is called by InstanceDeepCopyVisitor under the magazine mutex, when there is not enough memory in the magazine
+  static bool refill_magazine(memory_resource::unsynchronized_pool_resource &magazine_resource, size_t size) noexcept {
+    auto &cache = InstanceCache::get();
+    php_assert(cache.context_ && cache.magazine_ && &cache.magazine_->memory_resource == &magazine_resource);
+    MemoryMagazine &magazine = *cache.magazine_;
+    const size_t min_chunk_size = memory_resource::details::align_for_chunk(size) + sizeof(memory_resource::extra_memory_pool);
+    size_t chunk_size = std::max(magazine.next_chunk_size, min_chunk_size);
+
+    // the allocator_mutex is held for a short time by anyone, so it's waited for
+    std::lock_guard<inter_process_mutex> allocator_lock{cache.context_->allocator_mutex};
+    auto &common_resource = cache.context_->memory_resource;
+    if (!common_resource.is_enough_memory_for(chunk_size)) {
+      // the rest of the buffer isn't given away in a big chunk, the swap is requested only if even the element doesn't fit
+      chunk_size = min_chunk_size;
+      if (!common_resource.is_enough_memory_for(chunk_size)) {
+        return false;
+      }
+    }
+    magazine_resource.add_extra_memory(new(common_resource.allocate(chunk_size)) memory_resource::extra_memory_pool{chunk_size});
+    magazine.next_chunk_size = std::min(magazine.next_chunk_size * 2, MAGAZINE_MAX_CHUNK_SIZE);
+    magazine.chunks_size += chunk_size;
+    cache.context_->stats.memory_magazine_refills.fetch_add(1, std::memory_order_relaxed);
+    cache.context_->stats.memory_magazines_taken.fetch_add(chunk_size, std::memory_order_relaxed);
+    return true;
+  }
+
+  // workers of a new master look for a snapshot of the previous one for some time after start
+  void open_snapshot_if_needed() noexcept {
+    if (!instance_cache_settings.snapshot_file_name || snapshot_.is_open()) {
+      return;
+    }
+    const int64_t now_sec = std::chrono::duration_cast<std::chrono::seconds>(now_).count();
+    if (!snapshot_waiting_started_at_) {
+      snapshot_waiting_started_at_ = now_sec;
+    }
+    if (now_sec < next_snapshot_open_attempt_ || now_sec > snapshot_waiting_started_at_ + SNAPSHOT_WAITING_TIME.count()) {
+      return;
     }
-    return nullptr;
+    next_snapshot_open_attempt_ = now_sec + 1;
+    snapshot_.open(instance_cache_settings.snapshot_file_name, snapshot_waiting_started_at_ - SNAPSHOT_WAITING_TIME.count());
   }
 
   void fire_warning(const InstanceDeepCopyVisitor &detach_processor, const char *class_name) noexcept {
@@ -637,6 +871,8 @@ private:
 
   SharedMemoryData *current_{nullptr};
   CacheContext *context_{nullptr};
+  // the magazine of this process in the current buffer
+  MemoryMagazine *magazine_{nullptr};
   InterProcessResourceManager<SharedMemoryData, 2> data_manager_;
 
 
@@ -664,6 +900,11 @@ private:
   };
   array<class_instance<DelayedInstance>> storing_delayed_;
 
+  // A snapshot of the previous master, it's mapped into the memory of a worker
+  InstanceCacheSnapshot snapshot_;
+  int64_t snapshot_waiting_started_at_{0};
+  int64_t next_snapshot_open_attempt_{0};
+
   std::chrono::nanoseconds now_{std::chrono::nanoseconds::zero()};
   memory_resource::MemoryStats last_memory_stats_;
   size_t purge_shard_offset_{0};
@@ -677,6 +918,10 @@ const InstanceCopyistBase *instance_cache_fetch_wrapper(const string &key, bool
   return InstanceCache::get().fetch(key, even_if_expired);
 }
 
+bool instance_cache_take_from_snapshot(const string &key, string &class_name, string &value, int64_t &ttl) {
+  return InstanceCache::get().take_from_snapshot(key, class_name, value, ttl);
+}
+
 } // namespace impl_
 
 void global_init_instance_cache_lib() {
@@ -696,6 +941,11 @@ void set_instance_cache_memory_limit(size_t limit) {
   impl_::instance_cache_settings.total_memory_limit = limit;
 }
 
+// should be called only from master
+void set_instance_cache_snapshot_file(const char *file_name) {
+  impl_::instance_cache_settings.snapshot_file_name = file_name;
+}
+
 // should be called only from master
 InstanceCacheSwapStatus instance_cache_try_swap_memory() {
   return impl_::InstanceCache::get().try_swap_memory_resource();
@@ -716,6 +966,11 @@ void instance_cache_purge_expired_elements() {
   impl_::InstanceCache::get().purge_expired();
 }
 
+// should be called only from master
+void instance_cache_save_snapshot() {
+  impl_::InstanceCache::get().save_snapshot();
+}
+
 void instance_cache_release_all_resources_acquired_by_this_proc() {
   impl_::InstanceCache::get().force_release_all_resources();
 }
@@ -20,12 +20,14 @@
 
 #include "runtime/instance-copy-processor.h"
 #include "runtime/kphp_core.h"
+#include "runtime/msgpack-serialization.h"
 #include "runtime/shape.h"
 
 namespace impl_ {
 
 bool instance_cache_store(const string &key, const InstanceCopyistBase &instance_wrapper, int64_t ttl);
 const InstanceCopyistBase *instance_cache_fetch_wrapper(const string &key, bool even_if_expired);
+bool instance_cache_take_from_snapshot(const string &key, string &class_name, string &value, int64_t &ttl);
 
 } // namespace impl_
 
@@ -35,6 +37,8 @@ void free_instance_cache_lib();
 
 // these function should be called from master
 void set_instance_cache_memory_limit(size_t limit);
+// these function should be called from master
+void set_instance_cache_snapshot_file(const char *file_name);
 
 struct InstanceCacheStats : private vk::not_copyable {
   std::atomic<uint64_t> elements_stored{0};
@@ -52,6 +56,13 @@ struct InstanceCacheStats : private vk::not_copyable {
   std::atomic<uint64_t> elements_created{0};
   std::atomic<uint64_t> elements_destroyed{0};
   std::atomic<uint64_t> elements_cached{0};
+
+  std::atomic<uint64_t> elements_restored_from_snapshot{0};
+
+  std::atomic<uint64_t> memory_magazines_created{0};
+  std::atomic<uint64_t> memory_magazine_refills{0};
+  // the memory taken by the magazines from the common buffer, it's accounted as used only if it's used by the elements
+  std::atomic<uint64_t> memory_magazines_taken{0};
 };
 
 enum class InstanceCacheSwapStatus {
@@ -67,6 +78,8 @@ const InstanceCacheStats &instance_cache_get_stats();
 const memory_resource::MemoryStats &instance_cache_get_memory_stats();
 // these function should be called from master
 void instance_cache_purge_expired_elements();
+// these function should be called from master, on graceful restart
+void instance_cache_save_snapshot();
 
 void instance_cache_release_all_resources_acquired_by_this_proc();
 
@@ -80,6 +93,32 @@ bool f$instance_cache_store(const string &key, const ClassInstanceType &instance
   return impl_::instance_cache_store(key, instance_wrapper, ttl);
 }
 
+namespace impl_ {
+
+// elements saved by the previous master are restored lazily, on the first miss of their key
+template<typename ClassInstanceType>
+ClassInstanceType instance_cache_restore_from_snapshot(const string &key) noexcept {
+  if constexpr (is_msgpack_serializable<typename ClassInstanceType::ClassType>::value) {
+    string class_name;
+    string value;
+    int64_t ttl = 0;
+    if (instance_cache_take_from_snapshot(key, class_name, value, ttl)) {
+      string err_msg;
+      auto instance = f$msgpack_deserialize<ClassInstanceType>(value, &err_msg);
+      // classes could be changed since the snapshot was saved, an element of another class is dropped
+      if (err_msg.empty() && !instance.is_null() && !strcmp(instance.get_class(), class_name.c_str())) {
+        f$instance_cache_store(key, instance, ttl);
+        return instance;
+      }
+    }
+  } else {
+    static_cast<void>(key);
+  }
+  return {};
+}
+
+} // namespace impl_
+
 template<typename ClassInstanceType>
 ClassInstanceType f$instance_cache_fetch(const string &class_name, const string &key, bool even_if_expired = false) {
   static_assert(is_class_instance<ClassInstanceType>::value, "class_instance<> type expected");
@@ -94,8 +133,9 @@ ClassInstanceType f$instance_cache_fetch(const string &class_name, const string
       php_warning("Trying to fetch incompatible instance class: expect '%s', got '%s'",
                   class_name.c_str(), base_wrapper->get_class());
     }
+    return {};
   }
-  return {};
+  return impl_::instance_cache_restore_from_snapshot<ClassInstanceType>(key);
 }
 
 bool f$instance_cache_update_ttl(const string &key, int64_t ttl = 0);
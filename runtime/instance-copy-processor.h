@@ -14,6 +14,7 @@
 #include "runtime/critical_section.h"
 #include "runtime/kphp_core.h"
 #include "runtime/memory_resource/unsynchronized_pool_resource.h"
+#include "runtime/msgpack/adaptors.h"
 
 namespace impl_ {
 
@@ -348,9 +349,19 @@ public:
   virtual const char *get_class() const noexcept = 0;
   virtual std::unique_ptr<InstanceCopyistBase> deep_copy_and_set_ref_cnt(InstanceDeepCopyVisitor &detach_processor) const noexcept = 0;
   virtual std::unique_ptr<InstanceCopyistBase> shallow_copy() const noexcept = 0;
+  // returns false if the class is not @kphp-serializable
+  virtual bool msgpack_pack(vk::msgpack::packer<string_buffer> &packer) const noexcept = 0;
   virtual ~InstanceCopyistBase() noexcept = default;
 };
 
+template<typename I, typename = void>
+struct is_msgpack_serializable : std::false_type {
+};
+
+template<typename I>
+struct is_msgpack_serializable<I, decltype(std::declval<const I &>().msgpack_pack(std::declval<vk::msgpack::packer<string_buffer> &>()))> : std::true_type {
+};
+
 template<typename I>
 class InstanceCopyistImpl;
 
@@ -389,6 +400,16 @@ public:
     return make_unique_on_script_memory<InstanceCopyistImpl<class_instance<I>>>(instance_);
   }
 
+  bool msgpack_pack(vk::msgpack::packer<string_buffer> &packer) const noexcept final {
+    if constexpr (is_msgpack_serializable<I>::value) {
+      packer.pack(instance_);
+      return true;
+    } else {
+      static_cast<void>(packer);
+      return false;
+    }
+  }
+
   class_instance<I> get_instance() const noexcept {
     return instance_;
   }
@@ -4,6 +4,7 @@
 
 #include "runtime/interface.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cassert>
 #include <clocale>
@@ -20,6 +21,7 @@
 #include "common/tl/constants/common.h"
 
 #include "net/net-connections.h"
+#include "runtime/array-keys-pool.h"
 #include "runtime/array_functions.h"
 #include "runtime/bcmath.h"
 #include "runtime/confdata-functions.h"
@@ -179,6 +181,14 @@ static char headers_storage[sizeof(array<string>)];
 static array<string> *headers = reinterpret_cast <array<string> *> (headers_storage);
 static long long header_last_query_num = -1;
 
+// the body of a long POST request (it's not received before the script start) which isn't parsed into $_POST/$_FILES
+// is left in the connection: php://input reads it on demand chunk by chunk, so it never takes the script memory as a whole
+static struct {
+  int len;
+  int pos;
+  bool is_streamed;
+} http_input;
+
 static bool check_status_line_int(const char *str, int str_len, int *pos) {
   if (*pos != str_len && str[*pos] == '0') {
     (*pos)++;
@@ -553,6 +563,9 @@ void f$fastcgi_finish_request(int64_t exit_code) {
         }
       }
 
+      if (http_input.is_streamed && http_input.pos < http_input.len) {
+        header("Connection: close", 17, true);
+      }
       const string_buffer *headers = get_headers(compressed->size());
       http_set_result(headers->buffer(), headers->size(), compressed->buffer(), compressed->size(), static_cast<int32_t>(exit_code));
 
@@ -826,6 +839,29 @@ mixed v$_ENV     __attribute__ ((weak));
 mixed v$argc  __attribute__ ((weak));
 mixed v$argv  __attribute__ ((weak));
 
+static struct {
+  bool server{true};
+  bool get{true};
+  bool post{true};
+  bool files{true};
+  bool cookie{true};
+  bool request{true};
+  bool env{true};
+} used_superglobals;
+
+void set_used_superglobals(std::initializer_list<const char *> names) noexcept {
+  auto is_used = [&names](const char *name) {
+    return std::any_of(names.begin(), names.end(), [name](const char *used_name) { return !strcmp(used_name, name); });
+  };
+  used_superglobals.server = is_used("_SERVER");
+  used_superglobals.get = is_used("_GET");
+  used_superglobals.post = is_used("_POST");
+  used_superglobals.files = is_used("_FILES");
+  used_superglobals.cookie = is_used("_COOKIE");
+  used_superglobals.request = is_used("_REQUEST");
+  used_superglobals.env = is_used("_ENV");
+}
+
 static std::aligned_storage_t<sizeof(array<bool>), alignof(array<bool>)> uploaded_files_storage;
 static array<bool> *uploaded_files = reinterpret_cast<array<bool> *> (&uploaded_files_storage);
 static long long uploaded_files_last_query_num = -1;
@@ -1466,28 +1502,41 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
 
   reset_superglobals();
 
+  // $_REQUEST is merged from $_GET, $_POST and $_COOKIE
+  const bool need_server = used_superglobals.server;
+  const bool need_get = used_superglobals.get || used_superglobals.request;
+  const bool need_post = used_superglobals.post || used_superglobals.request;
+  const bool need_cookie = used_superglobals.cookie || used_superglobals.request;
+
   if (query_type == QUERY_TYPE_JOB) {
-    v$_SERVER.set_value(string("JOB_ID"), job_data.job_request->job_id);
+    if (need_server) {
+      v$_SERVER.set_value(string("JOB_ID"), job_data.job_request->job_id);
+    }
     init_job_server_interface_lib(job_data);
   }
 
   string uri_str;
   if (http_data.uri_len) {
     uri_str.assign(http_data.uri, http_data.uri_len);
-    v$_SERVER.set_value(string("PHP_SELF"), uri_str);
-    v$_SERVER.set_value(string("SCRIPT_URL"), uri_str);
-    v$_SERVER.set_value(string("SCRIPT_NAME"), uri_str);
+    if (need_server) {
+      v$_SERVER.set_value(string("PHP_SELF"), uri_str);
+      v$_SERVER.set_value(string("SCRIPT_URL"), uri_str);
+      v$_SERVER.set_value(string("SCRIPT_NAME"), uri_str);
+    }
   }
 
   string get_str;
   if (http_data.get_len) {
     get_str.assign(http_data.get, http_data.get_len);
-    f$parse_str(get_str, v$_GET);
-
-    v$_SERVER.set_value(string("QUERY_STRING"), get_str);
+    if (need_get) {
+      f$parse_str(get_str, v$_GET);
+    }
+    if (need_server) {
+      v$_SERVER.set_value(string("QUERY_STRING"), get_str);
+    }
   }
 
-  if (http_data.uri) {
+  if (http_data.uri && need_server) {
     if (http_data.get_len) {
       v$_SERVER.set_value(string("REQUEST_URI"), (static_SB.clean() << uri_str << '?' << get_str).str());
     } else {
@@ -1534,7 +1583,7 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
         if (strstr(header_value.c_str(), "deflate") != nullptr) {
           http_need_gzip |= 2;
         }
-      } else if (!strcmp(header_name.c_str(), "cookie")) {
+      } else if (need_cookie && !strcmp(header_name.c_str(), "cookie")) {
         array<string> cookie = explode(';', header_value);
         for (int t = 0; t < (int)cookie.count(); t++) {
           array<string> cur_cookie = explode('=', f$trim(cookie[t]), 2);
@@ -1542,9 +1591,9 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
             parse_str_set_value(v$_COOKIE, cur_cookie[0], f$urldecode(cur_cookie[1]));
           }
         }
-      } else if (!strcmp(header_name.c_str(), "host")) {
+      } else if (need_server && !strcmp(header_name.c_str(), "host")) {
         v$_SERVER.set_value(string("SERVER_NAME"), header_value);
-      } else if (!strcmp(header_name.c_str(), "authorization")) {
+      } else if (need_server && !strcmp(header_name.c_str(), "authorization")) {
         parse_http_authorization_header(header_value);
       }
 
@@ -1553,7 +1602,7 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
         content_type_lower = f$strtolower(header_value);
       } else if (!strcmp(header_name.c_str(), "content-length")) {
         //must be equal to http_data.post_len, ignored
-      } else {
+      } else if (need_server) {
         string key(header_name.size() + 5, false);
         bool good_name = true;
         for (int i = 0; i < (int)header_name.size(); i++) {
@@ -1593,6 +1642,9 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
     v$_SERVER.set_value(string("SCRIPT_URI"), script_uri);
   }
 
+  http_input.len = 0;
+  http_input.pos = 0;
+  http_input.is_streamed = false;
   if (http_data.post_len > 0) {
     bool is_parsed = (http_data.post != nullptr);
 //    fprintf (stderr, "!!!%.*s!!!\n", http_data.post_len, http_data.post);
@@ -1602,9 +1654,11 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
         raw_post_data.assign(http_data.post, http_data.post_len);
         dl::leave_critical_section();
 
-        f$parse_str(raw_post_data, v$_POST);
+        if (need_post) {
+          f$parse_str(raw_post_data, v$_POST);
+        }
       }
-    } else if (strstr(content_type_lower.c_str(), "multipart/form-data")) {
+    } else if ((need_post || used_superglobals.files) && strstr(content_type_lower.c_str(), "multipart/form-data")) {
       const char *p = strstr(content_type_lower.c_str(), "boundary");
       if (p) {
         p += 8;
@@ -1629,50 +1683,47 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
       }
     }
 
-    if (!is_parsed) {
-      int loaded = 0;
-      while (loaded < http_data.post_len) {
-        int to_load = min(PHP_BUF_LEN, http_data.post_len - loaded);
-        http_load_long_query(php_buf, to_load, to_load);
-        loaded += to_load;
-      }
-    }
+    // if the rest of the body isn't read by the script, the connection is closed after the response
+    http_input.is_streamed = !is_parsed;
+    http_input.len = http_data.post_len;
 
-    v$_SERVER.set_value(string("CONTENT_TYPE"), content_type);
+    if (need_server) {
+      v$_SERVER.set_value(string("CONTENT_TYPE"), content_type);
+    }
   }
 
-  double cur_time = microtime();
-  v$_SERVER.set_value(string("GATEWAY_INTERFACE"), string("CGI/1.1"));
-  if (http_data.ip) {
-    v$_SERVER.set_value(string("REMOTE_ADDR"), f$long2ip(static_cast<int>(http_data.ip)));
-  }
-  if (http_data.port) {
-    v$_SERVER.set_value(string("REMOTE_PORT"), static_cast<int>(http_data.port));
-  }
-  if (rpc_data.header.qid) {
-    v$_SERVER.set_value(string("RPC_REQUEST_ID"), f$strval(static_cast<int64_t>(rpc_data.header.qid)));
-    save_rpc_query_headers(rpc_data.header);
-    v$_SERVER.set_value(string("RPC_REMOTE_IP"), static_cast<int>(rpc_data.ip));
-    v$_SERVER.set_value(string("RPC_REMOTE_PORT"), static_cast<int>(rpc_data.port));
-    v$_SERVER.set_value(string("RPC_REMOTE_PID"), static_cast<int>(rpc_data.pid));
-    v$_SERVER.set_value(string("RPC_REMOTE_UTIME"), rpc_data.utime);
-  }
-  is_head_query = false;
-  if (http_data.request_method_len) {
-    v$_SERVER.set_value(string("REQUEST_METHOD"), string(http_data.request_method, http_data.request_method_len));
-    if (http_data.request_method_len == 4 && !strncmp(http_data.request_method, "HEAD", http_data.request_method_len)) {
-      is_head_query = true;
+  is_head_query = http_data.request_method_len == 4 && !strncmp(http_data.request_method, "HEAD", http_data.request_method_len);
+
+  if (need_server) {
+    double cur_time = microtime();
+    v$_SERVER.set_value(string("GATEWAY_INTERFACE"), string("CGI/1.1"));
+    if (http_data.ip) {
+      v$_SERVER.set_value(string("REMOTE_ADDR"), f$long2ip(static_cast<int>(http_data.ip)));
+    }
+    if (http_data.port) {
+      v$_SERVER.set_value(string("REMOTE_PORT"), static_cast<int>(http_data.port));
+    }
+    if (rpc_data.header.qid) {
+      v$_SERVER.set_value(string("RPC_REQUEST_ID"), f$strval(static_cast<int64_t>(rpc_data.header.qid)));
+      save_rpc_query_headers(rpc_data.header);
+      v$_SERVER.set_value(string("RPC_REMOTE_IP"), static_cast<int>(rpc_data.ip));
+      v$_SERVER.set_value(string("RPC_REMOTE_PORT"), static_cast<int>(rpc_data.port));
+      v$_SERVER.set_value(string("RPC_REMOTE_PID"), static_cast<int>(rpc_data.pid));
+      v$_SERVER.set_value(string("RPC_REMOTE_UTIME"), rpc_data.utime);
     }
+    if (http_data.request_method_len) {
+      v$_SERVER.set_value(string("REQUEST_METHOD"), string(http_data.request_method, http_data.request_method_len));
+    }
+    v$_SERVER.set_value(string("REQUEST_TIME"), int(cur_time));
+    v$_SERVER.set_value(string("REQUEST_TIME_FLOAT"), cur_time);
+    v$_SERVER.set_value(string("SERVER_PORT"), string("80"));
+    v$_SERVER.set_value(string("SERVER_PROTOCOL"), string("HTTP/1.1"));
+    v$_SERVER.set_value(string("SERVER_SIGNATURE"), (static_SB.clean() << "Apache/2.2.9 (Debian) PHP/5.2.6-1<<lenny10 with Suhosin-Patch Server at "
+                                                                           << v$_SERVER[string("SERVER_NAME")] << " Port 80").str());
+    v$_SERVER.set_value(string("SERVER_SOFTWARE"), string("Apache/2.2.9 (Debian) PHP/5.2.6-1+lenny10 with Suhosin-Patch"));
   }
-  v$_SERVER.set_value(string("REQUEST_TIME"), int(cur_time));
-  v$_SERVER.set_value(string("REQUEST_TIME_FLOAT"), cur_time);
-  v$_SERVER.set_value(string("SERVER_PORT"), string("80"));
-  v$_SERVER.set_value(string("SERVER_PROTOCOL"), string("HTTP/1.1"));
-  v$_SERVER.set_value(string("SERVER_SIGNATURE"), (static_SB.clean() << "Apache/2.2.9 (Debian) PHP/5.2.6-1<<lenny10 with Suhosin-Patch Server at "
-                                                                         << v$_SERVER[string("SERVER_NAME")] << " Port 80").str());
-  v$_SERVER.set_value(string("SERVER_SOFTWARE"), string("Apache/2.2.9 (Debian) PHP/5.2.6-1+lenny10 with Suhosin-Patch"));
 
-  if (environ != nullptr) {
+  if (environ != nullptr && used_superglobals.env) {
     for (int i = 0; environ[i] != nullptr; i++) {
       const char *s = strchr(environ[i], '=');
       php_assert (s != nullptr);
@@ -1680,9 +1731,11 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
     }
   }
 
-  v$_REQUEST.as_array("") += v$_GET.to_array();
-  v$_REQUEST.as_array("") += v$_POST.to_array();
-  v$_REQUEST.as_array("") += v$_COOKIE.to_array();
+  if (used_superglobals.request) {
+    v$_REQUEST.as_array("") += v$_GET.to_array();
+    v$_REQUEST.as_array("") += v$_POST.to_array();
+    v$_REQUEST.as_array("") += v$_COOKIE.to_array();
+  }
 
   if (http_data.uri != nullptr) {
     if (http_data.keep_alive) {
@@ -1708,8 +1761,10 @@ static void init_superglobals(const http_query_data &http_data, const rpc_query_
     v$argv = *arg_vars;
   }
 
-  v$_SERVER.set_value(string("argv"), v$argv);
-  v$_SERVER.set_value(string("argc"), v$argc);
+  if (need_server) {
+    v$_SERVER.set_value(string("argv"), v$argv);
+    v$_SERVER.set_value(string("argc"), v$argc);
+  }
 
   v$d$PHP_SAPI = php_sapi_name();
 
@@ -1872,6 +1927,27 @@ const Stream STDIN("php://stdin", 11);
 const Stream STDOUT("php://stdout", 12);
 const Stream STDERR("php://stderr", 12);
 
+static int get_http_input_len() {
+  // a body that is received before the script start is kept in raw_post_data
+  return http_input.is_streamed ? http_input.len : static_cast<int>(raw_post_data.size());
+}
+
+static string read_http_input(int64_t length) {
+  const int to_read = static_cast<int>(std::min(length, int64_t{get_http_input_len() - http_input.pos}));
+  if (to_read <= 0) {
+    return {};
+  }
+  string res;
+  if (http_input.is_streamed) {
+    res.assign(static_cast<string::size_type>(to_read), false);
+    http_load_long_query(res.buffer(), to_read, to_read);
+  } else {
+    res.assign(raw_post_data, http_input.pos, to_read);
+  }
+  http_input.pos += to_read;
+  return res;
+}
+
 static Stream php_fopen(const string &stream, const string &mode) {
   if (eq2(stream, STDOUT) || eq2(stream, STDERR)) {
     if (!eq2(mode, string("w")) && !eq2(mode, string("a"))) {
@@ -1941,9 +2017,7 @@ static Optional<int64_t> php_ftell(const Stream &stream) {
   }
 
   if (eq2(stream, INPUT)) {
-    //TODO implement this
-    php_warning("Can't use ftell with stream %s", stream.to_string().c_str());
-    return false;
+    return http_input.pos;
   }
 
   if (eq2(stream, STDIN)) {
@@ -1971,9 +2045,7 @@ static Optional<string> php_fread(const Stream &stream, int64_t length) {
   }
 
   if (eq2(stream, INPUT)) {
-    //TODO implement this
-    php_warning("Can't use fread with stream %s", stream.to_string().c_str());
-    return false;
+    return read_http_input(length);
   }
 
   if (eq2(stream, STDIN)) {
@@ -2108,9 +2180,7 @@ static bool php_feof(const Stream &stream) {
   }
 
   if (eq2(stream, INPUT)) {
-    //TODO implement this
-    php_warning("Can't use feof with stream %s", stream.to_string().c_str());
-    return true;
+    return http_input.pos >= get_http_input_len();
   }
 
   if (eq2(stream, STDIN)) {
@@ -2131,6 +2201,9 @@ static Optional<string> php_file_get_contents(const string &url) {
   }
 
   if (eq2(url, INPUT)) {
+    if (http_input.is_streamed) {
+      return read_http_input(http_input.len - http_input.pos);
+    }
     return raw_post_data;
   }
 
@@ -2320,6 +2393,7 @@ static void free_runtime_libs() {
   vk::singleton<JsonLogger>::get().reset_buffers();
   database_drivers::free_mysql_lib();
   vk::singleton<database_drivers::Adaptor>::get().reset();
+  vk::singleton<ArrayKeysPool>::get().reset();
   free_interface_lib();
   hard_reset_var(JsonEncoderError::msg);
 }
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <functional>
+#include <initializer_list>
 
 #include "common/wrappers/string_view.h"
 
@@ -130,6 +131,10 @@ extern mixed v$_COOKIE;
 extern mixed v$_REQUEST;
 extern mixed v$_ENV;
 
+// is called from the generated init_php_scripts() with names of superglobals that the script uses ("_SERVER", "_GET", ...);
+// the others are left empty, so that request data isn't parsed in vain; all of them are filled if it's not called
+void set_used_superglobals(std::initializer_list<const char *> names) noexcept;
+
 const int32_t UPLOAD_ERR_OK = 0;
 const int32_t UPLOAD_ERR_INI_SIZE = 1;
 const int32_t UPLOAD_ERR_FORM_SIZE = 2;
@@ -38,26 +38,33 @@ private:
 
 namespace {
 
-template<typename JobMessageT, typename T>
-JobMessageT *make_job_request_message(const class_instance<T> &instance) {
-  auto &memory_manager = vk::singleton<job_workers::SharedMemoryManager>::get();
-  auto *memory_request = memory_manager.acquire_shared_message<JobMessageT>();
-  if (memory_request == nullptr) {
-    php_notice("Can't send job: not enough shared messages. "
-               "Most probably job workers are slowed and overloaded due to external factors: net/cpu lags, network queries slowdown etc.");
-    return nullptr;
-  }
+void notice_not_enough_shared_messages() {
+  php_notice("Can't send job: not enough shared messages. "
+             "Most probably job workers are slowed and overloaded due to external factors: net/cpu lags, network queries slowdown etc.");
+}
 
+template<typename JobMessageT, typename T>
+JobMessageT *fill_job_request_message(JobMessageT *memory_request, const class_instance<T> &instance) {
   memory_request->instance = copy_instance_into_other_memory(instance, memory_request->resource,
                                                              ExtraRefCnt::for_job_worker_communication, job_workers::request_extra_shared_memory);
   if (memory_request->instance.is_null()) {
-    memory_manager.release_shared_message(memory_request);
+    vk::singleton<job_workers::SharedMemoryManager>::get().release_shared_message(memory_request);
     php_warning("Can't send job: too big request");
     return nullptr;
   }
   return memory_request;
 }
 
+template<typename JobMessageT, typename T>
+JobMessageT *make_job_request_message(const class_instance<T> &instance) {
+  auto *memory_request = vk::singleton<job_workers::SharedMemoryManager>::get().acquire_shared_message<JobMessageT>();
+  if (memory_request == nullptr) {
+    notice_not_enough_shared_messages();
+    return nullptr;
+  }
+  return fill_job_request_message(memory_request, instance);
+}
+
 int send_job_request_message(job_workers::JobSharedMessage *job_message, double timeout, job_workers::JobSharedMemoryPiece *common_job = nullptr, bool no_reply = false) {
   auto &client = vk::singleton<job_workers::JobWorkerClient>::get();
 
@@ -144,6 +151,103 @@ Optional<int64_t> kphp_job_worker_start_impl(const class_instance<C$KphpJobWorke
   return job_resumable_id;
 }
 
+/**
+ * Sends the requests keeping at most max_jobs_in_flight of them in the job workers,
+ * the next request is sent as soon as a response is received.
+ * When there are no free shared messages, or the jobs in flight already hold half of them and need the rest for the responses,
+ * the next request waits for the responses too, instead of failing: so a big array can be mapped even if it has more requests than shared messages.
+ * The responses are returned under the keys of the requests and in their order; a request that can't be sent gets null.
+ */
+class job_map_resumable final : public Resumable {
+public:
+  using ReturnT = array<class_instance<C$KphpJobWorkerResponse>>;
+
+  job_map_resumable(const array<class_instance<C$KphpJobWorkerRequest>> &requests, double timeout, int64_t max_jobs_in_flight) noexcept
+    : requests_(requests)
+    , timeout_(timeout)
+    , max_jobs_in_flight_(max_jobs_in_flight)
+    , responses_(requests.size()) {
+    for (const auto &it : requests_) {
+      responses_.set_value(it.get_key(), class_instance<C$KphpJobWorkerResponse>{});
+    }
+  }
+
+protected:
+  bool run() final {
+    RESUMABLE_BEGIN
+      for (request_it_ = requests_.begin(); request_it_ != requests_.end() || jobs_in_flight_ > 0;) {
+        if (request_it_ != requests_.end() && jobs_in_flight_ < max_jobs_in_flight_ && send_next_request()) {
+          continue;
+        }
+
+        ready_job_id_ = f$wait_queue_next(queue_id_, -1);
+        TRY_WAIT(job_map_resumable_label_0, ready_job_id_, Optional<int64_t>);
+        if (ready_job_id_.val() <= 0) {
+          break;
+        }
+        response_ = f$wait<class_instance<C$KphpJobWorkerResponse>, false>(ready_job_id_.val());
+        php_assert(resumable_finished);
+
+        responses_.set_value(request_keys_.get_value(ready_job_id_.val()), std::move(response_));
+        request_keys_.unset(ready_job_id_.val());
+        --jobs_in_flight_;
+      }
+
+      unregister_wait_queue(queue_id_);
+      RETURN(responses_);
+    RESUMABLE_END
+  }
+
+private:
+  // returns false if the request has to wait for a response as there are no free shared messages
+  bool send_next_request() noexcept {
+    const auto &request = request_it_.get_value();
+    if (request.is_null()) {
+      php_warning("Can't send job: requests[%s] is null", request_it_.get_key().to_string().c_str());
+      ++request_it_;
+      return true;
+    }
+
+    auto &memory_manager = vk::singleton<job_workers::SharedMemoryManager>::get();
+    // a job holds its request message until it's finished and needs one more for the response,
+    // if the requests took all the messages, the job workers couldn't reply and nothing would be freed
+    if (jobs_in_flight_ > 0 && 2 * (jobs_in_flight_ + 1) > memory_manager.get_stats().messages.count) {
+      return false;
+    }
+
+    auto *memory_request = memory_manager.acquire_shared_message<job_workers::JobSharedMessage>();
+    if (memory_request == nullptr) {
+      if (jobs_in_flight_ > 0) {
+        return false;
+      }
+      notice_not_enough_shared_messages();
+    } else if ((memory_request = fill_job_request_message(memory_request, request))) {
+      const int64_t job_resumable_id = send_job_request_message(memory_request, timeout_);
+      if (job_resumable_id > 0) {
+        queue_id_ = wait_queue_push_unsafe(queue_id_, job_resumable_id);
+        request_keys_.set_value(job_resumable_id, request_it_.get_key());
+        ++jobs_in_flight_;
+      }
+    }
+    ++request_it_;
+    return true;
+  }
+
+  const array<class_instance<C$KphpJobWorkerRequest>> requests_;
+  const double timeout_;
+  const int64_t max_jobs_in_flight_;
+  array<class_instance<C$KphpJobWorkerResponse>> responses_;
+
+  array<class_instance<C$KphpJobWorkerRequest>>::const_iterator request_it_;
+  // job resumable id => key of its request
+  array<mixed> request_keys_;
+  int64_t jobs_in_flight_{0};
+  int64_t queue_id_{-1};
+
+  Optional<int64_t> ready_job_id_;
+  class_instance<C$KphpJobWorkerResponse> response_;
+};
+
 } // namespace
 
 Optional<int64_t> f$kphp_job_worker_start(const class_instance<C$KphpJobWorkerRequest> &request, double timeout) noexcept {
@@ -240,6 +344,18 @@ array<Optional<int64_t>> f$kphp_job_worker_start_multi(const array<class_instanc
   return res;
 }
 
+array<class_instance<C$KphpJobWorkerResponse>> f$kphp_job_worker_map(const array<class_instance<C$KphpJobWorkerRequest>> &requests, double timeout,
+                                                                       int64_t max_jobs_in_flight) noexcept {
+  if (!job_workers_api_allowed()) {
+    return {};
+  }
+  timeout = normalize_job_timeout(timeout);
+  if (max_jobs_in_flight <= 0) {
+    max_jobs_in_flight = f$get_job_workers_number();
+  }
+  return start_resumable<array<class_instance<C$KphpJobWorkerResponse>>>(new job_map_resumable{requests, timeout, max_jobs_in_flight});
+}
+
 void free_job_client_interface_lib() noexcept {
   if (f$is_kphp_job_workers_enabled()) {
     vk::singleton<job_workers::ProcessingJobs>::get().reset();
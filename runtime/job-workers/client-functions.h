@@ -12,3 +12,5 @@ void free_job_client_interface_lib() noexcept;
 Optional<int64_t> f$kphp_job_worker_start(const class_instance<C$KphpJobWorkerRequest> &request, double timeout) noexcept;
 bool f$kphp_job_worker_start_no_reply(const class_instance<C$KphpJobWorkerRequest> &request, double timeout) noexcept;
 array<Optional<int64_t>> f$kphp_job_worker_start_multi(const array<class_instance<C$KphpJobWorkerRequest>> &requests, double timeout) noexcept;
+array<class_instance<C$KphpJobWorkerResponse>> f$kphp_job_worker_map(const array<class_instance<C$KphpJobWorkerRequest>> &requests, double timeout,
+                                                                       int64_t max_jobs_in_flight = -1) noexcept;
@@ -6,6 +6,7 @@
 
 #include "common/algorithms/find.h"
 
+#include "runtime/array-keys-pool.h"
 #include "runtime/exception.h"
 #include "runtime/string_functions.h"
 
@@ -318,6 +319,33 @@ void json_skip_blanks(const char *s, int &i) noexcept {
   }
 }
 
+bool do_json_decode(const char *s, int s_len, int &i, mixed &v, const char *json_obj_magic_key) noexcept;
+
+// object keys are interned, so that decoded objects of the same shape share key strings and their hashes
+bool json_decode_object_key(const char *s, int s_len, int &i, ArrayKeysPool::Key &key, const char *json_obj_magic_key) noexcept {
+  auto &keys_pool = vk::singleton<ArrayKeysPool>::get();
+  json_skip_blanks(s, i);
+  if (s[i] == '"') {
+    int j = i + 1;
+    while (j < s_len && s[j] != '"' && s[j] != '\\') {
+      j++;
+    }
+    // a key without escape sequences is interned right from the input
+    if (j < s_len && s[j] == '"') {
+      key = keys_pool.intern(s + i + 1, static_cast<string::size_type>(j - i - 1));
+      i = j + 1;
+      return true;
+    }
+  }
+
+  mixed decoded_key;
+  if (!do_json_decode(s, s_len, i, decoded_key, json_obj_magic_key) || !decoded_key.is_string()) {
+    return false;
+  }
+  key = keys_pool.intern(decoded_key.as_string().c_str(), decoded_key.as_string().size());
+  return true;
+}
+
 bool do_json_decode(const char *s, int s_len, int &i, mixed &v, const char *json_obj_magic_key) noexcept {
   if (!v.is_null()) {
     v.destroy();
@@ -500,8 +528,8 @@ bool do_json_decode(const char *s, int s_len, int &i, mixed &v, const char *json
       json_skip_blanks(s, i);
       if (s[i] != '}') {
         do {
-          mixed key;
-          if (!do_json_decode(s, s_len, i, key, json_obj_magic_key) || !key.is_string()) {
+          ArrayKeysPool::Key key;
+          if (!json_decode_object_key(s, s_len, i, key, json_obj_magic_key)) {
             return false;
           }
           json_skip_blanks(s, i);
@@ -509,9 +537,11 @@ bool do_json_decode(const char *s, int s_len, int &i, mixed &v, const char *json
             return false;
           }
 
-          if (!do_json_decode(s, s_len, i, res[key], json_obj_magic_key)) {
+          mixed value;
+          if (!do_json_decode(s, s_len, i, value, json_obj_magic_key)) {
             return false;
           }
+          key.set_value_to(res, std::move(value));
           json_skip_blanks(s, i);
         } while (s[i++] == ',');
 
@@ -56,6 +56,39 @@ void hard_reset_var(T &var, Args &&... args) noexcept {
   new(&var) T(std::forward<Args>(args)...);
 }
 
+// plain data globals (ints, floats, bools) are defined by the compiler in a separate section;
+// the first reset initializes them one by one and takes a snapshot of the section, next ones just copy it back
+#ifdef __linux__
+#define PLAIN_DATA_GLOBAL __attribute__((section("kphp_plain_globals")))
+// the section bounds are defined by the linker; weak, as there may be no plain data globals at all
+extern "C" char __start_kphp_plain_globals[] __attribute__((weak));
+extern "C" char __stop_kphp_plain_globals[] __attribute__((weak));
+#else
+#define PLAIN_DATA_GLOBAL
+#endif
+
+template<typename F>
+void reset_plain_data_globals(F &&reset_one_by_one) noexcept {
+#ifdef __linux__
+  static char *snapshot = nullptr;
+  const size_t size = __stop_kphp_plain_globals - __start_kphp_plain_globals;
+  if (size == 0) {
+    // the section bounds are null then, nothing to copy
+    reset_one_by_one();
+    return;
+  }
+  if (snapshot) {
+    memcpy(__start_kphp_plain_globals, snapshot, size);
+    return;
+  }
+  reset_one_by_one();
+  snapshot = new char[size];
+  memcpy(snapshot, __start_kphp_plain_globals, size);
+#else
+  reset_one_by_one();
+#endif
+}
+
 inline constexpr int64_t operator "" _i64(unsigned long long int v) noexcept {
   return static_cast<int64_t>(v);
 }
@@ -398,6 +431,9 @@ inline string f$get_class(const class_instance<T> &v);
 template<class T>
 inline int64_t f$get_hash_of_class(const class_instance<T> &klass);
 
+template<class T>
+inline int64_t f$_get_virt_dispatch_slot(const class_instance<T> &klass);
+
 
 inline int64_t f$count(const mixed &v);
 
@@ -1271,6 +1307,13 @@ inline int64_t f$get_hash_of_class(const class_instance<T> &klass) {
   return klass.get_hash();
 }
 
+// the compiler numbers the classes of a hierarchy T from 1 sequentially, a class returns its number via the overload tagged by T;
+// null always falls into slot 0
+template<class T>
+inline int64_t f$_get_virt_dispatch_slot(const class_instance<T> &klass) {
+  return klass.is_null() ? 0 : klass.get()->get_virt_dispatch_slot(static_cast<const T *>(nullptr));
+}
+
 string &append(string &dest, const string &from) {
   return dest.append(from);
 }
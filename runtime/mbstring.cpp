@@ -17,9 +17,57 @@ static int mb_detect_encoding(const string &encoding) {
   return -1;
 }
 
-static int64_t mb_UTF8_strlen(const char *s) {
+// UTF-8 strings are processed by 8 bytes at once where possible: characters are counted without decoding,
+// runs of ASCII characters (spaces, digits, punctuation and markup are ASCII in any language) are validated and case mapped as a whole;
+// the word-at-a-time code uses plain 64-bit arithmetic, so it's the same for all platforms and needs no cpu dispatch;
+// as before, all the functions stop at the first zero byte
+namespace {
+
+constexpr uint64_t EVERY_BYTE_ONE = 0x0101010101010101ULL;
+constexpr uint64_t EVERY_BYTE_HIGH_BIT = 0x8080808080808080ULL;
+
+uint64_t load_word(const char *s) noexcept {
+  uint64_t word = 0;
+  memcpy(&word, s, sizeof(word));
+  return word;
+}
+
+// the number of bytes that start a character, i.e. are not 10xxxxxx; the word must not contain zero bytes
+int64_t count_char_starts(uint64_t word) noexcept {
+  const uint64_t continuation_bytes = (word & ~(word << 1) & EVERY_BYTE_HIGH_BIT) >> 7;
+  return 8 - static_cast<int64_t>((continuation_bytes * EVERY_BYTE_ONE) >> 56);
+}
+
+bool has_zero_byte(uint64_t word) noexcept {
+  return (word - EVERY_BYTE_ONE) & ~word & EVERY_BYTE_HIGH_BIT;
+}
+
+bool is_ascii_word(uint64_t word) noexcept {
+  return !(word & EVERY_BYTE_HIGH_BIT) && !has_zero_byte(word);
+}
+
+// case mapping of 8 ASCII characters: 0x20 is toggled in bytes from [first, last]
+template<char first, char last>
+uint64_t toggle_ascii_case(uint64_t word) noexcept {
+  const uint64_t above_last = (word + (0x7f - last) * EVERY_BYTE_ONE) & EVERY_BYTE_HIGH_BIT;
+  const uint64_t from_first = (word + (0x80 - first) * EVERY_BYTE_ONE) & EVERY_BYTE_HIGH_BIT;
+  return word ^ ((from_first & ~above_last) >> 2);
+}
+
+} // namespace
+
+// the number of characters in the first len bytes
+static int64_t mb_UTF8_strlen(const char *s, int64_t len) {
   int64_t res = 0;
-  for (int64_t i = 0; s[i]; i++) {
+  int64_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    const uint64_t word = load_word(s + i);
+    if (has_zero_byte(word)) {
+      break;
+    }
+    res += count_char_starts(word);
+  }
+  for (; i < len && s[i]; i++) {
     if ((((unsigned char)s[i]) & 0xc0) != 0x80) {
       res++;
     }
@@ -27,10 +75,22 @@ static int64_t mb_UTF8_strlen(const char *s) {
   return res;
 }
 
-static int64_t mb_UTF8_advance(const char *s, int64_t cnt) {
+// the byte offset of the character cnt, s must be followed by at least len bytes (including the terminating zero one)
+static int64_t mb_UTF8_advance(const char *s, int64_t len, int64_t cnt) {
   php_assert (cnt >= 0);
-  int64_t i;
-  for (i = 0; s[i] && cnt >= 0; i++) {
+  int64_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    const uint64_t word = load_word(s + i);
+    if (has_zero_byte(word)) {
+      break;
+    }
+    const int64_t starts = count_char_starts(word);
+    if (starts > cnt) {
+      break;
+    }
+    cnt -= starts;
+  }
+  for (; s[i] && cnt >= 0; i++) {
     if ((((unsigned char)s[i]) & 0xc0) != 0x80) {
       cnt--;
     }
@@ -41,18 +101,13 @@ static int64_t mb_UTF8_advance(const char *s, int64_t cnt) {
   return i;
 }
 
-static int64_t mb_UTF8_get_offset(const char *s, int64_t pos) {
-  int64_t res = 0;
-  for (int64_t i = 0; i < pos && s[i]; i++) {
-    if ((((unsigned char)s[i]) & 0xc0) != 0x80) {
-      res++;
+bool mb_UTF8_check(const char *s, size_t len) {
+  const char *end = s + len;
+  do {
+    while (end - s >= 8 && is_ascii_word(load_word(s))) {
+      s += 8;
     }
-  }
-  return res;
-}
 
-bool mb_UTF8_check(const char *s) {
-  do {
 #define CHECK(condition) if (!(condition)) {return false;}
     unsigned int a = (unsigned char)(*s++);
     if ((a & 0x80) == 0) {
@@ -94,6 +149,37 @@ bool mb_UTF8_check(const char *s) {
   php_assert (0);
 }
 
+template<uint64_t (*ascii_convert_case)(uint64_t), int (*unicode_convert_case)(int)>
+static string mb_UTF8_convert_case(const string &str, const char *function) {
+  const char *s = str.c_str();
+  const char *end = s + str.size();
+  string res(str.size() * 3, false);
+  int res_len = 0;
+  int p;
+  int ch;
+  do {
+    for (; end - s >= 8; s += 8, res_len += 8) {
+      const uint64_t word = load_word(s);
+      if (!is_ascii_word(word)) {
+        break;
+      }
+      const uint64_t converted = ascii_convert_case(word);
+      memcpy(&res[res_len], &converted, sizeof(converted));
+    }
+    if ((p = get_char_utf8(&ch, s)) <= 0) {
+      break;
+    }
+    s += p;
+    res_len += put_char_utf8(unicode_convert_case(ch), &res[res_len]);
+  } while (true);
+  if (p < 0) {
+    php_warning("Incorrect UTF-8 string \"%s\" in function %s", str.c_str(), function);
+  }
+  res.shrink(res_len);
+
+  return res;
+}
+
 bool f$mb_check_encoding(const string &str, const string &encoding) {
   int encoding_num = mb_detect_encoding(encoding);
   if (encoding_num < 0) {
@@ -105,7 +191,7 @@ bool f$mb_check_encoding(const string &str, const string &encoding) {
     return true;
   }
 
-  return mb_UTF8_check(str.c_str());
+  return mb_UTF8_check(str.c_str(), str.size());
 }
 
 
@@ -120,7 +206,7 @@ int64_t f$mb_strlen(const string &str, const string &encoding) {
     return str.size();
   }
 
-  return mb_UTF8_strlen(str.c_str());
+  return mb_UTF8_strlen(str.c_str(), str.size());
 }
 
 
@@ -171,21 +257,7 @@ string f$mb_strtolower(const string &str, const string &encoding) {
 
     return res;
   } else {
-    string res(len * 3, false);
-    const char *s = str.c_str();
-    int res_len = 0;
-    int p;
-    int ch;
-    while ((p = get_char_utf8(&ch, s)) > 0) {
-      s += p;
-      res_len += put_char_utf8(unicode_tolower(ch), &res[res_len]);
-    }
-    if (p < 0) {
-      php_warning("Incorrect UTF-8 string \"%s\" in function mb_strtolower", str.c_str());
-    }
-    res.shrink(res_len);
-
-    return res;
+    return mb_UTF8_convert_case<toggle_ascii_case<'A', 'Z'>, unicode_tolower>(str, "mb_strtolower");
   }
 }
 
@@ -241,21 +313,7 @@ string f$mb_strtoupper(const string &str, const string &encoding) {
 
     return res;
   } else {
-    string res(len * 3, false);
-    const char *s = str.c_str();
-    int res_len = 0;
-    int p;
-    int ch;
-    while ((p = get_char_utf8(&ch, s)) > 0) {
-      s += p;
-      res_len += put_char_utf8(unicode_toupper(ch), &res[res_len]);
-    }
-    if (p < 0) {
-      php_warning("Incorrect UTF-8 string \"%s\" in function mb_strtoupper", str.c_str());
-    }
-    res.shrink(res_len);
-
-    return res;
+    return mb_UTF8_convert_case<toggle_ascii_case<'a', 'z'>, unicode_toupper>(str, "mb_strtoupper");
   }
 }
 
@@ -284,12 +342,12 @@ Optional<int64_t> mp_strpos_impl(const string &haystack, const string &needle, i
     return f$strpos(haystack, needle, offset);
   }
 
-  int64_t UTF8_offset = mb_UTF8_advance(haystack.c_str(), offset);
+  int64_t UTF8_offset = mb_UTF8_advance(haystack.c_str(), haystack.size(), offset);
   const char *s = static_cast<const char *>(memmem(haystack.c_str() + UTF8_offset, haystack.size() - UTF8_offset, needle.c_str(), needle.size()));
   if (unlikely(s == nullptr)) {
     return false;
   }
-  return mb_UTF8_get_offset(haystack.c_str() + UTF8_offset, s - (haystack.c_str() + UTF8_offset)) + offset;
+  return mb_UTF8_strlen(haystack.c_str() + UTF8_offset, s - (haystack.c_str() + UTF8_offset)) + offset;
 }
 
 } // namespace
@@ -330,7 +388,7 @@ string f$mb_substr(const string &str, int64_t start, const mixed &length_var, co
     return res.val();
   }
 
-  int64_t len = mb_UTF8_strlen(str.c_str());
+  int64_t len = mb_UTF8_strlen(str.c_str(), str.size());
   if (start < 0) {
     start += len;
   }
@@ -347,8 +405,8 @@ string f$mb_substr(const string &str, int64_t start, const mixed &length_var, co
     length = len - start;
   }
 
-  int64_t UTF8_start = mb_UTF8_advance(str.c_str(), start);
-  int64_t UTF8_length = mb_UTF8_advance(str.c_str() + UTF8_start, length);
+  int64_t UTF8_start = mb_UTF8_advance(str.c_str(), str.size(), start);
+  int64_t UTF8_length = mb_UTF8_advance(str.c_str() + UTF8_start, str.size() - UTF8_start, length);
 
   return {str.c_str() + UTF8_start, static_cast<string::size_type>(UTF8_length)};
 }
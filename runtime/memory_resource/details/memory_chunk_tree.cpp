@@ -123,6 +123,31 @@ memory_chunk_tree::tree_node *memory_chunk_tree::extract_smallest() noexcept {
   return v;
 }
 
+memory_chunk_tree::tree_node *memory_chunk_tree::extract_at(void *mem, size_t min_size) noexcept {
+  tree_node *v = search_at(root_, mem, min_size);
+  if (!v) {
+    return nullptr;
+  }
+  if (v == mem) {
+    // the chunk is in the tree itself: it's detached with its same size list, and the list is put back
+    tree_node *same_size_chunk = v->same_size_chunk_list;
+    detach_node(v);
+    while (same_size_chunk) {
+      tree_node *next = same_size_chunk->same_size_chunk_list;
+      insert(same_size_chunk, same_size_chunk->chunk_size);
+      same_size_chunk = next;
+    }
+    return v;
+  }
+  // the chunk is in the same size list of v
+  while (v->same_size_chunk_list != mem) {
+    v = v->same_size_chunk_list;
+  }
+  tree_node *result = v->same_size_chunk_list;
+  v->same_size_chunk_list = result->same_size_chunk_list;
+  return result;
+}
+
 bool memory_chunk_tree::has_memory_for(size_t size) const noexcept {
   return search(size, true);
 }
@@ -179,6 +204,25 @@ memory_chunk_tree::tree_node *memory_chunk_tree::search(size_t size, bool lower_
   return lower_bound ? lower_bound_node : node;
 }
 
+memory_chunk_tree::tree_node *memory_chunk_tree::search_at(tree_node *node, void *mem, size_t min_size) const noexcept {
+  // the tree is ordered by sizes, so all the nodes not smaller than min_size are visited;
+  // returns the node, which is mem itself or has mem in its same size list
+  while (node) {
+    if (node->chunk_size >= min_size) {
+      for (tree_node *same_size_chunk = node; same_size_chunk; same_size_chunk = same_size_chunk->same_size_chunk_list) {
+        if (same_size_chunk == mem) {
+          return node;
+        }
+      }
+      if (tree_node *found = search_at(node->left, mem, min_size)) {
+        return found;
+      }
+    }
+    node = node->right;
+  }
+  return nullptr;
+}
+
 void memory_chunk_tree::left_rotate(tree_node *node) noexcept {
   tree_node *new_parent = node->right;
   if (node == root_) {
@@ -21,6 +21,8 @@ public:
   void insert(void *mem, size_t size) noexcept;
   tree_node *extract(size_t size) noexcept;
   tree_node *extract_smallest() noexcept;
+  // extracts the chunk that starts exactly at mem, if its size is at least min_size
+  tree_node *extract_at(void *mem, size_t min_size) noexcept;
   bool has_memory_for(size_t size) const noexcept;
 
   static size_t get_chunk_size(tree_node *node) noexcept;
@@ -30,6 +32,7 @@ public:
 private:
   void flush_node_to(tree_node *node, memory_ordered_chunk_list &mem_list) noexcept;
   tree_node *search(size_t size, bool lower_bound) const noexcept;
+  tree_node *search_at(tree_node *node, void *mem, size_t min_size) const noexcept;
 
   void left_rotate(tree_node *node) noexcept;
   void right_rotate(tree_node *node) noexcept;
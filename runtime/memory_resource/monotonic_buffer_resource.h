@@ -81,8 +81,8 @@ public:
   }
 
   void *try_expand(void *mem, size_t new_size, size_t old_size) noexcept {
-    if (static_cast<char *>(mem) + old_size == memory_current_) {
-      const auto additional_size = old_size - new_size;
+    if (static_cast<char *>(mem) + old_size == memory_current_ && new_size >= old_size) {
+      const auto additional_size = new_size - old_size;
       if (static_cast<size_t>(memory_end_ - memory_current_) >= additional_size) {
         memory_current_ += additional_size;
         register_allocation(mem, additional_size);
@@ -97,6 +97,26 @@ void *unsynchronized_pool_resource::perform_defragmentation_and_allocate_huge_pi
   return allocate_huge_piece(aligned_size, false);
 }
 
+void *unsynchronized_pool_resource::try_expand_over_next_huge_piece(void *mem, size_t new_size, size_t old_size) noexcept {
+  char *piece_end = static_cast<char *>(mem) + old_size;
+  // extra memory pools are separate buffers, a piece can't be joined with a piece from another buffer
+  if (static_cast<char *>(mem) < memory_begin_ || piece_end >= memory_current_) {
+    return nullptr;
+  }
+  details::memory_chunk_tree::tree_node *next_piece = huge_pieces_.extract_at(piece_end, new_size - old_size);
+  if (!next_piece) {
+    return nullptr;
+  }
+  --stats_.huge_memory_pieces;
+  const size_t next_piece_size = details::memory_chunk_tree::get_chunk_size(next_piece);
+  if (const size_t left = old_size + next_piece_size - new_size) {
+    put_memory_back(static_cast<char *>(mem) + new_size, left);
+  }
+  memory_debug("reallocate %zu to %zu, expanded over the next huge chunk (%zu) at %p\n", old_size, new_size, next_piece_size, mem);
+  register_allocation(mem, new_size - old_size);
+  return mem;
+}
+
 bool unsynchronized_pool_resource::is_memory_from_extra_pool(void *mem, size_t size) const noexcept {
   auto *extra_pool = extra_memory_head_;
   do {
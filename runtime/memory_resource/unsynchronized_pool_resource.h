@@ -18,7 +18,6 @@ namespace memory_resource {
 
 class unsynchronized_pool_resource : private monotonic_buffer_resource {
 public:
-  using monotonic_buffer_resource::try_expand;
   using monotonic_buffer_resource::get_memory_stats;
   using monotonic_buffer_resource::memory_begin;
 
@@ -58,6 +57,18 @@ public:
     return details::universal_reallocate(*this, mem, aligned_new_size, aligned_old_size);
   }
 
+  // the sizes should be aligned;
+  // a piece is expanded in place at the end of the used memory or over the free huge piece that follows it
+  void *try_expand(void *mem, size_t new_size, size_t old_size) noexcept {
+    if (void *expanded_mem = monotonic_buffer_resource::try_expand(mem, new_size, old_size)) {
+      return expanded_mem;
+    }
+    if (old_size >= MAX_CHUNK_BLOCK_SIZE_ && new_size > old_size) {
+      return try_expand_over_next_huge_piece(mem, new_size, old_size);
+    }
+    return nullptr;
+  }
+
   void deallocate(void *mem, size_t size) noexcept {
     memory_debug("deallocate %zu at %p\n", size, mem);
     const auto aligned_size = details::align_for_chunk(size);
@@ -116,6 +127,7 @@ private:
 
   void *allocate_small_piece_from_fallback_resource(size_t aligned_size) noexcept;
   void *perform_defragmentation_and_allocate_huge_piece(size_t aligned_size) noexcept;
+  void *try_expand_over_next_huge_piece(void *mem, size_t new_size, size_t old_size) noexcept;
   bool is_memory_from_extra_pool(void *mem, size_t size) const noexcept;
 
   void put_memory_back(void *mem, size_t size) noexcept {
@@ -4,6 +4,7 @@
 
 #include "runtime/mysql.h"
 
+#include "runtime/array-keys-pool.h"
 #include "server/php-queries.h"
 
 static int mysql_callback_state;
@@ -149,7 +150,11 @@ static void mysql_query_callback(const char *result_, int result_len) {
       mysql_read_string(result, result_len, is_null);//db
       mysql_read_string(result, result_len, is_null);//table
       mysql_read_string(result, result_len, is_null);//org_table
-      field_names_ptr->push_back(mysql_read_string(result, result_len, is_null, true));//name
+      {
+        // all the rows share field names as keys, they are also shared with previous queries by the pool
+        const string name = mysql_read_string(result, result_len, is_null, true);
+        field_names_ptr->push_back(vk::singleton<ArrayKeysPool>::get().intern(name.c_str(), name.size()).str);//name
+      }
       mysql_read_string(result, result_len, is_null);//org_name
 
       result_len -= 13;
@@ -57,6 +57,10 @@ void MysqlPdoDriver::connect(const class_instance<C$PDO> &v$this, const string &
           }
           break;
         }
+        case C$PDO::MYSQL_ATTR_USE_BUFFERED_QUERY: {
+          use_buffered_query = it.get_value().to_bool();
+          break;
+        }
         default: {
           php_warning("MySQL option %" PRId64 " is not supported", option);
         }
@@ -69,11 +73,12 @@ void MysqlPdoDriver::connect(const class_instance<C$PDO> &v$this, const string &
 }
 
 class_instance<C$PDOStatement> MysqlPdoDriver::prepare(const class_instance<C$PDO> &v$this, const string &query, const array<mixed> &options) noexcept {
-  (void)options;
+  const mixed *use_buffered_query_option = options.find_value(C$PDO::MYSQL_ATTR_USE_BUFFERED_QUERY);
+  const bool is_buffered = use_buffered_query_option ? use_buffered_query_option->to_bool() : use_buffered_query;
   class_instance<C$PDOStatement> res;
   res.alloc();
 
-  res.get()->statement = std::make_unique<MysqlPdoEmulatedStatement>(query, v$this.get()->driver->connector_id);
+  res.get()->statement = std::make_unique<MysqlPdoEmulatedStatement>(query, v$this.get()->driver->connector_id, is_buffered);
   res.get()->timeout_sec = v$this->timeout_sec;
 
   return res;
@@ -19,6 +19,9 @@ public:
   class_instance<C$PDOStatement> prepare(const class_instance<C$PDO> &v$this, const string &query, const array<mixed> &options) noexcept final;
   virtual const char *error_code_sqlstate() noexcept final;
   virtual std::pair<int, const char *> error_info() noexcept final;
+
+private:
+  bool use_buffered_query{true};
 };
 
 } // namespace pdo::mysql
@@ -2,10 +2,15 @@
 // Copyright (c) 2021 LLC «V Kontakte»
 // Distributed under the GPL v3 License, see LICENSE.notice.txt
 
+#include <cmath>
+#include <cstdio>
+
 #include "runtime/pdo/mysql/mysql_pdo_emulated_statement.h"
+#include "runtime/array-keys-pool.h"
 #include "runtime/kphp_core.h"
 #include "runtime/pdo/pdo_statement.h"
 #include "runtime/resumable.h"
+#include "server/database-drivers/mysql/mysql-connector.h"
 #include "server/database-drivers/mysql/mysql.h"
 #include "server/database-drivers/mysql/mysql-request.h"
 #include "server/database-drivers/mysql/mysql-response.h"
@@ -13,18 +18,59 @@
 
 namespace pdo::mysql {
 
+namespace {
+
+bool is_placeholder_name_char(char c) noexcept {
+  return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_';
+}
+
+string::size_type skip_until(const string &str, string::size_type pos, const char *end) noexcept {
+  const char *found = strstr(str.c_str() + pos, end);
+  return found ? static_cast<string::size_type>(found - str.c_str()) + static_cast<string::size_type>(strlen(end)) - 1 : str.size();
+}
+
+bool append_escaped_string(string &query, MYSQL *mysql, const string &value) noexcept {
+  string escaped{2 * value.size() + 1, false};
+  const unsigned long len = LIB_MYSQL_CALL(mysql_real_escape_string_quote(mysql, escaped.buffer(), value.c_str(), value.size(), '\''));
+  if (len == static_cast<unsigned long>(-1)) {
+    return false;
+  }
+  escaped.shrink(static_cast<string::size_type>(len));
+  query.append(1, '\'').append(escaped).append(1, '\'');
+  return true;
+}
+
+bool append_float(string &query, double value) noexcept {
+  if (!std::isfinite(value)) {
+    return false;
+  }
+  // %.17G is enough to restore any double exactly
+  char buf[32];
+  const int len = snprintf(buf, sizeof(buf), "%.17G", value);
+  query.append(buf, static_cast<string::size_type>(len));
+  return true;
+}
+
+} // namespace
+
 class MysqlPdoEmulatedStatement::ExecuteResumable final : public Resumable {
 private:
   MysqlPdoEmulatedStatement *ctx{};
+  string query;
   int64_t timeout_sec{-1};
   std::unique_ptr<database_drivers::Response> response{};
   int resumable_id{};
 public:
   using ReturnT = bool;
-  explicit ExecuteResumable(MysqlPdoEmulatedStatement *ctx, int64_t timeout_sec) noexcept : ctx(ctx), timeout_sec(timeout_sec) {}
+  ExecuteResumable(MysqlPdoEmulatedStatement *ctx, string query, int64_t timeout_sec) noexcept
+    : ctx(ctx)
+    , query(std::move(query))
+    , timeout_sec(timeout_sec) {}
   bool run() noexcept final {
     RESUMABLE_BEGIN
-      resumable_id = vk::singleton<database_drivers::Adaptor>::get().launch_request_resumable(std::make_unique<database_drivers::MysqlRequest>(ctx->connector_id, ctx->statement));
+      resumable_id = vk::singleton<database_drivers::Adaptor>::get().launch_request_resumable(std::make_unique<database_drivers::MysqlRequest>(
+        ctx->connector_id, query,
+        ctx->is_buffered ? database_drivers::MysqlRequest::Type::buffered_query : database_drivers::MysqlRequest::Type::unbuffered_query));
       response = vk::singleton<database_drivers::Adaptor>::get().wait_request_resumable(resumable_id, timeout_sec);
       TRY_WAIT(MysqlPdoEmulatedStatement_ExecuteResumable_label, response, std::unique_ptr<database_drivers::Response>);
       if (auto *casted = dynamic_cast<database_drivers::MysqlResponse *>(response.get())) {
@@ -33,39 +79,228 @@ public:
       } else {
         php_critical_error("Unexpected error at MySQL PDO::execute");
       }
+      ctx->has_unread_rows = !ctx->is_buffered && ctx->response->res != nullptr;
       RETURN(!ctx->response->is_error);
     RESUMABLE_END
   }
 };
 
-MysqlPdoEmulatedStatement::MysqlPdoEmulatedStatement(const string &statement, int connector_id)
+MysqlPdoEmulatedStatement::MysqlPdoEmulatedStatement(const string &statement, int connector_id, bool is_buffered)
   : statement(statement)
-  , connector_id(connector_id) {}
+  , connector_id(connector_id)
+  , is_buffered(is_buffered) {}
+
+void MysqlPdoEmulatedStatement::parse_placeholders() noexcept {
+  is_parsed = true;
+  const string::size_type len = statement.size();
+  string::size_type part_begin = 0;
+  for (string::size_type i = 0; i < len; ++i) {
+    const char c = statement[i];
+    if (c == '\'' || c == '"' || c == '`') {
+      // a doubled quote is parsed as two adjacent quoted strings, that's the same for placeholders
+      for (++i; i < len && statement[i] != c; ++i) {
+        if (statement[i] == '\\' && c != '`') {
+          ++i;
+        }
+      }
+      continue;
+    }
+    if (c == '#' || (c == '-' && i + 1 < len && statement[i + 1] == '-' && (i + 2 == len || isspace(statement[i + 2])))) {
+      i = skip_until(statement, i, "\n");
+      continue;
+    }
+    if (c == '/' && i + 1 < len && statement[i + 1] == '*') {
+      i = skip_until(statement, i + 2, "*/");
+      continue;
+    }
+
+    string::size_type placeholder_len = 0;
+    if (c == '?') {
+      placeholder_len = 1;
+    } else if (c == ':') {
+      while (i + placeholder_len + 1 < len && is_placeholder_name_char(statement[i + placeholder_len + 1])) {
+        ++placeholder_len;
+      }
+      if (placeholder_len == 0) {
+        continue;
+      }
+      ++placeholder_len;
+    } else {
+      continue;
+    }
+    query_parts.push_back(statement.substr(part_begin, i - part_begin));
+    placeholder_names.push_back(statement.substr(i + 1, placeholder_len - 1));
+    i += placeholder_len - 1;
+    part_begin = i + 1;
+  }
+  query_parts.push_back(statement.substr(part_begin, len - part_begin));
+
+  array<bool> named_placeholders;
+  bool has_positional = false;
+  for (const auto &it : placeholder_names) {
+    const string &name = it.get_value();
+    if (name.empty()) {
+      has_positional = true;
+      ++distinct_placeholders_count;
+    } else if (!named_placeholders.isset(name)) {
+      named_placeholders.set_value(name, true);
+      ++distinct_placeholders_count;
+    }
+  }
+  has_mixed_placeholders = has_positional && !named_placeholders.empty();
+}
+
+Optional<string> MysqlPdoEmulatedStatement::bind_params(const array<mixed> &params) noexcept {
+  if (!is_parsed) {
+    parse_placeholders();
+  }
+  if (has_mixed_placeholders) {
+    php_warning("Invalid parameter number in PDOStatement::execute: mixed named and positional parameters");
+    return false;
+  }
+  if (params.count() != distinct_placeholders_count) {
+    php_warning("Invalid parameter number in PDOStatement::execute: %" PRIi64 " parameters are bound for %" PRIi64 " placeholders",
+                params.count(), distinct_placeholders_count);
+    return false;
+  }
+  auto *connector = vk::singleton<database_drivers::Adaptor>::get().get_connector<database_drivers::MysqlConnector>(connector_id);
+  if (connector == nullptr) {
+    return false;
+  }
+
+  const int64_t placeholders_count = placeholder_names.count();
+
+  string query = query_parts[0];
+  for (int64_t i = 0; i < placeholders_count; ++i) {
+    const string &name = placeholder_names[i];
+    const mixed *value = nullptr;
+    if (name.empty()) {
+      value = params.find_value(i);
+    } else {
+      value = params.find_value(string{":"}.append(name));
+      if (value == nullptr) {
+        value = params.find_value(name);
+      }
+    }
+    if (value == nullptr) {
+      php_warning("Parameter %s%s is not bound in PDOStatement::execute", name.empty() ? "#" : ":",
+                  name.empty() ? string{i}.c_str() : name.c_str());
+      return false;
+    }
+    switch (value->get_type()) {
+      case mixed::type::NUL:
+        query.append("NULL", 4);
+        break;
+      case mixed::type::BOOLEAN:
+        query.append(1, value->as_bool() ? '1' : '0');
+        break;
+      case mixed::type::INTEGER:
+        query.append(value->as_int());
+        break;
+      case mixed::type::FLOAT:
+        if (!append_float(query, value->as_double())) {
+          php_warning("Can't bind non-finite float %s to parameter in PDOStatement::execute", string{value->as_double()}.c_str());
+          return false;
+        }
+        break;
+      case mixed::type::STRING:
+        if (!append_escaped_string(query, connector->ctx, value->as_string())) {
+          php_warning("Can't escape string parameter in PDOStatement::execute");
+          return false;
+        }
+        break;
+      default:
+        php_warning("Can't bind %s to parameter in PDOStatement::execute", value->get_type_c_str());
+        return false;
+    }
+    query.append(query_parts[i + 1]);
+  }
+  return query;
+}
 
 bool MysqlPdoEmulatedStatement::execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept {
-  (void)v$this, (void)params; // TODO: use params
-  return start_resumable<bool>(new ExecuteResumable(this, v$this.get()->timeout_sec));
+  if (has_unread_rows) {
+    close_cursor();
+  }
+  response = nullptr;
+
+  string query = statement;
+  if (params.has_value()) {
+    Optional<string> bound_query = bind_params(params.val());
+    if (!bound_query.has_value()) {
+      return false;
+    }
+    query = std::move(bound_query.val());
+  }
+  return start_resumable<bool>(new ExecuteResumable(this, std::move(query), v$this.get()->timeout_sec));
+}
+
+std::unique_ptr<database_drivers::MysqlResponse> MysqlPdoEmulatedStatement::fetch_unbuffered_rows(bool discard) noexcept {
+  auto &adaptor = vk::singleton<database_drivers::Adaptor>::get();
+  const auto type = discard ? database_drivers::MysqlRequest::Type::discard_rows : database_drivers::MysqlRequest::Type::fetch_row;
+  const int resumable_id = adaptor.launch_request_resumable(std::make_unique<database_drivers::MysqlRequest>(connector_id, response->res, type));
+  // fetch() isn't resumable, so the row is waited for synchronously, as f$wait_synchronously() does
+  wait_without_result_synchronously(resumable_id);
+  std::unique_ptr<database_drivers::Response> row_response = adaptor.wait_request_resumable(resumable_id);
+  if (auto *casted = dynamic_cast<database_drivers::MysqlResponse *>(row_response.get())) {
+    row_response.release();
+    return std::unique_ptr<database_drivers::MysqlResponse>{casted};
+  }
+  return nullptr;
 }
 
 mixed MysqlPdoEmulatedStatement::fetch(const class_instance<C$PDOStatement> &) noexcept {
+  if (response == nullptr || response->res == nullptr) {
+    return {};
+  }
   MYSQL_RES *mysql_res = response->res;
-  MYSQL_ROW row = LIB_MYSQL_CALL(mysql_fetch_row(mysql_res));
+  MYSQL_ROW row = nullptr;
+  // the row response must outlive the row
+  std::unique_ptr<database_drivers::MysqlResponse> row_response;
+  if (is_buffered) {
+    row = LIB_MYSQL_CALL(mysql_fetch_row(mysql_res));
+  } else if (has_unread_rows) {
+    row_response = fetch_unbuffered_rows(false);
+    if (row_response == nullptr || row_response->is_error) {
+      php_warning("Can't fetch a row of unbuffered MySQL result in PDOStatement::fetch");
+      has_unread_rows = false;
+      return {};
+    }
+    row = row_response->row;
+    has_unread_rows = row != nullptr;
+  }
   if (row == nullptr) {
     return {};
   }
-  array<mixed> res;
-  unsigned int fields_num = LIB_MYSQL_CALL(mysql_num_fields(mysql_res));
+
+  const unsigned int fields_num = LIB_MYSQL_CALL(mysql_num_fields(mysql_res));
+  const unsigned long *lengths = LIB_MYSQL_CALL(mysql_fetch_lengths(mysql_res));
+  array<mixed> res{array_size{fields_num, fields_num, false}};
   for (int i = 0; i < fields_num; ++i) {
     MYSQL_FIELD *cur_field = LIB_MYSQL_CALL(mysql_fetch_field_direct(mysql_res, i));
-    const char *cur_col = row[i];
-    res.set_value(i, string{cur_col});
-    res.set_value(string{cur_field->name}, string{cur_col});
+    mixed value;
+    if (row[i] != nullptr) {
+      value = string{row[i], static_cast<string::size_type>(lengths[i])};
+    }
+    res.set_value(i, value);
+    vk::singleton<ArrayKeysPool>::get().intern(cur_field->name, cur_field->name_length).set_value_to(res, std::move(value));
   }
   return res;
 }
 
 int64_t MysqlPdoEmulatedStatement::affected_rows() noexcept {
-  return response->affected_rows;
+  return response ? response->affected_rows : 0;
+}
+
+bool MysqlPdoEmulatedStatement::close_cursor() noexcept {
+  bool ok = true;
+  if (has_unread_rows) {
+    has_unread_rows = false;
+    auto discard_response = fetch_unbuffered_rows(true);
+    ok = discard_response != nullptr && !discard_response->is_error;
+  }
+  response = nullptr;
+  return ok;
 }
 
 } // namespace pdo::mysql
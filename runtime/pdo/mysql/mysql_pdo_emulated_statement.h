@@ -15,19 +15,42 @@ class MysqlResponse;
 } // namespace database_drivers
 
 namespace pdo::mysql {
+/**
+ * Parameters are substituted into the query text on the client side: strings are quoted and escaped with respect to the connection charset,
+ * floats are written with full precision, integers, booleans and nulls are written as they are. The query is split by placeholders once, on the first execution with parameters.
+ *
+ * Rows of an unbuffered statement (see PDO::MYSQL_ATTR_USE_BUFFERED_QUERY) are read from the connection one by one on fetch(),
+ * so a result set doesn't have to fit into memory. The connection can't be used for other queries until all the rows are read or closeCursor() is called.
+ */
 class MysqlPdoEmulatedStatement : public pdo::AbstractPdoStatement {
 public:
-  MysqlPdoEmulatedStatement(const string &statement, int connector_id);
+  MysqlPdoEmulatedStatement(const string &statement, int connector_id, bool is_buffered = true);
 
   bool execute(const class_instance<C$PDOStatement> &v$this, const Optional<array<mixed>> &params) noexcept final;
   mixed fetch(const class_instance<C$PDOStatement> &v$this) noexcept final;
   int64_t affected_rows() noexcept final;
+  bool close_cursor() noexcept final;
 
 private:
   string statement;
   int connector_id{};
+  bool is_buffered{true};
+
+  // the statement split by placeholders, there is one part more than placeholders
+  array<string> query_parts;
+  // names of placeholders without ':', empty for '?' ones
+  array<string> placeholder_names;
+  // a named placeholder may be used several times, but it's bound once
+  int64_t distinct_placeholders_count{0};
+  bool has_mixed_placeholders{false};
+  bool is_parsed{false};
 
   std::unique_ptr<database_drivers::MysqlResponse> response;
+  bool has_unread_rows{false};
+
+  void parse_placeholders() noexcept;
+  Optional<string> bind_params(const array<mixed> &params) noexcept;
+  std::unique_ptr<database_drivers::MysqlResponse> fetch_unbuffered_rows(bool discard) noexcept;
 
   class ExecuteResumable;
 };
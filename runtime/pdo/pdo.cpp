@@ -31,7 +31,6 @@ class_instance<C$PDO> f$PDO$$__construct(const class_instance<C$PDO> &v$this, co
 }
 
 class_instance<C$PDOStatement> f$PDO$$prepare(const class_instance<C$PDO> &v$this, const string &query, const array<mixed> &options) noexcept {
-  // TODO: prepared statements are not supported so far
   return v$this.get()->driver->prepare(v$this, query, options);
 }
 
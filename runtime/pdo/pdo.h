@@ -17,6 +17,7 @@
 
 struct C$PDO : public refcountable_polymorphic_php_classes<abstract_refcountable_php_interface>, private DummyVisitorMethods {
   static constexpr int ATTR_TIMEOUT = 2;
+  static constexpr int MYSQL_ATTR_USE_BUFFERED_QUERY = 1000;
 
   std::unique_ptr<pdo::AbstractPdoDriver> driver;
   int64_t timeout_sec{-1};
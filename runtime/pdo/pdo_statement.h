@@ -37,3 +37,4 @@ bool f$PDOStatement$$execute(const class_instance<C$PDOStatement> &v$this, const
 
 mixed f$PDOStatement$$fetch(const class_instance<C$PDOStatement> &v$this) noexcept;
 array<mixed> f$PDOStatement$$fetchAll(const class_instance<C$PDOStatement> &v$this) noexcept;
+bool f$PDOStatement$$closeCursor(const class_instance<C$PDOStatement> &v$this) noexcept;
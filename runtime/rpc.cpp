@@ -4,7 +4,10 @@
 
 #include "runtime/rpc.h"
 
+#include <algorithm>
 #include <cstdarg>
+#include <iterator>
+#include <sys/uio.h>
 
 #include "common/rpc-error-codes.h"
 #include "common/rpc-headers.h"
@@ -240,6 +243,26 @@ void f$fetch_raw_vector_double(array<double> &out, int64_t n_elems) {
   rpc_data += rpc_data_buf_offset;
 }
 
+void fetch_raw_vector_int(array<int64_t> &out, int64_t n_elems) {
+  TRY_CALL_VOID(void, (check_rpc_data_len(n_elems)));
+  out.convert_vector(n_elems, rpc_data);
+  rpc_data += n_elems;
+}
+
+void fetch_raw_vector_long(array<int64_t> &out, int64_t n_elems) {
+  int64_t rpc_data_buf_offset = static_cast<int64_t>(sizeof(int64_t) * n_elems / 4);
+  TRY_CALL_VOID(void, (check_rpc_data_len(rpc_data_buf_offset)));
+  out.memcpy_vector(n_elems, rpc_data);
+  rpc_data += rpc_data_buf_offset;
+}
+
+const char *fetch_raw_data(int64_t x4_bytes_length) {
+  TRY_CALL_VOID_(check_rpc_data_len(x4_bytes_length), return nullptr);
+  const char *data = reinterpret_cast<const char *>(rpc_data);
+  rpc_data += x4_bytes_length;
+  return data;
+}
+
 static inline const char *f$fetch_string_raw(int *string_len) {
   TRY_CALL_VOID_(check_rpc_data_len(1), return nullptr);
   const char *str = reinterpret_cast <const char *> (rpc_data);
@@ -267,6 +290,12 @@ string f$fetch_string() {
   return {str, static_cast<string::size_type>(result_len)};
 }
 
+ArrayKeysPool::Key fetch_string_as_array_key() {
+  int result_len = 0;
+  const char *str = TRY_CALL(const char*, ArrayKeysPool::Key, f$fetch_string_raw(&result_len));
+  return vk::singleton<ArrayKeysPool>::get().intern(str, static_cast<string::size_type>(result_len));
+}
+
 int64_t f$fetch_string_as_int() {
   int result_len = 0;
   const char *str = TRY_CALL(const char*, int, f$fetch_string_raw(&result_len));
@@ -401,6 +430,26 @@ void f$store_raw_vector_double(const array<double> &vector) {
                   sizeof(double) * vector.count());
 }
 
+bool store_raw_vector_int(const array<int64_t> &vector) {
+  const int64_t *values = vector.get_const_vector_pointer();
+  const int64_t n = vector.count();
+  if (std::any_of(values, values + n, is_int32_overflow)) {
+    return false;
+  }
+  int32_t chunk[256];
+  for (int64_t i = 0; i < n; i += std::size(chunk)) {
+    const auto chunk_size = std::min(n - i, static_cast<int64_t>(std::size(chunk)));
+    std::transform(values + i, values + i + chunk_size, chunk, [](int64_t v) { return static_cast<int32_t>(v); });
+    data_buf.append(reinterpret_cast<const char *>(chunk), sizeof(int32_t) * chunk_size);
+  }
+  return true;
+}
+
+void store_raw_vector_long(const array<int64_t> &vector) {
+  data_buf.append(reinterpret_cast<const char *>(vector.get_const_vector_pointer()),
+                  sizeof(int64_t) * vector.count());
+}
+
 bool store_header(long long cluster_id, int64_t flags) {
   if (flags) {
     store_int(TL_RPC_DEST_ACTOR_FLAGS);
@@ -546,6 +595,11 @@ bool f$rpc_clean(bool is_error) {
   return true;
 }
 
+vk::string_view rpc_get_stored_data() {
+  php_assert(data_buf.size() >= sizeof(RpcHeaders));
+  return {data_buf.c_str() + sizeof(RpcHeaders), static_cast<size_t>(data_buf.size()) - sizeof(RpcHeaders)};
+}
+
 bool rpc_store(bool is_error) {
   if (rpc_stored) {
     return false;
@@ -676,16 +730,13 @@ int64_t rpc_send(const class_instance<C$RpcConnection> &conn, double timeout, bo
   RpcExtraHeaders extra_headers{};
   size_t extra_headers_size = fill_extra_headers_if_needed(extra_headers, function_magic, conn.get()->default_actor_id, ignore_answer);
 
-  const auto request_size = static_cast<size_t>(data_buf.size() + extra_headers_size);
-  char *p = static_cast<char *>(dl::allocate(request_size));
-
-  // Memory will look like this:
-  //    [ RpcHeaders (reserved in f$rpc_clean) ] [ RpcExtraHeaders (optional) ] [ payload ]
-  memcpy(p, data_buf.c_str(), sizeof(RpcHeaders));
-  memcpy(p + sizeof(RpcHeaders), &extra_headers, extra_headers_size);
-  memcpy(p + sizeof(RpcHeaders) + extra_headers_size, data_buf.c_str() + sizeof(RpcHeaders), data_buf.size() - sizeof(RpcHeaders));
-
-  slot_id_t result = rpc_send_query(conn.get()->host_num, p, static_cast<int>(request_size), timeout_convert_to_ms(timeout));
+  // The request is copied straight into net buffers, the network packet will look like this:
+  //    [ RpcHeaders (reserved in f$rpc_clean, filled on sending) ] [ RpcExtraHeaders (optional) ] [ payload ] [ crc32 (reserved above) ]
+  const iovec request_parts[] = {
+    {&extra_headers, extra_headers_size},
+    {const_cast<char *>(data_buf.c_str() + sizeof(RpcHeaders)), static_cast<size_t>(data_buf.size()) - sizeof(RpcHeaders) - sizeof(int)},
+  };
+  slot_id_t result = rpc_send_query(conn.get()->host_num, request_parts, static_cast<int>(std::size(request_parts)), timeout_convert_to_ms(timeout));
   if (result <= 0) {
     return -1;
   }
@@ -7,6 +7,8 @@
 #include <memory>
 
 #include "common/algorithms/hashes.h"
+#include "common/wrappers/string_view.h"
+#include "runtime/array-keys-pool.h"
 #include "runtime/dummy-visitor-methods.h"
 #include "runtime/kphp_core.h"
 #include "runtime/resumable.h"
@@ -72,6 +74,9 @@ string f$fetch_string();
 
 int64_t f$fetch_string_as_int();
 
+// fetches a string to be used as an array key (of a dictionary), short keys are interned
+ArrayKeysPool::Key fetch_string_as_array_key();
+
 mixed f$fetch_memcache_value();
 
 bool f$fetch_eof();
@@ -80,6 +85,13 @@ bool f$fetch_end();
 
 void f$fetch_raw_vector_double(array<double> &out, int64_t n_elems);
 
+// vectors of TL ints and longs, the data length is checked once for all the elements
+void fetch_raw_vector_int(array<int64_t> &out, int64_t n_elems);
+void fetch_raw_vector_long(array<int64_t> &out, int64_t n_elems);
+
+// returns the next x4_bytes_length * 4 bytes of the rpc data and skips them, or nullptr with a thrown exception
+const char *fetch_raw_data(int64_t x4_bytes_length);
+
 void estimate_and_flush_overflow(size_t &bytes_sent);
 
 struct tl_func_base;
@@ -143,6 +155,10 @@ bool f$store_raw(const string &data);
 
 void f$store_raw_vector_double(const array<double> &vector);
 
+// returns false and stores nothing if some value doesn't fit int32, so that the caller can report it per element
+bool store_raw_vector_int(const array<int64_t> &vector);
+void store_raw_vector_long(const array<int64_t> &vector);
+
 bool f$set_fail_rpc_on_int32_overflow(bool fail_rpc); // TODO: remove when all RPC errors will be fixed
 
 bool is_int32_overflow(int64_t v);
@@ -173,6 +189,9 @@ bool f$store_finish();
 
 bool f$rpc_clean(bool is_error = false);
 
+// the data stored after f$rpc_clean(), without the reserved headers
+vk::string_view rpc_get_stored_data();
+
 bool rpc_store(bool is_error = false);
 
 int64_t f$rpc_send(const class_instance<C$RpcConnection> &conn, double timeout = -1.0);
@@ -41,6 +41,7 @@ prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
         ${KPHP_RUNTIME_PDO_SOURCES}
         ${KPHP_RUNTIME_PDO_MYSQL_SOURCES}
         allocator.cpp
+        array-keys-pool.cpp
         array_functions.cpp
         bcmath.cpp
         common_template_instantiations.cpp
@@ -54,6 +55,7 @@ prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
         files.cpp
         from-json-processor.cpp
         instance-cache.cpp
+        instance-cache-snapshot.cpp
         instance-copy-processor.cpp
         inter-process-mutex.cpp
         interface.cpp
@@ -84,6 +86,7 @@ prepend(KPHP_RUNTIME_SOURCES ${BASE_DIR}/runtime/
         string_buffer.cpp
         string_cache.cpp
         string_functions.cpp
+        strtr-matcher.cpp
         timelib_wrapper.cpp
         tl/rpc_tl_query.cpp
         tl/rpc_response.cpp
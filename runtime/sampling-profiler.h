@@ -0,0 +1,25 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstdint>
+
+// codegen emits such a symbol for every php function compiled to a separate native one (not inline, not resumable);
+// the linker collects them in a separate section, and the sampling profiler maps native stacks to php functions with them
+// (see server/php-sampling-profiler.h)
+struct PhpFunctionSymbol {
+  const void *address;
+  const char *function_name;
+  const char *file_name;
+  int64_t line;
+};
+
+static_assert(sizeof(PhpFunctionSymbol) == 32, "symbols must be laid out in the section without gaps");
+
+#ifdef __linux__
+#define PHP_FUNCTION_SYMBOL __attribute__((section("kphp_php_function_symbols"), used))
+#else
+#define PHP_FUNCTION_SYMBOL __attribute__((unused))
+#endif
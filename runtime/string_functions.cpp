@@ -12,6 +12,7 @@
 #include "common/unicode/unicode-utils.h"
 
 #include "runtime/interface.h"
+#include "runtime/strtr-matcher.h"
 
 const string COLON(",", 1);
 const string CP1251("1251", 4);
@@ -2117,6 +2118,27 @@ string f$str_repeat(const string &s, int64_t multiplier) {
   return result;
 }
 
+string strtr_by_matcher(const string &subject, const array<string> &from, const array<string> &to) noexcept {
+  const StrtrMatcher &matcher = get_strtr_matcher(from);
+  const char *piece = subject.c_str(), *piece_end = subject.c_str() + subject.size();
+  const char *pos = piece;
+  int64_t pattern_id = matcher.find(pos, piece_end);
+  if (pattern_id == -1) {
+    return subject;
+  }
+
+  string result;
+  do {
+    result.append(piece, static_cast<string::size_type>(pos - piece));
+    result.append(to.get_value(pattern_id));
+    piece = pos + matcher.pattern_size(pattern_id);
+    pos = piece;
+    pattern_id = matcher.find(pos, piece_end);
+  } while (pattern_id != -1);
+  result.append(piece, static_cast<string::size_type>(piece_end - piece));
+  return result;
+}
+
 static string str_replace_char(char c, const string &replace, const string &subject, int64_t &replace_count, bool with_case) {
   int count = 0;
   const char *piece = subject.c_str();
@@ -370,8 +370,24 @@ Optional<string> f$strstr(const string &haystack, const mixed &needle, bool befo
   }
 }
 
+string strtr_by_matcher(const string &subject, const array<string> &from, const array<string> &to) noexcept;
+
 template<class T>
 string f$strtr(const string &subject, const array<T> &replace_pairs) {
+  if (replace_pairs.count() > 1) {
+    array<string> from{array_size(replace_pairs.count(), 0, true)};
+    array<string> to{array_size(replace_pairs.count(), 0, true)};
+    for (const auto &it : replace_pairs) {
+      string search = f$strval(it.get_key());
+      if (search.empty()) {
+        return subject;
+      }
+      from.push_back(std::move(search));
+      to.push_back(f$strval(it.get_value()));
+    }
+    return strtr_by_matcher(subject, from, to);
+  }
+
   const char *piece = subject.c_str(), *piece_end = subject.c_str() + subject.size();
   string result;
   while (1) {
@@ -0,0 +1,144 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "runtime/strtr-matcher.h"
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "common/algorithms/hashes.h"
+#include "common/smart_ptrs/singleton.h"
+#include "common/wrappers/string_view.h"
+
+#include "runtime/critical_section.h"
+
+namespace {
+
+// a protection against scripts that pass new patterns each time
+constexpr size_t MAX_CACHED_MATCHERS = 256;
+
+size_t hash_patterns(const array<string> &patterns) noexcept {
+  size_t hash = static_cast<size_t>(patterns.count());
+  for (const auto &it : patterns) {
+    const string &pattern = it.get_value();
+    vk::hash_combine(hash, vk::std_hash(vk::string_view{pattern.c_str(), pattern.size()}));
+  }
+  return hash;
+}
+
+class StrtrMatchersCache : vk::not_copyable {
+public:
+  const StrtrMatcher &get(const array<string> &patterns) noexcept {
+    const size_t hash = hash_patterns(patterns);
+    auto it = matchers_.find(hash);
+    if (it != matchers_.end() && it->second->has_same_patterns(patterns)) {
+      return *it->second;
+    }
+
+    dl::CriticalSectionGuard critical_section;
+    if (matchers_.size() >= MAX_CACHED_MATCHERS) {
+      matchers_.clear();
+    }
+    auto &matcher = matchers_[hash];
+    matcher = std::make_unique<StrtrMatcher>(patterns);
+    return *matcher;
+  }
+
+private:
+  StrtrMatchersCache() = default;
+
+  std::unordered_map<size_t, std::unique_ptr<StrtrMatcher>> matchers_;
+
+  friend class vk::singleton<StrtrMatchersCache>;
+};
+
+} // namespace
+
+StrtrMatcher::StrtrMatcher(const array<string> &patterns) noexcept {
+  // a pointer based trie is built first, then it's flattened to arrays with sorted edges
+  std::vector<std::map<unsigned char, int32_t>> children(1);
+  std::vector<int32_t> pattern_ids(1, -1);
+  for (const auto &it : patterns) {
+    const string &pattern = it.get_value();
+    int32_t node = 0;
+    for (string::size_type i = 0; i < pattern.size(); ++i) {
+      const auto c = static_cast<unsigned char>(pattern[i]);
+      auto child = children[node].find(c);
+      if (child == children[node].end()) {
+        child = children[node].emplace(c, static_cast<int32_t>(children.size())).first;
+        children.emplace_back();
+        pattern_ids.emplace_back(-1);
+      }
+      node = child->second;
+    }
+    if (pattern_ids[node] == -1) {
+      pattern_ids[node] = static_cast<int32_t>(patterns_.size());
+    }
+    patterns_.emplace_back(pattern.c_str(), pattern.size());
+  }
+
+  root_children_.fill(-1);
+  for (const auto &c_and_child : children[0]) {
+    root_children_[c_and_child.first] = c_and_child.second;
+  }
+  nodes_.resize(children.size());
+  for (size_t node = 0; node < children.size(); ++node) {
+    nodes_[node].pattern_id = pattern_ids[node];
+    nodes_[node].edges_begin = static_cast<uint32_t>(edges_.size());
+    for (const auto &c_and_child : children[node]) {
+      edges_.emplace_back(Edge{c_and_child.first, c_and_child.second});
+    }
+    nodes_[node].edges_end = static_cast<uint32_t>(edges_.size());
+  }
+}
+
+bool StrtrMatcher::has_same_patterns(const array<string> &patterns) const noexcept {
+  if (patterns.count() != patterns_.size()) {
+    return false;
+  }
+  size_t i = 0;
+  for (const auto &it : patterns) {
+    const string &pattern = it.get_value();
+    if (vk::string_view{pattern.c_str(), pattern.size()} != vk::string_view{patterns_[i++]}) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int32_t StrtrMatcher::next(int32_t node, unsigned char c) const noexcept {
+  // fan-out of inner nodes is small, a linear scan is faster than a binary search there
+  const Node &n = nodes_[node];
+  for (uint32_t i = n.edges_begin; i != n.edges_end; ++i) {
+    if (edges_[i].c == c) {
+      return edges_[i].to;
+    }
+  }
+  return -1;
+}
+
+int64_t StrtrMatcher::find(const char *&pos, const char *end) const noexcept {
+  for (; pos != end; ++pos) {
+    int32_t node = root_children_[static_cast<unsigned char>(*pos)];
+    int64_t longest = -1;
+    for (const char *p = pos + 1; node != -1; ++p) {
+      if (nodes_[node].pattern_id != -1) {
+        longest = nodes_[node].pattern_id;
+      }
+      if (p == end) {
+        break;
+      }
+      node = next(node, static_cast<unsigned char>(*p));
+    }
+    if (longest != -1) {
+      return longest;
+    }
+  }
+  return -1;
+}
+
+const StrtrMatcher &get_strtr_matcher(const array<string> &patterns) noexcept {
+  return vk::singleton<StrtrMatchersCache>::get().get(patterns);
+}
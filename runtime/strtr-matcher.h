@@ -0,0 +1,55 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+
+#include "runtime/kphp_core.h"
+
+// A trie of strtr() patterns: instead of searching each pattern in the subject after every replacement,
+// the subject is scanned once, and at each position the longest pattern starting there is found by walking the trie.
+// Positions that can't start any pattern are skipped by a table of root transitions.
+// Matchers live in the heap and are cached by the set of patterns (see get_strtr_matcher()),
+// so the same replacement pairs used in every request (typically constant arrays) are compiled once per worker.
+class StrtrMatcher : vk::not_copyable {
+public:
+  explicit StrtrMatcher(const array<string> &patterns) noexcept;
+
+  bool has_same_patterns(const array<string> &patterns) const noexcept;
+
+  // finds the leftmost position in [pos, end) where some pattern starts and returns the longest pattern there,
+  // pos is moved to that position; returns -1 if there are no more patterns
+  int64_t find(const char *&pos, const char *end) const noexcept;
+
+  size_t pattern_size(int64_t pattern_id) const noexcept {
+    return patterns_[pattern_id].size();
+  }
+
+private:
+  struct Edge {
+    unsigned char c;
+    int32_t to;
+  };
+
+  struct Node {
+    uint32_t edges_begin{0};
+    uint32_t edges_end{0};
+    int32_t pattern_id{-1};
+  };
+
+  int32_t next(int32_t node, unsigned char c) const noexcept;
+
+  std::array<int32_t, 256> root_children_;
+  std::vector<Node> nodes_;
+  std::vector<Edge> edges_;
+  std::vector<std::string> patterns_;
+};
+
+// patterns must be not empty; the matcher is valid until the next call
+const StrtrMatcher &get_strtr_matcher(const array<string> &patterns) noexcept;
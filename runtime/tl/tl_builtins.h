@@ -75,26 +75,6 @@ inline void fetch_magic_if_not_bare(unsigned int inner_magic, const char *error_
   }
 }
 
-template<class T>
-inline void fetch_raw_vector_T(array<T> &out __attribute__ ((unused)), int64_t n_elems __attribute__ ((unused))) {
-  php_assert(0 && "never called in runtime");
-}
-
-template<>
-inline void fetch_raw_vector_T<double>(array<double> &out, int64_t n_elems) {
-  f$fetch_raw_vector_double(out, n_elems);
-}
-
-template<class T>
-inline void store_raw_vector_T(const array<T> &v __attribute__ ((unused))) {
-  php_assert(0 && "never called in runtime");
-}
-
-template<>
-inline void store_raw_vector_T<double>(const array<double> &v) {
-  f$store_raw_vector_double(v);
-}
-
 // Wrap into Optional that TL types which PhpType is:
 //  1. int, double, string, bool
 //  2. array<T>
@@ -240,6 +220,63 @@ struct t_Float {
   }
 };
 
+// Bare vectors of these types are fetched and stored in bulk, the data length is checked once for all the elements
+template<typename T>
+struct is_raw_vector_tl_type : vk::is_type_in_list<T, t_Int, t_Long, t_Double> {
+};
+
+// the type of a value in the rpc data
+template<typename T>
+using raw_tl_type_t = std::conditional_t<std::is_same<T, t_Int>{}, int32_t, typename T::PhpType>;
+
+template<typename T>
+inline void fetch_raw_vector_T(array<typename T::PhpType> &out, int64_t n_elems) {
+  static_assert(is_raw_vector_tl_type<T>{}, "unexpected raw vector type");
+  if constexpr (std::is_same<T, t_Int>{}) {
+    fetch_raw_vector_int(out, n_elems);
+  } else if constexpr (std::is_same<T, t_Long>{}) {
+    fetch_raw_vector_long(out, n_elems);
+  } else {
+    f$fetch_raw_vector_double(out, n_elems);
+  }
+}
+
+// returns false if nothing has been stored, then elements are to be stored one by one
+template<typename T>
+inline bool store_raw_vector_T(const array<typename T::PhpType> &v) {
+  static_assert(is_raw_vector_tl_type<T>{}, "unexpected raw vector type");
+  if constexpr (std::is_same<T, t_Int>{}) {
+    return store_raw_vector_int(v);
+  } else if constexpr (std::is_same<T, t_Long>{}) {
+    store_raw_vector_long(v);
+  } else {
+    f$store_raw_vector_double(v);
+  }
+  return true;
+}
+
+// keys and values of int keyed dictionaries of primitive types follow each other without magics, so they are read at once
+template<typename KeyT, typename ValueT>
+inline void fetch_raw_dictionary_T(array<typename ValueT::PhpType> &out, int32_t n) {
+  using RawKeyT = raw_tl_type_t<KeyT>;
+  using RawValueT = raw_tl_type_t<ValueT>;
+  constexpr int64_t pair_size = sizeof(RawKeyT) + sizeof(RawValueT);
+  static_assert(pair_size % 4 == 0, "rpc data is aligned by 4 bytes");
+
+  const char *data = fetch_raw_data(n * pair_size / 4);
+  if (!data) {
+    return;
+  }
+  out.reserve(n, 0, false);
+  for (int32_t i = 0; i < n; ++i, data += pair_size) {
+    RawKeyT key;
+    RawValueT value;
+    memcpy(&key, data, sizeof(key));
+    memcpy(&value, data + sizeof(key), sizeof(value));
+    out.set_value(int64_t{key}, typename ValueT::PhpType{value});
+  }
+}
+
 struct t_String {
   void store(const mixed &tl_object) {
     f$store_string(f$strval(tl_object));
@@ -365,9 +402,10 @@ struct t_Vector {
     int64_t n = v.count();
     f$store_int(n);
 
-    if (std::is_same<T, t_Double>{} && inner_magic == 0 && v.is_vector()) {
-      store_raw_vector_T<typename T::PhpType>(v);
-      return;
+    if constexpr (is_raw_vector_tl_type<T>{} && inner_magic == 0) {
+      if (v.is_vector() && store_raw_vector_T<T>(v)) {
+        return;
+      }
     }
 
     for (int64_t i = 0; i < n; ++i) {
@@ -389,8 +427,8 @@ struct t_Vector {
     }
     out.reserve(n, 0, true);
 
-    if (std::is_same<T, t_Double>{} && inner_magic == 0) {
-      fetch_raw_vector_T<typename T::PhpType>(out, n);
+    if constexpr (is_raw_vector_tl_type<T>{} && inner_magic == 0) {
+      fetch_raw_vector_T<T>(out, n);
       return;
     }
 
@@ -515,11 +553,11 @@ struct tl_Dictionary_impl {
       return result;
     }
     for (int32_t i = 0; i < n; ++i) {
-      const auto &key = KeyT().fetch();
+      const auto &key = fetch_key();
       fetch_magic_if_not_bare(inner_value_magic, "Incorrect magic of inner type of some Dictionary");
       const mixed &value = value_state.fetch();
       CHECK_EXCEPTION(return result);
-      result.set_value(key, value);
+      set_value(result, key, value);
     }
     return result;
   }
@@ -547,16 +585,42 @@ struct tl_Dictionary_impl {
       CurrentProcessingQuery::get().raise_fetching_error("Dictionary size is negative");
       return;
     }
+    if constexpr (!std::is_same<KeyT, t_String>{} && is_raw_vector_tl_type<ValueT>{} && inner_value_magic == 0) {
+      fetch_raw_dictionary_T<KeyT, ValueT>(out, n);
+      return;
+    }
     for (int32_t i = 0; i < n; ++i) {
-      typename KeyT::PhpType key;
-      KeyT().typed_fetch_to(key);
+      const auto &key = fetch_key();
       fetch_magic_if_not_bare(inner_value_magic, "Incorrect magic of inner type of some Dictionary");
       typename ValueT::PhpType elem;
       value_state.typed_fetch_to(elem);
-      out.set_value(key, std::move(elem));
+      set_value(out, key, std::move(elem));
       CHECK_EXCEPTION(return);
     }
   }
+
+private:
+  // string keys of dictionaries are interned, as the same keys come in response after response
+  static auto fetch_key() {
+    if constexpr (std::is_same<KeyT, t_String>{}) {
+      CHECK_EXCEPTION(return ArrayKeysPool::Key{});
+      return fetch_string_as_array_key();
+    } else {
+      typename KeyT::PhpType key{};
+      KeyT().typed_fetch_to(key);
+      return key;
+    }
+  }
+
+  template<class T, class V>
+  static void set_value(array<T> &arr, const ArrayKeysPool::Key &key, V &&value) noexcept {
+    key.set_value_to(arr, std::forward<V>(value));
+  }
+
+  template<class T, class V>
+  static void set_value(array<T> &arr, int64_t key, V &&value) noexcept {
+    arr.set_value(key, std::forward<V>(value));
+  }
 };
 
 template<typename T, unsigned int inner_magic>
@@ -606,9 +670,10 @@ struct t_Tuple {
   using PhpType = array<typename T::PhpType>;
 
   void typed_store(const PhpType &v) {
-    if (std::is_same<T, t_Double>{} && inner_magic == 0 && v.is_vector() && v.count() == size) {
-      store_raw_vector_T<typename T::PhpType>(v);
-      return;
+    if constexpr (is_raw_vector_tl_type<T>{} && inner_magic == 0) {
+      if (v.is_vector() && v.count() == size && store_raw_vector_T<T>(v)) {
+        return;
+      }
     }
 
     for (int64_t i = 0; i < size; ++i) {
@@ -625,8 +690,8 @@ struct t_Tuple {
     CHECK_EXCEPTION(return);
     out.reserve(size, 0, true);
 
-    if (std::is_same<T, t_Double>{} && inner_magic == 0) {
-      fetch_raw_vector_T<typename T::PhpType>(out, size);
+    if constexpr (is_raw_vector_tl_type<T>{} && inner_magic == 0) {
+      fetch_raw_vector_T<T>(out, size);
       return;
     }
 
@@ -679,9 +744,10 @@ struct tl_array {
   using PhpType = array<typename T::PhpType>;
 
   void typed_store(const PhpType &v) {
-    if (std::is_same<T, t_Double>{} && inner_magic == 0 && v.is_vector() && v.count() == size) {
-      store_raw_vector_T<typename T::PhpType>(v);
-      return;
+    if constexpr (is_raw_vector_tl_type<T>{} && inner_magic == 0) {
+      if (v.is_vector() && v.count() == size && store_raw_vector_T<T>(v)) {
+        return;
+      }
     }
 
     for (int64_t i = 0; i < size; ++i) {
@@ -698,8 +764,8 @@ struct tl_array {
     CHECK_EXCEPTION(return);
     out.reserve(size, 0, true);
 
-    if (std::is_same<T, t_Double>{} && inner_magic == 0) {
-      fetch_raw_vector_T<typename T::PhpType>(out, size);
+    if constexpr (is_raw_vector_tl_type<T>{} && inner_magic == 0) {
+      fetch_raw_vector_T<T>(out, size);
       return;
     }
 
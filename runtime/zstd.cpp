@@ -6,8 +6,17 @@
 
 #include <zstd.h>
 
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "common/algorithms/hashes.h"
+#include "common/mixin/not_copyable.h"
+#include "common/smart_ptrs/singleton.h"
 #include "common/smart_ptrs/unique_ptr_with_delete_function.h"
+#include "common/wrappers/string_view.h"
 
+#include "runtime/critical_section.h"
 #include "runtime/string_functions.h"
 
 #include "runtime/zstd.h"
@@ -16,46 +25,176 @@ namespace {
 
 static_assert(2 * ZSTD_BLOCKSIZE_MAX < PHP_BUF_LEN, "double block size is expected to be less then buffer size");
 
-ZSTD_customMem make_custom_alloc() noexcept {
-  return ZSTD_customMem{
-    [](void *, size_t size) { return dl::script_allocator_malloc(size); },
-    [](void *, void *address) { dl::script_allocator_free(address); },
-    nullptr
-  };
-}
-
 template<class T, size_t (*Deleter)(T *)>
 void free_ctx_wrapper(T *ptr) { Deleter(ptr); }
 
 using ZSTD_CCtxPtr = vk::unique_ptr_with_delete_function<ZSTD_CStream, free_ctx_wrapper<ZSTD_CCtx, ZSTD_freeCCtx>>;
 using ZSTD_DCtxPtr = vk::unique_ptr_with_delete_function<ZSTD_DCtx, free_ctx_wrapper<ZSTD_DCtx, ZSTD_freeDCtx>>;
+using ZSTD_CDictPtr = vk::unique_ptr_with_delete_function<ZSTD_CDict, free_ctx_wrapper<ZSTD_CDict, ZSTD_freeCDict>>;
+using ZSTD_DDictPtr = vk::unique_ptr_with_delete_function<ZSTD_DDict, free_ctx_wrapper<ZSTD_DDict, ZSTD_freeDDict>>;
 
-Optional<string> zstd_compress_impl(const string &data, int64_t level = DEFAULT_COMPRESS_LEVEL, const string &dict = string{}) noexcept {
-  ZSTD_CCtxPtr ctx{ZSTD_createCCtx_advanced(make_custom_alloc())};
-  if (!ctx) {
-    php_warning("zstd_compress: can not create context");
-    return false;
+// Digesting a dictionary is much more expensive than compressing a small value with it,
+// so digested dictionaries and contexts for them live in the heap of a worker and are reused by all requests.
+// Dictionaries passed to zstd_*_dict() are cached by their content, named ones are registered by zstd_register_dict().
+// All heap allocations (including ones inside zstd while it works with the contexts) are done in a critical section.
+class ZstdCache : vk::not_copyable {
+public:
+  // a context keeps its workspace, that depends on the level and the data; too big ones are not kept between calls
+  void release_cctx_if_too_big() noexcept {
+    if (ZSTD_sizeof_CCtx(cctx_.get()) > MAX_KEPT_CONTEXT_SIZE) {
+      cctx_.reset();
+    }
   }
 
-  size_t result = ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_compressionLevel, static_cast<int>(level));
-  if (ZSTD_isError(result)) {
-    php_warning("zstd_compress: can not init context: %s", ZSTD_getErrorName(result));
-    return false;
+  ZSTD_CCtx *get_cctx() noexcept {
+    if (!cctx_) {
+      cctx_.reset(ZSTD_createCCtx());
+    }
+    return cctx_.get();
   }
 
-  result = ZSTD_CCtx_loadDictionary_byReference(ctx.get(), dict.c_str(), dict.size());
-  if (ZSTD_isError(result)) {
-    php_warning("zstd_compress: can not load dict: %s", ZSTD_getErrorName(result));
-    return false;
+  ZSTD_DCtx *get_dctx() noexcept {
+    if (!dctx_) {
+      dctx_.reset(ZSTD_createDCtx());
+    }
+    return dctx_.get();
+  }
+
+  const ZSTD_CDict *get_cdict(vk::string_view dict, int level) noexcept {
+    if (cdicts_.size() >= MAX_CACHED_DICTS) {
+      cdicts_.clear();
+    }
+    auto &cached = cdicts_[DictKey{dict, level}];
+    if (!cached.digested || !cached.holds(dict)) {
+      cached.digested.reset();
+      cached.dict.assign(dict.data(), dict.size());
+      cached.digested.reset(ZSTD_createCDict_byReference(cached.dict.data(), cached.dict.size(), level));
+    }
+    return cached.digested.get();
+  }
+
+  const ZSTD_DDict *get_ddict(vk::string_view dict) noexcept {
+    if (ddicts_.size() >= MAX_CACHED_DICTS) {
+      ddicts_.clear();
+    }
+    auto &cached = ddicts_[DictKey{dict, 0}];
+    if (!cached.digested || !cached.holds(dict)) {
+      cached.digested.reset();
+      cached.dict.assign(dict.data(), dict.size());
+      cached.digested.reset(ZSTD_createDDict_byReference(cached.dict.data(), cached.dict.size()));
+    }
+    return cached.digested.get();
+  }
+
+  bool register_dict(vk::string_view name, vk::string_view dict, int level) noexcept {
+    NamedDict &named = named_dicts_[std::string{name.data(), name.size()}];
+    if (named.cdict && named.level == level && named.dict.size() == dict.size() && !memcmp(named.dict.data(), dict.data(), dict.size())) {
+      return true;
+    }
+    named.level = level;
+    named.cdict.reset(ZSTD_createCDict(dict.data(), dict.size(), level));
+    named.ddict.reset(ZSTD_createDDict(dict.data(), dict.size()));
+    if (!named.cdict || !named.ddict) {
+      named_dicts_.erase(std::string{name.data(), name.size()});
+      return false;
+    }
+    named.dict.assign(dict.data(), dict.size());
+    return true;
   }
 
+  const ZSTD_CDict *get_named_cdict(vk::string_view name) const noexcept {
+    const auto *named = find_named_dict(name);
+    return named ? named->cdict.get() : nullptr;
+  }
+
+  const ZSTD_DDict *get_named_ddict(vk::string_view name) const noexcept {
+    const auto *named = find_named_dict(name);
+    return named ? named->ddict.get() : nullptr;
+  }
+
+private:
+  // a protection against scripts that pass a new dictionary each time
+  static constexpr size_t MAX_CACHED_DICTS = 64;
+  static constexpr size_t MAX_KEPT_CONTEXT_SIZE = 16 * 1024 * 1024;
+
+  ZstdCache() = default;
+
+  // dictionaries are looked up by the hash of their content: equal ones passed by different strings share the digested one
+  struct DictKey {
+    size_t hash{0};
+    size_t size{0};
+    int level{0};
+
+    DictKey(vk::string_view dict, int level) noexcept :
+      hash(vk::std_hash(dict)),
+      size(dict.size()),
+      level(level) {}
+
+    bool operator==(const DictKey &other) const noexcept {
+      return hash == other.hash && size == other.size && level == other.level;
+    }
+  };
+
+  struct DictKeyHash {
+    size_t operator()(const DictKey &key) const noexcept {
+      return vk::hash_sequence(key.hash, key.size, key.level);
+    }
+  };
+
+  // the digested dictionary refers to the kept copy of the content, which is also compared on lookups:
+  // a dictionary with a colliding key replaces the cached one instead of being silently mixed up with it
+  template<class DigestedPtr>
+  struct CachedDict {
+    std::string dict;
+    DigestedPtr digested;
+
+    bool holds(vk::string_view other) const noexcept {
+      return dict.size() == other.size() && !memcmp(dict.data(), other.data(), other.size());
+    }
+  };
+
+  struct NamedDict {
+    std::string dict;
+    int level{0};
+    ZSTD_CDictPtr cdict;
+    ZSTD_DDictPtr ddict;
+  };
+
+  const NamedDict *find_named_dict(vk::string_view name) const noexcept {
+    auto it = named_dicts_.find(std::string{name.data(), name.size()});
+    return it != named_dicts_.end() ? &it->second : nullptr;
+  }
+
+  ZSTD_CCtxPtr cctx_;
+  ZSTD_DCtxPtr dctx_;
+  std::unordered_map<DictKey, CachedDict<ZSTD_CDictPtr>, DictKeyHash> cdicts_;
+  std::unordered_map<DictKey, CachedDict<ZSTD_DDictPtr>, DictKeyHash> ddicts_;
+  std::unordered_map<std::string, NamedDict> named_dicts_;
+
+  friend class vk::singleton<ZstdCache>;
+};
+
+vk::string_view as_string_view(const string &s) noexcept {
+  return {s.c_str(), s.size()};
+}
+
+ZSTD_customMem make_custom_alloc() noexcept {
+  return ZSTD_customMem{
+    [](void *, size_t size) { return dl::script_allocator_malloc(size); },
+    [](void *, void *address) { dl::script_allocator_free(address); },
+    nullptr
+  };
+}
+
+Optional<string> zstd_compress_stream(ZSTD_CCtx *ctx, const string &data) noexcept {
   php_assert(ZSTD_CStreamOutSize() <= PHP_BUF_LEN);
   ZSTD_outBuffer out{php_buf, PHP_BUF_LEN, 0};
   ZSTD_inBuffer in{data.c_str(), data.size(), 0};
 
   string encoded_string;
+  size_t result = 0;
   do {
-    result = ZSTD_compressStream2(ctx.get(), &out, &in, ZSTD_e_end);
+    result = ZSTD_compressStream2(ctx, &out, &in, ZSTD_e_end);
     if (ZSTD_isError(result)) {
       php_warning("zstd_compress: got zstd stream compression error: %s", ZSTD_getErrorName(result));
       return false;
@@ -66,22 +205,47 @@ Optional<string> zstd_compress_impl(const string &data, int64_t level = DEFAULT_
   return encoded_string;
 }
 
-Optional<string> zstd_uncompress_impl(const string &data, const string &dict = string{}) noexcept {
-  auto size = ZSTD_getFrameContentSize(data.c_str(), data.size());
-  if (size == ZSTD_CONTENTSIZE_ERROR) {
-    php_warning("zstd_uncompress: it was not compressed by zstd");
+// without a dictionary, a context is allocated in the script memory: its size depends on the level and the data
+Optional<string> zstd_compress_impl(const string &data, int64_t level) noexcept {
+  ZSTD_CCtxPtr ctx{ZSTD_createCCtx_advanced(make_custom_alloc())};
+  if (!ctx) {
+    php_warning("zstd_compress: can not create context");
     return false;
   }
 
-  ZSTD_DCtxPtr ctx{ZSTD_createDCtx_advanced(make_custom_alloc())};
+  size_t result = ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_compressionLevel, static_cast<int>(level));
+  if (ZSTD_isError(result)) {
+    php_warning("zstd_compress: can not init context: %s", ZSTD_getErrorName(result));
+    return false;
+  }
+  return zstd_compress_stream(ctx.get(), data);
+}
+
+Optional<string> zstd_compress_with_cdict(const string &data, const ZSTD_CDict *cdict) noexcept {
+  dl::CriticalSectionGuard critical_section;
+  auto &cache = vk::singleton<ZstdCache>::get();
+  ZSTD_CCtx *ctx = cache.get_cctx();
   if (!ctx) {
-    php_warning("zstd_uncompress: can not create context");
+    php_warning("zstd_compress: can not create context");
     return false;
   }
 
-  size_t result = ZSTD_DCtx_loadDictionary_byReference(ctx.get(), dict.c_str(), dict.size());
+  // the level of a digested dictionary is used
+  ZSTD_CCtx_reset(ctx, ZSTD_reset_session_and_parameters);
+  const size_t result = ZSTD_CCtx_refCDict(ctx, cdict);
   if (ZSTD_isError(result)) {
-    php_warning("zstd_uncompress: can not load dict: %s", ZSTD_getErrorName(result));
+    php_warning("zstd_compress: can not load dict: %s", ZSTD_getErrorName(result));
+    return false;
+  }
+  auto encoded_string = zstd_compress_stream(ctx, data);
+  cache.release_cctx_if_too_big();
+  return encoded_string;
+}
+
+Optional<string> zstd_uncompress_impl(const string &data, const ZSTD_DDict *ddict = nullptr) noexcept {
+  auto size = ZSTD_getFrameContentSize(data.c_str(), data.size());
+  if (size == ZSTD_CONTENTSIZE_ERROR) {
+    php_warning("zstd_uncompress: it was not compressed by zstd");
     return false;
   }
 
@@ -90,8 +254,24 @@ Optional<string> zstd_uncompress_impl(const string &data, const string &dict = s
       php_warning("zstd_uncompress: trying to uncompress too large data");
       return false;
     }
+
+    // the whole frame is decompressed at once directly to the result, a context is small and reused
+    dl::CriticalSectionGuard critical_section;
+    auto &cache = vk::singleton<ZstdCache>::get();
+    ZSTD_DCtx *ctx = cache.get_dctx();
+    if (!ctx) {
+      php_warning("zstd_uncompress: can not create context");
+      return false;
+    }
+    ZSTD_DCtx_reset(ctx, ZSTD_reset_session_and_parameters);
+    size_t result = ZSTD_DCtx_refDDict(ctx, ddict);
+    if (ZSTD_isError(result)) {
+      php_warning("zstd_uncompress: can not load dict: %s", ZSTD_getErrorName(result));
+      return false;
+    }
+
     string decompressed{static_cast<string::size_type>(size), false};
-    result = ZSTD_decompressDCtx(ctx.get(), decompressed.buffer(), size, data.c_str(), data.size());
+    result = ZSTD_decompressDCtx(ctx, decompressed.buffer(), size, data.c_str(), data.size());
     if (ZSTD_isError(result)) {
       php_warning("zstd_uncompress: got zstd error: %s", ZSTD_getErrorName(result));
       return false;
@@ -99,8 +279,16 @@ Optional<string> zstd_uncompress_impl(const string &data, const string &dict = s
     return decompressed;
   }
 
+  // streaming needs a window buffer of a size chosen by the compressor, it's allocated in the script memory
+  ZSTD_DCtxPtr ctx{ZSTD_createDCtx_advanced(make_custom_alloc())};
+  if (!ctx) {
+    php_warning("zstd_uncompress: can not create context");
+    return false;
+  }
+
+  size_t result = ZSTD_DCtx_refDDict(ctx.get(), ddict);
   if (ZSTD_isError(result)) {
-    php_warning("zstd_uncompress: can not init stream: %s", ZSTD_getErrorName(result));
+    php_warning("zstd_uncompress: can not load dict: %s", ZSTD_getErrorName(result));
     return false;
   }
 
@@ -128,13 +316,20 @@ Optional<string> zstd_uncompress_impl(const string &data, const string &dict = s
   return decoded_string;
 }
 
-} // namespace
-
-Optional<string> f$zstd_compress(const string &data, int64_t level) noexcept {
+bool check_compress_level(const char *function_name, int64_t level) noexcept {
   const int min_level = ZSTD_minCLevel();
   const int max_level = ZSTD_maxCLevel();
   if (min_level > level || level > max_level) {
-    php_warning("zstd_compress: compression level (%" PRIi64 ") must be within %d..%d or equal to 0", level, min_level, max_level);
+    php_warning("%s: compression level (%" PRIi64 ") must be within %d..%d or equal to 0", function_name, level, min_level, max_level);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+Optional<string> f$zstd_compress(const string &data, int64_t level) noexcept {
+  if (!check_compress_level("zstd_compress", level)) {
     return false;
   }
 
@@ -146,9 +341,71 @@ Optional<string> f$zstd_uncompress(const string &data) noexcept {
 }
 
 Optional<string> f$zstd_compress_dict(const string &data, const string &dict) noexcept {
-  return zstd_compress_impl(data, DEFAULT_COMPRESS_LEVEL, dict);
+  if (dict.empty()) {
+    return zstd_compress_impl(data, DEFAULT_COMPRESS_LEVEL);
+  }
+  const ZSTD_CDict *cdict = nullptr;
+  {
+    dl::CriticalSectionGuard critical_section;
+    cdict = vk::singleton<ZstdCache>::get().get_cdict(as_string_view(dict), DEFAULT_COMPRESS_LEVEL);
+  }
+  if (!cdict) {
+    php_warning("zstd_compress: can not load dict");
+    return false;
+  }
+  return zstd_compress_with_cdict(data, cdict);
 }
 
 Optional<string> f$zstd_uncompress_dict(const string &data, const string &dict) noexcept {
-  return zstd_uncompress_impl(data, dict);
+  if (dict.empty()) {
+    return zstd_uncompress_impl(data);
+  }
+  const ZSTD_DDict *ddict = nullptr;
+  {
+    dl::CriticalSectionGuard critical_section;
+    ddict = vk::singleton<ZstdCache>::get().get_ddict(as_string_view(dict));
+  }
+  if (!ddict) {
+    php_warning("zstd_uncompress: can not load dict");
+    return false;
+  }
+  return zstd_uncompress_impl(data, ddict);
+}
+
+bool f$zstd_register_dict(const string &name, const string &dict, int64_t level) noexcept {
+  if (!check_compress_level("zstd_register_dict", level)) {
+    return false;
+  }
+  dl::CriticalSectionGuard critical_section;
+  if (!vk::singleton<ZstdCache>::get().register_dict(as_string_view(name), as_string_view(dict), static_cast<int>(level))) {
+    php_warning("zstd_register_dict: can not load dict '%s'", name.c_str());
+    return false;
+  }
+  return true;
+}
+
+Optional<string> f$zstd_compress_named_dict(const string &data, const string &name) noexcept {
+  const ZSTD_CDict *cdict = nullptr;
+  {
+    dl::CriticalSectionGuard critical_section;
+    cdict = vk::singleton<ZstdCache>::get().get_named_cdict(as_string_view(name));
+  }
+  if (!cdict) {
+    php_warning("zstd_compress: dict '%s' is not registered", name.c_str());
+    return false;
+  }
+  return zstd_compress_with_cdict(data, cdict);
+}
+
+Optional<string> f$zstd_uncompress_named_dict(const string &data, const string &name) noexcept {
+  const ZSTD_DDict *ddict = nullptr;
+  {
+    dl::CriticalSectionGuard critical_section;
+    ddict = vk::singleton<ZstdCache>::get().get_named_ddict(as_string_view(name));
+  }
+  if (!ddict) {
+    php_warning("zstd_uncompress: dict '%s' is not registered", name.c_str());
+    return false;
+  }
+  return zstd_uncompress_impl(data, ddict);
 }
@@ -16,3 +16,9 @@ Optional<string> f$zstd_uncompress(const string &data) noexcept;
 Optional<string> f$zstd_compress_dict(const string &data, const string &dict) noexcept;
 
 Optional<string> f$zstd_uncompress_dict(const string &data, const string &dict) noexcept;
+
+bool f$zstd_register_dict(const string &name, const string &dict, int64_t level = DEFAULT_COMPRESS_LEVEL) noexcept;
+
+Optional<string> f$zstd_compress_named_dict(const string &data, const string &name) noexcept;
+
+Optional<string> f$zstd_uncompress_named_dict(const string &data, const string &name) noexcept;
@@ -0,0 +1,88 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2022 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/database-drivers/mysql/mysql-connection-pool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "runtime/critical_section.h"
+#include "server/database-drivers/mysql/mysql.h"
+
+namespace database_drivers {
+
+bool MysqlConnectionPool::is_expired(const IdleConnection &idle, Clock::time_point now) const noexcept {
+  return now - idle.released_at >= max_idle_time_ || now - idle.connection.created_at >= max_lifetime_;
+}
+
+void MysqlConnectionPool::close(Connection &connection) noexcept {
+  LIB_MYSQL_CALL(mysql_close(connection.ctx));
+  connection.ctx = nullptr;
+}
+
+MysqlConnectionPool::Connection MysqlConnectionPool::take(vk::string_view key) noexcept {
+  dl::CriticalSectionGuard guard;
+
+  auto it = idle_connections_.find(std::string{key.data(), key.size()});
+  if (it == idle_connections_.end()) {
+    return {};
+  }
+  const auto now = Clock::now();
+  auto &connections = it->second;
+  while (!connections.empty()) {
+    IdleConnection idle = connections.back();
+    connections.pop_back();
+    if (!is_expired(idle, now)) {
+      ++stats_.reused;
+      tvkprintf(mysql, 1, "MySQL take pooled connection: idle connections left = %zu\n", connections.size());
+      return idle.connection;
+    }
+    close(idle.connection);
+    ++stats_.expired;
+  }
+  return {};
+}
+
+void MysqlConnectionPool::release(vk::string_view key, Connection connection) noexcept {
+  dl::CriticalSectionGuard guard;
+
+  const auto now = Clock::now();
+  if (!is_enabled() || now - connection.created_at >= max_lifetime_) {
+    close(connection);
+    return;
+  }
+  auto &connections = idle_connections_[std::string{key.data(), key.size()}];
+  if (connections.size() >= max_idle_connections_) {
+    close(connection);
+    return;
+  }
+  connections.push_back(IdleConnection{connection, now});
+  tvkprintf(mysql, 1, "MySQL release connection to pool: idle connections = %zu\n", connections.size());
+}
+
+void MysqlConnectionPool::close_broken(Connection connection) noexcept {
+  dl::CriticalSectionGuard guard;
+
+  close(connection);
+  ++stats_.reset_failed;
+}
+
+MysqlConnectionPool::Stats MysqlConnectionPool::on_request_end() noexcept {
+  dl::CriticalSectionGuard guard;
+
+  const auto now = Clock::now();
+  for (auto it = idle_connections_.begin(); it != idle_connections_.end();) {
+    auto &connections = it->second;
+    const auto first_expired = std::stable_partition(connections.begin(), connections.end(),
+                                                     [this, now](const IdleConnection &idle) { return !is_expired(idle, now); });
+    std::for_each(first_expired, connections.end(), [this](IdleConnection &idle) { close(idle.connection); });
+    stats_.expired += connections.end() - first_expired;
+    connections.erase(first_expired, connections.end());
+    it = connections.empty() ? idle_connections_.erase(it) : std::next(it);
+  }
+  return std::exchange(stats_, Stats{});
+}
+
+} // namespace database_drivers
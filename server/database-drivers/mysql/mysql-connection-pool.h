@@ -0,0 +1,97 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2022 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mysql/mysql.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+#include "common/smart_ptrs/singleton.h"
+#include "common/wrappers/string_view.h"
+
+namespace database_drivers {
+
+/**
+ * Authenticated MySQL connections of a worker, that outlive requests, @see --pdo-mysql-pool-size.
+ * A connection is returned here when its connector is destroyed at the end of the request, if there is no query in flight on it.
+ * The next connector with the same host, port, database, user and password takes it instead of connecting
+ * and resets its session state with COM_RESET_CONNECTION: it's also the health check, a broken connection is closed and replaced by a new one.
+ * A connection isn't reused after being idle for --pdo-mysql-pool-max-idle-time or after living for --pdo-mysql-pool-max-lifetime,
+ * expired idle connections are closed at the end of requests.
+ *
+ * Connections are allocated on the heap (as everything allocated by mysql lib), all operations are in the critical section.
+ */
+class MysqlConnectionPool : vk::not_copyable {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Connection {
+    MYSQL *ctx{nullptr};
+    Clock::time_point created_at;
+  };
+
+  struct Stats {
+    uint64_t reused{0};
+    uint64_t created{0};
+    uint64_t reset_failed{0};
+    uint64_t expired{0};
+  };
+
+  void set_max_idle_connections(uint32_t max_idle_connections) noexcept {
+    max_idle_connections_ = max_idle_connections;
+  }
+  void set_max_idle_time(std::chrono::seconds max_idle_time) noexcept {
+    max_idle_time_ = max_idle_time;
+  }
+  void set_max_lifetime(std::chrono::seconds max_lifetime) noexcept {
+    max_lifetime_ = max_lifetime;
+  }
+
+  bool is_enabled() const noexcept {
+    return max_idle_connections_ != 0;
+  }
+
+  // the key identifies the host, port, database, user and password of a connection
+  // returns a connection with ctx == nullptr if there is no alive idle one for the key
+  Connection take(vk::string_view key) noexcept;
+  // takes ownership of the connection; it's closed if the pool is full or the connection is too old
+  void release(vk::string_view key, Connection connection) noexcept;
+  // is used for a taken connection, which can't be reset
+  void close_broken(Connection connection) noexcept;
+
+  void on_connection_created() noexcept {
+    ++stats_.created;
+  }
+
+  // is called at the end of each request: closes the expired idle connections and returns the stats since the previous call
+  Stats on_request_end() noexcept;
+
+private:
+  MysqlConnectionPool() = default;
+
+  friend class vk::singleton<MysqlConnectionPool>;
+
+  struct IdleConnection {
+    Connection connection;
+    Clock::time_point released_at;
+  };
+
+  bool is_expired(const IdleConnection &idle, Clock::time_point now) const noexcept;
+  void close(Connection &connection) noexcept;
+
+  uint32_t max_idle_connections_{0};
+  std::chrono::seconds max_idle_time_{60};
+  std::chrono::seconds max_lifetime_{3600};
+
+  // the most recently released connections are at the back
+  std::unordered_map<std::string, std::vector<IdleConnection>> idle_connections_;
+  Stats stats_;
+};
+
+} // namespace database_drivers
@@ -5,6 +5,7 @@
 #include "server/database-drivers/mysql/mysql-connector.h"
 
 #include <mysql/mysql.h>
+#include <utility>
 
 #include "server/database-drivers/mysql/mysql.h"
 #include "server/database-drivers/mysql/mysql-request.h"
@@ -20,11 +21,30 @@ MysqlConnector::MysqlConnector(MYSQL *ctx, string host, string user, string pass
   , user(std::move(user))
   , password(std::move(password))
   , db_name(std::move(db_name))
-  , port(port) {}
+  , port(port) {
+  if (vk::singleton<MysqlConnectionPool>::get().is_enabled()) {
+    // '\0' can't be a part of the parameters, they are passed to mysql lib as C strings
+    pool_key.append(int64_t{port}).append(1, '\0').append(this->host).append(1, '\0').append(this->db_name)
+      .append(1, '\0').append(this->user).append(1, '\0').append(this->password);
+  }
+}
 
 MysqlConnector::~MysqlConnector() noexcept {
-  if (is_connected) {
-    epoll_remove(get_fd());
+  if (pooled_connection.ctx) {
+    LIB_MYSQL_CALL(mysql_close(pooled_connection.ctx));
+  }
+  if (!is_connected) {
+    LIB_MYSQL_CALL(mysql_close(ctx));
+    return;
+  }
+  epoll_remove(get_fd());
+  // a connection with a query in flight or with unread rows can't be reused, its protocol state is unknown;
+  // a transaction left open by the script would keep its locks while the connection is idle in the pool, closing rolls it back
+  const bool in_transaction = ctx->server_status & SERVER_STATUS_IN_TRANS;
+  if (!pool_key.empty() && pending_request == nullptr && pending_response == nullptr && !has_unfinished_result && !in_transaction) {
+    vk::singleton<MysqlConnectionPool>::get().release(vk::string_view{pool_key.c_str(), pool_key.size()}, MysqlConnectionPool::Connection{ctx, created_at});
+    tvkprintf(mysql, 1, "MySQL connection to [%s:%d] is released: connector_id = %d\n", host.c_str(), port, connector_id);
+  } else {
     LIB_MYSQL_CALL(mysql_close(ctx));
     tvkprintf(mysql, 1, "MySQL disconnected from [%s:%d]: connector_id = %d\n", host.c_str(), port, connector_id);
   }
@@ -41,6 +61,31 @@ AsyncOperationStatus MysqlConnector::connect_async() noexcept {
   if (is_connected) {
     return AsyncOperationStatus::COMPLETED;
   }
+  auto &pool = vk::singleton<MysqlConnectionPool>::get();
+  if (!pool_key.empty() && !is_pool_checked) {
+    is_pool_checked = true;
+    pooled_connection = pool.take(vk::string_view{pool_key.c_str(), pool_key.size()});
+  }
+  if (pooled_connection.ctx) {
+    // COM_RESET_CONNECTION is also the health check of the pooled connection
+    net_async_status status = LIB_MYSQL_CALL(mysql_reset_connection_nonblocking(pooled_connection.ctx));
+    tvkprintf(mysql, 1, "MySQL try to reset pooled connection to [%s:%d]: connector_id = %d, status = %d\n", host.c_str(), port, connector_id, status);
+    switch (status) {
+      case NET_ASYNC_NOT_READY:
+        return AsyncOperationStatus::IN_PROGRESS;
+      case NET_ASYNC_COMPLETE:
+        // the fresh context hasn't been connected yet, so it's just freed
+        LIB_MYSQL_CALL(mysql_close(ctx));
+        ctx = std::exchange(pooled_connection.ctx, nullptr);
+        created_at = pooled_connection.created_at;
+        return AsyncOperationStatus::COMPLETED;
+      case NET_ASYNC_ERROR:
+      default:
+        pool.close_broken(std::exchange(pooled_connection, MysqlConnectionPool::Connection{}));
+        break;
+    }
+  }
+
   net_async_status status =
     LIB_MYSQL_CALL(mysql_real_connect_nonblocking(ctx, host.c_str(), user.c_str(), password.c_str(), db_name.c_str(), port, nullptr, 0));
 
@@ -49,6 +94,10 @@ AsyncOperationStatus MysqlConnector::connect_async() noexcept {
     case NET_ASYNC_NOT_READY:
       return AsyncOperationStatus::IN_PROGRESS;
     case NET_ASYNC_COMPLETE:
+      created_at = MysqlConnectionPool::Clock::now();
+      if (!pool_key.empty()) {
+        pool.on_connection_created();
+      }
       return AsyncOperationStatus::COMPLETED;
     case NET_ASYNC_ERROR:
     default:
@@ -77,7 +126,8 @@ void MysqlConnector::handle_write() noexcept {
     case AsyncOperationStatus::IN_PROGRESS:
       return;
     case AsyncOperationStatus::COMPLETED: {
-      pending_response = std::make_unique<MysqlResponse>(connector_id, pending_request->request_id);
+      const auto &request = static_cast<const MysqlRequest &>(*pending_request);
+      pending_response = std::make_unique<MysqlResponse>(connector_id, request.request_id, request.type, request.unbuffered_res);
       pending_request = nullptr;
       update_state_ready_to_read(); // TODO: maybe do it via EVA_CONTINUE | flags?
       break;
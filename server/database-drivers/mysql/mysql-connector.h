@@ -9,6 +9,7 @@
 
 #include "runtime/kphp_core.h"
 #include "server/database-drivers/connector.h"
+#include "server/database-drivers/mysql/mysql-connection-pool.h"
 
 namespace database_drivers {
 
@@ -18,6 +19,8 @@ class Response;
 class MysqlConnector final : public Connector {
 public:
   MYSQL *ctx{};
+  // an unbuffered result which rows haven't been read to the end, no other query can be sent until it's finished
+  bool has_unfinished_result{false};
 
   MysqlConnector(MYSQL *ctx, string host, string user, string password, string db_name, int port);
 
@@ -34,6 +37,12 @@ private:
   string password{};
   string db_name{};
   int port{};
+  // empty if the connection pool is disabled
+  string pool_key;
+  // a connection taken from the pool, it's used instead of ctx when its session state is reset
+  MysqlConnectionPool::Connection pooled_connection;
+  bool is_pool_checked{false};
+  MysqlConnectionPool::Clock::time_point created_at;
   std::unique_ptr<Request> pending_request;
   std::unique_ptr<Response> pending_response;
 
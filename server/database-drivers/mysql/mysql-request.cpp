@@ -12,13 +12,24 @@
 
 namespace database_drivers {
 
-MysqlRequest::MysqlRequest(int connector_id, const string &request)
+MysqlRequest::MysqlRequest(int connector_id, const string &request, Type type)
   : Request(connector_id)
+  , type(type)
   , request(request) {}
 
+MysqlRequest::MysqlRequest(int connector_id, MYSQL_RES *unbuffered_res, Type type)
+  : Request(connector_id)
+  , type(type)
+  , unbuffered_res(unbuffered_res) {}
+
 AsyncOperationStatus MysqlRequest::send_async() noexcept {
   dl::CriticalSectionGuard guard;
 
+  if (type == Type::fetch_row || type == Type::discard_rows) {
+    // the rows have been requested by the query already
+    return AsyncOperationStatus::COMPLETED;
+  }
+
   auto *connector = vk::singleton<database_drivers::Adaptor>::get().get_connector<MysqlConnector>(connector_id);
   if (connector == nullptr) {
     return AsyncOperationStatus::ERROR;
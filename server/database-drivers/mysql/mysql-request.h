@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <mysql/mysql.h>
+
 #include "runtime/kphp_core.h"
 #include "server/database-drivers/request.h"
 
@@ -13,10 +15,25 @@ class MysqlConnector;
 
 class MysqlRequest final : public Request {
 public:
-  MysqlRequest(int connector_id, const string &request);
+  enum class Type {
+    // the whole result set is read into MYSQL_RES
+    buffered_query,
+    // only the columns info is read, rows are left in the connection and are read one by one with fetch_row requests
+    unbuffered_query,
+    // reads the next row of the unbuffered result
+    fetch_row,
+    // reads the rest of the unbuffered result and drops it
+    discard_rows
+  };
+
+  MysqlRequest(int connector_id, const string &request, Type type = Type::buffered_query);
+  MysqlRequest(int connector_id, MYSQL_RES *unbuffered_res, Type type);
 
   AsyncOperationStatus send_async() noexcept final;
 
+  const Type type;
+  MYSQL_RES *const unbuffered_res{nullptr};
+
 private:
   string request;
 };
@@ -4,14 +4,23 @@
 
 #include "server/database-drivers/mysql/mysql-resources.h"
 
-#include <unordered_set>
+#include <sys/socket.h>
+#include <unordered_map>
 
 #include "runtime/critical_section.h"
 #include "server/database-drivers/mysql/mysql.h"
 
 namespace {
 
-std::unordered_set<MYSQL_RES *> mysql_responses_to_free; // all operations are in the critical section
+// the value is the fd of the connection of an unfinished unbuffered result, or -1
+std::unordered_map<MYSQL_RES *, int> mysql_responses_to_free; // all operations are in the critical section
+
+void free_mysql_response(MYSQL_RES *res, int unfinished_fd) {
+  if (unfinished_fd >= 0) {
+    shutdown(unfinished_fd, SHUT_RDWR);
+  }
+  LIB_MYSQL_CALL(mysql_free_result(res));
+}
 
 } // namespace
 
@@ -20,15 +29,33 @@ namespace database_drivers {
 void register_mysql_response(MYSQL_RES *res) {
   dl::CriticalSectionGuard guard;
 
-  mysql_responses_to_free.insert(res);
+  mysql_responses_to_free.emplace(res, -1);
   tvkprintf(mysql, 2, "MySQL response %p registered\n", res);
 }
 
+void register_unbuffered_mysql_response(MYSQL_RES *res, int fd) {
+  dl::CriticalSectionGuard guard;
+
+  mysql_responses_to_free.emplace(res, fd);
+  tvkprintf(mysql, 2, "MySQL unbuffered response %p registered\n", res);
+}
+
+void finish_unbuffered_mysql_response(MYSQL_RES *res) {
+  dl::CriticalSectionGuard guard;
+
+  auto it = mysql_responses_to_free.find(res);
+  if (it != mysql_responses_to_free.end()) {
+    it->second = -1;
+  }
+}
+
 void remove_mysql_response(MYSQL_RES *res) {
   dl::CriticalSectionGuard guard;
 
-  if (mysql_responses_to_free.erase(res)) {
-    LIB_MYSQL_CALL(mysql_free_result(res));
+  auto it = mysql_responses_to_free.find(res);
+  if (it != mysql_responses_to_free.end()) {
+    free_mysql_response(res, it->second);
+    mysql_responses_to_free.erase(it);
     tvkprintf(mysql, 2, "MySQL response %p removed\n", res);
   }
 }
@@ -36,9 +63,9 @@ void remove_mysql_response(MYSQL_RES *res) {
 void free_mysql_resources() {
   dl::CriticalSectionGuard guard;
 
-  for (auto *res : mysql_responses_to_free) {
-    LIB_MYSQL_CALL(mysql_free_result(res));
-    tvkprintf(mysql, 2, "MySQL response %p freed on script termination\n", res);
+  for (const auto &it : mysql_responses_to_free) {
+    free_mysql_response(it.first, it.second);
+    tvkprintf(mysql, 2, "MySQL response %p freed on script termination\n", it.first);
   }
   mysql_responses_to_free.clear();
 }
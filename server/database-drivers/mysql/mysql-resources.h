@@ -15,6 +15,13 @@ namespace database_drivers {
  */
 
 void register_mysql_response(MYSQL_RES *res);
+/**
+ * Rows of an unbuffered result are left in the connection with @a fd, and mysql lib reads them all when such a result is freed.
+ * To not block the worker, the connection is shut down before an unfinished unbuffered result is freed, so it can't be used anymore.
+ */
+void register_unbuffered_mysql_response(MYSQL_RES *res, int fd);
+// is called when all the rows of the unbuffered result are read
+void finish_unbuffered_mysql_response(MYSQL_RES *res);
 void remove_mysql_response(MYSQL_RES *res);
 void free_mysql_resources();
 
@@ -11,6 +11,11 @@
 
 namespace database_drivers {
 
+MysqlResponse::MysqlResponse(int connector_id, int bound_request_id, MysqlRequest::Type type, MYSQL_RES *unbuffered_res)
+  : Response(connector_id, bound_request_id)
+  , type(type)
+  , unbuffered_res(unbuffered_res) {}
+
 AsyncOperationStatus MysqlResponse::fetch_async() noexcept {
   auto *connector = vk::singleton<database_drivers::Adaptor>::get().get_connector<MysqlConnector>(connector_id);
   if (connector == nullptr) {
@@ -18,8 +23,21 @@ AsyncOperationStatus MysqlResponse::fetch_async() noexcept {
     return AsyncOperationStatus::ERROR;
   }
 
+  switch (type) {
+    case MysqlRequest::Type::buffered_query:
+    case MysqlRequest::Type::unbuffered_query:
+      return fetch_query_result(*connector);
+    case MysqlRequest::Type::fetch_row:
+    case MysqlRequest::Type::discard_rows:
+      return fetch_unbuffered_rows(*connector);
+  }
+  is_error = true;
+  return AsyncOperationStatus::ERROR;
+}
+
+AsyncOperationStatus MysqlResponse::fetch_query_result(MysqlConnector &connector) noexcept {
   if (!got_columns_info) {
-    bool error = LIB_MYSQL_CALL(mysql_read_query_result(connector->ctx));
+    bool error = LIB_MYSQL_CALL(mysql_read_query_result(connector.ctx));
     if (error) {
       is_error = true;
       return AsyncOperationStatus::ERROR;
@@ -29,7 +47,24 @@ AsyncOperationStatus MysqlResponse::fetch_async() noexcept {
   }
 
   dl::CriticalSectionGuard guard; // guarantee that MYSQL_RES will be registered to prevent memory leak on script timeouts
-  net_async_status status = LIB_MYSQL_CALL(mysql_store_result_nonblocking(connector->ctx, &res)); // buffered queries
+  if (type == MysqlRequest::Type::unbuffered_query) {
+    // the rows aren't read here, so it doesn't wait for the network
+    res = LIB_MYSQL_CALL(mysql_use_result(connector.ctx));
+    tvkprintf(mysql, 1, "MySQL fetch response: request_id = %d, get unbuffered result set\n", bound_request_id);
+    if (res != nullptr) {
+      register_unbuffered_mysql_response(res, connector.get_fd());
+      connector.has_unfinished_result = true;
+      return AsyncOperationStatus::COMPLETED;
+    }
+    if (LIB_MYSQL_CALL(mysql_field_count(connector.ctx)) == 0) {
+      affected_rows = LIB_MYSQL_CALL(mysql_affected_rows(connector.ctx));
+      return AsyncOperationStatus::COMPLETED;
+    }
+    is_error = true;
+    return AsyncOperationStatus::ERROR;
+  }
+
+  net_async_status status = LIB_MYSQL_CALL(mysql_store_result_nonblocking(connector.ctx, &res)); // buffered queries
   tvkprintf(mysql, 1, "MySQL fetch response: request_id = %d, get result set, status = %d\n", bound_request_id, status);
   switch (status) {
     case NET_ASYNC_COMPLETE: {
@@ -37,8 +72,8 @@ AsyncOperationStatus MysqlResponse::fetch_async() noexcept {
         register_mysql_response(res);
         return AsyncOperationStatus::COMPLETED;
       } else {
-        if (LIB_MYSQL_CALL(mysql_field_count(connector->ctx)) == 0) {
-          affected_rows = LIB_MYSQL_CALL(mysql_affected_rows(connector->ctx));
+        if (LIB_MYSQL_CALL(mysql_field_count(connector.ctx)) == 0) {
+          affected_rows = LIB_MYSQL_CALL(mysql_affected_rows(connector.ctx));
           return AsyncOperationStatus::COMPLETED;
         } else {
           is_error = true;
@@ -60,6 +95,31 @@ AsyncOperationStatus MysqlResponse::fetch_async() noexcept {
   }
 }
 
+AsyncOperationStatus MysqlResponse::fetch_unbuffered_rows(MysqlConnector &connector) noexcept {
+  dl::CriticalSectionGuard guard;
+  while (true) {
+    net_async_status status = LIB_MYSQL_CALL(mysql_fetch_row_nonblocking(unbuffered_res, &row));
+    if (status == NET_ASYNC_NOT_READY) {
+      return AsyncOperationStatus::IN_PROGRESS;
+    }
+    if (status != NET_ASYNC_COMPLETE) {
+      is_error = true;
+      return AsyncOperationStatus::ERROR;
+    }
+    if (row == nullptr) {
+      // mysql lib reports an error in the middle of the result set as its end
+      is_error = LIB_MYSQL_CALL(mysql_errno(connector.ctx)) != 0;
+      finish_unbuffered_mysql_response(unbuffered_res);
+      connector.has_unfinished_result = false;
+      tvkprintf(mysql, 1, "MySQL fetch response: request_id = %d, unbuffered result set is finished\n", bound_request_id);
+      return is_error ? AsyncOperationStatus::ERROR : AsyncOperationStatus::COMPLETED;
+    }
+    if (type == MysqlRequest::Type::fetch_row) {
+      return AsyncOperationStatus::COMPLETED;
+    }
+  }
+}
+
 MysqlResponse::~MysqlResponse() {
   if (res) {
     remove_mysql_response(res);
@@ -6,6 +6,7 @@
 
 #include <mysql/mysql.h>
 
+#include "server/database-drivers/mysql/mysql-request.h"
 #include "server/database-drivers/response.h"
 
 namespace database_drivers {
@@ -14,18 +15,27 @@ class MysqlConnector;
 
 class MysqlResponse final : public Response {
 public:
+  // the result of a query, it's owned by the response
   MYSQL_RES *res{nullptr};
+  // the row of fetch_row request, it's valid until the next row of the result is fetched; nullptr if there are no more rows
+  MYSQL_ROW row{nullptr};
   uint64_t affected_rows{0};
   bool is_error{false};
 
-  using Response::Response;
+  MysqlResponse(int connector_id, int bound_request_id, MysqlRequest::Type type = MysqlRequest::Type::buffered_query,
+                MYSQL_RES *unbuffered_res = nullptr);
 
   AsyncOperationStatus fetch_async() noexcept final;
 
   ~MysqlResponse() final;
 
 private:
+  const MysqlRequest::Type type;
+  MYSQL_RES *const unbuffered_res{nullptr};
   bool got_columns_info{false};
+
+  AsyncOperationStatus fetch_query_result(MysqlConnector &connector) noexcept;
+  AsyncOperationStatus fetch_unbuffered_rows(MysqlConnector &connector) noexcept;
 };
 
 } // namespace database_drivers
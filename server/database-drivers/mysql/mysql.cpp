@@ -3,7 +3,9 @@
 // Distributed under the GPL v3 License, see LICENSE.notice.txt
 
 #include "server/database-drivers/mysql/mysql.h"
+#include "server/database-drivers/mysql/mysql-connection-pool.h"
 #include "server/database-drivers/mysql/mysql-resources.h"
+#include "server/server-stats.h"
 
 DEFINE_VERBOSITY(mysql);
 
@@ -11,6 +13,12 @@ namespace database_drivers {
 
 void free_mysql_lib() {
   free_mysql_resources();
+
+  auto &pool = vk::singleton<MysqlConnectionPool>::get();
+  if (pool.is_enabled()) {
+    const auto stats = pool.on_request_end();
+    vk::singleton<ServerStats>::get().add_mysql_pool_stats(stats.reused, stats.created, stats.reset_failed, stats.expired);
+  }
 }
 
 } // namespace database_drivers
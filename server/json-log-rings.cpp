@@ -0,0 +1,66 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/json-log-rings.h"
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+#include "common/wrappers/memory-utils.h"
+
+JsonLogRings *JsonLogRings::create(uint16_t rings_count, size_t ring_size) noexcept {
+  assert(rings_count);
+  ring_size = (ring_size + sizeof(Ring) - 1) / sizeof(Ring) * sizeof(Ring);
+  assert(ring_size >= 4 * aligned_record_size(0));
+  void *mem = mmap_shared(rings_offset() + rings_count * (sizeof(Ring) + ring_size));
+  auto *rings = new(mem) JsonLogRings{rings_count, ring_size};
+  for (uint16_t ring_id = 0; ring_id != rings_count; ++ring_id) {
+    new(&rings->get_ring(ring_id)) Ring{};
+  }
+  return rings;
+}
+
+JsonLogRings::Ring &JsonLogRings::get_ring(uint16_t ring_id) noexcept {
+  assert(ring_id < rings_count_);
+  char *first_ring = reinterpret_cast<char *>(this) + rings_offset();
+  return *reinterpret_cast<Ring *>(first_ring + ring_id * (sizeof(Ring) + ring_size_));
+}
+
+bool JsonLogRings::push(uint16_t ring_id, uint64_t key, vk::string_view record) noexcept {
+  assert(record.size() <= max_record_size());
+  Ring &ring = get_ring(ring_id);
+  uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+  const uint64_t head = ring.head.load(std::memory_order_acquire);
+
+  const size_t record_size = aligned_record_size(record.size());
+  const size_t offset = tail % ring_size_;
+  // records are never split, the rest of the ring is skipped if the record doesn't fit there
+  const size_t skipped = ring_size_ - offset < record_size ? ring_size_ - offset : 0;
+  if (ring_size_ - (tail - head) < skipped + record_size) {
+    ring.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  char *data = get_ring_data(ring);
+  if (skipped) {
+    reinterpret_cast<RecordHeader *>(data + offset)->size = WRAP_MARK;
+    tail += skipped;
+  }
+  auto *header = reinterpret_cast<RecordHeader *>(data + tail % ring_size_);
+  header->size = static_cast<uint32_t>(record.size());
+  header->reserved = 0;
+  header->key = key;
+  memcpy(header + 1, record.data(), record.size());
+  ring.tail.store(tail + record_size, std::memory_order_release);
+  return true;
+}
+
+uint64_t JsonLogRings::take_dropped_count() noexcept {
+  uint64_t dropped = 0;
+  for (uint16_t ring_id = 0; ring_id != rings_count_; ++ring_id) {
+    dropped += get_ring(ring_id).dropped.exchange(0, std::memory_order_relaxed);
+  }
+  return dropped;
+}
@@ -0,0 +1,99 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/mixin/not_copyable.h"
+#include "common/wrappers/string_view.h"
+
+// Shared memory rings of json log records, one per worker: workers append records without syscalls,
+// the master drains them (see JsonLogger::flush_log_rings()).
+// Each ring has a single producer (a worker with the ring id) and a single consumer (the master),
+// so a ring is lock free: a record becomes visible to the master only after it's completely written,
+// therefore a worker killed in the middle of writing doesn't break the ring for the next worker with the same id.
+class JsonLogRings : vk::not_copyable {
+public:
+  // is called by the master before workers are started
+  static JsonLogRings *create(uint16_t rings_count, size_t ring_size) noexcept;
+
+  // it's safe for signal handlers, but not reentrant for the same ring, the caller must care about it;
+  // returns false if the ring is full: the record is dropped and counted
+  bool push(uint16_t ring_id, uint64_t key, vk::string_view record) noexcept;
+
+  size_t max_record_size() const noexcept {
+    return ring_size_ / 4 - sizeof(RecordHeader);
+  }
+
+  template<class F>
+  void drain(F &&on_record) noexcept {
+    for (uint16_t ring_id = 0; ring_id != rings_count_; ++ring_id) {
+      drain_ring(get_ring(ring_id), on_record);
+    }
+  }
+
+  uint64_t take_dropped_count() noexcept;
+
+private:
+  struct RecordHeader {
+    uint32_t size;
+    uint32_t reserved;
+    uint64_t key;
+  };
+
+  struct alignas(64) Ring {
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "rings are used from signal handlers and from several processes");
+
+  // records are aligned by the header size, so there is always a room for the header at the end of the ring
+  static constexpr size_t RECORD_ALIGNMENT = sizeof(RecordHeader);
+  static constexpr uint32_t WRAP_MARK = UINT32_MAX;
+
+  JsonLogRings(uint16_t rings_count, size_t ring_size) noexcept:
+    rings_count_(rings_count),
+    ring_size_(ring_size) {
+  }
+
+  // rings follow this object, each one is followed by its data
+  static size_t rings_offset() noexcept {
+    return (sizeof(JsonLogRings) + sizeof(Ring) - 1) / sizeof(Ring) * sizeof(Ring);
+  }
+
+  Ring &get_ring(uint16_t ring_id) noexcept;
+  char *get_ring_data(Ring &ring) noexcept {
+    return reinterpret_cast<char *>(&ring + 1);
+  }
+
+  static size_t aligned_record_size(size_t size) noexcept {
+    return (sizeof(RecordHeader) + size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+  }
+
+  template<class F>
+  void drain_ring(Ring &ring, F &on_record) noexcept {
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const uint64_t tail = ring.tail.load(std::memory_order_acquire);
+    char *data = get_ring_data(ring);
+    while (head != tail) {
+      const size_t offset = head % ring_size_;
+      const auto *header = reinterpret_cast<const RecordHeader *>(data + offset);
+      if (header->size == WRAP_MARK) {
+        head += ring_size_ - offset;
+        continue;
+      }
+      on_record(header->key, vk::string_view{reinterpret_cast<const char *>(header + 1), header->size});
+      head += aligned_record_size(header->size);
+    }
+    ring.head.store(head, std::memory_order_release);
+  }
+
+  const uint16_t rings_count_{0};
+  const size_t ring_size_{0};
+};
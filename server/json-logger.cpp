@@ -6,11 +6,17 @@
 #include <cinttypes>
 #include <execinfo.h>
 #include <fcntl.h>
+#include <string>
 #include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
 #include "common/algorithms/find.h"
+#include "common/algorithms/hashes.h"
 #include "common/fast-backtrace.h"
+#include "common/kprintf.h"
 #include "common/wrappers/likely.h"
+#include "server/json-log-rings.h"
 #include "server/json-logger.h"
 #include "server/php-engine-vars.h"
 
@@ -22,6 +28,10 @@ enum {
   ServerLogWarning = -3
 };
 
+constexpr int64_t MIN_LOG_RING_SIZE = 64 * 1024;
+// distinct records written by the master per flush, the others are dropped
+constexpr size_t MAX_LOG_RECORDS_PER_FLUSH = 1024;
+
 template<size_t N>
 void copy_if_enough_size(vk::string_view src, vk::string_view &dest, std::array<char, N> &buffer, volatile std::atomic<bool> &availability_flag) noexcept {
   if (src.size() <= buffer.size()) {
@@ -84,14 +94,11 @@ bool JsonLogger::JsonBuffer::try_start_json() noexcept {
   return acquired;
 }
 
-void JsonLogger::JsonBuffer::finish_json_and_flush(int out_fd) noexcept {
+vk::string_view JsonLogger::JsonBuffer::finish_json() noexcept {
   assert(*(last_ - 1) == ',');
   *(last_ - 1) = '}';
   *last_++ = '\n';
-  const auto r = write(out_fd, buffer_.data(), static_cast<size_t>(last_ - buffer_.data()));
-  // TODO assert?
-  static_cast<void>(r);
-  force_reset();
+  return {buffer_.data(), static_cast<size_t>(last_ - buffer_.data())};
 }
 
 void JsonLogger::JsonBuffer::force_reset() noexcept {
@@ -252,7 +259,98 @@ void JsonLogger::write_log(vk::string_view message, int type, int64_t created_at
   json_out_it->finish<']'>();
 
   json_out_it->append_key("msg").append_raw_string(message);
-  json_out_it->finish_json_and_flush(json_log_fd_);
+  const vk::string_view json = json_out_it->finish_json();
+  if (uncaught || !push_to_log_ring(json, message, trace, trace_size)) {
+    write_to_log_file(json);
+  }
+  json_out_it->force_reset();
+}
+
+bool JsonLogger::push_to_log_ring(vk::string_view json, vk::string_view message, void *const *trace, int64_t trace_size) noexcept {
+  if (!log_rings_ || process_type == ProcessType::master || json.size() > log_rings_->max_record_size()) {
+    return false;
+  }
+  if (log_ring_busy_.exchange(true)) {
+    return false;
+  }
+  size_t key = vk::std_hash(message);
+  for (int64_t i = 0; i < trace_size; i++) {
+    vk::hash_combine(key, reinterpret_cast<size_t>(trace[i]));
+  }
+  // if the ring is full, the record is dropped and counted, the master reports it
+  log_rings_->push(static_cast<uint16_t>(logname_id), key, json);
+  log_ring_busy_ = false;
+  return true;
+}
+
+void JsonLogger::write_to_log_file(vk::string_view json) const noexcept {
+  while (!json.empty()) {
+    const ssize_t written = write(json_log_fd_, json.data(), json.size());
+    if (written <= 0) {
+      return;
+    }
+    json.remove_prefix(static_cast<size_t>(written));
+  }
+}
+
+bool JsonLogger::set_log_ring_size(int64_t ring_size) noexcept {
+  if (ring_size < MIN_LOG_RING_SIZE) {
+    return false;
+  }
+  log_ring_size_ = static_cast<size_t>(ring_size);
+  return true;
+}
+
+void JsonLogger::init_log_rings(uint16_t workers_count) noexcept {
+  if (log_ring_size_ && !log_rings_) {
+    log_rings_ = JsonLogRings::create(workers_count, log_ring_size_);
+  }
+}
+
+void JsonLogger::flush_log_rings() noexcept {
+  if (!log_rings_) {
+    return;
+  }
+
+  struct AggregatedRecord {
+    std::string json;
+    uint64_t count;
+  };
+  std::unordered_map<uint64_t, size_t> record_ids;
+  std::vector<AggregatedRecord> records;
+  uint64_t rate_limited = 0;
+  log_rings_->drain([&](uint64_t key, vk::string_view json) {
+    auto it = record_ids.find(key);
+    if (it != record_ids.end()) {
+      ++records[it->second].count;
+    } else if (records.size() == MAX_LOG_RECORDS_PER_FLUSH) {
+      ++rate_limited;
+    } else {
+      record_ids.emplace(key, records.size());
+      records.push_back(AggregatedRecord{std::string{json.data(), json.size()}, 1});
+    }
+  });
+
+  std::string batch;
+  for (auto &record : records) {
+    if (record.count > 1) {
+      // the first record is written with the number of the same ones: '}\n' is replaced with ',"count":N}\n'
+      record.json.resize(record.json.size() - 2);
+      record.json.append(R"(,"count":)").append(std::to_string(record.count)).append("}\n");
+    }
+    batch.append(record.json);
+  }
+  if (json_log_fd_ > 0) {
+    write_to_log_file({batch.data(), batch.size()});
+  }
+
+  const uint64_t dropped = log_rings_->take_dropped_count() + rate_limited;
+  if (dropped) {
+    std::array<char, 256> message{};
+    snprintf(message.data(), message.size(), "%" PRIu64 " warnings of workers are dropped: log rings are full or too many distinct warnings", dropped);
+    kprintf("%s\n", message.data());
+    write_log(message.data(), ServerLogWarning, time(nullptr), nullptr, 0, false);
+  }
 }
 
 void JsonLogger::write_log_with_backtrace(vk::string_view message, int type) noexcept {
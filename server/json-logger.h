@@ -11,6 +11,7 @@
 #include "common/smart_ptrs/singleton.h"
 #include "common/wrappers/string_view.h"
 
+class JsonLogRings;
 
 class JsonLogger : vk::not_copyable {
 public:
@@ -26,6 +27,14 @@ public:
   void set_extra_info(vk::string_view extra_info) noexcept;
   void set_env(vk::string_view env) noexcept;
 
+  // Under a warning storm, workers spend their time in write syscalls: optionally, warnings of workers are appended
+  // to shared memory rings instead, and the master writes them to its log in batches, deduplicated by message and trace.
+  // Uncaught errors, crashes and records of the master itself are always written directly.
+  bool set_log_ring_size(int64_t ring_size) noexcept;
+  void init_log_rings(uint16_t workers_count) noexcept;
+  // is called by the master once a second
+  void flush_log_rings() noexcept;
+
   // ATTENTION: this functions are used in signal handlers, therefore they are expected to be safe for them
   // Details: https://man7.org/linux/man-pages/man7/signal-safety.7.html
   void write_log(vk::string_view message, int type, int64_t created_at, void *const *trace, int64_t trace_size, bool uncaught) noexcept;
@@ -37,9 +46,17 @@ public:
 private:
   JsonLogger() = default;
 
+  bool push_to_log_ring(vk::string_view json, vk::string_view message, void *const *trace, int64_t trace_size) noexcept;
+  void write_to_log_file(vk::string_view json) const noexcept;
+
   int64_t release_version_{0};
   int json_log_fd_{-1};
 
+  size_t log_ring_size_{0};
+  JsonLogRings *log_rings_{nullptr};
+  // a warning may be raised in a signal handler while another one is being pushed to the ring
+  volatile std::atomic<bool> log_ring_busy_{false};
+
 #if __cplusplus >= 201703
   static_assert(std::atomic<bool>::is_always_lock_free);
 #endif
@@ -60,7 +77,7 @@ private:
   class JsonBuffer : vk::not_copyable {
   public:
     bool try_start_json() noexcept;
-    void finish_json_and_flush(int out_fd) noexcept;
+    vk::string_view finish_json() noexcept;
     JsonBuffer &append_key(vk::string_view key) noexcept;
     template<char BRACKET>
     JsonBuffer &start() noexcept;
@@ -76,9 +76,11 @@ constexpr double SIGTERM_MAX_TIMEOUT = 10.0;
 #if defined(__APPLE__)
 #define SIGPHPASSERT (SIGCONT)
 #define SIGSTACKOVERFLOW (SIGTSTP)
+#define SIGSAMPLINGPROFILER (SIGWINCH)
 #else
 #define SIGPHPASSERT (SIGRTMIN + 1)
 #define SIGSTACKOVERFLOW (SIGRTMIN + 2)
+#define SIGSAMPLINGPROFILER (SIGRTMIN + 3)
 #endif
 
 /***
@@ -22,6 +22,7 @@
 #include "common/crc32c.h"
 #include "common/cycleclock.h"
 #include "common/dl-utils-lite.h"
+#include "common/kfs/kfs.h"
 #include "common/kprintf.h"
 #include "common/macos-ports.h"
 #include "common/options.h"
@@ -61,6 +62,7 @@
 #include "server/confdata-binlog-replay.h"
 #include "server/database-drivers/adaptor.h"
 #include "server/database-drivers/connector.h"
+#include "server/database-drivers/mysql/mysql-connection-pool.h"
 #include "server/job-workers/job-worker-client.h"
 #include "server/job-workers/job-worker-server.h"
 #include "server/job-workers/job-workers-context.h"
@@ -77,12 +79,14 @@
 #include "server/php-mc-connections.h"
 #include "server/php-queries.h"
 #include "server/php-runner.h"
+#include "server/php-sampling-profiler.h"
 #include "server/php-sql-connections.h"
 #include "server/php-worker.h"
 #include "server/server-log.h"
 #include "server/server-stats.h"
 #include "server/statshouse/statshouse-client.h"
 #include "server/statshouse/worker-stats-buffer.h"
+#include "server/workers-autoscaler.h"
 #include "server/workers-control.h"
 
 using job_workers::JobWorkersContext;
@@ -254,18 +258,17 @@ connection dummy_request_queue;
 
 
 void command_net_write_run_rpc(command_t *base_command, void *data) {
-  auto *command = (command_net_write_t *)base_command;
-//  fprintf (stderr, "command_net_write [ptr=%p] [len = %d] [data = %p]\n", base_command, command->len, data);
+  auto *command = reinterpret_cast<command_net_write_rpc_t *>(base_command);
 
-  slot_id_t slot_id = static_cast<slot_id_t>(command->extra);
-  assert (command->data != nullptr);
+  const slot_id_t slot_id = command->slot_id;
   if (data == nullptr) { //send to /dev/null
     vkprintf (3, "failed to send rpc request %d\n", slot_id);
     on_net_event(create_rpc_error_event(slot_id, TL_ERROR_NO_CONNECTIONS, "Failed to send query, timeout expired", nullptr));
   } else {
-    auto *d = (connection *)data;
-    //assert (d->status == conn_ready);
-    send_rpc_query(d, TL_RPC_INVOKE_REQ, slot_id, (int *)command->data, command->len);
+    auto *d = static_cast<connection *>(data);
+    raw_message_t request;
+    rwm_steal(&request, &command->request);
+    send_rpc_query(d, TL_RPC_INVOKE_REQ, slot_id, &request);
     d->last_query_sent_time = precise_now;
   }
 }
@@ -282,9 +285,15 @@ void command_net_write_free(command_t *base_command) {
   free(command);
 }
 
+static void command_net_write_rpc_free(command_t *base_command) {
+  auto *command = reinterpret_cast<command_net_write_rpc_t *>(base_command);
+  rwm_free(&command->request);
+  free(command);
+}
+
 command_t command_net_write_rpc_base = {
   .run = command_net_write_run_rpc,
-  .free = command_net_write_free
+  .free = command_net_write_rpc_free
 };
 
 
@@ -301,6 +310,17 @@ command_t *create_command_net_writer(const char *data, int data_len, command_t *
   return reinterpret_cast<command_t *>(command);
 }
 
+command_t *create_command_net_rpc_writer(raw_message_t *request, slot_id_t slot_id) {
+  auto *command = static_cast<command_net_write_rpc_t *>(malloc(sizeof(command_net_write_rpc_t)));
+  command->base.run = command_net_write_rpc_base.run;
+  command->base.free = command_net_write_rpc_base.free;
+
+  rwm_steal(&command->request, request);
+  command->slot_id = slot_id;
+
+  return reinterpret_cast<command_t *>(command);
+}
+
 
 /** php-script **/
 
@@ -343,6 +363,18 @@ void send_rpc_query(connection *c, int op, long long id, int *q, int qsize) {
   TCP_RPCS_FUNC(c)->flush_packet(c);
 }
 
+void send_rpc_query(connection *c, int op, long long id, raw_message_t *request) {
+  auto *header = static_cast<char *>(rwm_prepend_alloc(request, sizeof(op) + sizeof(id)));
+  assert(header);
+  memcpy(header, &op, sizeof(op));
+  memcpy(header + sizeof(op), &id, sizeof(id));
+
+  vkprintf (4, "send_rpc_query: [len = %d] [op = %08x] [rpc_id = <%lld>]\n", request->total_bytes, op, id);
+  tcp_rpc_conn_send(c, request, 0);
+
+  TCP_RPCS_FUNC(c)->flush_packet(c);
+}
+
 void on_net_event(int event_status) {
   if (event_status == 0) {
     return;
@@ -518,6 +550,10 @@ int do_hts_func_wakeup(connection *c, bool flag) {
   assert(worker);
   double timeout = worker->enter_lifecycle();
   if (timeout == 0) {
+    // the connection can't be reused, it's not known where the next query starts
+    if (worker->has_unread_http_post()) {
+      D->query_flags &= ~QF_KEEPALIVE;
+    }
     delete worker;
     hts_at_query_end(c, flag);
   } else {
@@ -1414,12 +1450,20 @@ static void sigusr1_handler(const int sig) {
   pending_signals = pending_signals | (1ll << sig);
 }
 
+static void sigsamplingprofiler_handler(const int sig) {
+  const char message[] = "got SIGSAMPLINGPROFILER, toggle sampling profiler.\n";
+  kwrite(2, message, sizeof(message) - (size_t)1);
+
+  pending_signals = pending_signals | (1ll << sig);
+}
+
 void cron() {
   if (master_flag == -1 && getppid() == 1) {
     turn_sigterm_on();
   }
   vk::singleton<ServerStats>::get().update_this_worker_stats();
   vk::singleton<statshouse::WorkerStatsBuffer>::get().flush_if_needed();
+  vk::singleton<SamplingProfiler>::get().flush_samples();
 }
 
 void reopen_json_log() {
@@ -1531,12 +1575,13 @@ void generic_event_loop(WorkerType worker_type, bool init_and_listen_rpc_port) n
   ksignal(SIGPIPE, SIG_IGN);
   ksignal(SIGINT, run_once ? sigint_immediate_handler : sigint_handler);
   ksignal(SIGUSR1, sigusr1_handler);
+  ksignal(SIGSAMPLINGPROFILER, sigsamplingprofiler_handler);
   ksignal(SIGPOLL, SIG_IGN);
 
   dl_allow_all_signals();
 
   vkprintf (1, "Server started\n");
-  for (int i = 0; !(pending_signals & ~((1ll << SIGUSR1) | (1ll << SIGHUP))); i++) {
+  for (int i = 0; !(pending_signals & ~((1ll << SIGUSR1) | (1ll << SIGHUP) | (1ll << SIGSAMPLINGPROFILER))); i++) {
     if (verbosity > 0 && !(i & 255)) {
       vkprintf (1, "epoll_work(): %d out of %d connections, network buffers: %d used, %d out of %d allocated\n",
                 active_connections, maxconn, NB_used, NB_alloc, NB_max);
@@ -1561,6 +1606,12 @@ void generic_event_loop(WorkerType worker_type, bool init_and_listen_rpc_port) n
       reopen_json_log();
     }
 
+    if (pending_signals & (1ll << SIGSAMPLINGPROFILER)) {
+      pending_signals = pending_signals & ~(1ll << SIGSAMPLINGPROFILER);
+
+      vk::singleton<SamplingProfiler>::get().toggle();
+    }
+
     if (now != prev_time) {
       prev_time = now;
       cron();
@@ -1632,6 +1683,7 @@ void start_server() {
 }
 
 void set_instance_cache_memory_limit(size_t limit);
+void set_instance_cache_snapshot_file(const char *file_name);
 const char *get_php_scripts_version() noexcept;
 char **get_runtime_options(int *count) noexcept;
 
@@ -1954,6 +2006,48 @@ int main_args_handler(int i, const char *long_option) {
       kprintf("--%s option: couldn't set prefix '%s'\n", long_option, optarg);
       return -1;
     }
+    case 2033: {
+      if (vk::singleton<JsonLogger>::get().set_log_ring_size(parse_memory_limit(optarg))) {
+        return 0;
+      }
+      kprintf("--%s option: couldn't parse argument or it's less than 64k\n", long_option);
+      return -1;
+    }
+    case 2034: {
+      set_instance_cache_snapshot_file(optarg);
+      return 0;
+    }
+    case 2035: {
+      if (vk::singleton<WorkersAutoscaler>::get().set_min_workers_count(atoll(optarg))) {
+        return 0;
+      }
+      kprintf("--%s option: couldn't parse argument\n", long_option);
+      return -1;
+    }
+    case 2036: {
+      const int chunks = atoi(optarg);
+      if (chunks < 0 || chunks > 64) {
+        kprintf("--%s option: expected a number from 0 to 64\n", long_option);
+        return -1;
+      }
+      kfs_bz_set_read_ahead(chunks);
+      return 0;
+    }
+    case 2037: {
+      return parse_numeric_option(long_option, 0U, 1024U, [](uint32_t size) {
+        vk::singleton<database_drivers::MysqlConnectionPool>::get().set_max_idle_connections(size);
+      });
+    }
+    case 2038: {
+      return parse_numeric_option(long_option, 1, 24 * 60 * 60, [](int seconds) {
+        vk::singleton<database_drivers::MysqlConnectionPool>::get().set_max_idle_time(std::chrono::seconds{seconds});
+      });
+    }
+    case 2039: {
+      return parse_numeric_option(long_option, 1, 7 * 24 * 60 * 60, [](int seconds) {
+        vk::singleton<database_drivers::MysqlConnectionPool>::get().set_max_lifetime(std::chrono::seconds{seconds});
+      });
+    }
     case 2011: {
       if (set_mysql_db_name(optarg)) {
         return 0;
@@ -2143,6 +2237,13 @@ int main_args_handler(int i, const char *long_option) {
       }
       return 0;
     }
+    case 2032: {
+      if (vk::singleton<SamplingProfiler>::get().set_log_prefix(optarg)) {
+        return 0;
+      }
+      kprintf("--%s option: couldn't set prefix '%s'\n", long_option, optarg);
+      return -1;
+    }
     default:
       return -1;
   }
@@ -2214,6 +2315,7 @@ void parse_main_args(int argc, char *argv[]) {
   parse_option("php-version", no_argument, 2008, "show the compiled php code version and exit");
   parse_option("php-warnings-minimal-verbosity", required_argument, 2009, "set minimum verbosity level for php warnings");
   parse_option("profiler-log-prefix", required_argument, 2010, "set profier log path perfix");
+  parse_option("sampling-profiler-log-prefix", required_argument, 2032, "set sampling profiler log path prefix, the profiler is toggled by SIGRTMIN+3 (e.g. via engine.sendSignal)");
   parse_option("mysql-db-name", required_argument, 2011, "database name of MySQL to connect");
   parse_option("net-dc-mask", required_argument, 2012, "a string formatted like '8=1.2.3.4/12' to detect a datacenter by ipv4");
   parse_option("warmup-workers-ratio", required_argument, 2013, "the ratio of the instance cache warming up workers during the graceful restart");
@@ -2243,6 +2345,19 @@ void parse_main_args(int argc, char *argv[]) {
   parse_option("sigterm-wait-time", required_argument, 2029, "Time to wait before termination on SIGTERM");
   parse_option("job-workers-shared-memory-size-process-multiplier", required_argument, 2030, "Per process memory size used to calculate the total size of shared memory for job workers related communication:\n"
                                                                                              "memory limit = per_process_memory * processes_count");
+  parse_option("json-log-ring-size", required_argument, 2033, "size of the shared memory ring of each worker for warnings in the json log: if set, workers don't write them,\n"
+                                                              "the master writes them to its json log once a second, deduplicated by message and trace");
+  parse_option("instance-cache-snapshot-file", required_argument, 2034, "file for instance cache elements of serializable classes: the old master saves them there on graceful restart,\n"
+                                                                        "and workers of the new master restore them on misses");
+  parse_option("workers-autoscaling-min", required_argument, 2035, "enables autoscaling of general workers: the master runs from this number of them up to the number set by --workers-num,\n"
+                                                                   "depending on how many of them are busy, the accept queue length and the net time ratio of requests");
+  parse_option("zipped-binlog-read-ahead", required_argument, 2036, "count of chunks (16MB each) of zipped confdata binlogs decoded ahead by background threads while the binlog is replayed,\n"
+                                                                    "each of them takes a buffer of about 33MB until the replay ends, i.e. about 100MB by default;\n"
+                                                                    "0 disables it (default 3)");
+  parse_option("pdo-mysql-pool-size", required_argument, 2037, "max count of idle authenticated PDO MySQL connections per host, port, database and user kept by each worker\n"
+                                                              "between requests, 0 disables pooling (default)");
+  parse_option("pdo-mysql-pool-max-idle-time", required_argument, 2038, "pooled PDO MySQL connections idle for longer are closed, in seconds (default 60)");
+  parse_option("pdo-mysql-pool-max-lifetime", required_argument, 2039, "pooled PDO MySQL connections older than this are closed, in seconds (default 3600)");
   parse_option("job-workers-shared-messages-process-multiplier", required_argument, 2031, "Coefficient used to calculate the total count of the shared messages for job workers related communication:\n"
                                                                                           "messages count = coefficient * processes_count");
   parse_engine_options_long(argc, argv, main_args_handler);
@@ -27,6 +27,14 @@ struct command_net_write_t {
   long long extra;
 };
 
+// the rpc request, which waits for a connection, @see net_queries_data::rpc_send
+struct command_net_write_rpc_t {
+  command_t base;
+
+  raw_message_t request;
+  slot_id_t slot_id;
+};
+
 void server_rpc_error(connection *c, long long req_id, int code, const char *str);
 
 void http_return(connection *c, const char *str, int len);
@@ -43,6 +51,8 @@ extern command_t command_net_write_rpc_base;
 extern conn_target_t rpc_ct;
 
 void send_rpc_query(connection *c, int op, long long id, int *q, int qsize) ubsan_supp("alignment");
+// takes the ownership of the request, the packet headers are prepended right in its buffers
+void send_rpc_query(connection *c, int op, long long id, raw_message_t *request);
 void on_net_event(int event_status);
 void create_delayed_send_query(conn_target_t *t, command_t *command, double finish_time);
 
@@ -67,6 +77,8 @@ data_reader_t *create_data_reader(connection *c, int data_len);
 void create_pnet_delayed_query(connection *http_conn, conn_target_t *t, net_ansgen_t *gen, double finish_time);
 void command_net_write_free(command_t *base_command);
 command_t *create_command_net_writer(const char *data, int data_len, command_t *base, long long extra);
+// takes the ownership of the request
+command_t *create_command_net_rpc_writer(raw_message_t *request, slot_id_t slot_id);
 connection *get_target_connection_force(conn_target_t *S);
 int pnet_query_timeout(conn_query *q);
 void reopen_json_log();
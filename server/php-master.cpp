@@ -55,6 +55,7 @@
 #include "server/cluster-name.h"
 #include "server/confdata-binlog-replay.h"
 #include "server/http-server-context.h"
+#include "server/json-logger.h"
 #include "server/php-engine-vars.h"
 #include "server/php-engine.h"
 #include "server/php-master-tl-handlers.h"
@@ -62,6 +63,7 @@
 #include "server/server-stats.h"
 #include "server/statshouse/add-metrics-batch.h"
 #include "server/statshouse/statshouse-client.h"
+#include "server/workers-autoscaler.h"
 #include "server/workers-control.h"
 #include "server/lease-rpc-client.h"
 
@@ -317,6 +319,13 @@ void sigusr1_handler(const int sig) {
   local_pending_signals = local_pending_signals | (1ll << sig);
 }
 
+void sigsamplingprofiler_handler(const int sig) {
+  const char message[] = "got SIGSAMPLINGPROFILER, forward it to workers.\n";
+  kwrite(2, message, sizeof(message) - (size_t)1);
+
+  local_pending_signals = local_pending_signals | (1ll << sig);
+}
+
 /**
  * Description of states:
  * on                       - main working state: reruns terminated workers, communicates with old master during graceful restart
@@ -508,6 +517,9 @@ WorkerType start_master() {
   dl_passert (signal_fd >= 0, "failed to create signalfd");
 
   ksignal(SIGUSR1, sigusr1_handler);
+  ksignal(SIGSAMPLINGPROFILER, sigsamplingprofiler_handler);
+
+  vk::singleton<JsonLogger>::get().init_log_rings(vk::singleton<WorkersControl>::get().get_total_workers_count());
 
   //allow all signals except SIGPOLL, SIGCHLD and SIGTERM
   if (sigprocmask(SIG_SETMASK, &mask, &orig_mask) < 0) {
@@ -670,6 +682,7 @@ void remove_worker(pid_t pid) {
   for (int i = 0; i < workers_control.get_all_alive(); i++) {
     if (workers[i]->pid == pid) {
       vk::singleton<WorkersControl>::get().on_worker_removing(workers[i]->type, workers[i]->is_dying, workers[i]->unique_id);
+      vk::singleton<ServerStats>::get().reset_worker_status(workers[i]->unique_id);
       if (workers[i]->type == WorkerType::general_worker && !workers[i]->is_dying) {
         failed++;
       }
@@ -1065,6 +1078,8 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, stats_tag_kphp_server) {
   stats->add_gauge_stat("workers.general.processes.working", general_worker_group.running_workers);
   stats->add_gauge_stat("workers.general.processes.working_but_waiting", general_worker_group.waiting_workers);
   stats->add_gauge_stat("workers.general.processes.ready_for_accept", general_worker_group.ready_for_accept_workers);
+  stats->add_gauge_stat("workers.general.processes.autoscaling_target",
+                        vk::singleton<WorkersAutoscaler>::get().get_target_workers_count(general_worker_group.total_workers));
 
   const auto job_worker_group = vk::singleton<ServerStats>::get().collect_workers_stat(WorkerType::job_worker);
   stats->add_gauge_stat("workers.job.processes.total", job_worker_group.total_workers);
@@ -1111,6 +1126,10 @@ STATS_PROVIDER_TAGGED(kphp_stats, 100, stats_tag_kphp_server) {
   stats->add_gauge_stat(instance_cache_element_stats.elements_cached, "instance_cache.elements.cached");
   stats->add_gauge_stat(instance_cache_element_stats.elements_logically_expired_and_ignored, "instance_cache.elements.logically_expired_and_ignored");
   stats->add_gauge_stat(instance_cache_element_stats.elements_logically_expired_but_fetched, "instance_cache.elements.logically_expired_but_fetched");
+  stats->add_gauge_stat(instance_cache_element_stats.elements_restored_from_snapshot, "instance_cache.elements.restored_from_snapshot");
+  stats->add_gauge_stat(instance_cache_element_stats.memory_magazines_created, "instance_cache.memory.magazines_created");
+  stats->add_gauge_stat(instance_cache_element_stats.memory_magazine_refills, "instance_cache.memory.magazine_refills");
+  stats->add_gauge_stat(instance_cache_element_stats.memory_magazines_taken, "instance_cache.memory.magazines_taken");
 
   write_confdata_stats_to(stats);
   vk::singleton<ServerStats>::get().write_stats_to(stats);
@@ -1288,8 +1307,13 @@ void run_master_on() {
 
   if (done) {
     const auto &control = vk::singleton<WorkersControl>::get();
+    const int general_workers = vk::singleton<WorkersAutoscaler>::get().get_target_workers_count(control.get_count(WorkerType::general_worker));
     const int total_workers = control.get_alive_count(WorkerType::general_worker) + (other->is_alive ? other->running_http_workers_n + other->dying_http_workers_n : 0);
-    to_run = std::max(0, int{control.get_count(WorkerType::general_worker)} - total_workers);
+    to_run = std::max(0, general_workers - total_workers);
+    if (!other->is_alive) {
+      // the autoscaling target has been decreased
+      to_kill = std::max(0, int{control.get_running_count(WorkerType::general_worker)} - general_workers);
+    }
     job_workers_to_run = control.get_count(WorkerType::job_worker) - control.get_alive_count(WorkerType::job_worker);
 
     if (other->is_alive) {
@@ -1358,6 +1382,7 @@ static void cron() {
   }
   create_all_outbound_connections();
   vk::singleton<ServerStats>::get().aggregate_stats();
+  vk::singleton<JsonLogger>::get().flush_log_rings();
 
   unsigned long long cpu_total = 0;
   unsigned long long utime = 0;
@@ -1387,6 +1412,17 @@ static void cron() {
   const auto job_workers_stat = vk::singleton<ServerStats>::get().collect_workers_stat(WorkerType::job_worker);
   server_stats.update_misc_stat_for_job_workers(MiscStatTimestamp{my_now, job_workers_stat.running_workers});
 
+  if (state == master_state::on && !other->is_alive) {
+    WorkersAutoscaler::Signals signals;
+    signals.running_workers = general_workers_stat.running_workers;
+    signals.accept_queue_length = WorkersAutoscaler::get_accept_queue_length(vk::singleton<HttpServerContext>::get().http_socket_fds());
+    const auto queries_time = vk::singleton<ServerStats>::get().get_total_queries_time(WorkerType::general_worker);
+    signals.script_time_ns = queries_time.script_time_ns;
+    signals.net_time_ns = queries_time.net_time_ns;
+    vk::singleton<WorkersAutoscaler>::get().update(signals, vk::singleton<WorkersControl>::get().get_count(WorkerType::general_worker),
+                                                   static_cast<uint32_t>(cpu_cnt));
+  }
+
   utime += dead_utime;
   stime += dead_stime;
   CpuStatTimestamp cpu_timestamp{my_now, utime, stime, cpu_total};
@@ -1539,6 +1575,11 @@ WorkerType run_master() {
 
     shared_data_unlock(shared_data);
 
+    // the new master is already alive, its workers restore elements from the snapshot on misses
+    if (state != prev_state && state == master_state::off_in_graceful_restart) {
+      instance_cache_save_snapshot();
+    }
+
     if (to_exit) {
       vkprintf(1, "all workers killed. Exit\n");
       _exit(0);
@@ -1552,6 +1593,12 @@ WorkerType run_master() {
       workers_send_signal(SIGUSR1);
     }
 
+    if (local_pending_signals & (1ll << SIGSAMPLINGPROFILER)) {
+      local_pending_signals = local_pending_signals & ~(1ll << SIGSAMPLINGPROFILER);
+
+      workers_send_signal(SIGSAMPLINGPROFILER);
+    }
+
     vkprintf(2, "run_master iteration: end\n");
 
     using namespace std::chrono_literals;
@@ -179,6 +179,7 @@ int php_worker_http_load_post_impl(PhpWorker *worker, char *buf, int min_len, in
   }
 
   //  fprintf (stderr, "%d bytes loaded\n", read);
+  worker->loaded_http_post_len += read;
   return read;
 }
 
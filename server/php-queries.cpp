@@ -12,12 +12,14 @@
 #include <type_traits>
 
 #include "common/precise-time.h"
+#include "common/rpc-headers.h"
 #include "common/wrappers/overloaded.h"
 
 #include "net/net-buffers.h"
 #include "net/net-connections.h"
 
 #include "runtime/allocator.h"
+#include "runtime/critical_section.h"
 #include "runtime/job-workers/processing-jobs.h"
 #include "runtime/rpc.h"
 
@@ -917,8 +919,9 @@ net_query_t *pop_net_query() {
   return net_queries.pop();
 }
 
-void free_rpc_send_query(const net_queries_data::rpc_send &query) {
-  dl::deallocate(query.request, query.request_size);
+void free_rpc_send_query(net_queries_data::rpc_send &query) {
+  dl::CriticalSectionGuard critical_section;
+  rwm_free(&query.request);
 }
 
 /*** main functions ***/
@@ -968,19 +971,38 @@ void http_send_immediate_response(const char *headers, int headers_len, const ch
   }
 }
 
-slot_id_t rpc_send_query(int host_num, char *request, int request_size, int timeout_ms) {
+slot_id_t rpc_send_query(int host_num, const iovec *request_parts, int request_parts_count, int timeout_ms) {
   net_query_t *query = create_net_query();
   if (query == nullptr) {
     return -1; // memory limit
   }
+
+  net_queries_data::rpc_send rpc_query{host_num, {}, timeout_ms};
+  {
+    dl::CriticalSectionGuard critical_section;
+    rwm_init(&rpc_query.request, 0);
+    for (int i = 0; i < request_parts_count; ++i) {
+      const int part_size = static_cast<int>(request_parts[i].iov_len);
+      if (rwm_push_data(&rpc_query.request, request_parts[i].iov_base, part_size) != part_size) {
+        // net buffers are limited by allocated_buffer_bytes_limit and shared by all queries of the worker
+        rwm_free(&rpc_query.request);
+        unalloc_net_query(query);
+        php_warning("Can't send rpc query: net buffers are exhausted");
+        return -1;
+      }
+    }
+  }
+
+  // the slot is created last: request ids of the script must be sequential, so a failed query mustn't take one
   query->slot_id = rpc_ids_factory.create_slot();
   if (query->slot_id == -1) {
+    free_rpc_send_query(rpc_query);
     unalloc_net_query(query);
     return -1;
   }
 
-  PhpQueriesStats::get_rpc_queries_stat().register_query(request_size);
-  query->data = net_queries_data::rpc_send{ host_num, request, request_size, timeout_ms };
+  PhpQueriesStats::get_rpc_queries_stat().register_query(static_cast<int>(sizeof(RpcHeaders) + sizeof(int)) + rpc_query.request.total_bytes);
+  query->data = rpc_query;
   return query->slot_id;
 }
 
@@ -1110,7 +1132,12 @@ void php_queries_finish() {
   clear_slots();
 
   net_events.clear();
-  net_queries.clear();
+  // the queries, which haven't been sent by the finished script, still own their net buffers
+  while (net_query_t *query = net_queries.pop()) {
+    if (auto *rpc_query = std::get_if<net_queries_data::rpc_send>(&query->data)) {
+      free_rpc_send_query(*rpc_query);
+    }
+  }
 }
 
 const char *net_event_t::get_description() const noexcept {
@@ -10,6 +10,7 @@
 #include <variant>
 
 #include "common/sanitizer.h"
+#include "net/net-msg.h"
 #include "server/slot-ids-factory.h"
 #include "server/php-queries-types.h"
 
@@ -57,8 +58,9 @@ namespace net_queries_data {
 
 struct rpc_send {
   int host_num{};
-  char *request{};
-  int request_size{};
+  // [ RpcExtraHeaders (optional) ] [ payload ], it's allocated in net buffers;
+  // the headers and the crc32 are added on sending
+  raw_message_t request{};
   int timeout_ms{};
 };
 
@@ -284,7 +286,7 @@ int alloc_net_event(slot_id_t slot_id, net_event_t **res);
 void unalloc_net_event(net_event_t *event);
 
 net_query_t *pop_net_query();
-void free_rpc_send_query(const net_queries_data::rpc_send &query);
+void free_rpc_send_query(net_queries_data::rpc_send &query);
 
 int create_rpc_error_event(slot_id_t slot_id, int error_code, const char *error_message, net_event_t **res);
 int create_rpc_answer_event(slot_id_t slot_id, int len, net_event_t **res);
@@ -321,7 +323,8 @@ void script_error();
 void finish_script(int exit_code);
 void http_send_immediate_response(const char *headers, int headers_len, const char *body, int body_len);
 int rpc_connect_to(const char *host_name, int port);
-slot_id_t rpc_send_query(int host_num, char *request, int request_len, int timeout_ms);
+// the request parts are copied into net buffers right away, so they may be reused after the call
+slot_id_t rpc_send_query(int host_num, const iovec *request_parts, int request_parts_count, int timeout_ms);
 void wait_net_events(int timeout_ms);
 net_event_t *pop_net_event();
 const net_event_t *get_last_net_event();
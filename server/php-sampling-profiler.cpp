@@ -0,0 +1,274 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/php-sampling-profiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "common/dl-utils-lite.h"
+#include "common/kprintf.h"
+#include "runtime/sampling-profiler.h"
+#include "server/php-runner.h"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define SAMPLING_PROFILER_SUPPORTED 1
+
+// the top of the main stack, it's set by glibc on start
+extern "C" void *__libc_stack_end;
+
+// the section bounds are defined by the linker; weak, as there may be no symbols at all
+extern "C" const PhpFunctionSymbol __start_kphp_php_function_symbols[] __attribute__((weak));
+extern "C" const PhpFunctionSymbol __stop_kphp_php_function_symbols[] __attribute__((weak));
+#else
+#define SAMPLING_PROFILER_SUPPORTED 0
+#endif
+
+namespace {
+
+#if SAMPLING_PROFILER_SUPPORTED
+// frame pointers are never omitted (see compiler flags), each frame starts with a saved frame pointer and a return address
+struct FrameRecord {
+  const FrameRecord *prev;
+  void *return_address;
+};
+
+// the lowest possible address of the main stack, it's calculated by the stack size limit on start
+const char *main_stack_bottom = nullptr;
+
+void init_main_stack_bottom() noexcept {
+  constexpr rlim_t MAX_MAIN_STACK_SIZE = 1 << 30;
+  rlimit stack_limit{};
+  getrlimit(RLIMIT_STACK, &stack_limit);
+  const rlim_t stack_size = std::min(stack_limit.rlim_cur, MAX_MAIN_STACK_SIZE);
+  main_stack_bottom = static_cast<const char *>(__libc_stack_end) - stack_size;
+}
+
+// a frame pointer of the interrupted code is not trusted: it may be used as a general register by a leaf libc function;
+// frames are walked only inside the stack that contains the interrupted stack pointer (the script one or the main one),
+// all the memory between the stack pointer and the stack top is mapped
+const char *get_stack_top(const char *sp) noexcept {
+  const PhpScript *script = PhpScript::current_script;
+  if (script && script->run_stack <= sp && sp < script->run_stack_end) {
+    return script->run_stack_end;
+  }
+  const auto *main_stack_end = static_cast<const char *>(__libc_stack_end);
+  if (main_stack_bottom <= sp && sp <= main_stack_end) {
+    return main_stack_end;
+  }
+  return nullptr;
+}
+
+int collect_frames(void *ucontext, void **frames, int max_depth) noexcept {
+  const auto &mcontext = static_cast<const ucontext_t *>(ucontext)->uc_mcontext;
+#if defined(__x86_64__)
+  auto *pc = reinterpret_cast<void *>(mcontext.gregs[REG_RIP]);
+  const auto *frame = reinterpret_cast<const FrameRecord *>(mcontext.gregs[REG_RBP]);
+  const auto *sp = reinterpret_cast<const char *>(mcontext.gregs[REG_RSP]);
+#else
+  auto *pc = reinterpret_cast<void *>(mcontext.pc);
+  const auto *frame = reinterpret_cast<const FrameRecord *>(mcontext.regs[29]);
+  const auto *sp = reinterpret_cast<const char *>(mcontext.sp);
+#endif
+
+  int depth = 0;
+  frames[depth++] = pc;
+  const char *stack_top = get_stack_top(sp);
+  while (stack_top && depth < max_depth
+         && reinterpret_cast<const char *>(frame) >= sp && reinterpret_cast<const char *>(frame + 1) <= stack_top
+         && !(reinterpret_cast<uintptr_t>(frame) & (sizeof(void *) - 1))) {
+    frames[depth++] = frame->return_address;
+    if (frame->prev <= frame) {
+      break;
+    }
+    frame = frame->prev;
+  }
+  return depth;
+}
+#endif
+
+class FrameNames {
+public:
+  FrameNames() {
+#if SAMPLING_PROFILER_SUPPORTED
+    for (const PhpFunctionSymbol *symbol = __start_kphp_php_function_symbols; symbol != __stop_kphp_php_function_symbols; ++symbol) {
+      php_symbols_.emplace(symbol->address, symbol);
+    }
+#endif
+  }
+
+  // is_return_address: a call may be the last instruction of a function, the previous byte is inside the caller for sure
+  const std::string *get_php_name(void *address, bool is_return_address) {
+    const void *function_start = get_function_start(address, is_return_address);
+    auto it = php_symbols_.find(function_start);
+    if (it == php_symbols_.end()) {
+      return nullptr;
+    }
+    auto name_it = names_.find(function_start);
+    if (name_it == names_.end()) {
+      const PhpFunctionSymbol *symbol = it->second;
+      std::string name = std::string{symbol->function_name} + " (" + symbol->file_name + ":" + std::to_string(symbol->line) + ")";
+      name_it = names_.emplace(function_start, std::move(name)).first;
+    }
+    return &name_it->second;
+  }
+
+  std::string get_native_name(void *address) {
+    Dl_info info{};
+    if (!dladdr(address, &info) || !info.dli_sname) {
+      return "[native]";
+    }
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    std::string name{status == 0 && demangled ? demangled : info.dli_sname};
+    free(demangled);
+    return name;
+  }
+
+private:
+  static const void *get_function_start(void *address, bool is_return_address) {
+    Dl_info info{};
+    void *lookup_address = is_return_address ? static_cast<char *>(address) - 1 : address;
+    return dladdr(lookup_address, &info) ? info.dli_saddr : nullptr;
+  }
+
+  std::unordered_map<const void *, const PhpFunctionSymbol *> php_symbols_;
+  std::unordered_map<const void *, std::string> names_;
+};
+
+} // namespace
+
+bool SamplingProfiler::set_log_prefix(const char *prefix) noexcept {
+  // reserve 128 bytes for pid + timestamp
+  if (!*prefix || strlen(prefix) + 128 > PATH_MAX) {
+    return false;
+  }
+  log_prefix_ = prefix;
+  return true;
+}
+
+void SamplingProfiler::toggle() noexcept {
+  if (!SAMPLING_PROFILER_SUPPORTED) {
+    kprintf("sampling profiler is not supported on this platform\n");
+    return;
+  }
+  if (!log_prefix_) {
+    kprintf("sampling profiler can't be started: --sampling-profiler-log-prefix is not set\n");
+    return;
+  }
+  if (running_) {
+    stop();
+  } else {
+    start();
+  }
+}
+
+void SamplingProfiler::start() noexcept {
+  pending_samples_ = std::make_unique<Sample[]>(MAX_PENDING_SAMPLES);
+  pending_samples_count_ = 0;
+  lost_samples_count_ = 0;
+  stacks_.clear();
+  running_ = true;
+
+#if SAMPLING_PROFILER_SUPPORTED
+  init_main_stack_bottom();
+#endif
+  dl_sigaction(SIGPROF, nullptr, dl_get_empty_sigset(), SA_SIGINFO | SA_RESTART, sigprof_handler);
+  const itimerval timer{.it_interval{0, 1000000 / SAMPLES_PER_SECOND}, .it_value{0, 1000000 / SAMPLES_PER_SECOND}};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  kprintf("sampling profiler is started\n");
+}
+
+void SamplingProfiler::stop() noexcept {
+  const itimerval timer{.it_interval{0, 0}, .it_value{0, 0}};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  flush_samples();
+  running_ = false;
+  pending_samples_.reset();
+
+  char file_name[PATH_MAX];
+  snprintf(file_name, sizeof(file_name), "%s.%d.%ld.folded", log_prefix_, static_cast<int>(getpid()), static_cast<long>(time(nullptr)));
+  FILE *out = fopen(file_name, "w");
+  if (!out) {
+    kprintf("sampling profiler can't open '%s': %s\n", file_name, strerror(errno));
+    return;
+  }
+  write_folded_stacks(out);
+  fclose(out);
+  kprintf("sampling profiler is stopped, %zu stacks are written to '%s', %zu samples are lost\n", stacks_.size(), file_name, lost_samples_count_);
+  stacks_.clear();
+}
+
+void SamplingProfiler::flush_samples() noexcept {
+  if (!running_) {
+    return;
+  }
+
+  sigset_t sigprof_set, old_set;
+  sigemptyset(&sigprof_set);
+  sigaddset(&sigprof_set, SIGPROF);
+  sigprocmask(SIG_BLOCK, &sigprof_set, &old_set);
+  for (size_t i = 0; i < pending_samples_count_; ++i) {
+    const Sample &sample = pending_samples_[i];
+    ++stacks_[std::vector<void *>(sample.frames, sample.frames + sample.depth)];
+  }
+  pending_samples_count_ = 0;
+  sigprocmask(SIG_SETMASK, &old_set, nullptr);
+}
+
+void SamplingProfiler::sigprof_handler(int, siginfo_t *, void *ucontext) noexcept {
+#if SAMPLING_PROFILER_SUPPORTED
+  auto &self = vk::singleton<SamplingProfiler>::get();
+  if (!self.running_) {
+    return;
+  }
+  if (self.pending_samples_count_ == MAX_PENDING_SAMPLES) {
+    ++self.lost_samples_count_;
+    return;
+  }
+  Sample &sample = self.pending_samples_[self.pending_samples_count_];
+  sample.depth = collect_frames(ucontext, sample.frames, MAX_STACK_DEPTH);
+  self.pending_samples_count_ = self.pending_samples_count_ + 1;
+#else
+  static_cast<void>(ucontext);
+#endif
+}
+
+// only php frames are kept, native ones are dropped except for the leaf (it shows where a builtin or the runtime spends time);
+// samples outside of a script (e.g. a worker waiting for network) have no php frames at all
+void SamplingProfiler::write_folded_stacks(FILE *out) const noexcept {
+  FrameNames frame_names;
+  std::map<std::string, uint64_t> folded;
+  std::string line;
+  for (const auto &stack_and_count : stacks_) {
+    const std::vector<void *> &frames = stack_and_count.first;
+    line.clear();
+    for (size_t i = frames.size(); i-- > 1;) {
+      if (const std::string *php_name = frame_names.get_php_name(frames[i], true)) {
+        line.append(*php_name).push_back(';');
+      }
+    }
+    if (const std::string *php_name = frame_names.get_php_name(frames[0], false)) {
+      line.append(*php_name);
+    } else {
+      line.append(line.empty() ? "[worker];" : "").append(frame_names.get_native_name(frames[0]));
+    }
+    folded[line] += stack_and_count.second;
+  }
+
+  for (const auto &line_and_count : folded) {
+    fprintf(out, "%s %" PRIu64 "\n", line_and_count.first.c_str(), line_and_count.second);
+  }
+}
@@ -0,0 +1,58 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <csignal>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+#include "common/smart_ptrs/singleton.h"
+
+// Always available sampling profiler for workers, it doesn't need a special build (unlike the tracing one, see runtime/profiler.h).
+// It's switched on and off by SIGSAMPLINGPROFILER at runtime: the master forwards it to all workers (e.g. engine.sendSignal).
+// While running, native stacks are sampled by SIGPROF (by cpu time) and mapped to php functions by symbols emitted by codegen.
+// On stop, stacks are written in the folded format (`f1;f2;f3 count`) to a file per worker:
+// they can be concatenated to get the whole picture and passed to flamegraph.pl or converted to pprof.
+class SamplingProfiler : vk::not_copyable {
+public:
+  bool set_log_prefix(const char *prefix) noexcept;
+
+  void toggle() noexcept;
+  // moves samples collected in the signal handler to the aggregated stacks, called from the worker cron
+  void flush_samples() noexcept;
+
+private:
+  static constexpr int SAMPLES_PER_SECOND = 99;
+  static constexpr int MAX_STACK_DEPTH = 64;
+  static constexpr size_t MAX_PENDING_SAMPLES = 1024;
+
+  struct Sample {
+    int depth;
+    void *frames[MAX_STACK_DEPTH];
+  };
+
+  SamplingProfiler() = default;
+
+  void start() noexcept;
+  void stop() noexcept;
+  void write_folded_stacks(FILE *out) const noexcept;
+
+  static void sigprof_handler(int signum, siginfo_t *info, void *ucontext) noexcept;
+
+  const char *log_prefix_{nullptr};
+  bool running_{false};
+
+  // written by the signal handler only, SIGPROF is blocked while they are read
+  std::unique_ptr<Sample[]> pending_samples_;
+  volatile size_t pending_samples_count_{0};
+  size_t lost_samples_count_{0};
+
+  std::map<std::vector<void *>, uint64_t> stacks_;
+
+  friend class vk::singleton<SamplingProfiler>;
+};
@@ -151,7 +151,7 @@ void PhpWorker::state_init_script() noexcept {
   state = phpq_run;
 }
 
-void php_worker_run_rpc_send_query(int32_t request_id, const net_queries_data::rpc_send &query) {
+void php_worker_run_rpc_send_query(int32_t request_id, net_queries_data::rpc_send &query) {
   int connection_id = query.host_num;
   slot_id_t slot_id = request_id;
   if (connection_id < 0 || connection_id >= MAX_TARGETS) {
@@ -162,7 +162,9 @@ void php_worker_run_rpc_send_query(int32_t request_id, const net_queries_data::r
   connection *conn = get_target_connection(target, 0);
 
   if (conn != nullptr) {
-    send_rpc_query(conn, TL_RPC_INVOKE_REQ, slot_id, reinterpret_cast<int *>(query.request), query.request_size);
+    raw_message_t request;
+    rwm_steal(&request, &query.request);
+    send_rpc_query(conn, TL_RPC_INVOKE_REQ, slot_id, &request);
     conn->last_query_sent_time = precise_now;
   } else {
     int new_conn_cnt = create_new_connections(target);
@@ -171,7 +173,7 @@ void php_worker_run_rpc_send_query(int32_t request_id, const net_queries_data::r
       return;
     }
 
-    command_t *command = create_command_net_writer(query.request, query.request_size, &command_net_write_rpc_base, slot_id);
+    command_t *command = create_command_net_rpc_writer(&query.request, slot_id);
     double timeout = fix_timeout(query.timeout_ms * 0.001) + precise_now;
     create_delayed_send_query(target, command, timeout);
   }
@@ -182,7 +184,7 @@ void php_worker_run_net_queue(PhpWorker *worker __attribute__((unused))) {
   while ((query = pop_net_query()) != nullptr) {
     // no other types of query are currently supported
     std::visit(overloaded{
-                 [&](const net_queries_data::rpc_send &data) {
+                 [&](net_queries_data::rpc_send &data) {
                    php_worker_run_rpc_send_query(query->slot_id, data);
                    free_rpc_send_query(data);
                  },
@@ -366,6 +368,11 @@ void PhpWorker::set_result(script_result *res) noexcept {
   }
 }
 
+bool PhpWorker::has_unread_http_post() const noexcept {
+  const http_query_data *http_data = data ? data->http_data : nullptr;
+  return http_data && http_data->post == nullptr && loaded_http_post_len < http_data->post_len;
+}
+
 void PhpWorker::state_free_script() noexcept {
   php_worker_run_flag = 0;
   int f = 0;
@@ -444,6 +451,7 @@ PhpWorker::PhpWorker(php_worker_mode_t mode_, connection *c, http_query_data *ht
   , state(phpq_try_start)
   , mode(mode_)
   , req_id(req_id_)
+  , loaded_http_post_len(0)
 {
   assert(c != nullptr);
   if (conn->target) {
@@ -57,6 +57,9 @@ public:
   long long req_id;
   int target_fd;
 
+  // bytes of a long http POST body that are read from the connection by the script, see http_load_long_query()
+  int loaded_http_post_len;
+
   PhpWorker(php_worker_mode_t mode_, connection *c, http_query_data *http_data, rpc_query_data *rpc_data, job_query_data *job_data,
              long long req_id_, double timeout);
   ~PhpWorker();
@@ -73,6 +76,9 @@ public:
   void on_wakeup() noexcept;
   void set_result(script_result *res) noexcept;
 
+  // the script hasn't read the whole long POST body, so the rest of it is left in the connection
+  bool has_unread_http_post() const noexcept;
+
 private:
   void state_try_start() noexcept;
   void state_init_script() noexcept;
@@ -72,6 +72,16 @@ struct JobCommonMemorySamples : WithStatType<uint64_t> {
   };
 };
 
+struct MysqlPoolStat : WithStatType<uint64_t> {
+  enum class Key {
+    reused_connections = 0,
+    created_connections,
+    reset_failed_connections,
+    expired_connections,
+    types_count
+  };
+};
+
 struct MallocStat : WithStatType<uint64_t> {
   enum class Key {
     non_mmaped_allocated_bytes = 0,
@@ -294,7 +304,14 @@ struct WorkerSharedStats : private vk::not_copyable {
 
   std::array<std::atomic<uint32_t>, static_cast<size_t>(script_error_t::errors_count)> errors{};
 
+  void add_mysql_pool_stats(const EnumTable<MysqlPoolStat> &stat) noexcept {
+    for (size_t i = 0; i != stat.size(); ++i) {
+      mysql_pool_stat[i].fetch_add(stat[i], std::memory_order_relaxed);
+    }
+  }
+
   EnumTable<QueriesStat, std::atomic<QueriesStat::StatType>> total_queries_stat;
+  EnumTable<MysqlPoolStat, std::atomic<MysqlPoolStat::StatType>> mysql_pool_stat;
   SharedSamplesBundle<ScriptSamples> script_samples;
 };
 
@@ -635,6 +652,17 @@ void ServerStats::add_job_common_memory_stats(int64_t common_request_memory_used
   vk::singleton<WorkerStatsBuffer>::get().add_query_stat(QueryStatKey::job_common_request_real_memory_usage, common_request_real_memory_used);
 }
 
+void ServerStats::add_mysql_pool_stats(uint64_t reused_connections, uint64_t created_connections,
+                                       uint64_t reset_failed_connections, uint64_t expired_connections) noexcept {
+  auto &stats = worker_type_ == WorkerType::job_worker ? shared_stats_->job_workers : shared_stats_->general_workers;
+  EnumTable<MysqlPoolStat> stat;
+  stat[MysqlPoolStat::Key::reused_connections] = reused_connections;
+  stat[MysqlPoolStat::Key::created_connections] = created_connections;
+  stat[MysqlPoolStat::Key::reset_failed_connections] = reset_failed_connections;
+  stat[MysqlPoolStat::Key::expired_connections] = expired_connections;
+  stats.add_mysql_pool_stats(stat);
+}
+
 void ServerStats::update_this_worker_stats() noexcept {
   const auto now_tp = std::chrono::steady_clock::now();
   if (now_tp - last_update_ >= std::chrono::seconds{5}) {
@@ -736,6 +764,11 @@ void write_to(stats_t *stats, const char *prefix, const WorkerAggregatedStats &a
   stats->add_gauge_stat(shared.total_queries_stat[QueriesStat::Key::outgoing_queries], prefix, ".requests.total_outgoing_queries");
   stats->add_gauge_stat(shared.total_queries_stat[QueriesStat::Key::outgoing_long_queries], prefix, ".requests.total_outgoing_long_queries");
 
+  stats->add_gauge_stat(shared.mysql_pool_stat[MysqlPoolStat::Key::reused_connections], prefix, ".pdo_mysql_pool.reused_connections");
+  stats->add_gauge_stat(shared.mysql_pool_stat[MysqlPoolStat::Key::created_connections], prefix, ".pdo_mysql_pool.created_connections");
+  stats->add_gauge_stat(shared.mysql_pool_stat[MysqlPoolStat::Key::reset_failed_connections], prefix, ".pdo_mysql_pool.reset_failed_connections");
+  stats->add_gauge_stat(shared.mysql_pool_stat[MysqlPoolStat::Key::expired_connections], prefix, ".pdo_mysql_pool.expired_connections");
+
   write_to(stats, prefix, ".requests.outgoing_queries", agg.script_samples[ScriptSamples::Key::outgoing_queries]);
   write_to(stats, prefix, ".requests.outgoing_long_queries", agg.script_samples[ScriptSamples::Key::outgoing_long_queries]);
   write_to(stats, prefix, ".requests.script_time", agg.script_samples[ScriptSamples::Key::script_time], ns2double);
@@ -899,3 +932,15 @@ ServerStats::WorkersStat ServerStats::collect_workers_stat(WorkerType worker_typ
 uint64_t ServerStats::get_worker_activity_counter(uint16_t worker_process_id) const noexcept {
   return shared_stats_->workers.misc_stats.get_stat(MiscStat::Key::worker_activity_counter, worker_process_id);
 }
+
+void ServerStats::reset_worker_status(uint16_t worker_process_id) noexcept {
+  shared_stats_->workers.update_worker_status(MiscStat::worker_idle, worker_process_id);
+}
+
+ServerStats::QueriesTime ServerStats::get_total_queries_time(WorkerType worker_type) const noexcept {
+  const auto &stats = worker_type == WorkerType::job_worker ? shared_stats_->job_workers : shared_stats_->general_workers;
+  QueriesTime result;
+  result.script_time_ns = stats.total_queries_stat[QueriesStat::Key::script_time].load(std::memory_order_relaxed);
+  result.net_time_ns = stats.total_queries_stat[QueriesStat::Key::net_time].load(std::memory_order_relaxed);
+  return result;
+}
@@ -24,6 +24,9 @@ public:
   void add_job_stats(double job_wait_time_sec, int64_t request_memory_used, int64_t request_real_memory_used, int64_t response_memory_used,
                      int64_t response_real_memory_used) noexcept;
   void add_job_common_memory_stats(int64_t common_request_memory_used, int64_t common_request_real_memory_used) noexcept;
+  // totals of the PDO MySQL connection pool since the previous call, @see database_drivers::MysqlConnectionPool
+  void add_mysql_pool_stats(uint64_t reused_connections, uint64_t created_connections,
+                            uint64_t reset_failed_connections, uint64_t expired_connections) noexcept;
   void update_this_worker_stats() noexcept;
   void update_active_connections(uint64_t active_connections, uint64_t max_connections) noexcept;
 
@@ -40,6 +43,8 @@ public:
   void write_stats_to(std::ostream &os, bool add_worker_pids) const noexcept;
 
   uint64_t get_worker_activity_counter(uint16_t worker_process_id) const noexcept;
+  // the status of a removed worker mustn't be counted until its id is reused
+  void reset_worker_status(uint16_t worker_process_id) noexcept;
 
   struct WorkersStat {
     uint16_t running_workers{0};
@@ -49,6 +54,12 @@ public:
   };
   WorkersStat collect_workers_stat(WorkerType worker_type) const noexcept;
 
+  struct QueriesTime {
+    uint64_t script_time_ns{0};
+    uint64_t net_time_ns{0};
+  };
+  QueriesTime get_total_queries_time(WorkerType worker_type) const noexcept;
+
 private:
   friend class vk::singleton<ServerStats>;
 
@@ -3,6 +3,7 @@ prepend(KPHP_SERVER_SOURCES ${BASE_DIR}/server/
         confdata-binlog-replay.cpp
         confdata-stats.cpp
         http-server-context.cpp
+        json-log-rings.cpp
         json-logger.cpp
         lease-config-parser.cpp
         lease-rpc-client.cpp
@@ -18,12 +19,14 @@ prepend(KPHP_SERVER_SOURCES ${BASE_DIR}/server/
         php-queries-types.cpp
         php-query-data.cpp
         php-runner.cpp
+        php-sampling-profiler.cpp
         php-init-scripts.cpp
         php-sql-connections.cpp
         php-worker.cpp
         server-log.cpp
         server-stats.cpp
         slot-ids-factory.cpp
+        workers-autoscaler.cpp
         workers-control.cpp
         statshouse/statshouse-client.cpp
         statshouse/add-metrics-batch.cpp
@@ -46,7 +49,8 @@ prepend(KPHP_DATABASE_DRIVERS_MYSQL_SOURCES ${BASE_DIR}/server/database-drivers/
         mysql-request.cpp
         mysql-connector.cpp
         mysql-response.cpp
-        mysql-resources.cpp)
+        mysql-resources.cpp
+        mysql-connection-pool.cpp)
 
 set(KPHP_SERVER_ALL_SOURCES
     ${KPHP_SERVER_SOURCES}
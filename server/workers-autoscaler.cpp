@@ -0,0 +1,110 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#include "server/workers-autoscaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "common/kprintf.h"
+#include "server/workers-control.h"
+
+namespace {
+
+// the part of workers that are expected to be busy, the rest is a spare capacity for load spikes
+constexpr double TARGET_BUSY_RATIO = 0.75;
+// the smoothing factor of the running workers average, it's updated once a second
+constexpr double RUNNING_WORKERS_AVG_ALPHA = 0.2;
+constexpr double NET_TIME_RATIO_ALPHA = 0.2;
+// workers that wait for the network don't use cpu, but a cpu bound load is not served faster by more workers than cpus
+constexpr double MIN_SCRIPT_TIME_RATIO = 0.1;
+constexpr uint32_t SCALE_DOWN_DELAY_SEC = 60;
+// the part of workers that may be terminated at once
+constexpr double SCALE_DOWN_STEP = 0.1;
+// the part of workers that is added at once when connections wait in the accept queue
+constexpr double SCALE_UP_STEP = 0.25;
+
+} // namespace
+
+bool WorkersAutoscaler::set_min_workers_count(int64_t min_workers_count) noexcept {
+  if (min_workers_count <= 0 || min_workers_count > WorkersControl::max_workers_count) {
+    return false;
+  }
+  min_workers_count_ = static_cast<uint16_t>(min_workers_count);
+  return true;
+}
+
+uint16_t WorkersAutoscaler::get_target_workers_count(uint16_t max_workers_count) const noexcept {
+  if (!is_enabled() || !target_workers_count_) {
+    return max_workers_count;
+  }
+  return std::min(target_workers_count_, max_workers_count);
+}
+
+void WorkersAutoscaler::update(const Signals &signals, uint16_t max_workers_count, uint32_t cpu_count) noexcept {
+  if (!is_enabled()) {
+    return;
+  }
+  const uint16_t min_workers_count = std::min(min_workers_count_, max_workers_count);
+  const uint16_t target = get_target_workers_count(max_workers_count);
+
+  running_workers_avg_ += RUNNING_WORKERS_AVG_ALPHA * (signals.running_workers - running_workers_avg_);
+  const uint64_t script_time_ns = signals.script_time_ns - std::min(prev_script_time_ns_, signals.script_time_ns);
+  const uint64_t net_time_ns = signals.net_time_ns - std::min(prev_net_time_ns_, signals.net_time_ns);
+  if (script_time_ns + net_time_ns) {
+    const double net_time_ratio = static_cast<double>(net_time_ns) / static_cast<double>(script_time_ns + net_time_ns);
+    net_time_ratio_ += NET_TIME_RATIO_ALPHA * (net_time_ratio - net_time_ratio_);
+  }
+  prev_script_time_ns_ = signals.script_time_ns;
+  prev_net_time_ns_ = signals.net_time_ns;
+
+  const double busy_workers = std::max(running_workers_avg_, static_cast<double>(signals.running_workers));
+  auto desired = static_cast<uint32_t>(std::ceil(busy_workers / TARGET_BUSY_RATIO));
+  if (signals.accept_queue_length) {
+    desired = std::max(desired, target + std::max(1U, static_cast<uint32_t>(std::ceil(target * SCALE_UP_STEP))));
+  }
+  const double cpu_bound_limit = std::ceil(cpu_count / std::max(1.0 - net_time_ratio_, MIN_SCRIPT_TIME_RATIO));
+  desired = std::min(desired, std::max(static_cast<uint32_t>(target), static_cast<uint32_t>(cpu_bound_limit)));
+  desired = std::clamp(desired, uint32_t{min_workers_count}, uint32_t{max_workers_count});
+
+  uint16_t new_target = target;
+  if (desired > target) {
+    new_target = static_cast<uint16_t>(desired);
+    low_load_seconds_ = 0;
+  } else if (desired < target) {
+    if (++low_load_seconds_ >= SCALE_DOWN_DELAY_SEC) {
+      const auto step = std::max(1U, static_cast<uint32_t>(target * SCALE_DOWN_STEP));
+      new_target = static_cast<uint16_t>(std::max(desired, target - step));
+      low_load_seconds_ = 0;
+    }
+  } else {
+    low_load_seconds_ = 0;
+  }
+
+  if (new_target != target) {
+    vkprintf(1, "workers autoscaling: [target = %d -> %d] [running avg = %.2f] [accept queue = %u] [net time ratio = %.2f]\n",
+             int{target}, int{new_target}, running_workers_avg_, signals.accept_queue_length, net_time_ratio_);
+  }
+  target_workers_count_ = new_target;
+}
+
+uint32_t WorkersAutoscaler::get_accept_queue_length(const std::vector<int> &listening_fds) noexcept {
+  uint32_t length = 0;
+#if defined(__linux__)
+  for (int fd : listening_fds) {
+    // for a listening socket, tcpi_unacked is the current length of the accept queue
+    tcp_info info{};
+    socklen_t info_size = sizeof(info);
+    if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &info_size) == 0) {
+      length += info.tcpi_unacked;
+    }
+  }
+#else
+  static_cast<void>(listening_fds);
+#endif
+  return length;
+}
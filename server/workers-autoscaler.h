@@ -0,0 +1,56 @@
+// Compiler for PHP (aka KPHP)
+// Copyright (c) 2021 LLC «V Kontakte»
+// Distributed under the GPL v3 License, see LICENSE.notice.txt
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/mixin/not_copyable.h"
+#include "common/smart_ptrs/singleton.h"
+
+// Autoscaling of general workers: the master keeps from --workers-autoscaling-min to --workers-num of them running.
+// The target grows as soon as workers are busy or connections wait in the accept queue,
+// and shrinks slowly after a minute of low load: superfluous workers are terminated gracefully, returning their memory.
+// A worker is forked from the master in milliseconds, so the spare capacity is kept as idle running workers (see TARGET_BUSY_RATIO)
+// rather than as parked processes.
+class WorkersAutoscaler : vk::not_copyable {
+public:
+  struct Signals {
+    uint16_t running_workers{0};
+    uint32_t accept_queue_length{0};
+    // total since the start, over all general workers
+    uint64_t script_time_ns{0};
+    uint64_t net_time_ns{0};
+  };
+
+  bool set_min_workers_count(int64_t min_workers_count) noexcept;
+
+  bool is_enabled() const noexcept {
+    return min_workers_count_ != 0;
+  }
+
+  // max_workers_count is the count of general workers (--workers-num minus job workers)
+  uint16_t get_target_workers_count(uint16_t max_workers_count) const noexcept;
+
+  // is called by the master once a second, while it's not in a graceful restart
+  void update(const Signals &signals, uint16_t max_workers_count, uint32_t cpu_count) noexcept;
+
+  static uint32_t get_accept_queue_length(const std::vector<int> &listening_fds) noexcept;
+
+private:
+  WorkersAutoscaler() = default;
+
+  friend class vk::singleton<WorkersAutoscaler>;
+
+  uint16_t min_workers_count_{0};
+  // 0 until the first update, all the workers are run on start
+  uint16_t target_workers_count_{0};
+  uint32_t low_load_seconds_{0};
+
+  double running_workers_avg_{0};
+  double net_time_ratio_{0};
+  uint64_t prev_script_time_ns_{0};
+  uint64_t prev_net_time_ns_{0};
+};
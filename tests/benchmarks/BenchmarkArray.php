@@ -0,0 +1,125 @@
+<?php
+
+class BenchmarkArray {
+  private static $N = 10000;
+
+  /** @var int[] */
+  private static $int_map = [];
+  /** @var int[] */
+  private static $string_map = [];
+
+  private static function fill() {
+    if (!self::$int_map) {
+      for ($i = 0; $i < self::$N; $i++) {
+        self::$int_map[$i * 7] = $i;
+        self::$string_map["key_$i"] = $i;
+      }
+    }
+  }
+
+  public function benchmarkBuildIntMap() {
+    $a = [];
+    for ($i = 0; $i < self::$N; $i++) {
+      $a[$i * 7] = $i;
+    }
+    return count($a);
+  }
+
+  public function benchmarkBuildStringMap() {
+    $a = [];
+    for ($i = 0; $i < self::$N; $i++) {
+      $a["key_$i"] = $i;
+    }
+    return count($a);
+  }
+
+  public function benchmarkMapMemory() {
+    $before = memory_get_usage();
+    $a = [];
+    for ($i = 0; $i < self::$N; $i++) {
+      $a["key_$i"] = $i;
+      $a[$i * 7] = $i;
+    }
+    return memory_get_usage() - $before + count($a);
+  }
+
+  public function benchmarkIterateIntMap() {
+    self::fill();
+    $sum = 0;
+    foreach (self::$int_map as $k => $v) {
+      $sum += $k + $v;
+    }
+    return $sum;
+  }
+
+  public function benchmarkIterateStringMap() {
+    self::fill();
+    $sum = 0;
+    foreach (self::$string_map as $k => $v) {
+      $sum += strlen($k) + $v;
+    }
+    return $sum;
+  }
+
+  public function benchmarkIterateAfterUnset() {
+    self::fill();
+    $a = self::$int_map;
+    for ($i = 0; $i < self::$N; $i += 2) {
+      unset($a[$i * 7]);
+    }
+    $sum = 0;
+    foreach ($a as $v) {
+      $sum += $v;
+    }
+    return $sum;
+  }
+
+  public function benchmarkFind() {
+    self::fill();
+    $found = 0;
+    for ($i = 0; $i < self::$N; $i++) {
+      if (isset(self::$string_map["key_$i"])) {
+        $found++;
+      }
+      if (isset(self::$int_map[$i])) {
+        $found++;
+      }
+    }
+    return $found;
+  }
+
+  public function benchmarkFindAbsent() {
+    self::fill();
+    $found = 0;
+    for ($i = 0; $i < self::$N; $i++) {
+      if (isset(self::$string_map["absent_$i"])) {
+        $found++;
+      }
+      if (isset(self::$int_map[$i * 7 + 3])) {
+        $found++;
+      }
+    }
+    return $found;
+  }
+
+  public function benchmarkQueue() {
+    $a = [];
+    for ($i = 0; $i < self::$N; $i++) {
+      $a["key_$i"] = $i;
+      if ($i % 3 == 0) {
+        array_shift($a);
+      }
+    }
+    return count($a);
+  }
+
+  public function benchmarkPopFromMap() {
+    self::fill();
+    $a = self::$string_map;
+    $sum = 0;
+    while ($a) {
+      $sum += array_pop($a);
+    }
+    return $sum;
+  }
+}
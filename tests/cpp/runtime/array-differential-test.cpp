@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "runtime/kphp_core.h"
+
+namespace {
+
+struct RefKey {
+  bool is_string{false};
+  int64_t int_key{0};
+  std::string string_key;
+
+  bool operator==(const RefKey &other) const {
+    return is_string == other.is_string && (is_string ? string_key == other.string_key : int_key == other.int_key);
+  }
+};
+
+// the reference ordered map: elements are kept in the insertion order as php arrays do
+class RefArray {
+public:
+  void set(const RefKey &key, int64_t value) {
+    auto it = find(key);
+    if (it != elements_.end()) {
+      it->second = value;
+    } else {
+      elements_.emplace_back(key, value);
+    }
+  }
+
+  void unset(const RefKey &key) {
+    auto it = find(key);
+    if (it != elements_.end()) {
+      elements_.erase(it);
+    }
+  }
+
+  std::vector<std::pair<RefKey, int64_t>>::iterator find(const RefKey &key) {
+    return std::find_if(elements_.begin(), elements_.end(), [&key](const auto &e) { return e.first == key; });
+  }
+
+  void renumber_int_keys() {
+    int64_t next_key = 0;
+    for (auto &e : elements_) {
+      if (!e.first.is_string) {
+        e.first.int_key = next_key++;
+      }
+    }
+  }
+
+  std::vector<std::pair<RefKey, int64_t>> elements_;
+};
+
+string to_string_key(const std::string &s) {
+  return string(s.c_str(), static_cast<string::size_type>(s.size()));
+}
+
+void expect_same(const array<int64_t> &arr, RefArray &ref) {
+  const auto &elements = ref.elements_;
+  ASSERT_EQ(arr.count(), static_cast<int64_t>(elements.size()));
+
+  size_t i = 0;
+  for (auto it = arr.begin(); it != arr.end(); ++it, ++i) {
+    ASSERT_LT(i, elements.size());
+    const RefKey &key = elements[i].first;
+    ASSERT_EQ(it.is_string_key(), key.is_string);
+    if (key.is_string) {
+      ASSERT_EQ(std::string(it.get_string_key().c_str(), it.get_string_key().size()), key.string_key);
+    } else {
+      ASSERT_EQ(it.get_key().as_int(), key.int_key);
+    }
+    ASSERT_EQ(it.get_value(), elements[i].second);
+  }
+  ASSERT_EQ(i, elements.size());
+
+  // backward iteration must stop on the first alive element even if the deleted ones are before it
+  auto it = arr.end();
+  for (size_t j = elements.size(); j > 0; --j) {
+    --it;
+    ASSERT_EQ(it.get_value(), elements[j - 1].second);
+  }
+  ASSERT_EQ(it, arr.begin());
+
+  const auto size = static_cast<int64_t>(elements.size());
+  for (int64_t n = -size; n < size; n += 1 + size / 7) {
+    ASSERT_EQ(arr.middle(n).get_value(), elements[n < 0 ? n + size : n].second);
+  }
+
+  for (const auto &e : elements) {
+    const int64_t *value = e.first.is_string ? arr.find_value(to_string_key(e.first.string_key)) : arr.find_value(e.first.int_key);
+    ASSERT_TRUE(value);
+    ASSERT_EQ(*value, e.second);
+    if (!e.first.is_string) {
+      ASSERT_GT(arr.get_next_key(), e.first.int_key);
+    }
+  }
+  ASSERT_FALSE(arr.find_value(int64_t{1} << 40));
+  ASSERT_FALSE(arr.find_value(string{"absent"}));
+}
+
+// applies the same operation to the array which is shared and to the one which isn't,
+// the result mustn't depend on the reference counter
+class DifferentialTest {
+public:
+  explicit DifferentialTest(uint64_t seed) :
+    rng_(seed),
+    keys_range_(1 + rng_() % 200) {
+  }
+
+  void run(int steps) {
+    for (int step = 0; step < steps; ++step) {
+      do_step();
+      ASSERT_EQ(shared_.get_next_key(), unshared_.get_next_key()) << "step " << step;
+      if (step % 16 == 0) {
+        ASSERT_NO_FATAL_FAILURE(expect_same(shared_, ref_)) << "step " << step;
+        ASSERT_NO_FATAL_FAILURE(expect_same(unshared_, ref_)) << "step " << step;
+      }
+    }
+    ASSERT_NO_FATAL_FAILURE(expect_same(shared_, ref_));
+    ASSERT_NO_FATAL_FAILURE(expect_same(unshared_, ref_));
+  }
+
+private:
+  template<class F>
+  void apply(F &&f) {
+    const array<int64_t> holder = shared_;
+    f(shared_);
+    f(unshared_);
+  }
+
+  RefKey random_int_key() {
+    return RefKey{false, static_cast<int64_t>(rng_() % keys_range_) - (rng_() % 10 == 0 ? 5 : 0), {}};
+  }
+
+  RefKey random_string_key() {
+    return RefKey{true, 0, "s" + std::to_string(rng_() % keys_range_)};
+  }
+
+  void do_step() {
+    const auto op = rng_() % 100;
+    const auto value = static_cast<int64_t>(rng_() % 1000);
+    if (op < 25) {
+      const RefKey key = random_int_key();
+      apply([&](array<int64_t> &arr) { arr.set_value(key.int_key, value); });
+      ref_.set(key, value);
+    } else if (op < 45) {
+      const RefKey key = random_string_key();
+      apply([&](array<int64_t> &arr) { arr.set_value(to_string_key(key.string_key), value); });
+      ref_.set(key, value);
+    } else if (op < 55) {
+      const RefKey key{false, unshared_.get_next_key(), {}};
+      apply([&](array<int64_t> &arr) { arr.push_back(value); });
+      ref_.set(key, value);
+    } else if (op < 75) {
+      const RefKey key = rng_() % 2 ? random_int_key() : random_string_key();
+      apply([&](array<int64_t> &arr) {
+        key.is_string ? arr.unset(to_string_key(key.string_key)) : arr.unset(key.int_key);
+      });
+      ref_.unset(key);
+    } else if (op < 82) {
+      if (ref_.elements_.empty()) {
+        return;
+      }
+      apply([&](array<int64_t> &arr) { ASSERT_EQ(arr.pop(), ref_.elements_.back().second); });
+      ref_.elements_.pop_back();
+    } else if (op < 86) {
+      if (ref_.elements_.empty()) {
+        return;
+      }
+      apply([&](array<int64_t> &arr) { ASSERT_EQ(arr.shift(), ref_.elements_.front().second); });
+      ref_.elements_.erase(ref_.elements_.begin());
+      ref_.renumber_int_keys();
+    } else if (op < 90) {
+      apply([&](array<int64_t> &arr) { arr.unshift(value); });
+      ref_.elements_.insert(ref_.elements_.begin(), {RefKey{}, value});
+      ref_.renumber_int_keys();
+    } else if (op < 94) {
+      array<int64_t> other;
+      RefArray other_ref;
+      for (int i = 0; i < 5; ++i) {
+        const RefKey key = random_string_key();
+        other.set_value(to_string_key(key.string_key), i);
+        other_ref.set(key, i);
+      }
+      apply([&](array<int64_t> &arr) { arr += other; });
+      for (const auto &e : other_ref.elements_) {
+        if (ref_.find(e.first) == ref_.elements_.end()) {
+          ref_.set(e.first, e.second);
+        }
+      }
+    } else {
+      const auto size = ref_.elements_.size();
+      apply([&](array<int64_t> &arr) { arr.reserve(size + 50, 0, false); });
+    }
+  }
+
+  std::mt19937_64 rng_;
+  uint64_t keys_range_;
+  RefArray ref_;
+  array<int64_t> shared_;
+  array<int64_t> unshared_;
+};
+
+} // namespace
+
+TEST(array_differential_test, random_operations_match_reference) {
+  std::mt19937_64 rng(42);
+  for (int round = 0; round < 200; ++round) {
+    const uint64_t seed = rng();
+    DifferentialTest test{seed};
+    ASSERT_NO_FATAL_FAILURE(test.run(static_cast<int>(rng() % 2000))) << "seed " << seed;
+  }
+}
+
+TEST(array_differential_test, next_key_does_not_depend_on_sharing) {
+  array<int64_t> shared;
+  array<int64_t> unshared;
+  for (int64_t i = 0; i < 10; ++i) {
+    shared.set_value(string{"key"}, i);
+    unshared.set_value(string{"key"}, i);
+    shared.set_value(i * 10, i);
+    unshared.set_value(i * 10, i);
+  }
+  shared.unset(int64_t{90});
+  unshared.unset(int64_t{90});
+
+  const array<int64_t> holder = shared;
+  shared.unset(string{"key"});
+  unshared.unset(string{"key"});
+
+  ASSERT_EQ(shared.get_next_key(), unshared.get_next_key());
+  ASSERT_EQ(shared.get_next_key(), 91);
+}
+
+TEST(array_differential_test, backward_iteration_skips_deleted_head) {
+  array<int64_t> arr;
+  for (int64_t i = 0; i < 8; ++i) {
+    arr.set_value(string{std::to_string(i).append("_").c_str()}, i);
+  }
+  for (int64_t i = 0; i < 7; ++i) {
+    arr.unset(string{std::to_string(i).append("_").c_str()});
+  }
+
+  auto it = arr.end();
+  --it;
+  ASSERT_EQ(it, arr.begin());
+  ASSERT_EQ(it.get_value(), 7);
+  ASSERT_EQ(arr.middle(-1).get_value(), 7);
+  ASSERT_EQ(arr.pop(), 7);
+  ASSERT_EQ(arr.count(), 0);
+}
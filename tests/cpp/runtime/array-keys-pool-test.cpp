@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "runtime/array-keys-pool.h"
+#include "runtime/kphp_core.h"
+
+TEST(array_keys_pool_test, test_equal_keys_share_string) {
+  auto &pool = vk::singleton<ArrayKeysPool>::get();
+  const char input[] = "user_id user_id";
+  const ArrayKeysPool::Key key1 = pool.intern(input, 7);
+  const ArrayKeysPool::Key key2 = pool.intern(input + 8, 7);
+
+  ASSERT_EQ(key1.str, string{"user_id"});
+  ASSERT_EQ(key1.str.c_str(), key2.str.c_str());
+  ASSERT_FALSE(key1.is_int);
+  ASSERT_EQ(key1.int_key, string{"user_id"}.hash());
+}
+
+TEST(array_keys_pool_test, test_int_keys) {
+  auto &pool = vk::singleton<ArrayKeysPool>::get();
+  const ArrayKeysPool::Key key = pool.intern("-123", 4);
+  ASSERT_TRUE(key.is_int);
+  ASSERT_EQ(key.int_key, -123);
+
+  const ArrayKeysPool::Key not_int_key = pool.intern("0123", 4);
+  ASSERT_FALSE(not_int_key.is_int);
+}
+
+TEST(array_keys_pool_test, test_long_keys_are_not_interned) {
+  auto &pool = vk::singleton<ArrayKeysPool>::get();
+  const string long_key{"a key that is much longer than the maximal length of interned keys"};
+  ASSERT_GT(long_key.size(), ArrayKeysPool::MAX_KEY_LENGTH);
+
+  const ArrayKeysPool::Key key1 = pool.intern(long_key.c_str(), long_key.size());
+  const ArrayKeysPool::Key key2 = pool.intern(long_key.c_str(), long_key.size());
+  ASSERT_EQ(key1.str, long_key);
+  ASSERT_EQ(key2.str, long_key);
+  ASSERT_NE(key1.str.c_str(), key2.str.c_str());
+  ASSERT_EQ(key1.int_key, long_key.hash());
+}
+
+TEST(array_keys_pool_test, test_set_value_to) {
+  auto &pool = vk::singleton<ArrayKeysPool>::get();
+  array<int64_t> arr;
+  pool.intern("name", 4).set_value_to(arr, 1);
+  pool.intern("42", 2).set_value_to(arr, 2);
+  pool.intern("name", 4).set_value_to(arr, 3);
+
+  ASSERT_EQ(arr.count(), 2);
+  ASSERT_EQ(arr.get_value(string{"name"}), 3);
+  ASSERT_EQ(arr.get_value(42), 2);
+  ASSERT_TRUE(arr.isset(string{"name"}));
+}
@@ -132,3 +132,98 @@ TEST(array_test, test_mutate_shared_map) {
   ASSERT_EQ(arr_copy.get_reference_counter(), 1);
   ASSERT_FALSE(arr_copy.is_equal_inner_pointer(arr));
 }
+
+TEST(array_test, test_map_order_after_unset) {
+  array<int> arr;
+  for (int i = 0; i < 100; ++i) {
+    arr.set_value(string{"key_"}.append(int64_t{i}), i);
+    arr.set_value(1000 + i, i);
+  }
+  ASSERT_FALSE(arr.is_vector());
+
+  for (int i = 0; i < 100; i += 2) {
+    arr.unset(string{"key_"}.append(int64_t{i}));
+    arr.unset(1000 + i + 1);
+  }
+  ASSERT_EQ(arr.count(), 100);
+  // the deleted keys are added to the end again
+  arr.set_value(string{"key_0"}, -1);
+  arr.set_value(1001, -1);
+
+  int expected = 0;
+  for (auto it = arr.begin(); it != arr.end(); ++it) {
+    if (expected < 100) {
+      ASSERT_EQ(it.is_string_key(), expected % 2 == 1);
+      ASSERT_EQ(it.get_value(), expected);
+    }
+    ++expected;
+  }
+  ASSERT_EQ(expected, 102);
+  ASSERT_TRUE(equals(arr.middle(-2).get_key(), mixed{string{"key_0"}}));
+  ASSERT_TRUE(equals(arr.middle(-1).get_key(), mixed{1001}));
+  ASSERT_TRUE(equals(arr.middle(1).get_key(), mixed{string{"key_1"}}));
+  ASSERT_EQ(arr.pop(), -1);
+  ASSERT_EQ(arr.pop(), -1);
+
+  for (int i = 0; i < 100; ++i) {
+    const int *value = arr.find_value(string{"key_"}.append(int64_t{i}));
+    ASSERT_EQ(value != nullptr, i % 2 == 1);
+    value = arr.find_value(1000 + i);
+    ASSERT_EQ(value != nullptr, i % 2 == 0);
+  }
+}
+
+TEST(array_test, test_map_reuses_deleted_entries) {
+  array<int> arr;
+  arr.set_value(string{"key"}, 0);
+  for (int i = 0; i < 10000; ++i) {
+    arr.set_value(i, i);
+    arr.unset(i);
+  }
+  ASSERT_EQ(arr.count(), 1);
+  ASSERT_EQ(arr.get_next_key(), 10000);
+
+  for (int i = 0; i < 10000; ++i) {
+    arr.set_value(i, i);
+    if (i % 3) {
+      arr.unset(i);
+    }
+  }
+  int64_t expected = 0;
+  for (auto it = arr.begin(); it != arr.end(); ++it) {
+    if (it.is_string_key()) {
+      continue;
+    }
+    ASSERT_EQ(it.get_int_key(), expected);
+    expected += 3;
+  }
+  ASSERT_EQ(expected, 10002);
+}
+
+TEST(array_test, test_map_sort) {
+  array<int> arr{
+    std::make_pair(mixed{string{"c"}}, 1),
+    std::make_pair(mixed{5}, 3),
+    std::make_pair(mixed{string{"a"}}, 2),
+    std::make_pair(mixed{1}, 0),
+  };
+  arr.unset(string{"c"});
+  arr.set_value(string{"b"}, 4);
+
+  arr.sort([](int lhs, int rhs) { return lhs - rhs; }, false);
+  int64_t expected_values[] = {0, 2, 3, 4};
+  int i = 0;
+  for (auto it = arr.begin(); it != arr.end(); ++it) {
+    ASSERT_EQ(it.get_value(), expected_values[i++]);
+  }
+  ASSERT_EQ(*arr.find_value(string{"a"}), 2);
+
+  arr.ksort([](const mixed &lhs, const mixed &rhs) { return lhs.to_string().compare(rhs.to_string()); });
+  const char *expected_keys[] = {"1", "5", "a", "b"};
+  i = 0;
+  for (auto it = arr.begin(); it != arr.end(); ++it) {
+    ASSERT_EQ(it.get_key().to_string(), string{expected_keys[i++]});
+  }
+  ASSERT_EQ(*arr.find_value(5), 3);
+  ASSERT_EQ(*arr.find_value(string{"b"}), 4);
+}
@@ -185,3 +185,32 @@ TEST(memory_chunk_tree_test, random_extract_smallest) {
   }
   ASSERT_FALSE(mem_chunk_tree.extract_smallest());
 }
+
+TEST(memory_chunk_tree_test, extract_at) {
+  memory_resource::details::memory_chunk_tree mem_chunk_tree;
+
+  char some_memory[1024 * 1024];
+  const auto chunk_sizes = prepare_test_sizes();
+  const auto chunk_offsets = make_offsets(chunk_sizes);
+
+  for (size_t i = 0; i < chunk_sizes.size(); ++i) {
+    mem_chunk_tree.insert(some_memory + chunk_offsets[i], chunk_sizes[i]);
+  }
+
+  ASSERT_FALSE(mem_chunk_tree.extract_at(some_memory + 8, 1));
+  ASSERT_FALSE(mem_chunk_tree.extract_at(some_memory, chunk_sizes[0] + 1));
+
+  // the chunks of the same sizes are in the tree and in the same size lists
+  for (size_t i = 0; i < chunk_sizes.size(); ++i) {
+    auto *mem = mem_chunk_tree.extract_at(some_memory + chunk_offsets[i], chunk_sizes[i]);
+    ASSERT_EQ(static_cast<void *>(mem), some_memory + chunk_offsets[i]);
+    ASSERT_EQ(memory_resource::details::memory_chunk_tree::get_chunk_size(mem), chunk_sizes[i]);
+    ASSERT_FALSE(mem_chunk_tree.extract_at(some_memory + chunk_offsets[i], 1));
+
+    // the rest of the tree is still valid
+    if (i + 1 < chunk_sizes.size()) {
+      ASSERT_TRUE(mem_chunk_tree.has_memory_for(*std::max_element(chunk_sizes.begin() + i + 1, chunk_sizes.end())));
+    }
+  }
+  ASSERT_FALSE(mem_chunk_tree.extract_smallest());
+}
@@ -292,4 +292,65 @@ TEST(unsynchronized_pool_resource_test, test_auto_defragmentation_small_piece) {
   ASSERT_EQ(mem_stats.small_memory_pieces, 0);
 
   resource.deallocate(mem64, 64);
-}
\ No newline at end of file
+}
+
+TEST(unsynchronized_pool_resource_test, reallocate_in_place_at_the_end) {
+  std::array<char, 1024*128> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+
+  resource.init(some_memory.data(), some_memory.size());
+
+  void *mem8 = resource.allocate(8);
+  void *mem = resource.allocate(16 * 1024);
+  ASSERT_EQ(resource.reallocate(mem, 32 * 1024, 16 * 1024), mem);
+  ASSERT_EQ(resource.reallocate(mem, 32 * 1024 + 8, 32 * 1024), mem);
+
+  auto mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.real_memory_used, 8 + 32 * 1024 + 8);
+  ASSERT_EQ(mem_stats.memory_used, 8 + 32 * 1024 + 8);
+
+  // the piece is not at the end anymore
+  void *mem8_2 = resource.allocate(8);
+  void *moved_mem = resource.reallocate(mem, 64 * 1024, 32 * 1024 + 8);
+  ASSERT_TRUE(moved_mem);
+  ASSERT_NE(moved_mem, mem);
+
+  mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.memory_used, 8 + 8 + 64 * 1024);
+  ASSERT_EQ(mem_stats.huge_memory_pieces, 1);
+
+  resource.deallocate(moved_mem, 64 * 1024);
+  resource.deallocate(mem8_2, 8);
+  resource.deallocate(mem8, 8);
+}
+
+TEST(unsynchronized_pool_resource_test, reallocate_in_place_over_next_huge_piece) {
+  std::array<char, 1024*128> some_memory{};
+  memory_resource::unsynchronized_pool_resource resource;
+
+  resource.init(some_memory.data(), some_memory.size());
+
+  void *mem = resource.allocate(32 * 1024);
+  void *next_mem = resource.allocate(64 * 1024);
+  void *mem8 = resource.allocate(8);
+  resource.deallocate(next_mem, 64 * 1024);
+
+  auto mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.huge_memory_pieces, 1);
+
+  // the rest of the next piece is put back
+  ASSERT_EQ(resource.reallocate(mem, 64 * 1024, 32 * 1024), mem);
+  mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.memory_used, 64 * 1024 + 8);
+  ASSERT_EQ(mem_stats.huge_memory_pieces, 1);
+  ASSERT_EQ(mem_stats.small_memory_pieces, 0);
+
+  // the next piece is taken whole
+  ASSERT_EQ(resource.reallocate(mem, 96 * 1024, 64 * 1024), mem);
+  mem_stats = resource.get_memory_stats();
+  ASSERT_EQ(mem_stats.memory_used, 96 * 1024 + 8);
+  ASSERT_EQ(mem_stats.huge_memory_pieces, 0);
+
+  resource.deallocate(mem, 96 * 1024);
+  resource.deallocate(mem8, 8);
+}
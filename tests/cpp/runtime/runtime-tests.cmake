@@ -1,6 +1,8 @@
 prepend(RUNTIME_TESTS_SOURCES ${BASE_DIR}/tests/cpp/runtime/
         _runtime-tests-env.cpp
         allocator-malloc-replacement-test.cpp
+        array-differential-test.cpp
+        array-keys-pool-test.cpp
         array-test.cpp
         common-php-functions-test.cpp
         confdata-functions-test.cpp
@@ -19,6 +21,7 @@ prepend(RUNTIME_TESTS_SOURCES ${BASE_DIR}/tests/cpp/runtime/
         memory_resource/unsynchronized_pool_resource-test.cpp
         string-list-test.cpp
         string-test.cpp
+        tl-builtins-test.cpp
         zstd-test.cpp)
 
 allow_deprecated_declarations_for_apple(${BASE_DIR}/tests/cpp/runtime/inter-process-mutex-test.cpp)
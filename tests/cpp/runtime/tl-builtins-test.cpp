@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "runtime/rpc.h"
+#include "runtime/tl/rpc_request.h"
+#include "runtime/tl/tl_builtins.h"
+
+namespace {
+
+template<class TlType>
+typename TlType::PhpType round_trip(TlType tl_type, const typename TlType::PhpType &value, size_t expected_stored_size) {
+  f$rpc_clean();
+  tl_type.typed_store(value);
+  const vk::string_view stored = rpc_get_stored_data();
+  EXPECT_EQ(stored.size(), expected_stored_size);
+
+  f$rpc_parse(string{stored.data(), static_cast<string::size_type>(stored.size())});
+  typename TlType::PhpType fetched;
+  tl_type.typed_fetch_to(fetched);
+  EXPECT_TRUE(f$fetch_eof());
+  return fetched;
+}
+
+template<class T>
+void expect_same_array(const array<T> &actual, const array<T> &expected) {
+  ASSERT_EQ(actual.count(), expected.count());
+  ASSERT_EQ(actual.is_vector(), expected.is_vector());
+  auto actual_it = actual.begin();
+  for (auto expected_it = expected.begin(); expected_it != expected.end(); ++expected_it, ++actual_it) {
+    ASSERT_TRUE(equals(actual_it.get_key(), expected_it.get_key()));
+    ASSERT_EQ(actual_it.get_value(), expected_it.get_value());
+  }
+}
+
+} // namespace
+
+TEST(tl_builtins_test, test_int_vector) {
+  array<int64_t> v;
+  for (int64_t x : {int64_t{0}, int64_t{1}, int64_t{-2}, int64_t{INT32_MAX}, int64_t{INT32_MIN}}) {
+    v.push_back(x);
+  }
+  // the size and then elements as int32
+  expect_same_array(round_trip(t_Vector<t_Int, 0>{t_Int{}}, v, 4 + 5 * 4), v);
+}
+
+TEST(tl_builtins_test, test_long_vector) {
+  array<int64_t> v;
+  for (int64_t x : {int64_t{1} << 40, int64_t{-3}, int64_t{INT64_MAX}, int64_t{INT64_MIN}}) {
+    v.push_back(x);
+  }
+  // the size and then elements as int64
+  expect_same_array(round_trip(t_Vector<t_Long, 0>{t_Long{}}, v, 4 + 4 * 8), v);
+}
+
+TEST(tl_builtins_test, test_double_vector) {
+  array<double> v;
+  for (double x : {0.0, -1.5, 1e300}) {
+    v.push_back(x);
+  }
+  expect_same_array(round_trip(t_Vector<t_Double, 0>{t_Double{}}, v, 4 + 3 * 8), v);
+}
+
+TEST(tl_builtins_test, test_empty_vectors) {
+  EXPECT_EQ(round_trip(t_Vector<t_Int, 0>{t_Int{}}, array<int64_t>{}, 4).count(), 0);
+  EXPECT_EQ(round_trip(t_Vector<t_Long, 0>{t_Long{}}, array<int64_t>{}, 4).count(), 0);
+  EXPECT_EQ(round_trip(t_Vector<t_Double, 0>{t_Double{}}, array<double>{}, 4).count(), 0);
+}
+
+TEST(tl_builtins_test, test_int_key_dictionaries) {
+  array<int64_t> long_values;
+  long_values.set_value(5, int64_t{1} << 40);
+  long_values.set_value(-3, 7);
+  long_values.set_value(0, -1);
+  // the size and then pairs of an int32 key and an int64 value, the order is kept
+  expect_same_array(round_trip(t_IntKeyDictionary<t_Long, 0>{t_Long{}}, long_values, 4 + 3 * (4 + 8)), long_values);
+
+  array<int64_t> int_values;
+  int_values.set_value(int64_t{1} << 40, -5);
+  int_values.set_value(2, INT32_MAX);
+  expect_same_array(round_trip(t_LongKeyDictionary<t_Int, 0>{t_Int{}}, int_values, 4 + 2 * (8 + 4)), int_values);
+
+  array<double> double_values;
+  double_values.set_value(10, 0.25);
+  double_values.set_value(9, -2.0);
+  expect_same_array(round_trip(t_IntKeyDictionary<t_Double, 0>{t_Double{}}, double_values, 4 + 2 * (4 + 8)), double_values);
+
+  EXPECT_EQ(round_trip(t_IntKeyDictionary<t_Int, 0>{t_Int{}}, array<int64_t>{}, 4).count(), 0);
+}
+
+TEST(tl_builtins_test, test_int_vector_with_overflow_is_stored_element_wise) {
+  array<int64_t> v;
+  v.push_back(1);
+  v.push_back(int64_t{1} << 40);
+  EXPECT_FALSE(store_raw_vector_int(v));
+}
@@ -0,0 +1,19 @@
+@ok
+<?php
+
+function test_json_decode_object_keys() {
+  $rows = json_decode('[{"id": 1, "name": "a"}, {"name": "b", "id": 2}, {"id": 3, "id": 4}]', true);
+  var_dump($rows);
+  foreach ($rows as $row) {
+    var_dump(isset($row["id"]), isset($row["name"]));
+  }
+
+  var_dump(json_decode('{"10": "int", "010": "string", "-5": "negative", "": "empty"}', true));
+  var_dump(json_decode('{"na\\u006de": 1, "name": 2, "a\\"b": 3}', true));
+  var_dump(json_decode('{"a key that is much longer than the maximal length of interned keys": true}', true));
+  var_dump(json_decode('{ "a" : 1 , "b"  :2}', true));
+  var_dump(json_decode('{"a": 1, 2: 2}', true));
+  var_dump(json_decode('{"a: 1}', true));
+}
+
+test_json_decode_object_keys();
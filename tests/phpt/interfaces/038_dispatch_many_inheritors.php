@@ -0,0 +1,42 @@
+@ok
+<?php
+
+interface Shape {
+  public function area(): int;
+  public function name(): string;
+}
+
+abstract class BaseShape implements Shape {
+  public function name(): string { return get_class($this); }
+}
+
+class Square extends BaseShape { public function area(): int { return 1; } }
+class Rect extends BaseShape { public function area(): int { return 2; } }
+class Circle extends BaseShape { public function area(): int { return 3; } }
+class Oval extends Circle {}
+class Triangle extends BaseShape { public function area(): int { return 4; } }
+class Rhombus extends Square { public function area(): int { return 5; } }
+class Hexagon extends BaseShape { public function area(): int { return 6; } }
+class Octagon extends Hexagon { public function name(): string { return "oct"; } }
+
+interface Single {
+  public function get(int $x): int;
+}
+
+class SingleImpl implements Single {
+  public function get(int $x): int { return $x * 2; }
+}
+
+class SingleImplChild extends SingleImpl {}
+
+/** @var Shape[] $shapes */
+$shapes = [new Square, new Rect, new Circle, new Oval, new Triangle, new Rhombus, new Hexagon, new Octagon];
+foreach ($shapes as $shape) {
+  echo $shape->name(), " ", $shape->area(), "\n";
+}
+
+/** @var Single[] $singles */
+$singles = [new SingleImpl, new SingleImplChild];
+foreach ($singles as $single) {
+  echo $single->get(21), "\n";
+}
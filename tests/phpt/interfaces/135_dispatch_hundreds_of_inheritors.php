@@ -0,0 +1,174 @@
+@ok
+<?php
+
+interface Op {
+  public function apply(int $x): int;
+  public function name(): string;
+}
+
+abstract class BaseOp implements Op {
+  public function name(): string { return get_class($this); }
+}
+
+abstract class NamedOp extends BaseOp {
+  public function name(): string { return "named " . get_class($this); }
+}
+
+class Op0 extends NamedOp { public function apply(int $x): int { return $x + 0; } }
+class Op1 extends BaseOp { public function apply(int $x): int { return $x + 1; } }
+class Op2 extends BaseOp { public function apply(int $x): int { return $x + 2; } }
+class Op3 extends BaseOp { public function apply(int $x): int { return $x + 3; } }
+class Op4 extends BaseOp { public function apply(int $x): int { return $x + 4; } }
+class Op5 extends BaseOp { public function apply(int $x): int { return $x + 5; } }
+class Op6 extends BaseOp { public function apply(int $x): int { return $x + 6; } }
+class Op7 extends BaseOp { public function apply(int $x): int { return $x + 7; } }
+class Op8 extends BaseOp { public function apply(int $x): int { return $x + 8; } }
+class Op9 extends BaseOp { public function apply(int $x): int { return $x + 9; } }
+class Op10 extends NamedOp { public function apply(int $x): int { return $x + 10; } }
+class Op11 extends BaseOp { public function apply(int $x): int { return $x + 11; } }
+class Op12 extends BaseOp { public function apply(int $x): int { return $x + 12; } }
+class Op13 extends BaseOp { public function apply(int $x): int { return $x + 13; } }
+class Op14 extends BaseOp { public function apply(int $x): int { return $x + 14; } }
+class Op15 extends BaseOp { public function apply(int $x): int { return $x + 15; } }
+class Op16 extends BaseOp { public function apply(int $x): int { return $x + 16; } }
+class Op17 extends BaseOp { public function apply(int $x): int { return $x + 17; } }
+class Op18 extends BaseOp { public function apply(int $x): int { return $x + 18; } }
+class Op19 extends BaseOp { public function apply(int $x): int { return $x + 19; } }
+class Op20 extends NamedOp { public function apply(int $x): int { return $x + 20; } }
+class Op21 extends BaseOp { public function apply(int $x): int { return $x + 21; } }
+class Op22 extends BaseOp { public function apply(int $x): int { return $x + 22; } }
+class Op23 extends BaseOp { public function apply(int $x): int { return $x + 23; } }
+class Op24 extends BaseOp { public function apply(int $x): int { return $x + 24; } }
+class Op25 extends BaseOp { public function apply(int $x): int { return $x + 25; } }
+class Op26 extends BaseOp { public function apply(int $x): int { return $x + 26; } }
+class Op27 extends BaseOp { public function apply(int $x): int { return $x + 27; } }
+class Op28 extends BaseOp { public function apply(int $x): int { return $x + 28; } }
+class Op29 extends BaseOp { public function apply(int $x): int { return $x + 29; } }
+class Op30 extends NamedOp { public function apply(int $x): int { return $x + 30; } }
+class Op31 extends BaseOp { public function apply(int $x): int { return $x + 31; } }
+class Op32 extends BaseOp { public function apply(int $x): int { return $x + 32; } }
+class Op33 extends BaseOp { public function apply(int $x): int { return $x + 33; } }
+class Op34 extends BaseOp { public function apply(int $x): int { return $x + 34; } }
+class Op35 extends BaseOp { public function apply(int $x): int { return $x + 35; } }
+class Op36 extends BaseOp { public function apply(int $x): int { return $x + 36; } }
+class Op37 extends BaseOp { public function apply(int $x): int { return $x + 37; } }
+class Op38 extends BaseOp { public function apply(int $x): int { return $x + 38; } }
+class Op39 extends BaseOp { public function apply(int $x): int { return $x + 39; } }
+class Op40 extends NamedOp { public function apply(int $x): int { return $x + 40; } }
+class Op41 extends BaseOp { public function apply(int $x): int { return $x + 41; } }
+class Op42 extends BaseOp { public function apply(int $x): int { return $x + 42; } }
+class Op43 extends BaseOp { public function apply(int $x): int { return $x + 43; } }
+class Op44 extends BaseOp { public function apply(int $x): int { return $x + 44; } }
+class Op45 extends BaseOp { public function apply(int $x): int { return $x + 45; } }
+class Op46 extends BaseOp { public function apply(int $x): int { return $x + 46; } }
+class Op47 extends BaseOp { public function apply(int $x): int { return $x + 47; } }
+class Op48 extends BaseOp { public function apply(int $x): int { return $x + 48; } }
+class Op49 extends BaseOp { public function apply(int $x): int { return $x + 49; } }
+class Op50 extends NamedOp { public function apply(int $x): int { return $x + 50; } }
+class Op51 extends BaseOp { public function apply(int $x): int { return $x + 51; } }
+class Op52 extends BaseOp { public function apply(int $x): int { return $x + 52; } }
+class Op53 extends BaseOp { public function apply(int $x): int { return $x + 53; } }
+class Op54 extends BaseOp { public function apply(int $x): int { return $x + 54; } }
+class Op55 extends BaseOp { public function apply(int $x): int { return $x + 55; } }
+class Op56 extends BaseOp { public function apply(int $x): int { return $x + 56; } }
+class Op57 extends BaseOp { public function apply(int $x): int { return $x + 57; } }
+class Op58 extends BaseOp { public function apply(int $x): int { return $x + 58; } }
+class Op59 extends BaseOp { public function apply(int $x): int { return $x + 59; } }
+class Op60 extends NamedOp { public function apply(int $x): int { return $x + 60; } }
+class Op61 extends BaseOp { public function apply(int $x): int { return $x + 61; } }
+class Op62 extends BaseOp { public function apply(int $x): int { return $x + 62; } }
+class Op63 extends BaseOp { public function apply(int $x): int { return $x + 63; } }
+class Op64 extends BaseOp { public function apply(int $x): int { return $x + 64; } }
+class Op65 extends BaseOp { public function apply(int $x): int { return $x + 65; } }
+class Op66 extends BaseOp { public function apply(int $x): int { return $x + 66; } }
+class Op67 extends BaseOp { public function apply(int $x): int { return $x + 67; } }
+class Op68 extends BaseOp { public function apply(int $x): int { return $x + 68; } }
+class Op69 extends BaseOp { public function apply(int $x): int { return $x + 69; } }
+class Op70 extends NamedOp { public function apply(int $x): int { return $x + 70; } }
+class Op71 extends BaseOp { public function apply(int $x): int { return $x + 71; } }
+class Op72 extends BaseOp { public function apply(int $x): int { return $x + 72; } }
+class Op73 extends BaseOp { public function apply(int $x): int { return $x + 73; } }
+class Op74 extends BaseOp { public function apply(int $x): int { return $x + 74; } }
+class Op75 extends BaseOp { public function apply(int $x): int { return $x + 75; } }
+class Op76 extends BaseOp { public function apply(int $x): int { return $x + 76; } }
+class Op77 extends BaseOp { public function apply(int $x): int { return $x + 77; } }
+class Op78 extends BaseOp { public function apply(int $x): int { return $x + 78; } }
+class Op79 extends BaseOp { public function apply(int $x): int { return $x + 79; } }
+class Op80 extends NamedOp { public function apply(int $x): int { return $x + 80; } }
+class Op81 extends BaseOp { public function apply(int $x): int { return $x + 81; } }
+class Op82 extends BaseOp { public function apply(int $x): int { return $x + 82; } }
+class Op83 extends BaseOp { public function apply(int $x): int { return $x + 83; } }
+class Op84 extends BaseOp { public function apply(int $x): int { return $x + 84; } }
+class Op85 extends BaseOp { public function apply(int $x): int { return $x + 85; } }
+class Op86 extends BaseOp { public function apply(int $x): int { return $x + 86; } }
+class Op87 extends BaseOp { public function apply(int $x): int { return $x + 87; } }
+class Op88 extends BaseOp { public function apply(int $x): int { return $x + 88; } }
+class Op89 extends BaseOp { public function apply(int $x): int { return $x + 89; } }
+class Op90 extends NamedOp { public function apply(int $x): int { return $x + 90; } }
+class Op91 extends BaseOp { public function apply(int $x): int { return $x + 91; } }
+class Op92 extends BaseOp { public function apply(int $x): int { return $x + 92; } }
+class Op93 extends BaseOp { public function apply(int $x): int { return $x + 93; } }
+class Op94 extends BaseOp { public function apply(int $x): int { return $x + 94; } }
+class Op95 extends BaseOp { public function apply(int $x): int { return $x + 95; } }
+class Op96 extends BaseOp { public function apply(int $x): int { return $x + 96; } }
+class Op97 extends BaseOp { public function apply(int $x): int { return $x + 97; } }
+class Op98 extends BaseOp { public function apply(int $x): int { return $x + 98; } }
+class Op99 extends BaseOp { public function apply(int $x): int { return $x + 99; } }
+class Op100 extends NamedOp { public function apply(int $x): int { return $x + 100; } }
+class Op101 extends BaseOp { public function apply(int $x): int { return $x + 101; } }
+class Op102 extends BaseOp { public function apply(int $x): int { return $x + 102; } }
+class Op103 extends BaseOp { public function apply(int $x): int { return $x + 103; } }
+class Op104 extends BaseOp { public function apply(int $x): int { return $x + 104; } }
+class Op105 extends BaseOp { public function apply(int $x): int { return $x + 105; } }
+class Op106 extends BaseOp { public function apply(int $x): int { return $x + 106; } }
+class Op107 extends BaseOp { public function apply(int $x): int { return $x + 107; } }
+class Op108 extends BaseOp { public function apply(int $x): int { return $x + 108; } }
+class Op109 extends BaseOp { public function apply(int $x): int { return $x + 109; } }
+class Op110 extends NamedOp { public function apply(int $x): int { return $x + 110; } }
+class Op111 extends BaseOp { public function apply(int $x): int { return $x + 111; } }
+class Op112 extends BaseOp { public function apply(int $x): int { return $x + 112; } }
+class Op113 extends BaseOp { public function apply(int $x): int { return $x + 113; } }
+class Op114 extends BaseOp { public function apply(int $x): int { return $x + 114; } }
+class Op115 extends BaseOp { public function apply(int $x): int { return $x + 115; } }
+class Op116 extends BaseOp { public function apply(int $x): int { return $x + 116; } }
+class Op117 extends BaseOp { public function apply(int $x): int { return $x + 117; } }
+class Op118 extends BaseOp { public function apply(int $x): int { return $x + 118; } }
+class Op119 extends BaseOp { public function apply(int $x): int { return $x + 119; } }
+class Op120 extends NamedOp { public function apply(int $x): int { return $x + 120; } }
+class Op121 extends BaseOp { public function apply(int $x): int { return $x + 121; } }
+class Op122 extends BaseOp { public function apply(int $x): int { return $x + 122; } }
+class Op123 extends BaseOp { public function apply(int $x): int { return $x + 123; } }
+class Op124 extends BaseOp { public function apply(int $x): int { return $x + 124; } }
+class Op125 extends BaseOp { public function apply(int $x): int { return $x + 125; } }
+class Op126 extends BaseOp { public function apply(int $x): int { return $x + 126; } }
+class Op127 extends BaseOp { public function apply(int $x): int { return $x + 127; } }
+class Op128 extends BaseOp { public function apply(int $x): int { return $x + 128; } }
+class Op129 extends BaseOp { public function apply(int $x): int { return $x + 129; } }
+class Op130 extends NamedOp { public function apply(int $x): int { return $x + 130; } }
+class Op131 extends BaseOp { public function apply(int $x): int { return $x + 131; } }
+class Op132 extends BaseOp { public function apply(int $x): int { return $x + 132; } }
+class Op133 extends BaseOp { public function apply(int $x): int { return $x + 133; } }
+class Op134 extends BaseOp { public function apply(int $x): int { return $x + 134; } }
+class Op135 extends BaseOp { public function apply(int $x): int { return $x + 135; } }
+class Op136 extends BaseOp { public function apply(int $x): int { return $x + 136; } }
+class Op137 extends BaseOp { public function apply(int $x): int { return $x + 137; } }
+class Op138 extends BaseOp { public function apply(int $x): int { return $x + 138; } }
+class Op139 extends BaseOp { public function apply(int $x): int { return $x + 139; } }
+
+class Plus extends Op1 { public function apply(int $x): int { return $x * 100; } }
+class PlusLeaf extends Op2 {}
+
+/** @var Op[] $ops */
+$ops = [new Op0, new Op1, new Op2, new Op3, new Op4, new Op5, new Op6, new Op7, new Op8, new Op9, new Op10, new Op11, new Op12, new Op13, new Op14, new Op15, new Op16, new Op17, new Op18, new Op19, new Op20, new Op21, new Op22, new Op23, new Op24, new Op25, new Op26, new Op27, new Op28, new Op29, new Op30, new Op31, new Op32, new Op33, new Op34, new Op35, new Op36, new Op37, new Op38, new Op39, new Op40, new Op41, new Op42, new Op43, new Op44, new Op45, new Op46, new Op47, new Op48, new Op49, new Op50, new Op51, new Op52, new Op53, new Op54, new Op55, new Op56, new Op57, new Op58, new Op59, new Op60, new Op61, new Op62, new Op63, new Op64, new Op65, new Op66, new Op67, new Op68, new Op69, new Op70, new Op71, new Op72, new Op73, new Op74, new Op75, new Op76, new Op77, new Op78, new Op79, new Op80, new Op81, new Op82, new Op83, new Op84, new Op85, new Op86, new Op87, new Op88, new Op89, new Op90, new Op91, new Op92, new Op93, new Op94, new Op95, new Op96, new Op97, new Op98, new Op99, new Op100, new Op101, new Op102, new Op103, new Op104, new Op105, new Op106, new Op107, new Op108, new Op109, new Op110, new Op111, new Op112, new Op113, new Op114, new Op115, new Op116, new Op117, new Op118, new Op119, new Op120, new Op121, new Op122, new Op123, new Op124, new Op125, new Op126, new Op127, new Op128, new Op129, new Op130, new Op131, new Op132, new Op133, new Op134, new Op135, new Op136, new Op137, new Op138, new Op139, new Plus, new PlusLeaf];
+$sum = 0;
+foreach ($ops as $op) {
+  $sum += $op->apply(1);
+  echo $op->name(), "\n";
+}
+echo $sum, "\n";
+
+// the static type of $leaf has no inheritors, so the inherited virtual method is called directly
+$leaf = new PlusLeaf;
+echo $leaf->apply(5), " ", $leaf->name(), "\n";
+$op1 = new Op1;
+echo $op1->apply(5), "\n";
@@ -0,0 +1,92 @@
+@ok
+<?php
+
+class Point {
+  /** @var int */
+  public $x;
+  /** @var int */
+  public $y;
+  /** @var string[] */
+  public $tags = [];
+
+  public function __construct(int $x, int $y) {
+    $this->x = $x;
+    $this->y = $y;
+  }
+
+  public function len2(): int {
+    return $this->x * $this->x + $this->y * $this->y;
+  }
+
+  public function addTag(string $tag) {
+    $this->tags[] = $tag;
+  }
+}
+
+class Leaking {
+  /** @var Leaking[] */
+  static public $all = [];
+
+  /** @var int */
+  public $id;
+
+  public function __construct(int $id) {
+    $this->id = $id;
+    self::$all[] = $this;
+  }
+}
+
+class Holder {
+  /** @var Point */
+  public $p;
+
+  public function keep(Point $p) {
+    $this->p = $p;
+  }
+}
+
+// doesn't escape: allocated on a stack
+function localPoint(int $x, int $y): int {
+  $p = new Point($x, $y);
+  $p->addTag("local");
+  $p->x += 1;
+  return $p->len2() + count($p->tags);
+}
+
+// escapes via return
+function makePoint(int $x): Point {
+  $p = new Point($x, $x);
+  return $p;
+}
+
+// escapes via an argument
+function storePoint(Holder $h, int $x) {
+  $p = new Point($x, 0);
+  $h->keep($p);
+}
+
+// escapes via a constructor that leaks $this
+function makeLeaking(int $id): int {
+  $l = new Leaking($id);
+  return $l->id;
+}
+
+// inside a loop: left in the heap
+function pointsInLoop(): int {
+  $sum = 0;
+  for ($i = 0; $i < 3; ++$i) {
+    $p = new Point($i, $i);
+    $sum += $p->len2();
+  }
+  return $sum;
+}
+
+echo localPoint(1, 2), "\n";
+echo localPoint(3, 4), "\n";
+echo makePoint(5)->len2(), "\n";
+$h = new Holder;
+storePoint($h, 7);
+echo $h->p->x, "\n";
+echo makeLeaking(1) + makeLeaking(2), "\n";
+echo count(Leaking::$all), "\n";
+echo pointsInLoop(), "\n";
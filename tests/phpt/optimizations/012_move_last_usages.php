@@ -0,0 +1,79 @@
+@ok
+<?php
+
+/**
+ * @param int[] $arr
+ * @return int[]
+ */
+function append_one($arr) {
+  $arr[] = 1;
+  return $arr;
+}
+
+/**
+ * @param int[] $arr
+ * @return mixed
+ */
+function as_mixed($arr) {
+  return $arr;
+}
+
+function self_assign() {
+  $a = [0];
+  for ($i = 0; $i < 3; ++$i) {
+    $a = append_one($a);
+  }
+  var_dump($a);
+}
+
+function used_after() {
+  $a = [0];
+  $b = append_one($a);
+  var_dump($a);
+  var_dump($b);
+}
+
+function used_in_next_iteration() {
+  $a = [5];
+  $b = [];
+  for ($i = 0; $i < 3; ++$i) {
+    $b = $a;
+    $b[] = $i;
+  }
+  var_dump($a);
+  var_dump($b);
+}
+
+function used_twice_in_statement() {
+  $a = [1, 2];
+  $b = array_merge(append_one($a), $a);
+  var_dump($b);
+}
+
+function used_in_catch() {
+  $a = [1];
+  try {
+    $b = append_one($a);
+    if (count($b) > 1) {
+      throw new Exception("oops");
+    }
+  } catch (Exception $e) {
+    var_dump($a);
+  }
+}
+
+function moved_and_reassigned() {
+  $s = "str";
+  $t = $s;
+  $t .= "!";
+  $s = "new";
+  echo $s, " ", $t, "\n";
+}
+
+self_assign();
+used_after();
+used_in_next_iteration();
+used_twice_in_statement();
+used_in_catch();
+moved_and_reassigned();
+var_dump(as_mixed([1, 2, 3]));
@@ -0,0 +1,52 @@
+@ok
+<?php
+
+function separator(int $len): string {
+  return str_repeat('-', $len);
+}
+
+function keys(string $config) {
+  return explode(',', $config);
+}
+
+function different_args(string $s): string {
+  return strtoupper($s);
+}
+
+function modified_param(int $x): int {
+  $x += 1;
+  return $x * 2;
+}
+
+function list_assigned($a) {
+  [$a, $b] = [10, 20];
+  return $a + $b;
+}
+
+/**
+ * @param int|false $v
+ */
+function with_mixed_hint($v) {
+  var_dump($v);
+}
+
+function default_arg(string $glue = '|'): string {
+  return implode($glue, ['a', 'b']);
+}
+
+for ($i = 0; $i < 3; ++$i) {
+  echo separator(5), "\n";
+  var_dump(keys("a,b,c"));
+}
+echo separator(5), "\n";
+var_dump(keys("a,b,c"));
+
+echo different_args("abc"), different_args("def"), "\n";
+echo modified_param(1), modified_param(1), "\n";
+echo list_assigned(1), "\n";
+with_mixed_hint(1);
+echo default_arg(), default_arg('|'), "\n";
+
+var_dump(strlen("hello"), trim("  x  "), substr("abcdef", 1, 3), md5("a"), crc32("a"));
+var_dump(json_decode('{"a":[1,2,{"b":null}]}', true));
+var_dump(array_flip(['x', 'y']), str_pad("7", 3, "0", STR_PAD_LEFT), round(2.5), sqrt(16.0));
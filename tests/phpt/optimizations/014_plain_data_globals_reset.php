@@ -0,0 +1,43 @@
+@ok
+<?php
+
+class Counters {
+  /** @var int */
+  static public $hits = 10;
+  /** @var float */
+  static public $ratio = 0.5;
+  /** @var bool */
+  static public $enabled = true;
+  /** @var string[] */
+  static public $names = ['a'];
+}
+
+$global_int = 5;
+$global_float = 1.5;
+$global_flag = false;
+$global_optional_int = false;
+
+function next_id(): int {
+  static $id = 100;
+  return ++$id;
+}
+
+function bump() {
+  global $global_int, $global_float, $global_flag, $global_optional_int;
+  $global_int += 1;
+  $global_float *= 2;
+  $global_flag = !$global_flag;
+  $global_optional_int = $global_int;
+  Counters::$hits++;
+  Counters::$ratio += 0.25;
+  Counters::$enabled = false;
+  Counters::$names[] = 'b';
+}
+
+echo next_id(), " ", next_id(), "\n";
+echo $global_int, " ", $global_float, " ", var_export($global_flag, true), " ", var_export($global_optional_int, true), "\n";
+echo Counters::$hits, " ", Counters::$ratio, " ", var_export(Counters::$enabled, true), " ", count(Counters::$names), "\n";
+bump();
+bump();
+echo $global_int, " ", $global_float, " ", var_export($global_flag, true), " ", var_export($global_optional_int, true), "\n";
+echo Counters::$hits, " ", Counters::$ratio, " ", var_export(Counters::$enabled, true), " ", count(Counters::$names), "\n";
@@ -0,0 +1,38 @@
+@ok
+<?php
+
+function test_strtr_longest_match() {
+  $pairs = ["a" => "1", "ab" => "2", "abc" => "3", "b" => "4", "bcd" => "5", "x" => "", "hello" => "hi", "hell" => "HELL"];
+  foreach (["abcd", "ababab", "xxabcxx", "hello hell hel", "", "zzz", "abcabcbcd", "bcdabcd"] as $s) {
+    var_dump(strtr($s, $pairs));
+  }
+}
+
+function test_strtr_int_keys_and_values() {
+  $pairs = [1 => 10, 23 => "x", "4" => 5.5, "foo" => 1];
+  var_dump(strtr("1234 foo 23 4", $pairs));
+}
+
+function test_strtr_replacements_are_not_rescanned() {
+  var_dump(strtr("Hi all, I said hello", ["Hi" => "Hello", "Hello" => "Hi", "hello" => "hi"]));
+  var_dump(strtr("{a}{b}{{a}}", ["{a}" => "{b}", "{b}" => "B", "{{" => "{"]));
+}
+
+function test_strtr_many_pairs() {
+  $pairs = [];
+  for ($i = 0; $i < 200; ++$i) {
+    $pairs["{var$i}"] = "value_$i";
+  }
+  $template = "";
+  for ($i = 0; $i < 300; $i += 7) {
+    $template .= "<p>{var$i} and {var" . ($i % 20) . "}</p>";
+  }
+  var_dump(md5(strtr($template, $pairs)));
+  // the same pairs again: a cached matcher is used
+  var_dump(strtr("{var1}{var10}{var100}{var1000}", $pairs));
+}
+
+test_strtr_longest_match();
+test_strtr_int_keys_and_values();
+test_strtr_replacements_are_not_rescanned();
+test_strtr_many_pairs();
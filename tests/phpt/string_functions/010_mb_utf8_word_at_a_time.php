@@ -0,0 +1,29 @@
+@ok
+<?php
+
+function test_mb_functions(string $s) {
+  var_dump(mb_check_encoding($s, "UTF-8"));
+  var_dump(mb_strlen($s, "UTF-8"));
+  var_dump(mb_strtolower($s, "UTF-8"));
+  var_dump(mb_strtoupper($s, "UTF-8"));
+  foreach ([0, 1, 7, 8, 9, 15, 16, 17, -1, -9, 100] as $start) {
+    var_dump(mb_substr($s, $start, null, "UTF-8"));
+    var_dump(mb_substr($s, $start, 9, "UTF-8"));
+  }
+  var_dump(mb_strpos($s, "z", 3, "UTF-8"));
+  var_dump(mb_stripos($s, "ПРИВЕТ", 0, "UTF-8"));
+}
+
+$strings = [
+  "",
+  "short",
+  "Hello, World! @[`{ ABCXYZ abcxyz 0123456789 The Quick Brown Fox Jumps",
+  "Привет, мир! Hello, world! Привет ещё раз, and some ASCII text after it z",
+  "ascii ascii ascii €€€ ascii ascii ascii 𝄞𝄞 ascii ascii ASCII ASCII z",
+  "12345678" . "\xD0\x9A" . "abcdefgh" . "\xF0\x9F\x98\x80" . "ABCDEFGHZ",
+  "valid prefix of 8+ bytes, then \xED\xA0\x80 a surrogate",
+  "valid prefix of 8+ bytes, then \xC0 a bad byte",
+];
+foreach ($strings as $s) {
+  test_mb_functions($s);
+}
@@ -8,6 +8,29 @@ class A {
   public $b = "hello";
 }
 
+class PlainGlobals {
+  /** @var int */
+  static public $hits = 10;
+  /** @var float */
+  static public $ratio = 0.5;
+  /** @var bool */
+  static public $enabled = true;
+}
+
+function next_plain_id(): int {
+  static $id = 100;
+  return ++$id;
+}
+
+function bump_plain_globals(): int {
+  global $plain_counter;
+  $plain_counter += 1;
+  PlainGlobals::$hits++;
+  PlainGlobals::$ratio += 0.25;
+  PlainGlobals::$enabled = false;
+  return $plain_counter;
+}
+
 /**
  * @kphp-required
  */
@@ -21,6 +44,17 @@ function assert($flag) {
     }
 }
 
+function burn_cpu_for_sampling_profiler(int $seconds): int {
+    $start = microtime(true);
+    $x = 0;
+    while (microtime(true) - $start < $seconds) {
+        for ($i = 0; $i < 100000; ++$i) {
+            $x = ($x * 31 + $i) % 1000003;
+        }
+    }
+    return $x;
+}
+
 interface I {
     public function work();
 }
@@ -85,6 +119,12 @@ if ($_SERVER["PHP_SELF"] === "/ini_get") {
       $res = zstd_compress((string)file_get_contents("in.dat"), (int)$_GET["level"]); break;
     case "compress_dict":
       $res = zstd_compress_dict((string)file_get_contents("in.dat"), (string)file_get_contents($_GET["dict"])); break;
+    case "uncompress_named_dict":
+      zstd_register_dict($_GET["dict"], (string)file_get_contents($_GET["dict"]));
+      $res = zstd_uncompress_named_dict((string)file_get_contents("in.dat"), $_GET["dict"]); break;
+    case "compress_named_dict":
+      zstd_register_dict($_GET["dict"], (string)file_get_contents($_GET["dict"]));
+      $res = zstd_compress_named_dict((string)file_get_contents("in.dat"), $_GET["dict"]); break;
     default:
       echo "ERROR"; return;
   }
@@ -141,6 +181,59 @@ if ($_SERVER["PHP_SELF"] === "/ini_get") {
         $res = 0;
     }
     echo json_encode(['len' => $res]);
+} else if ($_SERVER["PHP_SELF"] === "/test_streamed_post_data") {
+    $input = fopen("php://input", "r");
+    $len = 0;
+    $y_count = 0;
+    while (!feof($input)) {
+      $chunk = (string)fread($input, (int)$_GET["chunk_size"]);
+      $len += strlen($chunk);
+      $y_count += substr_count($chunk, "y");
+    }
+    echo json_encode(['len' => $len, 'pos' => ftell($input), 'y_count' => $y_count]);
+} else if ($_SERVER["PHP_SELF"] === "/test_sampling_profiler") {
+    echo burn_cpu_for_sampling_profiler((int)$_GET["seconds"]);
+} else if ($_SERVER["PHP_SELF"] === "/test_rpc_send") {
+    $conn = new_rpc_connection('localhost', (int)$_GET["port"], 0, 5);
+    $count = (int)$_GET["count"];
+    switch($_GET["type"]) {
+      case "delayed":
+        // the first queries are sent while the connection isn't established yet
+        $queries = [];
+        for ($i = 0; $i < $count; ++$i) {
+          $queries[] = ["_" => "engine.sleep", "time_ms" => 1];
+        }
+        $results = rpc_tl_query_result(rpc_tl_query($conn, $queries));
+        echo json_encode(["succeeded" => count(array_filter($results, function($r) { return isset($r["result"]) && $r["result"]; }))]);
+        break;
+      case "unflushed":
+        // the queries aren't flushed, they are freed when the script finishes
+        $payload = str_repeat("x", (int)$_GET["size"]);
+        $sent = 0;
+        for ($i = 0; $i < $count; ++$i) {
+          rpc_clean();
+          store_string($payload);
+          if (rpc_send_noflush($conn) > 0) {
+            $sent++;
+          }
+        }
+        echo json_encode(["sent" => $sent]);
+        break;
+      default:
+        echo "ERROR"; return;
+    }
+} else if ($_SERVER["PHP_SELF"] === "/test_plain_globals_reset") {
+    // every request must see the initial values, whatever the previous one has done
+    $values = [
+      "hits" => PlainGlobals::$hits,
+      "ratio" => PlainGlobals::$ratio,
+      "enabled" => PlainGlobals::$enabled,
+      "id" => next_plain_id(),
+      "counter" => bump_plain_globals(),
+    ];
+    bump_plain_globals();
+    next_plain_id();
+    echo json_encode($values);
 } else if ($_SERVER["PHP_SELF"] === "/pid") {
     echo "pid=" . posix_getpid();
 } else {
@@ -0,0 +1,16 @@
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestPlainGlobalsReset(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": 1,
+        })
+
+    def test_plain_globals_are_reset_between_requests(self):
+        # the first request takes the snapshot of the plain data globals, the next ones are restored from it
+        for _ in range(5):
+            resp = self.kphp_server.http_get("/test_plain_globals_reset")
+            self.assertEqual(resp.status_code, 200)
+            self.assertEqual(resp.json(), {"hits": 10, "ratio": 0.5, "enabled": True, "id": 101, "counter": 1})
@@ -88,3 +88,20 @@ class TestRequestLimits(KphpServerAutoTestCase):
         self.assertEqual(resp.status_code, 200)
         self.assertEqual(resp.json()["len"], 0)
 
+    def test_streamed_post_data(self):
+        for req_size in (4000, 2 * 1024 * 1024 + 1, 5 * 1024 * 1024):
+            data = ("x" * 999 + "y") * (req_size // 1000) + "x" * (req_size % 1000)
+            resp = self.kphp_server.http_post("/test_streamed_post_data?chunk_size=65536", data=data,
+                                              headers={"Content-Type": "application/octet-stream"})
+            self.assertEqual(resp.status_code, 200)
+            self.assertEqual(resp.json(), {"len": req_size, "pos": req_size, "y_count": req_size // 1000})
+
+    def test_unread_streamed_post_data_closes_connection(self):
+        resp = self.kphp_server.http_post("/test_big_post_data", data="x" * (2 * 1024 * 1024 + 1),
+                                          headers={"Content-Type": "application/octet-stream"})
+        self.assertEqual(resp.status_code, 200)
+        self.assertEqual(resp.headers["Connection"], "close")
+        resp = self.kphp_server.http_post("/test_big_post_data", data="x" * 4000,
+                                          headers={"Content-Type": "application/octet-stream"})
+        self.assertEqual(resp.status_code, 200)
+
@@ -0,0 +1,36 @@
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestRpcSend(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": 1,
+            "--msg-buffers-size": "16m",
+        })
+
+    def _rpc_send(self, **params):
+        params["port"] = self.kphp_server.master_port
+        uri = "/test_rpc_send?" + "&".join("{}={}".format(k, v) for k, v in params.items())
+        resp = self.kphp_server.http_get(uri)
+        self.assertEqual(resp.status_code, 200)
+        return resp.json()
+
+    def test_delayed_send(self):
+        self.assertEqual(self._rpc_send(type="delayed", count=100), {"succeeded": 100})
+
+    def test_unflushed_queries_are_freed(self):
+        # 4 MB of net buffers per request: they would be exhausted after a few requests if not freed on finish
+        for _ in range(20):
+            self.assertEqual(self._rpc_send(type="unflushed", count=1000, size=4000), {"sent": 1000})
+        self.assertEqual(self._rpc_send(type="delayed", count=10), {"succeeded": 10})
+
+    def test_queries_over_net_buffers_limit(self):
+        sent = self._rpc_send(type="unflushed", count=8000, size=4000)["sent"]
+        self.assertGreater(sent, 0)
+        self.assertLess(sent, 8000)
+        self.kphp_server.assert_log(["Can't send rpc query: net buffers are exhausted"], timeout=5)
+
+        # the worker is alive, and the buffers are freed
+        self.assertEqual(self._rpc_send(type="unflushed", count=1000, size=4000), {"sent": 1000})
+        self.assertEqual(self._rpc_send(type="delayed", count=10), {"succeeded": 10})
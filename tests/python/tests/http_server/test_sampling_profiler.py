@@ -0,0 +1,42 @@
+import glob
+import os
+import signal
+
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestSamplingProfiler(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": 1,
+            "--sampling-profiler-log-prefix": cls._log_prefix(),
+        })
+
+    @classmethod
+    def _log_prefix(cls):
+        return os.path.join(cls.kphp_server_working_dir, "sampling_profiler")
+
+    def _toggle_profiler(self):
+        self.kphp_server.send_signal(signal.SIGRTMIN + 3)
+
+    def test_samples_are_written(self):
+        self._toggle_profiler()
+        self.kphp_server.assert_log(["sampling profiler is started"], timeout=5)
+
+        resp = self.kphp_server.http_get("/test_sampling_profiler?seconds=2")
+        self.assertEqual(resp.status_code, 200)
+
+        self._toggle_profiler()
+        self.kphp_server.assert_log(["sampling profiler is stopped, \\d+ stacks are written"], timeout=5)
+
+        files = glob.glob(self._log_prefix() + ".*.folded")
+        self.assertEqual(len(files), 1)
+        samples_in_php_function = 0
+        with open(files[0]) as f:
+            for line in f:
+                stack, count = line.rsplit(" ", 1)
+                if "burn_cpu_for_sampling_profiler" in stack:
+                    samples_in_php_function += int(count)
+        # 99 samples per second of cpu time
+        self.assertGreater(samples_in_php_function, 50)
@@ -0,0 +1,23 @@
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestWorkersAutoscaling(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": 6,
+            "--workers-autoscaling-min": 2,
+            "-v": True,
+        })
+
+    def test_idle_workers_are_terminated(self):
+        self.kphp_server.assert_log(["workers autoscaling: \\[target = 6 -> 5\\]"], "Workers were not scaled down", timeout=90)
+        self.kphp_server.assert_stats(
+            prefix="kphp_server.workers_general_processes_",
+            expected_added_stats={
+                "total": 6,
+                "autoscaling_target": 5,
+            })
+
+        resp = self.kphp_server.http_get("/sleep?time=0")
+        self.assertEqual(resp.status_code, 200)
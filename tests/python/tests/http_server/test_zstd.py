@@ -153,3 +153,24 @@ class TestZstd(KphpServerAutoTestCase):
         self._write_in_file(self.some_string)
         self._call_php("compress_dict", dictionary="dict.bad")
         self.assertEqual(ctx.decompress(self._read_out_file()), self.some_string)
+
+    def test_compress_named_dict(self):
+        ctx = zstandard.ZstdDecompressor(dict_data=self.dict)
+        for s, _, _ in self.examples:
+            self._write_in_file(s)
+            self._call_php("compress_named_dict")
+            self.assertEqual(ctx.decompress(self._read_out_file()), s)
+
+    def test_uncompress_named_dict(self):
+        for dictionary, dict_data in (("dict", self.dict), ("dict.other", self.dict_other), ("dict", self.dict)):
+            ctx = zstandard.ZstdCompressor(dict_data=dict_data)
+            self._write_in_file(ctx.compress(self.some_string))
+            self._call_php("uncompress_named_dict", dictionary=dictionary)
+            self.assertEqual(self._read_out_file(), self.some_string)
+
+    def test_uncompress_named_dict_compressed_with_other_dict(self):
+        ctx = zstandard.ZstdCompressor(dict_data=self.dict_other)
+        self._write_in_file(ctx.compress(self.some_string))
+        self._call_php("uncompress_named_dict")
+        self.kphp_server.assert_log(["Warning: zstd_uncompress: got zstd error: Dictionary mismatch"])
+        self.assertEqual(self._read_out_file(), b"false")
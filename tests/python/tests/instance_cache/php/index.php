@@ -14,6 +14,22 @@ function main() {
       test_delete();
       return;
     }
+    case "/store_serializable": {
+      test_store_serializable();
+      return;
+    }
+    case "/fetch_serializable": {
+      test_fetch_serializable();
+      return;
+    }
+    case "/store_many": {
+      test_store_many();
+      return;
+    }
+    case "/delete_many": {
+      test_delete_many();
+      return;
+    }
   }
 
   critical_error("unknown test " . $_SERVER["PHP_SELF"]);
@@ -124,6 +140,29 @@ class TestClassABC {
   public $c = [];
 }
 
+/**
+ * @kphp-immutable-class
+ * @kphp-serializable
+ */
+class TestSerializableClass {
+  function __construct(string $str, array $arr) {
+    $this->str = $str;
+    $this->arr = $arr;
+  }
+
+  /**
+   * @kphp-serialized-field 1
+   * @var string
+   */
+  public $str = "";
+
+  /**
+   * @kphp-serialized-field 2
+   * @var int[]
+   */
+  public $arr = [];
+}
+
 function test_store() {
   $data = json_decode(file_get_contents('php://input'));
   echo json_encode(["result" => instance_cache_store((string)$data["key"], new TestClassABC, 5)]);
@@ -145,4 +184,35 @@ function test_delete() {
   instance_cache_delete((string)$data["key"]);
 }
 
+function test_store_serializable() {
+  $data = json_decode(file_get_contents('php://input'));
+  $instance = new TestSerializableClass((string)$data["str"], array_map('intval', (array)$data["arr"]));
+  echo json_encode(["result" => instance_cache_store((string)$data["key"], $instance, (int)$data["ttl"])]);
+}
+
+function test_fetch_serializable() {
+  $data = json_decode(file_get_contents('php://input'));
+  /** @var TestSerializableClass $instance */
+  $instance = instance_cache_fetch(TestSerializableClass::class, (string)$data["key"]);
+  echo json_encode($instance ? ["str" => $instance->str, "arr" => $instance->arr] : null);
+}
+
+function test_store_many() {
+  $data = json_decode(file_get_contents('php://input'));
+  $stored = [];
+  foreach ((array)$data["keys"] as $key) {
+    $stored[] = instance_cache_store((string)$key, new TestClassABC, (int)$data["ttl"]);
+  }
+  echo json_encode(["pid" => posix_getpid(), "stored" => $stored]);
+}
+
+function test_delete_many() {
+  $data = json_decode(file_get_contents('php://input'));
+  $deleted = [];
+  foreach ((array)$data["keys"] as $key) {
+    $deleted[] = instance_cache_delete((string)$key);
+  }
+  echo json_encode(["pid" => posix_getpid(), "deleted" => $deleted]);
+}
+
 main();
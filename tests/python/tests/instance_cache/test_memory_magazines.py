@@ -0,0 +1,106 @@
+import time
+from multiprocessing.dummy import Pool as ThreadPool
+
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestMemoryMagazines(KphpServerAutoTestCase):
+    WORKERS = 4
+
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": cls.WORKERS,
+        })
+
+    def _post_keys(self, uri, keys_list, ttl=0):
+        def post(keys):
+            resp = self.kphp_server.http_post(uri=uri, json={"keys": keys, "ttl": ttl})
+            self.assertEqual(resp.status_code, 200)
+            return resp.json()
+
+        with ThreadPool(2 * self.WORKERS) as pool:
+            return pool.map(post, keys_list)
+
+    def _fetch_and_verify(self, key):
+        resp = self.kphp_server.http_post(uri="/fetch_and_verify", json={"key": key})
+        self.assertEqual(resp.status_code, 200)
+        self.assertEqual(resp.json(), {"a": True, "b": True, "c": True})
+
+    def test_concurrent_stores_and_deletes_from_several_workers(self):
+        requests = 24
+        keys_per_request = 2
+        keys_list = [["key_{}_{}".format(r, i) for i in range(keys_per_request)] for r in range(requests)]
+        elements = requests * keys_per_request
+
+        stats_before = self.kphp_server.get_stats(prefix="kphp_server.instance_cache_")
+        stored = self._post_keys("/store_many", keys_list)
+        for result in stored:
+            self.assertEqual(result["stored"], [True] * keys_per_request)
+        store_pids = {result["pid"] for result in stored}
+        self.assertGreater(len(store_pids), 1)
+
+        for keys in keys_list:
+            for key in keys:
+                self._fetch_and_verify(key)
+
+        stats = self.kphp_server.get_stats(prefix="kphp_server.instance_cache_")
+        # a magazine is created once per process which stores something, it has no memory until it's refilled
+        self.assertEqual(stats["memory_magazines_created"] - stats_before.get("memory_magazines_created", 0), len(store_pids))
+        self.assertGreaterEqual(stats["memory_magazine_refills"] - stats_before.get("memory_magazine_refills", 0), len(store_pids))
+        self.assertGreater(stats["memory_magazines_taken"], 0)
+        # the stores of different processes don't wait for each other, so nothing is delayed
+        self.assertEqual(stats["elements_storing_delayed_due_mutex"] - stats_before.get("elements_storing_delayed_due_mutex", 0), 0)
+        self.assertEqual(stats["elements_stored"] - stats_before.get("elements_stored", 0), elements)
+
+        # the keys are deleted in the reverse order, so most of them are deleted by another process
+        deleted = self._post_keys("/delete_many", list(reversed(keys_list)))
+        for result in deleted:
+            self.assertEqual(result["deleted"], [True] * keys_per_request)
+        key_store_pid = {key: result["pid"] for keys, result in zip(keys_list, stored) for key in keys}
+        key_delete_pid = {key: result["pid"] for keys, result in zip(reversed(keys_list), deleted) for key in keys}
+        self.assertTrue(any(key_store_pid[key] != key_delete_pid[key] for key in key_store_pid))
+
+        self.kphp_server.assert_stats(
+            timeout=70,
+            initial_stats=stats_before,
+            prefix="kphp_server.instance_cache_",
+            expected_added_stats={
+                "memory_used": 0,
+                "elements_stored": elements,
+                "elements_destroyed": elements,
+                "elements_storing_delayed_due_mutex": 0,
+            })
+
+
+class TestMemoryMagazinesUnderMemoryPressure(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": 2,
+            "--instance-cache-memory-limit": "16M",
+        })
+
+    def _store_many(self, keys):
+        resp = self.kphp_server.http_post(uri="/store_many", json={"keys": keys, "ttl": 0})
+        self.assertEqual(resp.status_code, 200)
+        return resp.json()["stored"]
+
+    def test_refill_fails_on_memory_limit(self):
+        stats_before = self.kphp_server.get_stats(prefix="kphp_server.instance_cache_")
+        stored = self._store_many(["key_{}".format(i) for i in range(100)])
+        self.assertIn(True, stored)
+        self.assertIn(False, stored)
+        self.kphp_server.assert_log(["Memory limit exceeded on saving instance of class 'TestClassABC' into cache"])
+
+        stats = self.kphp_server.get_stats(prefix="kphp_server.instance_cache_")
+        self.assertGreater(stats["memory_magazine_refills"] - stats_before.get("memory_magazine_refills", 0), 0)
+        # magazines take only what they need when the buffer is almost full, so the swap is requested only when the buffer is really full
+        self.assertGreater(stats["memory_magazines_taken"], stats["memory_limit"] // 2)
+        self.assertLessEqual(stats["memory_magazines_taken"], stats["memory_real_used"])
+
+        # the master swaps the buffer, after that the elements can be stored again
+        deadline = time.time() + 10
+        while not self._store_many(["key_after_swap"])[0]:
+            self.assertLess(time.time(), deadline, "instance cache buffer isn't swapped")
+            time.sleep(0.5)
@@ -0,0 +1,77 @@
+import os
+import time
+
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestSnapshotOnGracefulRestart(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--instance-cache-snapshot-file": "instance_cache.snapshot",
+        })
+
+    def _store(self, key, ttl=0, value=None):
+        resp = self.kphp_server.http_post(
+            uri="/store_serializable",
+            json={"key": key, "str": value or "value of " + key, "arr": [1, 2, 3], "ttl": ttl})
+        self.assertEqual(resp.status_code, 200)
+        self.assertEqual(resp.json(), {"result": True})
+
+    def _fetch(self, key):
+        resp = self.kphp_server.http_post(uri="/fetch_serializable", json={"key": key})
+        self.assertEqual(resp.status_code, 200)
+        return resp.json()
+
+    def _graceful_restart(self):
+        self.kphp_server.start()
+        self.kphp_server.assert_log(["instance cache snapshot is saved"], "Instance cache snapshot was not saved")
+        time.sleep(1)
+
+    def test_elements_are_restored_after_graceful_restart(self):
+        self._store("restored_1")
+        self._store("restored_2", ttl=100)
+        self._graceful_restart()
+
+        stats_before = self.kphp_server.get_stats(prefix="kphp_server.instance_cache_")
+        self.assertEqual(self._fetch("restored_1"), {"str": "value of restored_1", "arr": [1, 2, 3]})
+        self.assertEqual(self._fetch("restored_2"), {"str": "value of restored_2", "arr": [1, 2, 3]})
+        self.assertIsNone(self._fetch("absent"))
+        # restored elements are stored into the cache of the new master
+        self.assertEqual(self._fetch("restored_1"), {"str": "value of restored_1", "arr": [1, 2, 3]})
+        self.kphp_server.assert_stats(
+            initial_stats=stats_before,
+            prefix="kphp_server.instance_cache_",
+            expected_added_stats={
+                "elements_restored_from_snapshot": 2,
+            })
+
+    def test_deleted_elements_are_not_restored(self):
+        self._store("deleted")
+        self._graceful_restart()
+
+        resp = self.kphp_server.http_post(uri="/delete", json={"key": "deleted"})
+        self.assertEqual(resp.status_code, 200)
+        self.assertIsNone(self._fetch("deleted"))
+
+    def test_elements_changed_before_snapshot_is_opened_are_not_restored(self):
+        self._store("deleted_early")
+        self._store("overwritten_early")
+        self.kphp_server.start()
+        self.kphp_server.assert_log(["instance cache snapshot is saved"], "Instance cache snapshot was not saved")
+        # hide the snapshot from the new workers, as if the old master hasn't saved it yet
+        snapshot_file = os.path.join(self.kphp_server_working_dir, "instance_cache.snapshot")
+        hidden_snapshot_file = snapshot_file + ".hidden"
+        os.rename(snapshot_file, hidden_snapshot_file)
+        time.sleep(1)
+
+        resp = self.kphp_server.http_post(uri="/delete", json={"key": "deleted_early"})
+        self.assertEqual(resp.status_code, 200)
+        self._store("overwritten_early", ttl=1, value="new value")
+        self.assertEqual(self._fetch("overwritten_early"), {"str": "new value", "arr": [1, 2, 3]})
+
+        os.rename(hidden_snapshot_file, snapshot_file)
+        # the new value expires, and workers open the snapshot on the next requests
+        time.sleep(2)
+        self.assertIsNone(self._fetch("deleted_early"))
+        self.assertIsNone(self._fetch("overwritten_early"))
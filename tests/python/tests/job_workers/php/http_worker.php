@@ -66,6 +66,10 @@ function do_http_worker() {
       test_job_worker_start_multi_with_errors();
       return;
     }
+    case "/test_job_worker_map": {
+      test_job_worker_map();
+      return;
+    }
     case "/test_send_job_no_reply": {
       test_send_job_no_reply();
       return;
@@ -172,6 +176,28 @@ function raise_error(string $err) {
   echo json_encode(["error" => $err]);
 }
 
+function test_job_worker_map() {
+  $context = json_decode(file_get_contents('php://input'));
+  $requests = [];
+  foreach ($context["data"] as $key => $arr) {
+    $req = new X2Request;
+    $req->arr_request = (array)$arr;
+    $req->tag = (string)$context["tag"];
+    $req->sleep_time_sec = (int)$context["job-sleep-time-sec"];
+    $requests[$key] = $req;
+  }
+
+  $result = [];
+  foreach (kphp_job_worker_map($requests, -1, (int)$context["max-jobs-in-flight"]) as $key => $resp) {
+    if ($resp instanceof X2Response) {
+      $result[$key] = ["data" => $resp->arr_reply];
+    } else if ($resp instanceof KphpJobWorkerResponseError) {
+      $result[$key] = ["error" => $resp->getError(), "error_code" => $resp->getErrorCode()];
+    }
+  }
+  echo json_encode(["jobs-result" => $result]);
+}
+
 function test_client_too_big_request() {
   $req = new X2Request;
   $req->arr_request = make_big_fake_array();
@@ -0,0 +1,86 @@
+import time
+
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestJobWorkerMap(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": 4,
+            "--job-workers-ratio": 0.5,
+            "--verbosity-job-workers=2": True,
+        })
+
+    def _map_jobs(self, data, max_jobs_in_flight, tag="", job_sleep_time_sec=0):
+        resp = self.kphp_server.http_post(
+            uri="/test_job_worker_map",
+            json={
+                "tag": tag,
+                "job-sleep-time-sec": job_sleep_time_sec,
+                "max-jobs-in-flight": max_jobs_in_flight,
+                "data": data})
+        self.assertEqual(resp.status_code, 200)
+        return resp.json()["jobs-result"]
+
+    def test_responses_in_order_of_requests(self):
+        stats_before = self.kphp_server.get_stats(prefix="kphp_server.workers_job_memory_messages_")
+        data = [[i, i + 1] for i in range(10)]
+        self.assertEqual(
+            self._map_jobs(data, max_jobs_in_flight=3),
+            [{"data": [i * i, (i + 1) * (i + 1)]} for i in range(10)])
+        self.kphp_server.assert_stats(
+            initial_stats=stats_before,
+            prefix="kphp_server.workers_job_memory_messages_",
+            expected_added_stats={
+                "shared_messages_buffers_acquired": 20,
+                "shared_messages_buffers_released": 20,
+                "shared_messages_buffer_acquire_fails": 0,
+            })
+
+    def test_keys_are_preserved(self):
+        self.assertEqual(
+            self._map_jobs({"b": [3], "a": [1, 2]}, max_jobs_in_flight=-1, tag="x2_with_sleep", job_sleep_time_sec=1),
+            {"b": {"data": [9]}, "a": {"data": [1, 4]}})
+
+    def test_jobs_in_flight_limit(self):
+        start = time.time()
+        self.assertEqual(
+            self._map_jobs([[1], [2], [3]], max_jobs_in_flight=1, tag="x2_with_sleep", job_sleep_time_sec=1),
+            [{"data": [1]}, {"data": [4]}, {"data": [9]}])
+        # the jobs are run one by one, although there are 2 job workers
+        self.assertGreaterEqual(time.time() - start, 3)
+
+
+class TestJobWorkerMapBackpressure(KphpServerAutoTestCase):
+    SHARED_MESSAGES = 10
+
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--workers-num": 4,
+            "--job-workers-ratio": 0.5,
+            "--job-workers-shared-messages": cls.SHARED_MESSAGES,
+            "--verbosity-job-workers=2": True,
+        })
+
+    def test_more_requests_than_shared_messages(self):
+        stats_before = self.kphp_server.get_stats(prefix="kphp_server.workers_job_memory_messages_")
+        requests_count = 4 * self.SHARED_MESSAGES
+        resp = self.kphp_server.http_post(
+            uri="/test_job_worker_map",
+            json={
+                "tag": "x2_with_sleep",
+                "job-sleep-time-sec": 0,
+                "max-jobs-in-flight": requests_count,
+                "data": [[i] for i in range(requests_count)]})
+        self.assertEqual(resp.status_code, 200)
+        self.assertEqual(resp.json()["jobs-result"], [{"data": [i * i]} for i in range(requests_count)])
+        # each job takes a message for the request and one for the response
+        self.kphp_server.assert_stats(
+            initial_stats=stats_before,
+            prefix="kphp_server.workers_job_memory_messages_",
+            expected_added_stats={
+                "shared_messages_buffers_acquired": 2 * requests_count,
+                "shared_messages_buffers_released": 2 * requests_count,
+            })
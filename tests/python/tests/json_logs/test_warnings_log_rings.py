@@ -0,0 +1,45 @@
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestJsonLogsWarningsLogRings(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--json-log-ring-size": "1m"
+        })
+        cls.kphp_server.ignore_log_errors()
+
+    def test_warnings_are_written_by_master(self):
+        resp = self.kphp_server.http_post(
+            json=[
+                {"op": "set_context", "env": "efg", "tags": {"a": "b"}, "extra_info": {"c": "d"}},
+                {"op": "warning", "msg": "hello"},
+                {"op": "warning", "msg": "world"}
+            ])
+        self.assertEqual(resp.text, "ok")
+        self.kphp_server.assert_json_log(
+            expect=[
+                {
+                    "version": 0, "type": 2, "env": "efg", "msg": "hello",
+                    "tags": {"uncaught": False, "a": "b"}, "extra_info": {"c": "d"}
+                },
+                {
+                    "version": 0, "type": 2, "env": "efg", "msg": "world",
+                    "tags": {"uncaught": False, "a": "b"}, "extra_info": {"c": "d"}
+                }
+            ])
+
+    def test_same_warnings_are_deduplicated(self):
+        resp = self.kphp_server.http_post(json=[{"op": "warning", "msg": "storm"}] * 100)
+        self.assertEqual(resp.text, "ok")
+        self.kphp_server.assert_json_log(
+            expect=[{"version": 0, "type": 2, "env": "", "msg": "storm", "tags": {"uncaught": False}, "count": 100}])
+
+    def test_uncaught_errors_are_written_directly(self):
+        resp = self.kphp_server.http_post(json=[{"op": "exception", "msg": "hello", "code": 123}])
+        self.assertEqual(resp.status_code, 500)
+        self.kphp_server.assert_json_log(
+            expect=[{
+                "version": 0, "type": 1, "env": "", "tags": {"uncaught": True},
+                "msg": "Unhandled ServerException from index.php:\\d+; Error 123; Message: hello"
+            }])
@@ -28,3 +28,11 @@ function get_value() {
     return $global_x;
 }
 
+/**
+ * @kphp-lib-export
+ * @return bool
+ */
+function has_request_time() {
+    // the lib user doesn't use $_SERVER, but it must be filled for the lib
+    return isset($_SERVER["REQUEST_TIME"]) && $_SERVER["REQUEST_TIME"] > 0;
+}
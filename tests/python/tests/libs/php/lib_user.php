@@ -52,6 +52,8 @@ function use_other_lib() {
 
 echo "lib_user: use_other_lib(): ", use_other_lib(), "\n";
 
+echo "lib_user: has_request_time(): ", var_export(has_request_time(), true), "\n";
+
 echo "lib_user: get_static_array(): ";
 var_dump(get_static_array());
 
@@ -36,12 +36,58 @@ function mysql_test_query() {
   echo json_encode(['result' => $res]);
 }
 
+function mysql_test_queries() {
+  $context = json_decode(file_get_contents('php://input'));
+
+  $db = create_connection($context);
+  $res = [];
+  foreach ($context['queries'] as $query) {
+    $affected_rows = $db->exec((string)$query);
+    if ($db->errorCode() == 0) {
+      $res[] = ['affected_rows' => $affected_rows];
+    } else {
+      $res[] = ['error' => array_slice($db->errorInfo(), 0, 2)];
+    }
+  }
+  echo json_encode(['result' => $res]);
+}
+
+function mysql_test_prepared_query() {
+  $context = json_decode(file_get_contents('php://input'));
+
+  $db = create_connection($context);
+  $stmt = $db->prepare((string)$context['query'], [PDO::MYSQL_ATTR_USE_BUFFERED_QUERY => (bool)$context['buffered']]);
+  $rows_limit = (int)$context['rows_limit'];
+  $res = [];
+  foreach ($context['params_list'] as $params) {
+    if (!$stmt->execute((array)$params)) {
+      $res[] = ['error' => array_slice($db->errorInfo(), 0, 2)];
+      continue;
+    }
+    $rows = [];
+    while (count($rows) != $rows_limit && ($row = $stmt->fetch())) {
+      $rows[] = $row;
+    }
+    $stmt->closeCursor();
+    $res[] = $rows;
+  }
+  echo json_encode(['result' => $res]);
+}
+
 function main() {
     switch($_SERVER["PHP_SELF"]) {
         case "/mysql_test_query": {
           mysql_test_query();
           return;
         }
+        case "/mysql_test_queries": {
+          mysql_test_queries();
+          return;
+        }
+        case "/mysql_test_prepared_query": {
+          mysql_test_prepared_query();
+          return;
+        }
         default: {
           critical_error("Unknown test " . $_SERVER["PHP_SELF"]);
         }
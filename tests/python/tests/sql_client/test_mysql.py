@@ -74,3 +74,68 @@ class TestMysql(KphpServerAutoTestCase):
     def test_fail_syntax_error(self):
         self._sql_query_impl(query='HELLO WORLD',
                              expected_res={'error': ['42000', 1064]})
+
+    def _prepared_query_impl(self, query, params_list, buffered=True, rows_limit=-1):
+        resp = self.kphp_server.http_post(
+            uri="/mysql_test_prepared_query",
+            json={
+                "mysql-dbname": 'test',
+                "mysql-host": '127.0.0.1',
+                "mysql-port": self.mysql_proc.port,
+                "mysql-user": self.mysql_proc.user,
+                "query": query,
+                "params_list": params_list,
+                "buffered": buffered,
+                "rows_limit": rows_limit,
+            }
+        )
+        self.assertEqual(resp.status_code, 200)
+        return resp.json()["result"]
+
+    def test_prepared_positional_params(self):
+        for buffered in (True, False):
+            self.assertEqual(
+                self._prepared_query_impl("SELECT val_str FROM TestTable WHERE id = ? OR val_str = ? ORDER BY id",
+                                          [[1, "a"], [2, "it's ? not :param"]], buffered=buffered),
+                [[{'0': 'hello', 'val_str': 'hello'}, {'0': 'a', 'val_str': 'a'}],
+                 [{'0': 'world', 'val_str': 'world'}]])
+
+    def test_prepared_named_params(self):
+        self.assertEqual(
+            self._prepared_query_impl("SELECT id, ':id' AS s FROM TestTable WHERE id > :id LIMIT :limit",
+                                      [{":id": 1, "limit": 1}]),
+            [[{'0': '2', 'id': '2', '1': ':id', 's': ':id'}]])
+
+    def test_prepared_null_param(self):
+        self.assertEqual(
+            self._prepared_query_impl("SELECT ? AS v", [[None]]),
+            [[{'0': None, 'v': None}]])
+
+    def test_unbuffered_partial_fetch_and_reuse(self):
+        self.assertEqual(
+            self._prepared_query_impl("SELECT id FROM TestTable WHERE id >= ? ORDER BY id", [[1], [2]],
+                                      buffered=False, rows_limit=1),
+            [[{'0': '1', 'id': '1'}], [{'0': '2', 'id': '2'}]])
+
+    def test_prepared_repeated_named_param(self):
+        self.assertEqual(
+            self._prepared_query_impl("SELECT val_str FROM TestTable WHERE id = :id OR id = :id + 1 ORDER BY id",
+                                      [{"id": 1}]),
+            [[{'0': 'hello', 'val_str': 'hello'}, {'0': 'world', 'val_str': 'world'}]])
+
+    def test_prepared_mixed_params_are_rejected(self):
+        res = self._prepared_query_impl("SELECT ? AS a, :b AS b", [{"0": 1, "b": 2}])
+        self.assertEqual(len(res), 1)
+        self.assertIn("error", res[0])
+        self.kphp_server.assert_log(["Invalid parameter number in PDOStatement::execute: mixed named and positional parameters"])
+
+    def test_prepared_float_param_keeps_precision(self):
+        self.assertEqual(
+            self._prepared_query_impl("SELECT ? AS v", [[0.1]]),
+            [[{'0': '0.10000000000000001', 'v': '0.10000000000000001'}]])
+
+    def test_prepared_string_param_is_escaped(self):
+        value = "it's \\ \"quoted\"\n\0 end"
+        self.assertEqual(
+            self._prepared_query_impl("SELECT ? AS v", [[value]]),
+            [[{'0': value, 'v': value}]])
@@ -0,0 +1,82 @@
+import time
+
+import pytest
+
+from pytest_mysql.factories import mysql, mysql_proc
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestMysqlConnectionPool(KphpServerAutoTestCase):
+    @classmethod
+    def extra_class_setup(cls):
+        cls.kphp_server.update_options({
+            "--verbosity-mysql=2": True,
+            "--pdo-mysql-pool-size": 2,
+            "-t": 10,
+        })
+
+    @pytest.fixture(autouse=True)
+    def _setup_mysql_db(self, mysql, mysql_proc):
+        self.mysql_client = mysql
+        self.mysql_proc = mysql_proc
+
+    def _post(self, uri, **params):
+        params.update({
+            "mysql-dbname": 'test',
+            "mysql-host": '127.0.0.1',
+            "mysql-port": self.mysql_proc.port,
+            "mysql-user": self.mysql_proc.user,
+        })
+        resp = self.kphp_server.http_post(uri=uri, json=params)
+        self.assertEqual(resp.status_code, 200)
+        return resp.json()["result"]
+
+    def _sql_query_impl(self, query):
+        return self._post("/mysql_test_query", query=query)
+
+    def _count_other_transactions(self):
+        cursor = self.mysql_client.cursor()
+        cursor.execute("SELECT COUNT(*) FROM information_schema.innodb_trx WHERE trx_mysql_thread_id != CONNECTION_ID()")
+        count = cursor.fetchone()[0]
+        cursor.close()
+        self.mysql_client.commit()
+        return count
+
+    def test_connection_is_reused(self):
+        first_id = self._sql_query_impl("SELECT CONNECTION_ID() AS id")[0]["id"]
+        second_id = self._sql_query_impl("SELECT CONNECTION_ID() AS id")[0]["id"]
+        self.assertEqual(first_id, second_id)
+        self.kphp_server.assert_log(["MySQL take pooled connection"], timeout=5)
+
+    def test_session_state_is_reset(self):
+        self.assertEqual(self._sql_query_impl("SET @pooled_var = 42"), {"affected_rows": 0})
+        self.assertEqual(self._sql_query_impl("SELECT @pooled_var AS v"), [{"0": None, "v": None}])
+
+    def test_killed_connection_is_replaced(self):
+        connection_id = self._sql_query_impl("SELECT CONNECTION_ID() AS id")[0]["id"]
+        cursor = self.mysql_client.cursor()
+        cursor.execute("KILL {}".format(connection_id))
+        cursor.close()
+        new_connection_id = self._sql_query_impl("SELECT CONNECTION_ID() AS id")[0]["id"]
+        self.assertNotEqual(connection_id, new_connection_id)
+
+    def test_connection_in_transaction_is_closed(self):
+        cursor = self.mysql_client.cursor()
+        cursor.execute("CREATE TABLE PoolLocks (id INT NOT NULL, PRIMARY KEY (id)); INSERT INTO PoolLocks (id) VALUES (1);")
+        cursor.fetchall()
+        cursor.close()
+        self.mysql_client.commit()
+
+        connection_id = self._sql_query_impl("SELECT CONNECTION_ID() AS id")[0]["id"]
+        # the script finishes without a commit, so the connector is dropped in the middle of the transaction
+        self.assertEqual(self._post("/mysql_test_queries", queries=["START TRANSACTION", "UPDATE PoolLocks SET id = 2 WHERE id = 1"]),
+                         [{"affected_rows": 0}, {"affected_rows": 1}])
+        self.kphp_server.assert_log(["MySQL disconnected from"], timeout=5)
+
+        # the transaction is rolled back by the server, and its row lock is released
+        deadline = time.time() + 5
+        while self._count_other_transactions():
+            self.assertLess(time.time(), deadline, "the transaction of the dropped connector is still open")
+            time.sleep(0.1)
+        self.assertEqual(self._sql_query_impl("SELECT id FROM PoolLocks"), [{"0": "1", "id": "1"}])
+        self.assertNotEqual(self._sql_query_impl("SELECT CONNECTION_ID() AS id")[0]["id"], connection_id)
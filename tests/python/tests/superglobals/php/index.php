@@ -0,0 +1,22 @@
+<?php
+
+// only $_SERVER and $_GET are used here, so the runtime doesn't fill the other superglobals
+
+if ($_SERVER["PHP_SELF"] === "/get") {
+  echo json_encode([
+    "get" => $_GET,
+    "method" => $_SERVER["REQUEST_METHOD"],
+    "query" => $_SERVER["QUERY_STRING"],
+    "cookie_header" => $_SERVER["HTTP_COOKIE"] ?? null,
+    "custom_header" => $_SERVER["HTTP_X_CUSTOM"] ?? null,
+  ]);
+} else if ($_SERVER["PHP_SELF"] === "/post") {
+  echo json_encode([
+    "get" => $_GET,
+    "method" => $_SERVER["REQUEST_METHOD"],
+    "content_type" => $_SERVER["CONTENT_TYPE"] ?? null,
+    "input" => file_get_contents("php://input"),
+  ]);
+} else {
+  echo "Hello world!";
+}
@@ -0,0 +1,46 @@
+from python.lib.testcase import KphpServerAutoTestCase
+
+
+class TestUsedSuperglobals(KphpServerAutoTestCase):
+    def test_used_superglobals_are_filled(self):
+        resp = self.kphp_server.http_get(
+            "/get?a=1&b[]=2&b[]=3",
+            headers={"Cookie": "c=4; d=5", "X-Custom": "hello"})
+        self.assertEqual(resp.status_code, 200)
+        self.assertEqual(resp.json(), {
+            "get": {"a": "1", "b": ["2", "3"]},
+            "method": "GET",
+            "query": "a=1&b[]=2&b[]=3",
+            "cookie_header": "c=4; d=5",
+            "custom_header": "hello",
+        })
+
+    def test_post_body_is_kept_without_post_superglobal(self):
+        for _ in range(3):
+            resp = self.kphp_server.http_post(
+                "/post?a=1",
+                data="p=1&q[]=2",
+                headers={"Content-Type": "application/x-www-form-urlencoded"})
+            self.assertEqual(resp.status_code, 200)
+            self.assertEqual(resp.json(), {
+                "get": {"a": "1"},
+                "method": "POST",
+                "content_type": "application/x-www-form-urlencoded",
+                "input": "p=1&q[]=2",
+            })
+
+    def test_multipart_body_is_read_without_files_superglobal(self):
+        resp = self.kphp_server.http_post(
+            "/post",
+            files={"file": ("a.txt", b"file content")},
+            data={"p": "1"})
+        self.assertEqual(resp.status_code, 200)
+        self.assertEqual(resp.json()["method"], "POST")
+        self.assertTrue(resp.json()["content_type"].startswith("multipart/form-data"))
+        # the multipart body isn't parsed, it's available as is
+        self.assertIn("file content", resp.json()["input"])
+
+        # the connection isn't broken by the unparsed body
+        resp = self.kphp_server.http_get("/get?a=1")
+        self.assertEqual(resp.status_code, 200)
+        self.assertEqual(resp.json()["get"], {"a": "1"})